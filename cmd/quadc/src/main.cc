@@ -1,10 +1,14 @@
+#include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <functional>
+#include <iomanip>
 #include <iostream>
 #include <llvmgen/generator.h>
+#include <map>
 #include <qc/ast.h>
 #include <qc/ast_node.h>
 #include <qc/ast_node_function.h>
@@ -14,7 +18,9 @@
 #include <random>
 #include <set>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
+#include <unistd.h>
 #include <unordered_set>
 #include <vector>
 
@@ -36,6 +42,16 @@ struct Options {
 	bool dumpIR = false;
 	bool debugInfo = false;
 	bool werror = false;
+	bool runtimeChecks = true;	   // -fno-runtime-checks: skip stack checks the validator proved
+	bool callStackTracking = true; // Shadow call stack for stack traces
+	bool stackTraces = false;	   // --stack-traces: keep the call stack even in release builds
+	bool moduleCache = true;	   // --no-cache: always compile imported modules from source
+	bool lto = false;			   // -flto: inline runtime and standard library functions
+	unsigned jobs = 1;			   // -j: threads for parsing, validating and compiling imported modules
+	std::string profileGenerate;   // --profile-generate: raw profile the instrumented program writes
+	std::string profileUse;		   // --profile-use: profile to optimize with
+	size_t stackSize = 0;		   // --stack-size: data stack capacity in elements (0: default)
+	bool stackGrowth = false;	   // --stack-growth: reserve the data stack and commit it as it grows
 	std::unordered_map<std::string, std::string> moduleVersions; // module name -> version
 };
 
@@ -56,6 +72,23 @@ void printHelp() {
 	std::cout << "  -r, --run          Compile and run immediately\n";
 	std::cout << "  --dump-ir          Print generated LLVM IR\n";
 	std::cout << "  --werror           Treat warnings as errors\n";
+	std::cout << "  --release          Optimize (-O2), drop proven runtime checks and call stack tracking\n";
+	std::cout << "  -fno-runtime-checks\n";
+	std::cout << "                     Skip stack checks at call sites proven by the type checker\n";
+	std::cout << "  -fruntime-checks   Keep all stack checks (default; overrides an earlier --release)\n";
+	std::cout << "  --stack-traces     Keep call stack tracking for stack traces in release builds\n";
+	std::cout << "  -flto              Inline runtime and standard library functions (with -O1 and up)\n";
+	std::cout << "  --no-cache         Don't reuse or store compiled modules in the module cache\n";
+	std::cout << "  -j <n>             Parse, validate and compile imported modules on <n> threads\n";
+	std::cout << "                     (0: one per CPU, default: 1)\n";
+	std::cout << "  --profile-generate[=<file>]\n";
+	std::cout << "                     Instrument the program to write a profile when it exits\n";
+	std::cout << "                     (default: <name>.profraw in the working directory)\n";
+	std::cout << "  --profile-use=<file>\n";
+	std::cout << "                     Optimize with a profile (.profdata, or .profraw to merge)\n";
+	std::cout << "  --stack-size=<n>   Data stack capacity in values, also for spawned tasks\n";
+	std::cout << "                     (default: 1024, 1048576 with --stack-growth)\n";
+	std::cout << "  --stack-growth     Reserve the data stack and only use memory as it grows\n";
 	std::cout << "\n";
 	std::cout << "Examples:\n";
 	std::cout << "  quadc main.qd              Compile to executable 'main'\n";
@@ -68,6 +101,7 @@ void printVersion() {
 }
 
 bool parseArgs(int argc, char* argv[], Options& opts) {
+	bool profileGenerate = false;
 	for (int i = 1; i < argc; i++) {
 		std::string arg = argv[i];
 
@@ -117,6 +151,76 @@ bool parseArgs(int argc, char* argv[], Options& opts) {
 			opts.moduleVersions[moduleName] = version;
 		} else if (arg == "--werror") {
 			opts.werror = true;
+		} else if (arg == "--release") {
+			opts.optLevel = 2;
+			opts.runtimeChecks = false;
+			opts.callStackTracking = false;
+		} else if (arg == "-fno-runtime-checks") {
+			opts.runtimeChecks = false;
+		} else if (arg == "-fruntime-checks") {
+			opts.runtimeChecks = true;
+		} else if (arg == "-flto") {
+			opts.lto = true;
+		} else if (arg == "-fno-lto") {
+			opts.lto = false;
+		} else if (arg == "--stack-traces") {
+			opts.stackTraces = true;
+		} else if (arg == "--no-cache") {
+			opts.moduleCache = false;
+		} else if (arg == "-j" || (arg.size() > 2 && arg.substr(0, 2) == "-j")) {
+			std::string count;
+			if (arg == "-j") {
+				if (i + 1 >= argc) {
+					std::cerr << "quadc: option '-j' requires an argument\n";
+					std::cerr << "Try 'quadc --help' for more information.\n";
+					return false;
+				}
+				count = argv[++i];
+			} else {
+				count = arg.substr(2);
+			}
+			if (count.empty() || count.size() > 4 || count.find_first_not_of("0123456789") != std::string::npos) {
+				std::cerr << "quadc: invalid job count for '-j': '" << count << "'\n";
+				return false;
+			}
+			opts.jobs = static_cast<unsigned>(std::stoul(count));
+			if (opts.jobs == 0) {
+				opts.jobs = std::max(1u, std::thread::hardware_concurrency());
+			}
+		} else if (arg == "--profile-generate") {
+			profileGenerate = true;
+		} else if (arg.rfind("--profile-generate=", 0) == 0) {
+			profileGenerate = true;
+			opts.profileGenerate = arg.substr(19);
+		} else if (arg == "--profile-use") {
+			if (i + 1 >= argc) {
+				std::cerr << "quadc: option '--profile-use' requires an argument\n";
+				std::cerr << "Try 'quadc --help' for more information.\n";
+				return false;
+			}
+			opts.profileUse = argv[++i];
+		} else if (arg.rfind("--profile-use=", 0) == 0) {
+			opts.profileUse = arg.substr(14);
+		} else if (arg == "--stack-size" || arg.rfind("--stack-size=", 0) == 0) {
+			std::string size;
+			if (arg == "--stack-size") {
+				if (i + 1 >= argc) {
+					std::cerr << "quadc: option '--stack-size' requires an argument\n";
+					std::cerr << "Try 'quadc --help' for more information.\n";
+					return false;
+				}
+				size = argv[++i];
+			} else {
+				size = arg.substr(13);
+			}
+			if (size.empty() || size.size() > 12 || size.find_first_not_of("0123456789") != std::string::npos ||
+					std::stoull(size) == 0) {
+				std::cerr << "quadc: invalid stack size for '--stack-size': '" << size << "'\n";
+				return false;
+			}
+			opts.stackSize = static_cast<size_t>(std::stoull(size));
+		} else if (arg == "--stack-growth") {
+			opts.stackGrowth = true;
 		} else if (arg == "-O0") {
 			opts.optLevel = 0;
 		} else if (arg == "-O1") {
@@ -140,6 +244,14 @@ bool parseArgs(int argc, char* argv[], Options& opts) {
 		return false;
 	}
 
+	if (profileGenerate && opts.profileGenerate.empty()) {
+		opts.profileGenerate = std::filesystem::path(opts.outputName).filename().string() + ".profraw";
+	}
+	if (profileGenerate && !opts.profileUse.empty()) {
+		std::cerr << "quadc: '--profile-generate' and '--profile-use' can't be combined\n";
+		return false;
+	}
+
 	return true;
 }
 
@@ -257,6 +369,79 @@ std::string getPackagesDir() {
 	return ""; // No packages directory available
 }
 
+// Get the module cache directory (compiled objects of imported modules)
+// Returns an empty string if there is no usable cache directory
+std::string getModuleCacheDir() {
+	std::string cacheDir;
+	if (const char* quadcCacheDir = std::getenv("QUADC_CACHE_DIR")) {
+		cacheDir = quadcCacheDir;
+	} else if (const char* xdgCacheHome = std::getenv("XDG_CACHE_HOME")) {
+		cacheDir = std::string(xdgCacheHome) + "/quadrate/modules";
+	} else if (const char* home = std::getenv("HOME")) {
+		cacheDir = std::string(home) + "/.cache/quadrate/modules";
+	}
+	if (cacheDir.empty()) {
+		return "";
+	}
+
+	std::error_code ec;
+	std::filesystem::create_directories(cacheDir, ec);
+	if (ec || access(cacheDir.c_str(), W_OK) != 0) {
+		return "";
+	}
+	return cacheDir;
+}
+
+// 128-bit hash (two FNV-1a style lanes) as hex, used for module cache keys
+std::string hashString(const std::string& data) {
+	uint64_t h1 = 14695981039346656037ULL;
+	uint64_t h2 = 0x9e3779b97f4a7c15ULL;
+	for (char ch : data) {
+		auto c = static_cast<unsigned char>(ch);
+		h1 = (h1 ^ c) * 1099511628211ULL;
+		h2 = (h2 ^ c) * 0xff51afd7ed558ccdULL;
+	}
+	std::stringstream ss;
+	ss << std::hex << std::setfill('0') << std::setw(16) << h1 << std::setw(16) << h2;
+	return ss.str();
+}
+
+// Identifies this quadc binary, so a rebuilt compiler never links objects from an older one
+std::string compilerIdentity() {
+	std::string identity = QUADC_VERSION;
+	std::error_code ec;
+	std::filesystem::path exePath = std::filesystem::canonical("/proc/self/exe", ec);
+	if (!ec) {
+		auto size = std::filesystem::file_size(exePath, ec);
+		auto mtime = std::filesystem::last_write_time(exePath, ec);
+		if (!ec) {
+			identity += ":" + std::to_string(size) + ":" + std::to_string(mtime.time_since_epoch().count());
+		}
+	}
+	return identity;
+}
+
+// Get the indexed profile to pass to the generator
+// Raw profiles written by an instrumented program are merged with llvm-profdata first
+// Returns an empty string if the profile is missing or can't be converted
+std::string indexedProfile(const std::string& profile, const std::string& outputDir) {
+	if (!std::filesystem::exists(profile)) {
+		std::cerr << "quadc: profile not found: " << profile << std::endl;
+		return "";
+	}
+	if (std::filesystem::path(profile).extension() != ".profraw") {
+		return profile;
+	}
+
+	std::string indexed = (std::filesystem::path(outputDir) / "profile.profdata").string();
+	std::string command = "llvm-profdata merge -o '" + indexed + "' '" + profile + "'";
+	if (system(command.c_str()) != 0) {
+		std::cerr << "quadc: failed to merge profile " << profile << " (is llvm-profdata installed?)" << std::endl;
+		return "";
+	}
+	return indexed;
+}
+
 // Find a package in the packages directory
 // Checks g_moduleVersionPins first for pinned versions from -l flags
 // Returns the full path to the package directory, or empty string if not found
@@ -453,8 +638,222 @@ struct ParsedModule {
 	std::unique_ptr<Qd::Ast> ast;
 	Qd::IAstNode* root;
 	std::vector<std::string> importedModules;
+	std::string sourceHash; // For module cache keys
+};
+
+// Result of loading an imported module
+enum class ModuleLoad {
+	LOADED,
+	NOT_FOUND, // Missing or unreadable, skipped (imports were validated with the importer)
+	PARSE_FAILED
 };
 
+// Compute the module cache key of every imported package
+// A package's object depends on its own sources and, through constants, structs and function
+// signatures, on the sources of everything it imports, so all of those go into the key
+std::map<std::string, std::string> computePackageKeys(const std::vector<ParsedModule>& modules,
+		const std::unordered_map<std::string, std::string>& moduleToPackage, const std::string& options) {
+	std::map<std::string, std::vector<std::string>> packageSources; // package -> source hashes
+	std::map<std::string, std::set<std::string>> packageImports;	// package -> directly imported packages
+	for (const auto& module : modules) {
+		if (module.package == "main") {
+			continue;
+		}
+		packageSources[module.package].push_back(module.sourceHash);
+		for (const auto& importedModule : module.importedModules) {
+			auto it = moduleToPackage.find(importedModule);
+			std::string importedPackage = (it != moduleToPackage.end()) ? it->second : importedModule;
+			if (importedPackage != module.package) {
+				packageImports[module.package].insert(importedPackage);
+			}
+		}
+	}
+
+	std::map<std::string, std::string> keys;
+	for (const auto& package : packageSources) {
+		// Collect the package and its transitive imports (std::set keeps the key order stable)
+		std::set<std::string> closure = {package.first};
+		std::vector<std::string> pending = {package.first};
+		while (!pending.empty()) {
+			std::string current = pending.back();
+			pending.pop_back();
+			auto importsIt = packageImports.find(current);
+			if (importsIt == packageImports.end()) {
+				continue;
+			}
+			for (const auto& importedPackage : importsIt->second) {
+				if (closure.insert(importedPackage).second) {
+					pending.push_back(importedPackage);
+				}
+			}
+		}
+
+		std::string keyData = options + "\npackage " + package.first;
+		for (const auto& member : closure) {
+			auto sourcesIt = packageSources.find(member);
+			std::vector<std::string> hashes;
+			if (sourcesIt != packageSources.end()) {
+				hashes = sourcesIt->second;
+			}
+			std::sort(hashes.begin(), hashes.end());
+			keyData += "\n" + member;
+			for (const auto& hash : hashes) {
+				keyData += " " + hash;
+			}
+		}
+		keys[package.first] = hashString(keyData);
+	}
+	return keys;
+}
+
+// Compile a single package to an object file
+// The object is written under a temporary name and renamed, so concurrent builds never see a partial file
+bool compilePackageObject(const std::vector<ParsedModule>& modules, const std::string& package, const Options& opts,
+		const std::string& objectPath) {
+	Qd::LlvmGenerator generator;
+	generator.setDebugInfo(opts.debugInfo);
+	generator.setOptimizationLevel(opts.optLevel);
+	generator.setRuntimeChecks(opts.runtimeChecks);
+	generator.setCallStackTracking(opts.callStackTracking || opts.stackTraces);
+	generator.setLinkTimeOptimization(opts.lto);
+	generator.setProfileGenerate(opts.profileGenerate);
+	generator.setProfileUse(opts.profileUse);
+	for (auto it = modules.rbegin(); it != modules.rend(); ++it) {
+		if (it->package != "main") {
+			generator.addModuleAST(it->package, it->root, it->name);
+		}
+	}
+	if (!generator.generateModule(package)) {
+		return false;
+	}
+
+	std::string tempPath = objectPath + ".tmp" + std::to_string(getpid());
+	if (!generator.writeObject(tempPath)) {
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	std::error_code ec;
+	std::filesystem::rename(tempPath, objectPath, ec);
+	if (ec) {
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+// Find, read and parse an imported module into parsedMod, whose package is already set
+// Only touches parsedMod, so several modules can be loaded in parallel
+ModuleLoad loadModule(const std::string& moduleName, const std::string& moduleSourceDir, ParsedModule& parsedMod) {
+	std::string moduleFilePath = findModuleFile(moduleName, moduleSourceDir);
+	if (moduleFilePath.empty()) {
+		// Module file not found - skip silently (already validated)
+		return ModuleLoad::NOT_FOUND;
+	}
+
+	// Read module file
+	std::ifstream moduleFile(moduleFilePath);
+	if (!moduleFile.is_open()) {
+		return ModuleLoad::NOT_FOUND;
+	}
+	moduleFile.seekg(0, std::ios::end);
+	auto pos = moduleFile.tellg();
+	moduleFile.seekg(0);
+	if (pos < 0) {
+		return ModuleLoad::NOT_FOUND;
+	}
+	size_t size = static_cast<size_t>(pos);
+	std::string buffer(size, ' ');
+	moduleFile.read(&buffer[0], static_cast<std::streamsize>(size));
+
+	// Parse the module
+	auto ast = std::make_unique<Qd::Ast>();
+	auto root = ast->generate(buffer.c_str(), false, moduleFilePath.c_str());
+	if (!root || ast->hasErrors()) {
+		return ModuleLoad::PARSE_FAILED;
+	}
+
+	// Get module's source directory
+	std::filesystem::path moduleFilePathObj(moduleFilePath);
+	std::string moduleFileSourceDir = moduleFilePathObj.parent_path().string();
+	if (moduleFileSourceDir.empty()) {
+		moduleFileSourceDir = ".";
+	}
+
+	// Detect if this module is from a third-party package
+	// Package paths look like: /path/to/packages/modulename@version/module.qd
+	std::string packageDir;
+	std::string packagesDir = getPackagesDir();
+	if (!packagesDir.empty()) {
+		std::string normalizedModulePath = std::filesystem::absolute(moduleFilePath).string();
+		std::string normalizedPackagesDir = std::filesystem::absolute(packagesDir).string();
+
+		// Check if module path starts with packages directory
+		if (normalizedModulePath.size() > normalizedPackagesDir.size() &&
+				normalizedModulePath.substr(0, normalizedPackagesDir.size()) == normalizedPackagesDir) {
+			// Extract the package directory (e.g., /path/to/packages/color@master)
+			std::string relativePath = normalizedModulePath.substr(normalizedPackagesDir.size());
+			if (!relativePath.empty() && relativePath[0] == '/') {
+				relativePath = relativePath.substr(1);
+			}
+			// Get the first path component (modulename@version)
+			size_t slashPos = relativePath.find('/');
+			if (slashPos != std::string::npos) {
+				std::string packageDirName = relativePath.substr(0, slashPos);
+				packageDir = normalizedPackagesDir + "/" + packageDirName;
+			}
+		}
+	}
+
+	parsedMod.name = moduleFilePath; // Store full file path for debug info
+	parsedMod.sourceDirectory = moduleFileSourceDir;
+	parsedMod.packageDirectory = packageDir;
+	parsedMod.root = root;
+	parsedMod.ast = std::move(ast);
+	parsedMod.sourceHash = hashString(buffer);
+
+	// Collect imports from this module
+	std::function<void(Qd::IAstNode*)> collectImports = [&](Qd::IAstNode* node) {
+		if (!node) {
+			return;
+		}
+		if (node->type() == Qd::IAstNode::Type::USE_STATEMENT) {
+			auto* useNode = static_cast<Qd::AstNodeUse*>(node);
+			parsedMod.importedModules.push_back(useNode->module());
+		}
+		for (size_t i = 0; i < node->childCount(); i++) {
+			collectImports(node->child(i));
+		}
+	};
+	collectImports(root);
+
+	return ModuleLoad::LOADED;
+}
+
+// Run task(0) .. task(count - 1) on up to jobs threads, including the calling one
+void parallelFor(size_t count, unsigned jobs, const std::function<void(size_t)>& task) {
+	if (jobs <= 1 || count <= 1) {
+		for (size_t i = 0; i < count; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	std::atomic<size_t> next{0};
+	auto worker = [&] {
+		for (size_t i = next++; i < count; i = next++) {
+			task(i);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (size_t t = 1; t < std::min<size_t>(jobs, count); t++) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
 int main(int argc, char** argv) {
 	Options opts;
 
@@ -504,6 +903,13 @@ int main(int argc, char** argv) {
 		std::cout << "Temporary files saved in: " << outputDir << std::endl;
 	}
 
+	if (!opts.profileUse.empty()) {
+		opts.profileUse = indexedProfile(opts.profileUse, outputDir);
+		if (opts.profileUse.empty()) {
+			return 1;
+		}
+	}
+
 	if (!opts.files.empty()) {
 		std::vector<ParsedModule> parsedModules;
 
@@ -622,147 +1028,142 @@ int main(int argc, char** argv) {
 
 		// Transpile all imported modules (including transitive imports)
 		// Keep processing until no new modules are discovered
+		// With -j, all modules discovered so far are loaded in parallel and their imports form the next batch
 		while (!allModules.empty()) {
-			// Get next unprocessed module
-			std::string moduleName = *allModules.begin();
-			allModules.erase(allModules.begin());
-
-			// Skip if already processed
-			if (processedModules.count(moduleName)) {
-				continue;
-			}
-			processedModules.insert(moduleName);
-
-			// Get the package name and source directory for this module
-			std::string packageName = moduleToPackage.count(moduleName) ? moduleToPackage[moduleName] : moduleName;
-			std::string moduleSourceDir =
-					moduleToSourceDir.count(moduleName) ? moduleToSourceDir[moduleName] : sourceDirectory;
-
-			std::string moduleFilePath = findModuleFile(moduleName, moduleSourceDir);
-			if (moduleFilePath.empty()) {
-				// Module file not found - skip silently (already validated)
-				continue;
-			}
-
-			// Read module file
-			std::ifstream moduleFile(moduleFilePath);
-			if (!moduleFile.is_open()) {
-				continue;
-			}
-			moduleFile.seekg(0, std::ios::end);
-			auto pos = moduleFile.tellg();
-			moduleFile.seekg(0);
-			if (pos < 0) {
-				continue;
+			// Get the next unprocessed modules
+			std::vector<std::string> batch;
+			while (!allModules.empty() && (batch.empty() || opts.jobs > 1)) {
+				std::string moduleName = *allModules.begin();
+				allModules.erase(allModules.begin());
+
+				// Skip if already processed
+				if (processedModules.insert(moduleName).second) {
+					batch.push_back(moduleName);
+				}
 			}
-			size_t size = static_cast<size_t>(pos);
-			std::string buffer(size, ' ');
-			moduleFile.read(&buffer[0], static_cast<std::streamsize>(size));
 
-			// Parse the module
-			auto ast = std::make_unique<Qd::Ast>();
-			auto root = ast->generate(buffer.c_str(), false, moduleFilePath.c_str());
-			if (!root || ast->hasErrors()) {
-				std::cerr << "quadc: failed to parse module: " << moduleName << std::endl;
-				return 1;
+			// Get the package name and source directory of each module
+			std::vector<ParsedModule> loadedModules(batch.size());
+			std::vector<std::string> moduleSourceDirs(batch.size());
+			for (size_t i = 0; i < batch.size(); i++) {
+				auto packageIt = moduleToPackage.find(batch[i]);
+				loadedModules[i].package = (packageIt != moduleToPackage.end()) ? packageIt->second : batch[i];
+				auto sourceDirIt = moduleToSourceDir.find(batch[i]);
+				moduleSourceDirs[i] = (sourceDirIt != moduleToSourceDir.end()) ? sourceDirIt->second : sourceDirectory;
 			}
 
-			// Semantic validation - catch errors before LLVM generation
-			// Pass true for isModuleFile to skip reporting errors for missing nested module imports
-			Qd::SemanticValidator validator;
-			size_t errorCount = validator.validate(root, moduleFilePath.c_str(), true, opts.werror);
-			if (errorCount > 0) {
-				// Validation failed - do not proceed
-				return 1;
-			}
+			std::vector<ModuleLoad> results(batch.size());
+			parallelFor(batch.size(), opts.jobs,
+					[&](size_t i) { results[i] = loadModule(batch[i], moduleSourceDirs[i], loadedModules[i]); });
 
-			// Get module's source directory
-			std::filesystem::path moduleFilePathObj(moduleFilePath);
-			std::string moduleFileSourceDir = moduleFilePathObj.parent_path().string();
-			if (moduleFileSourceDir.empty()) {
-				moduleFileSourceDir = ".";
-			}
-
-			// Detect if this module is from a third-party package
-			// Package paths look like: /path/to/packages/modulename@version/module.qd
-			std::string packageDir;
-			std::string packagesDir = getPackagesDir();
-			if (!packagesDir.empty()) {
-				std::string normalizedModulePath = std::filesystem::absolute(moduleFilePath).string();
-				std::string normalizedPackagesDir = std::filesystem::absolute(packagesDir).string();
-
-				// Check if module path starts with packages directory
-				if (normalizedModulePath.size() > normalizedPackagesDir.size() &&
-						normalizedModulePath.substr(0, normalizedPackagesDir.size()) == normalizedPackagesDir) {
-					// Extract the package directory (e.g., /path/to/packages/color@master)
-					std::string relativePath = normalizedModulePath.substr(normalizedPackagesDir.size());
-					if (!relativePath.empty() && relativePath[0] == '/') {
-						relativePath = relativePath.substr(1);
-					}
-					// Get the first path component (modulename@version)
-					size_t slashPos = relativePath.find('/');
-					if (slashPos != std::string::npos) {
-						std::string packageDirName = relativePath.substr(0, slashPos);
-						packageDir = normalizedPackagesDir + "/" + packageDirName;
-					}
+			for (size_t i = 0; i < batch.size(); i++) {
+				const std::string& moduleName = batch[i];
+				if (results[i] == ModuleLoad::NOT_FOUND) {
+					continue;
 				}
-			}
-
-			ParsedModule parsedMod;
-			parsedMod.name = moduleFilePath; // Store full file path for debug info
-			parsedMod.package = packageName;
-			parsedMod.sourceDirectory = moduleFileSourceDir;
-			parsedMod.packageDirectory = packageDir;
-			parsedMod.root = root;
-			parsedMod.ast = std::move(ast);
-
-			// Collect imports from this module
-			std::function<void(Qd::IAstNode*)> collectImports = [&](Qd::IAstNode* node) {
-				if (!node) {
-					return;
+				if (results[i] == ModuleLoad::PARSE_FAILED) {
+					std::cerr << "quadc: failed to parse module: " << moduleName << std::endl;
+					return 1;
 				}
-				if (node->type() == Qd::IAstNode::Type::USE_STATEMENT) {
-					auto* useNode = static_cast<Qd::AstNodeUse*>(node);
-					parsedMod.importedModules.push_back(useNode->module());
-				}
-				for (size_t i = 0; i < node->childCount(); i++) {
-					collectImports(node->child(i));
-				}
-			};
-			collectImports(root);
-
-			// Add any modules imported by this module to the set
-			for (const auto& transitiveModule : parsedMod.importedModules) {
-				if (!processedModules.count(transitiveModule)) {
-					allModules.insert(transitiveModule);
-
-					// Determine package for transitive imports
-					bool isDirectFile = transitiveModule.size() >= 3 &&
-										transitiveModule.substr(transitiveModule.size() - 3) == ".qd";
-					if (isDirectFile) {
-						// Check if importing file is a module directory (doesn't end in .qd)
-						bool importerIsModuleDirectory =
-								!(moduleName.size() >= 3 && moduleName.substr(moduleName.size() - 3) == ".qd");
-
-						if (importerIsModuleDirectory) {
-							// Intra-module import: use importer's package
-							moduleToPackage[transitiveModule] = packageName;
+				ParsedModule& parsedMod = loadedModules[i];
+
+				// Add any modules imported by this module to the set
+				for (const auto& transitiveModule : parsedMod.importedModules) {
+					if (!processedModules.count(transitiveModule)) {
+						allModules.insert(transitiveModule);
+
+						// Determine package for transitive imports
+						bool isDirectFile = transitiveModule.size() >= 3 &&
+											transitiveModule.substr(transitiveModule.size() - 3) == ".qd";
+						if (isDirectFile) {
+							// Check if importing file is a module directory (doesn't end in .qd)
+							bool importerIsModuleDirectory =
+									!(moduleName.size() >= 3 && moduleName.substr(moduleName.size() - 3) == ".qd");
+
+							if (importerIsModuleDirectory) {
+								// Intra-module import: use importer's package
+								moduleToPackage[transitiveModule] = parsedMod.package;
+							} else {
+								// Top-level import: derive package from filename
+								moduleToPackage[transitiveModule] = getPackageFromModuleName(transitiveModule);
+							}
+							// File imports use the importing module's source directory
+							moduleToSourceDir[transitiveModule] = parsedMod.sourceDirectory;
 						} else {
-							// Top-level import: derive package from filename
-							moduleToPackage[transitiveModule] = getPackageFromModuleName(transitiveModule);
+							// Regular module imports get their own package and search from original source dir
+							moduleToPackage[transitiveModule] = transitiveModule;
+							moduleToSourceDir[transitiveModule] = sourceDirectory;
 						}
-						// File imports use the importing module's source directory
-						moduleToSourceDir[transitiveModule] = moduleFileSourceDir;
-					} else {
-						// Regular module imports get their own package and search from original source dir
-						moduleToPackage[transitiveModule] = transitiveModule;
-						moduleToSourceDir[transitiveModule] = sourceDirectory;
 					}
 				}
+
+				parsedModules.push_back(std::move(parsedMod));
 			}
+		}
 
-			parsedModules.push_back(std::move(parsedMod));
+		// Module cache: packages whose sources, imports and code generation options are unchanged are
+		// linked from objects compiled by an earlier run instead of being validated and generated again
+		std::string cacheDir;
+		if (opts.moduleCache && !opts.debugInfo) {
+			cacheDir = getModuleCacheDir();
+		}
+		std::map<std::string, std::string> packageKeys; // package -> cache key
+		std::set<std::string> cachedPackages;
+		if (!cacheDir.empty()) {
+			std::string cacheOptions = "quadc " + compilerIdentity() + " -O" + std::to_string(opts.optLevel) +
+									   (opts.runtimeChecks ? " checks" : " no-checks") +
+									   (opts.callStackTracking || opts.stackTraces ? " call-stack" : "") +
+									   (opts.lto ? " lto" : "");
+			if (!opts.profileGenerate.empty()) {
+				cacheOptions += " profile-generate=" + opts.profileGenerate;
+			}
+			if (!opts.profileUse.empty()) {
+				// Keyed by the profile's contents, so a new profile recompiles the modules
+				std::ifstream profile(opts.profileUse, std::ios::binary);
+				std::stringstream contents;
+				contents << profile.rdbuf();
+				cacheOptions += " profile-use=" + hashString(contents.str());
+			}
+			packageKeys = computePackageKeys(parsedModules, moduleToPackage, cacheOptions);
+			for (const auto& entry : packageKeys) {
+				if (std::filesystem::exists(cacheDir + "/" + entry.second + ".o")) {
+					cachedPackages.insert(entry.first);
+				}
+			}
+		}
+
+		// Semantic validation of modules - catch errors before LLVM generation
+		// Cached packages passed validation when they were compiled
+		std::vector<const ParsedModule*> modulesToValidate;
+		for (const auto& module : parsedModules) {
+			if (module.package != "main" && !cachedPackages.count(module.package)) {
+				modulesToValidate.push_back(&module);
+			}
+		}
+		std::vector<size_t> errorCounts(modulesToValidate.size());
+		std::vector<Qd::SemanticValidator> validators(modulesToValidate.size());
+		parallelFor(modulesToValidate.size(), opts.jobs, [&](size_t i) {
+			// Pass true for isModuleFile to skip reporting errors for missing nested module imports
+			// Parallel workers keep their errors and warnings, so they are reported in module order below
+			Qd::SemanticValidator& validator = validators[i];
+			validator.setStoreErrors(opts.jobs > 1);
+			const ParsedModule* module = modulesToValidate[i];
+			errorCounts[i] = validator.validate(module->root, module->name.c_str(), true, opts.werror);
+		});
+		bool validationFailed = false;
+		for (size_t i = 0; i < modulesToValidate.size(); i++) {
+			if (opts.jobs > 1) {
+				validators[i].printStoredDiagnostics();
+			}
+			if (errorCounts[i] > 0) {
+				validationFailed = true;
+			}
+		}
+		if (validationFailed) {
+			// Validation failed - do not proceed
+			return 1;
 		}
+		validators.clear();
 
 		// Now generate LLVM IR from all parsed modules
 		Qd::LlvmGenerator generator;
@@ -775,6 +1176,21 @@ int main(int argc, char** argv) {
 		// Set optimization level
 		generator.setOptimizationLevel(opts.optLevel);
 
+		// Release builds trust the validator and drop call stack bookkeeping unless traces were requested
+		generator.setRuntimeChecks(opts.runtimeChecks);
+		generator.setCallStackTracking(opts.callStackTracking || opts.stackTraces);
+
+		// Inline runtime and library functions from their bitcode
+		generator.setLinkTimeOptimization(opts.lto);
+
+		// Profile-guided optimization
+		generator.setProfileGenerate(opts.profileGenerate);
+		generator.setProfileUse(opts.profileUse);
+
+		// Data stack of main and spawned tasks
+		generator.setStackSize(opts.stackSize);
+		generator.setStackGrowth(opts.stackGrowth);
+
 		// Add library search paths for third-party packages
 		// Track which packages we've already added to avoid duplicates
 		std::set<std::string> addedPackagePaths;
@@ -790,6 +1206,52 @@ int main(int argc, char** argv) {
 			}
 		}
 
+		// Packages linked from their own object files: cached packages, and with -j every package,
+		// so each one is generated on its own worker with its own LLVM context
+		std::map<std::string, std::string> packageObjects; // package -> object file
+		if (!cacheDir.empty()) {
+			for (const auto& entry : packageKeys) {
+				packageObjects[entry.first] = cacheDir + "/" + entry.second + ".o";
+			}
+		} else if (opts.jobs > 1) {
+			for (const auto& module : parsedModules) {
+				if (module.package != "main" && !packageObjects.count(module.package)) {
+					std::string objectName = "module" + std::to_string(packageObjects.size()) + ".o";
+					packageObjects[module.package] = (std::filesystem::path(outputDir) / objectName).string();
+				}
+			}
+		}
+
+		// Compile the packages that are missing, then link all of them
+		std::vector<std::string> packagesToCompile;
+		for (const auto& entry : packageObjects) {
+			if (cachedPackages.count(entry.first)) {
+				if (opts.verbose) {
+					std::cout << "Using cached module " << entry.first << std::endl;
+				}
+			} else {
+				packagesToCompile.push_back(entry.first);
+			}
+		}
+		std::vector<char> compiled(packagesToCompile.size()); // Not vector<bool>, workers write concurrently
+		parallelFor(packagesToCompile.size(), opts.jobs, [&](size_t i) {
+			const std::string& package = packagesToCompile[i];
+			compiled[i] = compilePackageObject(parsedModules, package, opts, packageObjects.at(package));
+		});
+		for (size_t i = 0; i < packagesToCompile.size(); i++) {
+			if (!compiled[i]) {
+				std::cerr << "quadc: failed to compile module " << packagesToCompile[i] << std::endl;
+				return 1;
+			}
+			if (opts.verbose) {
+				std::cout << (cacheDir.empty() ? "Compiled module " : "Cached module ") << packagesToCompile[i]
+						  << " in " << packageObjects.at(packagesToCompile[i]) << std::endl;
+			}
+		}
+		for (const auto& entry : packageObjects) {
+			generator.addPrecompiledModule(entry.first, entry.second);
+		}
+
 		// Add all dependency modules in REVERSE order (dependencies first)
 		// Modules were loaded in breadth-first order (main first, then dependents, then their dependencies)
 		// but we need to generate them depth-first (deep dependencies first, then their dependents)
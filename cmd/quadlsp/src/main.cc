@@ -1,10 +1,18 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <filesystem>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <jansson.h>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <qc/ast.h>
 #include <qc/ast_node.h>
 #include <qc/ast_node_function.h>
@@ -19,13 +27,26 @@
 #include <qc/ast_node_struct.h>
 #include <qc/error_reporter.h>
 #include <qc/semantic_validator.h>
+#include <qc/source_index.h>
+#include <set>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 // Default error span length in characters for diagnostic highlighting
 static const int ERROR_SPAN_LENGTH = 10;
 
+// Time to wait after the last change before validating a document
+static const int DIAGNOSTICS_DELAY_MS = 150;
+
+// JSON-RPC error code for requests cancelled with $/cancelRequest
+static const int REQUEST_CANCELLED = -32800;
+
+// Maximum number of results for workspace/symbol
+static const size_t WORKSPACE_SYMBOL_LIMIT = 1000;
+
 // Structure to hold function information for completions
 struct FunctionInfo {
 	std::string name;
@@ -42,6 +63,581 @@ struct StructInfo {
 	std::string signature; // Full struct declaration
 };
 
+// Source text with its AST, cached per top-level declaration
+//
+// The text is split at lines that start a new declaration (a line beginning
+// in column 0 outside of any brackets, strings or comments). Each piece is
+// parsed on its own and cached by its text, so a piece is only reparsed when
+// its text changes; when lines are inserted or removed above it, its nodes
+// and errors are moved to the new start line instead. The program node
+// combines the pieces' declarations for the request handlers.
+class Document {
+public:
+	const std::string& text() const {
+		return text_;
+	}
+
+	Qd::IAstNode* root() const {
+		return program_.get();
+	}
+
+	bool hasErrors() const {
+		return !errors_.empty();
+	}
+
+	const std::vector<Qd::ErrorInfo>& errors() const {
+		return errors_;
+	}
+
+	void setText(const std::string& text) {
+		text_ = text;
+		parse();
+	}
+
+	// Replace the whole text without reparsing
+	void replaceText(const std::string& text) {
+		text_ = text;
+	}
+
+	// Replace a range given in LSP positions (0-based lines, UTF-16 characters)
+	//
+	// Like replaceText(), this only updates the text; call parse() once all
+	// changes of an edit are applied.
+	void applyChange(size_t startLine, size_t startCharacter, size_t endLine, size_t endCharacter,
+			const std::string& newText) {
+		Qd::SourceIndex index(text_.c_str());
+		size_t start = offsetOf(index, startLine, startCharacter);
+		size_t end = offsetOf(index, endLine, endCharacter);
+		if (end < start) {
+			end = start;
+		}
+		text_.replace(start, end - start, newText);
+	}
+
+	// Rebuild the AST from the text, reusing the pieces whose text is unchanged
+	void parse() {
+		std::multimap<std::string, std::unique_ptr<Chunk>> previous;
+		for (auto& chunk : chunks_) {
+			std::string key = chunk->text;
+			previous.emplace(std::move(key), std::move(chunk));
+		}
+		chunks_.clear();
+
+		size_t line = 0;
+		for (const auto& range : splitDeclarations(text_)) {
+			std::string chunkText = text_.substr(range.first, range.second - range.first);
+			std::unique_ptr<Chunk> chunk;
+			auto it = previous.find(chunkText);
+			if (it != previous.end()) {
+				chunk = std::move(it->second);
+				previous.erase(it);
+			} else {
+				chunk = std::make_unique<Chunk>();
+				chunk->text = chunkText;
+				chunk->root = chunk->ast.generate(chunk->text.c_str(), false, nullptr);
+				chunk->errors = chunk->ast.getErrors();
+			}
+			moveChunk(*chunk, line);
+			for (char c : chunkText) {
+				if (c == '\n') {
+					line++;
+				}
+			}
+			chunks_.push_back(std::move(chunk));
+		}
+
+		program_ = std::make_unique<Qd::AstProgram>();
+		errors_.clear();
+		for (const auto& chunk : chunks_) {
+			errors_.insert(errors_.end(), chunk->errors.begin(), chunk->errors.end());
+			if (!chunk->root) {
+				continue;
+			}
+			for (size_t i = 0; i < chunk->root->childCount(); i++) {
+				Qd::IAstNode* child = chunk->root->child(i);
+				child->setParent(program_.get());
+				program_->addChild(child);
+			}
+		}
+	}
+
+private:
+	struct Chunk {
+		size_t startLine = 0; // Document line the positions are relative to
+		std::string text;
+		Qd::Ast ast;
+		Qd::IAstNode* root = nullptr;
+		std::vector<Qd::ErrorInfo> errors;
+	};
+
+	// Move a chunk's nodes and errors so that it starts at the given line
+	static void moveChunk(Chunk& chunk, size_t line) {
+		if (chunk.startLine == line) {
+			return;
+		}
+		size_t from = chunk.startLine;
+		auto shift = [from, line](size_t position) {
+			// Nodes created without a position keep line 0
+			return position == 0 ? position : position - from + line;
+		};
+		if (chunk.root) {
+			moveNode(chunk.root, shift);
+		}
+		for (auto& error : chunk.errors) {
+			error.line = shift(error.line);
+		}
+		chunk.startLine = line;
+	}
+
+	template <typename Shift> static void moveNode(Qd::IAstNode* node, const Shift& shift) {
+		node->setPosition(shift(node->line()), node->column());
+		if (node->type() == Qd::IAstNode::Type::IMPORT_STATEMENT) {
+			// Imported functions and their parameters aren't children of the import
+			for (auto* function : static_cast<Qd::AstNodeImport*>(node)->functions()) {
+				function->line = shift(function->line);
+				for (auto* parameter : function->inputParameters) {
+					moveNode(parameter, shift);
+				}
+				for (auto* parameter : function->outputParameters) {
+					moveNode(parameter, shift);
+				}
+			}
+		}
+		for (size_t i = 0; i < node->childCount(); i++) {
+			if (Qd::IAstNode* child = node->child(i)) {
+				moveNode(child, shift);
+			}
+		}
+	}
+
+	// Byte ranges of the top-level declarations, covering the whole text
+	static std::vector<std::pair<size_t, size_t>> splitDeclarations(const std::string& text) {
+		std::vector<std::pair<size_t, size_t>> ranges;
+		size_t chunkStart = 0;
+		int depth = 0;
+		bool inString = false;
+		bool inLineComment = false;
+		bool inBlockComment = false;
+
+		for (size_t i = 0; i < text.size(); i++) {
+			char c = text[i];
+			bool lineStart = i == 0 || text[i - 1] == '\n';
+			if (lineStart && i > chunkStart && depth <= 0 && !inString && !inBlockComment && c != ' ' && c != '\t' &&
+					c != '\n' && c != '\r' && c != '}') {
+				ranges.push_back({chunkStart, i});
+				chunkStart = i;
+				depth = 0;
+			}
+
+			if (inLineComment) {
+				inLineComment = c != '\n';
+			} else if (inBlockComment) {
+				if (c == '*' && i + 1 < text.size() && text[i + 1] == '/') {
+					inBlockComment = false;
+					i++;
+				}
+			} else if (inString) {
+				if (c == '\\') {
+					i++;
+				} else if (c == '"') {
+					inString = false;
+				}
+			} else if (c == '"') {
+				inString = true;
+			} else if (c == '/' && i + 1 < text.size() && text[i + 1] == '/') {
+				inLineComment = true;
+				i++;
+			} else if (c == '/' && i + 1 < text.size() && text[i + 1] == '*') {
+				inBlockComment = true;
+				i++;
+			} else if (c == '{' || c == '(') {
+				depth++;
+			} else if (c == '}' || c == ')') {
+				depth--;
+			}
+		}
+		ranges.push_back({chunkStart, text.size()});
+		return ranges;
+	}
+
+	// Convert an LSP position to a byte offset
+	static size_t offsetOf(const Qd::SourceIndex& index, size_t line, size_t character) {
+		if (line >= index.lineCount()) {
+			return index.length();
+		}
+		size_t offset = index.lineStart(line + 1);
+		size_t lineEnd = index.lineEnd(line + 1);
+		const char* src = index.source();
+		while (character > 0 && offset < lineEnd) {
+			unsigned char c = static_cast<unsigned char>(src[offset]);
+			size_t width = 1;
+			if ((c & 0xE0) == 0xC0) {
+				width = 2;
+			} else if ((c & 0xF0) == 0xE0) {
+				width = 3;
+			} else if ((c & 0xF8) == 0xF0) {
+				width = 4;
+			}
+			// Characters outside the BMP are two UTF-16 code units
+			size_t units = width == 4 ? 2 : 1;
+			offset += width;
+			character = character > units ? character - units : 0;
+		}
+		return offset < lineEnd ? offset : lineEnd;
+	}
+
+	std::string text_;
+	std::vector<std::unique_ptr<Chunk>> chunks_;
+	std::unique_ptr<Qd::AstProgram> program_;
+	std::vector<Qd::ErrorInfo> errors_;
+};
+
+// Workspace-wide index of the symbols declared and referenced in .qd files
+//
+// Symbols are keyed by "module::name", where the module of a file is the
+// directory holding its module.qd. A plain identifier gets the module of
+// the file it appears in, so `helper` inside std/module.qd and `std::helper`
+// elsewhere share a key, and definitions and references of a symbol are a
+// single hash lookup. Only names that can refer to a module-level definition
+// are shared: locals and plain identifiers in files outside of modules stay
+// with their own document. The index is saved between sessions and entries
+// are reused as long as the file's modification time matches.
+class SymbolIndex {
+public:
+	struct Entry {
+		std::string name;
+		std::string module;
+		int kind;	   // LSP SymbolKind, 0 for references
+		size_t line;   // 0-based
+		size_t column; // 0-based byte column of the name
+	};
+
+	struct File {
+		int64_t modified = 0;
+		std::vector<Entry> definitions;
+		std::vector<Entry> references; // Including the declarations
+	};
+
+	struct Location {
+		const std::string* path;
+		const Entry* entry;
+	};
+
+	SymbolIndex() = default;
+	SymbolIndex(const SymbolIndex&) = delete;
+	SymbolIndex& operator=(const SymbolIndex&) = delete;
+
+	static std::string key(const std::string& module, const std::string& name) {
+		return module.empty() ? name : module + "::" + name;
+	}
+
+	// Module a file belongs to, or "" for files outside of modules
+	static std::string moduleOf(const std::string& path) {
+		std::filesystem::path dir = std::filesystem::path(path).parent_path();
+		std::error_code ec;
+		if (std::filesystem::exists(dir / "module.qd", ec)) {
+			return dir.filename().string();
+		}
+		return "";
+	}
+
+	// Names bound with `->` anywhere below node; identifiers with these names are locals, not symbols
+	static void collectLocals(Qd::IAstNode* node, std::set<std::string>& locals) {
+		if (!node) {
+			return;
+		}
+		if (node->type() == Qd::IAstNode::Type::LOCAL) {
+			locals.insert(static_cast<Qd::AstNodeLocal*>(node)->name());
+		}
+		for (size_t i = 0; i < node->childCount(); i++) {
+			collectLocals(node->child(i), locals);
+		}
+	}
+
+	static int64_t modificationTime(const std::string& path) {
+		std::error_code ec;
+		auto modified = std::filesystem::last_write_time(path, ec);
+		return ec ? 0 : static_cast<int64_t>(modified.time_since_epoch().count());
+	}
+
+	// Collect the symbols of a parsed file
+	static File scan(const std::string& path, const Document& document, int64_t modified) {
+		File file;
+		file.modified = modified;
+
+		Qd::IAstNode* root = document.root();
+		if (!root) {
+			return file;
+		}
+
+		std::string module = moduleOf(path);
+		Qd::SourceIndex index(document.text().c_str());
+		const std::string& text = document.text();
+
+		// Node columns point at or just past the name, so take the last whole-word
+		// match that starts before the column, or else the first one on the line
+		auto columnOf = [&](size_t line, size_t column, const std::string& name) -> size_t {
+			size_t start = index.lineStart(line);
+			std::string lineText = text.substr(start, index.lineEnd(line) - start);
+			auto isIdentifierChar = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+
+			size_t first = std::string::npos;
+			size_t best = std::string::npos;
+			for (size_t pos = lineText.find(name); pos != std::string::npos; pos = lineText.find(name, pos + 1)) {
+				size_t after = pos + name.size();
+				if ((pos > 0 && isIdentifierChar(lineText[pos - 1])) ||
+						(after < lineText.size() && isIdentifierChar(lineText[after]))) {
+					continue;
+				}
+				if (first == std::string::npos) {
+					first = pos;
+				}
+				if (pos < column) {
+					best = pos;
+				}
+			}
+			if (best != std::string::npos) {
+				return best;
+			}
+			return first != std::string::npos ? first : 0;
+		};
+
+		auto add = [&](std::vector<Entry>& entries, const std::string& name, const std::string& entryModule, int kind,
+						   size_t line, size_t column) {
+			size_t lspLine = line > 0 ? line - 1 : 0;
+			entries.push_back({name, entryModule, kind, lspLine, columnOf(line, column, name)});
+		};
+
+		// Declarations are on the first line of their node
+		for (size_t i = 0; i < root->childCount(); i++) {
+			Qd::IAstNode* child = root->child(i);
+			if (!child) {
+				continue;
+			}
+
+			if (child->type() == Qd::IAstNode::Type::FUNCTION_DECLARATION) {
+				auto* func = static_cast<Qd::AstNodeFunctionDeclaration*>(child);
+				add(file.definitions, func->name(), module, 12, func->line(), 0);
+			} else if (child->type() == Qd::IAstNode::Type::STRUCT_DECLARATION) {
+				auto* structNode = static_cast<Qd::AstNodeStructDeclaration*>(child);
+				add(file.definitions, structNode->name(), module, 23, structNode->line(), 0);
+			} else if (child->type() == Qd::IAstNode::Type::CONSTANT_DECLARATION) {
+				auto* constNode = static_cast<Qd::AstNodeConstant*>(child);
+				add(file.definitions, constNode->name(), module, 14, constNode->line(), 0);
+			} else if (child->type() == Qd::IAstNode::Type::IMPORT_STATEMENT) {
+				auto* importNode = static_cast<Qd::AstNodeImport*>(child);
+				for (const auto* importedFunc : importNode->functions()) {
+					add(file.definitions, importedFunc->name, module, 12, importedFunc->line, 0);
+				}
+			}
+		}
+		// Plain names in a file outside of modules can't be used from other files
+		if (!module.empty()) {
+			file.references = file.definitions;
+		}
+
+		std::set<std::string> locals;
+		std::function<void(Qd::IAstNode*)> visit = [&](Qd::IAstNode* node) {
+			if (!node) {
+				return;
+			}
+			if (node->type() == Qd::IAstNode::Type::IDENTIFIER) {
+				auto* ident = static_cast<Qd::AstNodeIdentifier*>(node);
+				if (!module.empty() && !locals.count(ident->name())) {
+					add(file.references, ident->name(), module, 0, ident->line(), ident->column());
+				}
+			} else if (node->type() == Qd::IAstNode::Type::SCOPED_IDENTIFIER) {
+				auto* scoped = static_cast<Qd::AstNodeScopedIdentifier*>(node);
+				add(file.references, scoped->name(), scoped->scope(), 0, scoped->line(), scoped->column());
+			}
+			for (size_t i = 0; i < node->childCount(); i++) {
+				visit(node->child(i));
+			}
+		};
+		for (size_t i = 0; i < root->childCount(); i++) {
+			locals.clear();
+			collectLocals(root->child(i), locals);
+			visit(root->child(i));
+		}
+
+		return file;
+	}
+
+	const File* file(const std::string& path) const {
+		auto it = files_.find(path);
+		return it != files_.end() ? &it->second : nullptr;
+	}
+
+	size_t size() const {
+		return files_.size();
+	}
+
+	void update(const std::string& path, File file) {
+		remove(path);
+		auto it = files_.emplace(path, std::move(file)).first;
+		for (const Entry& entry : it->second.definitions) {
+			definitions_[key(entry.module, entry.name)].push_back({&it->first, &entry});
+		}
+		for (const Entry& entry : it->second.references) {
+			references_[key(entry.module, entry.name)].push_back({&it->first, &entry});
+		}
+	}
+
+	void remove(const std::string& path) {
+		auto it = files_.find(path);
+		if (it == files_.end()) {
+			return;
+		}
+		unlink(definitions_, it->first, it->second.definitions);
+		unlink(references_, it->first, it->second.references);
+		files_.erase(it);
+	}
+
+	const std::vector<Location>& definitions(const std::string& symbolKey) const {
+		return lookup(definitions_, symbolKey);
+	}
+
+	const std::vector<Location>& references(const std::string& symbolKey) const {
+		return lookup(references_, symbolKey);
+	}
+
+	// Definitions whose name contains the query, ignoring case
+	std::vector<Location> search(const std::string& query, size_t limit) const {
+		auto lower = [](std::string s) {
+			std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return std::tolower(c); });
+			return s;
+		};
+		std::string needle = lower(query);
+
+		std::vector<Location> results;
+		for (const auto& [path, file] : files_) {
+			for (const Entry& entry : file.definitions) {
+				if (results.size() >= limit) {
+					return results;
+				}
+				if (lower(entry.name).find(needle) != std::string::npos) {
+					results.push_back({&path, &entry});
+				}
+			}
+		}
+		return results;
+	}
+
+	bool load(const std::string& cachePath) {
+		json_error_t error;
+		json_t* root = json_load_file(cachePath.c_str(), 0, &error);
+		if (!root) {
+			return false;
+		}
+
+		json_t* files = json_object_get(root, "files");
+		if (json_integer_value(json_object_get(root, "version")) != CACHE_VERSION || !json_is_object(files)) {
+			json_decref(root);
+			return false;
+		}
+
+		const char* path;
+		json_t* value;
+		json_object_foreach(files, path, value) {
+			File file;
+			file.modified = static_cast<int64_t>(json_integer_value(json_object_get(value, "modified")));
+			readEntries(json_object_get(value, "definitions"), file.definitions);
+			readEntries(json_object_get(value, "references"), file.references);
+			update(path, std::move(file));
+		}
+
+		json_decref(root);
+		return true;
+	}
+
+	bool save(const std::string& cachePath) const {
+		json_t* files = json_object();
+		for (const auto& [path, file] : files_) {
+			json_t* value = json_object();
+			json_object_set_new(value, "modified", json_integer(static_cast<json_int_t>(file.modified)));
+			json_object_set_new(value, "definitions", writeEntries(file.definitions));
+			json_object_set_new(value, "references", writeEntries(file.references));
+			json_object_set_new(files, path.c_str(), value);
+		}
+
+		json_t* root = json_object();
+		json_object_set_new(root, "version", json_integer(CACHE_VERSION));
+		json_object_set_new(root, "files", files);
+
+		std::error_code ec;
+		std::filesystem::create_directories(std::filesystem::path(cachePath).parent_path(), ec);
+		// Write to a temporary file first, so a concurrent session never reads a partial index
+		std::string tempPath = cachePath + ".tmp";
+		bool saved = json_dump_file(root, tempPath.c_str(), JSON_COMPACT) == 0;
+		if (saved) {
+			std::filesystem::rename(tempPath, cachePath, ec);
+			saved = !ec;
+		}
+		json_decref(root);
+		return saved;
+	}
+
+private:
+	static const int CACHE_VERSION = 2;
+
+	using Table = std::unordered_map<std::string, std::vector<Location>>;
+
+	static const std::vector<Location>& lookup(const Table& table, const std::string& symbolKey) {
+		static const std::vector<Location> none;
+		auto it = table.find(symbolKey);
+		return it != table.end() ? it->second : none;
+	}
+
+	static void unlink(Table& table, const std::string& path, const std::vector<Entry>& entries) {
+		for (const Entry& entry : entries) {
+			auto it = table.find(key(entry.module, entry.name));
+			if (it == table.end()) {
+				continue;
+			}
+			auto& locations = it->second;
+			locations.erase(std::remove_if(locations.begin(), locations.end(),
+									[&](const Location& location) { return location.path == &path; }),
+					locations.end());
+			if (locations.empty()) {
+				table.erase(it);
+			}
+		}
+	}
+
+	// Entries are stored as [name, module, kind, line, column]
+	static void readEntries(json_t* array, std::vector<Entry>& entries) {
+		for (size_t i = 0; i < json_array_size(array); i++) {
+			json_t* item = json_array_get(array, i);
+			const char* name = json_string_value(json_array_get(item, 0));
+			const char* module = json_string_value(json_array_get(item, 1));
+			if (!name || !module) {
+				continue;
+			}
+			entries.push_back({name, module, static_cast<int>(json_integer_value(json_array_get(item, 2))),
+					static_cast<size_t>(json_integer_value(json_array_get(item, 3))),
+					static_cast<size_t>(json_integer_value(json_array_get(item, 4)))});
+		}
+	}
+
+	static json_t* writeEntries(const std::vector<Entry>& entries) {
+		json_t* array = json_array();
+		for (const Entry& entry : entries) {
+			json_t* item = json_array();
+			json_array_append_new(item, json_string(entry.name.c_str()));
+			json_array_append_new(item, json_string(entry.module.c_str()));
+			json_array_append_new(item, json_integer(entry.kind));
+			json_array_append_new(item, json_integer(static_cast<json_int_t>(entry.line)));
+			json_array_append_new(item, json_integer(static_cast<json_int_t>(entry.column)));
+			json_array_append_new(array, item);
+		}
+		return array;
+	}
+
+	std::map<std::string, File> files_;
+	Table definitions_;
+	Table references_;
+};
+
 // LSP Server using jansson for JSON handling
 class QuadrateLSP {
 public:
@@ -49,17 +645,83 @@ public:
 	}
 
 	void run() {
+		// The hashtable seed must be set before objects are created on several threads
+		json_object_seed(0);
+
+		std::thread diagnostics(&QuadrateLSP::diagnosticsLoop, this);
+		std::thread reader(&QuadrateLSP::readLoop, this);
+
 		while (true) {
-			std::string message = readMessage();
-			if (message.empty()) {
+			json_t* message = nextMessage();
+			if (!message) {
 				break;
 			}
 
 			handleMessage(message);
 		}
+
+		reader.join();
+		if (indexer_.joinable()) {
+			indexer_.join();
+		}
+		{
+			std::lock_guard<std::mutex> lock(diagnosticsMutex_);
+			stopping_ = true;
+		}
+		diagnosticsReady_.notify_one();
+		diagnostics.join();
 	}
 
 private:
+	// Reads messages ahead of the main loop, so cancellations of queued requests are seen
+	void readLoop() {
+		while (true) {
+			std::string message = readMessage();
+			if (message.empty()) {
+				break;
+			}
+
+			json_error_t error;
+			json_t* root = json_loads(message.c_str(), 0, &error);
+			if (!root) {
+				continue; // Invalid JSON, ignore
+			}
+
+			std::lock_guard<std::mutex> lock(messagesMutex_);
+			if (getJsonString(root, "method") == "$/cancelRequest") {
+				std::string id = getRequestId(getJsonObject(root, "params"));
+				if (queuedRequests_.count(id) > 0) {
+					cancelledRequests_.insert(id);
+				}
+				json_decref(root);
+				continue;
+			}
+
+			std::string id = getRequestId(root);
+			if (!id.empty()) {
+				queuedRequests_.insert(id);
+			}
+			messages_.push_back(root);
+			messagesReady_.notify_one();
+		}
+
+		std::lock_guard<std::mutex> lock(messagesMutex_);
+		inputClosed_ = true;
+		messagesReady_.notify_one();
+	}
+
+	// Next queued message, or NULL at the end of input
+	json_t* nextMessage() {
+		std::unique_lock<std::mutex> lock(messagesMutex_);
+		messagesReady_.wait(lock, [this] { return !messages_.empty() || inputClosed_; });
+		if (messages_.empty()) {
+			return nullptr;
+		}
+		json_t* message = messages_.front();
+		messages_.pop_front();
+		return message;
+	}
+
 	std::string readMessage() {
 		std::string line;
 		size_t contentLength = 0;
@@ -89,6 +751,7 @@ private:
 	void sendMessage(json_t* json) {
 		char* message = json_dumps(json, JSON_COMPACT);
 		if (message) {
+			std::lock_guard<std::mutex> lock(outputMutex_);
 			std::cout << "Content-Length: " << strlen(message) << "\r\n\r\n" << message << std::flush;
 			free(message);
 		}
@@ -106,29 +769,54 @@ private:
 		return json_object_get(obj, key);
 	}
 
-	void handleMessage(const std::string& message) {
-		json_error_t error;
-		json_t* root = json_loads(message.c_str(), 0, &error);
-
-		if (!root) {
-			return; // Invalid JSON, ignore
+	size_t getJsonSize(json_t* obj, const char* key) {
+		json_t* val = json_object_get(obj, key);
+		if (val && json_is_integer(val) && json_integer_value(val) > 0) {
+			return static_cast<size_t>(json_integer_value(val));
 		}
+		return 0;
+	}
 
-		std::string method = getJsonString(root, "method");
-		std::string id = getJsonString(root, "id");
+	std::string getRequestId(json_t* obj) {
+		if (!obj) {
+			return "";
+		}
+		std::string id = getJsonString(obj, "id");
 
 		// If id is not string, try integer
 		if (id.empty()) {
-			json_t* id_json = json_object_get(root, "id");
+			json_t* id_json = json_object_get(obj, "id");
 			if (id_json && json_is_integer(id_json)) {
 				id = std::to_string(json_integer_value(id_json));
 			}
 		}
+		return id;
+	}
+
+	void handleMessage(json_t* root) {
+		std::string method = getJsonString(root, "method");
+		std::string id = getRequestId(root);
+
+		if (!id.empty()) {
+			bool cancelled;
+			{
+				std::lock_guard<std::mutex> lock(messagesMutex_);
+				queuedRequests_.erase(id);
+				cancelled = cancelledRequests_.erase(id) > 0;
+			}
+			if (cancelled) {
+				handleCancelled(id);
+				json_decref(root);
+				return;
+			}
+		}
 
 		if (method == "initialize") {
-			handleInitialize(id);
+			handleInitialize(id, getJsonObject(root, "params"));
 		} else if (method == "initialized") {
-			// Nothing to do
+			if (watchFiles_) {
+				registerFileWatcher();
+			}
 		} else if (method == "textDocument/didOpen") {
 			json_t* params = getJsonObject(root, "params");
 			if (params) {
@@ -146,14 +834,7 @@ private:
 				json_t* contentChanges = getJsonObject(params, "contentChanges");
 				if (textDoc && contentChanges && json_is_array(contentChanges)) {
 					std::string uri = getJsonString(textDoc, "uri");
-					// For full sync, contentChanges[0] contains the full document
-					if (json_array_size(contentChanges) > 0) {
-						json_t* change = json_array_get(contentChanges, 0);
-						std::string text = getJsonString(change, "text");
-						if (!text.empty()) {
-							handleDidOpen(uri, text);
-						}
-					}
+					handleDidChange(uri, contentChanges);
 				}
 			}
 		} else if (method == "textDocument/didSave") {
@@ -165,6 +846,8 @@ private:
 					std::string text = getJsonString(params, "text");
 					if (!text.empty()) {
 						handleDidOpen(uri, text);
+					} else {
+						indexDocument(uri);
 					}
 				}
 			}
@@ -243,76 +926,499 @@ private:
 					}
 				}
 			}
-		} else if (method == "textDocument/rename") {
-			json_t* params = getJsonObject(root, "params");
-			if (params) {
-				json_t* textDoc = getJsonObject(params, "textDocument");
-				json_t* position = getJsonObject(params, "position");
-				std::string newName = getJsonString(params, "newName");
-				if (textDoc && position && !newName.empty()) {
-					std::string uri = getJsonString(textDoc, "uri");
-					json_t* lineJson = json_object_get(position, "line");
-					json_t* charJson = json_object_get(position, "character");
-					if (lineJson && charJson && json_is_integer(lineJson) && json_is_integer(charJson)) {
-						size_t line = static_cast<size_t>(json_integer_value(lineJson));
-						size_t character = static_cast<size_t>(json_integer_value(charJson));
-						handleRename(id, uri, line, character, newName);
-					}
+		} else if (method == "textDocument/rename") {
+			json_t* params = getJsonObject(root, "params");
+			if (params) {
+				json_t* textDoc = getJsonObject(params, "textDocument");
+				json_t* position = getJsonObject(params, "position");
+				std::string newName = getJsonString(params, "newName");
+				if (textDoc && position && !newName.empty()) {
+					std::string uri = getJsonString(textDoc, "uri");
+					json_t* lineJson = json_object_get(position, "line");
+					json_t* charJson = json_object_get(position, "character");
+					if (lineJson && charJson && json_is_integer(lineJson) && json_is_integer(charJson)) {
+						size_t line = static_cast<size_t>(json_integer_value(lineJson));
+						size_t character = static_cast<size_t>(json_integer_value(charJson));
+						handleRename(id, uri, line, character, newName);
+					}
+				}
+			}
+		} else if (method == "workspace/symbol") {
+			json_t* params = getJsonObject(root, "params");
+			if (params) {
+				handleWorkspaceSymbol(id, getJsonString(params, "query"));
+			}
+		} else if (method == "workspace/didChangeWatchedFiles") {
+			json_t* params = getJsonObject(root, "params");
+			json_t* changes = params ? getJsonObject(params, "changes") : nullptr;
+			if (changes && json_is_array(changes)) {
+				handleDidChangeWatchedFiles(changes);
+			}
+		} else if (method == "shutdown") {
+			handleShutdown(id);
+		} else if (method == "exit") {
+			json_decref(root);
+			exit(0);
+		}
+
+		json_decref(root);
+	}
+
+	void handleInitialize(const std::string& id, json_t* params) {
+		startIndexer(params);
+
+		json_t* response = json_object();
+		json_object_set_new(response, "jsonrpc", json_string("2.0"));
+		json_object_set_new(response, "id", json_integer(std::stoi(id)));
+
+		json_t* result = json_object();
+		json_t* capabilities = json_object();
+
+		json_object_set_new(capabilities, "textDocumentSync", json_integer(2)); // Incremental sync
+		json_object_set_new(capabilities, "documentFormattingProvider", json_true());
+		json_object_set_new(capabilities, "hoverProvider", json_true());
+		json_object_set_new(capabilities, "documentSymbolProvider", json_true());
+		json_object_set_new(capabilities, "definitionProvider", json_true());
+		json_object_set_new(capabilities, "referencesProvider", json_true());
+		json_object_set_new(capabilities, "renameProvider", json_true());
+		json_object_set_new(capabilities, "workspaceSymbolProvider", json_true());
+
+		// Enable snippet support in completions
+		json_t* completionProvider = json_object();
+		json_object_set_new(completionProvider, "resolveProvider", json_false());
+		json_object_set_new(capabilities, "completionProvider", completionProvider);
+
+		json_object_set_new(result, "capabilities", capabilities);
+
+		json_t* serverInfo = json_object();
+		json_object_set_new(serverInfo, "name", json_string("quadlsp"));
+		json_object_set_new(serverInfo, "version", json_string("0.1.0"));
+		json_object_set_new(result, "serverInfo", serverInfo);
+
+		json_object_set_new(response, "result", result);
+
+		sendMessage(response);
+		json_decref(response);
+	}
+
+	void handleCancelled(const std::string& id) {
+		json_t* response = json_object();
+		json_object_set_new(response, "jsonrpc", json_string("2.0"));
+		json_object_set_new(response, "id", json_integer(std::stoi(id)));
+
+		json_t* error = json_object();
+		json_object_set_new(error, "code", json_integer(REQUEST_CANCELLED));
+		json_object_set_new(error, "message", json_string("Request cancelled"));
+		json_object_set_new(response, "error", error);
+
+		sendMessage(response);
+		json_decref(response);
+	}
+
+	void handleDidOpen(const std::string& uri, const std::string& text) {
+		Document& document = documents_[uri];
+		document.setText(text);
+		scheduleDiagnostics(uri, document.text());
+		indexDocument(uri);
+	}
+
+	void handleDidChange(const std::string& uri, json_t* contentChanges) {
+		Document& document = documents_[uri];
+		for (size_t i = 0; i < json_array_size(contentChanges); i++) {
+			json_t* change = json_array_get(contentChanges, i);
+			std::string text = getJsonString(change, "text");
+			json_t* range = getJsonObject(change, "range");
+			if (!range) {
+				// Full document
+				document.replaceText(text);
+				continue;
+			}
+
+			json_t* start = getJsonObject(range, "start");
+			json_t* end = getJsonObject(range, "end");
+			if (!start || !end) {
+				continue;
+			}
+			document.applyChange(getJsonSize(start, "line"), getJsonSize(start, "character"),
+					getJsonSize(end, "line"), getJsonSize(end, "character"), text);
+		}
+		document.parse();
+		scheduleDiagnostics(uri, document.text());
+	}
+
+	// Queue diagnostics for a document version; a newer version replaces a queued one
+	void scheduleDiagnostics(const std::string& uri, const std::string& text) {
+		{
+			std::lock_guard<std::mutex> lock(diagnosticsMutex_);
+			PendingDiagnostics& pending = pendingDiagnostics_[uri];
+			pending.text = text;
+			pending.due = std::chrono::steady_clock::now() + std::chrono::milliseconds(DIAGNOSTICS_DELAY_MS);
+		}
+		diagnosticsReady_.notify_one();
+	}
+
+	// Parses and validates documents in the background, so requests aren't blocked by validation
+	void diagnosticsLoop() {
+		// The worker's own copy of each document, as the validator annotates the AST
+		std::map<std::string, Document> documents;
+
+		std::unique_lock<std::mutex> lock(diagnosticsMutex_);
+		while (true) {
+			if (pendingDiagnostics_.empty()) {
+				if (stopping_) {
+					break;
+				}
+				diagnosticsReady_.wait(lock);
+				continue;
+			}
+
+			auto next = pendingDiagnostics_.begin();
+			for (auto it = pendingDiagnostics_.begin(); it != pendingDiagnostics_.end(); ++it) {
+				if (it->second.due < next->second.due) {
+					next = it;
+				}
+			}
+			// Wait for typing to pause, unless shutting down
+			if (!stopping_ && next->second.due > std::chrono::steady_clock::now()) {
+				diagnosticsReady_.wait_until(lock, next->second.due);
+				continue;
+			}
+
+			std::string uri = next->first;
+			std::string text = std::move(next->second.text);
+			pendingDiagnostics_.erase(next);
+			lock.unlock();
+
+			Document& document = documents[uri];
+			document.setText(text);
+			json_t* notification = buildDiagnostics(uri, document);
+
+			lock.lock();
+			// Drop results for a version that has been edited since
+			if (pendingDiagnostics_.count(uri) == 0) {
+				sendMessage(notification);
+			}
+			json_decref(notification);
+		}
+	}
+
+	// Open document, or the file on disk for other file:// URIs
+	const Document& findDocument(const std::string& uri) {
+		static const Document noDocument;
+
+		auto docIter = documents_.find(uri);
+		if (docIter != documents_.end()) {
+			return docIter->second;
+		}
+		if (uri.substr(0, 7) == "file://") {
+			const Document* file = loadFile(uri.substr(7));
+			if (file) {
+				return *file;
+			}
+		}
+		return noDocument;
+	}
+
+	// Parse a file from disk, cached until its modification time changes
+	const Document* loadFile(const std::string& path) {
+		std::error_code ec;
+		auto modified = std::filesystem::last_write_time(path, ec);
+		if (ec) {
+			return nullptr;
+		}
+
+		auto fileIter = files_.find(path);
+		if (fileIter != files_.end() && fileIter->second.modified == modified) {
+			return &fileIter->second.document;
+		}
+
+		std::ifstream file(path);
+		if (!file.good()) {
+			return nullptr;
+		}
+		std::stringstream buffer;
+		buffer << file.rdbuf();
+
+		CachedFile& cached = files_[path];
+		cached.modified = modified;
+		cached.document.setText(buffer.str());
+		return &cached.document;
+	}
+
+	static std::string normalizePath(const std::string& path) {
+		return std::filesystem::path(path).lexically_normal().string();
+	}
+
+	// Path of a file:// URI, or "" for other schemes
+	static std::string uriToPath(const std::string& uri) {
+		return uri.substr(0, 7) == "file://" ? normalizePath(uri.substr(7)) : "";
+	}
+
+	// Start indexing the workspace, stdlib and installed packages in the background
+	void startIndexer(json_t* params) {
+		if (indexer_.joinable()) {
+			return;
+		}
+
+		std::vector<std::string> roots;
+		json_t* folders = params ? getJsonObject(params, "workspaceFolders") : nullptr;
+		for (size_t i = 0; folders && i < json_array_size(folders); i++) {
+			std::string path = uriToPath(getJsonString(json_array_get(folders, i), "uri"));
+			if (!path.empty()) {
+				roots.push_back(path);
+			}
+		}
+		if (roots.empty() && params) {
+			std::string rootPath = uriToPath(getJsonString(params, "rootUri"));
+			if (rootPath.empty()) {
+				rootPath = getJsonString(params, "rootPath");
+			}
+			if (!rootPath.empty()) {
+				roots.push_back(normalizePath(rootPath));
+			}
+		}
+		std::string workspace = roots.empty() ? "" : roots.front();
+
+		// Same locations as resolveModulePath()
+		roots.push_back(getPackagesDir());
+		const char* quadrateRoot = getenv("QUADRATE_ROOT");
+		if (quadrateRoot) {
+			roots.push_back(quadrateRoot);
+		}
+		roots.push_back("/usr/share/quadrate");
+		const char* home = getenv("HOME");
+		if (home) {
+			roots.push_back(std::string(home) + "/quadrate");
+		}
+
+		// Check if the client can watch files for us
+		json_t* capabilities = params ? getJsonObject(params, "capabilities") : nullptr;
+		json_t* workspaceCaps = capabilities ? getJsonObject(capabilities, "workspace") : nullptr;
+		json_t* watched = workspaceCaps ? getJsonObject(workspaceCaps, "didChangeWatchedFiles") : nullptr;
+		watchFiles_ = watched && json_is_true(json_object_get(watched, "dynamicRegistration"));
+
+		std::string cachePath = getIndexCachePath(workspace);
+		indexer_ = std::thread(&QuadrateLSP::buildIndex, this, roots, cachePath);
+	}
+
+	// One index file per workspace in the user's cache directory
+	static std::string getIndexCachePath(const std::string& workspace) {
+		std::string cacheDir;
+		const char* xdgCacheHome = getenv("XDG_CACHE_HOME");
+		const char* home = getenv("HOME");
+		if (xdgCacheHome) {
+			cacheDir = xdgCacheHome;
+		} else if (home) {
+			cacheDir = std::string(home) + "/.cache";
+		} else {
+			return "";
+		}
+
+		std::stringstream name;
+		name << std::hex << std::hash<std::string>{}(workspace) << ".json";
+		return cacheDir + "/quadrate/quadlsp/" + name.str();
+	}
+
+	// All .qd files below the roots, skipping hidden directories
+	static std::vector<std::string> collectSourceFiles(const std::vector<std::string>& roots) {
+		std::set<std::string> paths;
+		for (const std::string& root : roots) {
+			std::error_code ec;
+			if (root.empty() || !std::filesystem::is_directory(root, ec)) {
+				continue;
+			}
+
+			auto options = std::filesystem::directory_options::skip_permission_denied;
+			std::filesystem::recursive_directory_iterator it(root, options, ec);
+			for (; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+				std::string name = it->path().filename().string();
+				if (it->is_directory(ec)) {
+					if (!name.empty() && name[0] == '.') {
+						it.disable_recursion_pending();
+					}
+				} else if (it->path().extension() == ".qd" && it->is_regular_file(ec)) {
+					paths.insert(normalizePath(it->path().string()));
+				}
+			}
+		}
+		return std::vector<std::string>(paths.begin(), paths.end());
+	}
+
+	// Runs on indexer_: scan all files in parallel, reusing the saved index for unchanged ones
+	void buildIndex(std::vector<std::string> roots, std::string cachePath) {
+		SymbolIndex cached;
+		if (!cachePath.empty()) {
+			cached.load(cachePath);
+		}
+
+		std::vector<std::string> paths = collectSourceFiles(roots);
+		std::vector<SymbolIndex::File> results(paths.size());
+
+		std::atomic<size_t> next(0);
+		auto worker = [&] {
+			for (size_t i = next++; i < paths.size(); i = next++) {
+				int64_t modified = SymbolIndex::modificationTime(paths[i]);
+				const SymbolIndex::File* previous = cached.file(paths[i]);
+				if (previous && previous->modified == modified) {
+					results[i] = *previous;
+					continue;
 				}
+
+				std::ifstream file(paths[i]);
+				std::stringstream buffer;
+				buffer << file.rdbuf();
+				Document document;
+				document.setText(buffer.str());
+				results[i] = SymbolIndex::scan(paths[i], document, modified);
 			}
-		} else if (method == "shutdown") {
-			handleShutdown(id);
-		} else if (method == "exit") {
-			json_decref(root);
-			exit(0);
+		};
+
+		size_t threadCount = std::max(1u, std::thread::hardware_concurrency());
+		threadCount = std::min(threadCount, paths.size());
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < threadCount; i++) {
+			workers.emplace_back(worker);
+		}
+		worker();
+		for (auto& thread : workers) {
+			thread.join();
 		}
 
-		json_decref(root);
+		std::lock_guard<std::mutex> lock(indexMutex_);
+		for (size_t i = 0; i < paths.size(); i++) {
+			// Files indexed on demand meanwhile are at least as recent
+			if (!index_.file(paths[i])) {
+				index_.update(paths[i], std::move(results[i]));
+			}
+		}
+		indexCachePath_ = cachePath;
+		indexBuilt_ = true;
+		indexReady_.notify_all();
+
+		if (!indexCachePath_.empty()) {
+			index_.save(indexCachePath_);
+		}
 	}
 
-	void handleInitialize(const std::string& id) {
-		json_t* response = json_object();
-		json_object_set_new(response, "jsonrpc", json_string("2.0"));
-		json_object_set_new(response, "id", json_integer(std::stoi(id)));
+	// Index a file on disk unless its entry is up to date
+	void indexFile(const std::string& path) {
+		int64_t modified = SymbolIndex::modificationTime(path);
+		{
+			std::lock_guard<std::mutex> lock(indexMutex_);
+			const SymbolIndex::File* file = index_.file(path);
+			if (file && file->modified == modified) {
+				return;
+			}
+		}
 
-		json_t* result = json_object();
-		json_t* capabilities = json_object();
+		const Document* document = loadFile(path);
+		std::lock_guard<std::mutex> lock(indexMutex_);
+		if (document) {
+			index_.update(path, SymbolIndex::scan(path, *document, modified));
+		} else {
+			index_.remove(path);
+		}
+	}
 
-		json_object_set_new(capabilities, "textDocumentSync", json_integer(1)); // Full sync
-		json_object_set_new(capabilities, "documentFormattingProvider", json_true());
-		json_object_set_new(capabilities, "hoverProvider", json_true());
-		json_object_set_new(capabilities, "documentSymbolProvider", json_true());
-		json_object_set_new(capabilities, "definitionProvider", json_true());
-		json_object_set_new(capabilities, "referencesProvider", json_true());
-		json_object_set_new(capabilities, "renameProvider", json_true());
+	// Index an open document, or the file on disk if it isn't open
+	void indexDocument(const std::string& uri) {
+		std::string path = uriToPath(uri);
+		if (path.empty()) {
+			return;
+		}
 
-		// Enable snippet support in completions
-		json_t* completionProvider = json_object();
-		json_object_set_new(completionProvider, "resolveProvider", json_false());
-		json_object_set_new(capabilities, "completionProvider", completionProvider);
+		auto docIter = documents_.find(uri);
+		if (docIter == documents_.end()) {
+			indexFile(path);
+			return;
+		}
 
-		json_object_set_new(result, "capabilities", capabilities);
+		SymbolIndex::File file = SymbolIndex::scan(path, docIter->second, SymbolIndex::modificationTime(path));
+		std::lock_guard<std::mutex> lock(indexMutex_);
+		index_.update(path, std::move(file));
+	}
 
-		json_t* serverInfo = json_object();
-		json_object_set_new(serverInfo, "name", json_string("quadlsp"));
-		json_object_set_new(serverInfo, "version", json_string("0.1.0"));
-		json_object_set_new(result, "serverInfo", serverInfo);
+	// Ask the client to send workspace/didChangeWatchedFiles for .qd files
+	void registerFileWatcher() {
+		json_t* watcher = json_object();
+		json_object_set_new(watcher, "globPattern", json_string("**/*.qd"));
+		json_t* watchers = json_array();
+		json_array_append_new(watchers, watcher);
 
-		json_object_set_new(response, "result", result);
+		json_t* registerOptions = json_object();
+		json_object_set_new(registerOptions, "watchers", watchers);
 
-		sendMessage(response);
-		json_decref(response);
+		json_t* registration = json_object();
+		json_object_set_new(registration, "id", json_string("quadlsp-watch-qd"));
+		json_object_set_new(registration, "method", json_string("workspace/didChangeWatchedFiles"));
+		json_object_set_new(registration, "registerOptions", registerOptions);
+
+		json_t* registrations = json_array();
+		json_array_append_new(registrations, registration);
+		json_t* params = json_object();
+		json_object_set_new(params, "registrations", registrations);
+
+		json_t* request = json_object();
+		json_object_set_new(request, "jsonrpc", json_string("2.0"));
+		json_object_set_new(request, "id", json_string("quadlsp-watch-qd"));
+		json_object_set_new(request, "method", json_string("client/registerCapability"));
+		json_object_set_new(request, "params", params);
+
+		sendMessage(request);
+		json_decref(request);
 	}
 
-	void handleDidOpen(const std::string& uri, const std::string& text) {
-		documents_[uri] = text;
-		publishDiagnostics(uri, text);
+	// LSP Range of the name of an index entry
+	static json_t* indexRange(const SymbolIndex::Entry& entry) {
+		json_t* range = json_object();
+		json_t* start = json_object();
+		json_object_set_new(start, "line", json_integer(static_cast<json_int_t>(entry.line)));
+		json_object_set_new(start, "character", json_integer(static_cast<json_int_t>(entry.column)));
+		json_object_set_new(range, "start", start);
+
+		json_t* end = json_object();
+		json_object_set_new(end, "line", json_integer(static_cast<json_int_t>(entry.line)));
+		json_object_set_new(
+				end, "character", json_integer(static_cast<json_int_t>(entry.column + entry.name.length())));
+		json_object_set_new(range, "end", end);
+		return range;
 	}
 
-	void publishDiagnostics(const std::string& uri, const std::string& text) {
-		// Parse using Ast class
-		Qd::Ast ast;
-		Qd::IAstNode* root = ast.generate(text.c_str(), false, nullptr);
+	// LSP Location of an index entry
+	static json_t* indexLocation(const std::string& path, const SymbolIndex::Entry& entry) {
+		json_t* location = json_object();
+		std::string uri = "file://" + path;
+		json_object_set_new(location, "uri", json_string(uri.c_str()));
+		json_object_set_new(location, "range", indexRange(entry));
+		return location;
+	}
+
+	// Index key of the word under the cursor in a file, or "" if it can only mean something in this document:
+	// a local of the function at line, or a plain name in a file outside of modules
+	static std::string symbolKey(Qd::IAstNode* root, const std::string& path, const std::string& word, size_t line) {
+		if (word.find("::") != std::string::npos) {
+			return word;
+		}
+		std::string module = SymbolIndex::moduleOf(path);
+		if (module.empty()) {
+			return "";
+		}
+
+		// Functions are top-level, so the one at the cursor is the last one starting before it
+		Qd::IAstNode* function = nullptr;
+		for (size_t i = 0; root && i < root->childCount(); i++) {
+			Qd::IAstNode* child = root->child(i);
+			if (child && child->type() == Qd::IAstNode::Type::FUNCTION_DECLARATION && child->line() <= line + 1) {
+				function = child;
+			}
+		}
+		std::set<std::string> locals;
+		SymbolIndex::collectLocals(function, locals);
+		return locals.count(word) ? "" : SymbolIndex::key(module, word);
+	}
+
+	json_t* buildDiagnostics(const std::string& uri, const Document& document) {
+		Qd::IAstNode* root = document.root();
 
 		json_t* notification = json_object();
 		json_object_set_new(notification, "jsonrpc", json_string("2.0"));
@@ -324,8 +1430,8 @@ private:
 		json_t* diagnostics = json_array();
 
 		// First, show parse errors from AST
-		if (ast.hasErrors()) {
-			const auto& errors = ast.getErrors();
+		if (document.hasErrors()) {
+			const auto& errors = document.errors();
 			for (const auto& error : errors) {
 				json_t* diag = json_object();
 
@@ -354,7 +1460,7 @@ private:
 		}
 
 		// If parsing succeeded, run semantic validation to catch unresolved symbols, etc.
-		if (root && !ast.hasErrors()) {
+		if (root && !document.hasErrors()) {
 			Qd::SemanticValidator validator;
 			validator.setStoreErrors(true);
 
@@ -395,8 +1501,7 @@ private:
 		json_object_set_new(params, "diagnostics", diagnostics);
 		json_object_set_new(notification, "params", params);
 
-		sendMessage(notification);
-		json_decref(notification);
+		return notification;
 	}
 
 	void handleFormatting(const std::string& id, const std::string& uri) {
@@ -436,25 +1541,11 @@ private:
 		}
 
 		// Add user-defined functions from the current document
-		std::string documentText;
-		auto docIter = documents_.find(uri);
-		if (docIter != documents_.end()) {
-			documentText = docIter->second;
-		} else {
-			// Try to read file from disk if it's a file:// URI
-			if (uri.substr(0, 7) == "file://") {
-				std::string filePath = uri.substr(7);
-				std::ifstream file(filePath);
-				if (file.good()) {
-					std::stringstream buffer;
-					buffer << file.rdbuf();
-					documentText = buffer.str();
-				}
-			}
-		}
+		const Document& document = findDocument(uri);
+		const std::string& documentText = document.text();
 
 		if (!documentText.empty()) {
-			std::vector<FunctionInfo> functions = extractFunctions(documentText);
+			std::vector<FunctionInfo> functions = extractFunctions(document);
 
 			for (const auto& func : functions) {
 				json_t* item = json_object();
@@ -502,7 +1593,7 @@ private:
 		}
 
 		// Add struct completions
-		std::vector<StructInfo> structs = extractStructs(documentText);
+		std::vector<StructInfo> structs = extractStructs(document);
 		for (const auto& structInfo : structs) {
 			json_t* item = json_object();
 			json_object_set_new(item, "label", json_string(structInfo.name.c_str()));
@@ -587,20 +1678,18 @@ private:
 		return "";
 	}
 
-	std::string getWordAtPosition(const std::string& text, size_t line, size_t character) {
-		// Split text into lines
-		std::vector<std::string> lines;
-		std::istringstream stream(text);
-		std::string currentLine;
-		while (std::getline(stream, currentLine)) {
-			lines.push_back(currentLine);
-		}
-
-		if (line >= lines.size()) {
+	// Get a line of the document (0-based, as in LSP positions)
+	std::string getLine(const std::string& text, size_t line) {
+		Qd::SourceIndex index(text.c_str());
+		if (line >= index.lineCount()) {
 			return "";
 		}
+		size_t start = index.lineStart(line + 1);
+		return text.substr(start, index.lineEnd(line + 1) - start);
+	}
 
-		const std::string& targetLine = lines[line];
+	std::string getWordAtPosition(const std::string& text, size_t line, size_t character) {
+		const std::string targetLine = getLine(text, line);
 		if (character >= targetLine.length()) {
 			return "";
 		}
@@ -633,22 +1722,8 @@ private:
 		json_object_set_new(response, "id", json_integer(std::stoi(id)));
 
 		// Get document text
-		std::string documentText;
-		auto docIter = documents_.find(uri);
-		if (docIter != documents_.end()) {
-			documentText = docIter->second;
-		} else {
-			// Try to read from disk
-			if (uri.substr(0, 7) == "file://") {
-				std::string filePath = uri.substr(7);
-				std::ifstream file(filePath);
-				if (file.good()) {
-					std::stringstream buffer;
-					buffer << file.rdbuf();
-					documentText = buffer.str();
-				}
-			}
-		}
+		const Document& document = findDocument(uri);
+		const std::string& documentText = document.text();
 
 		json_t* result = json_null();
 
@@ -668,7 +1743,7 @@ private:
 					json_object_set_new(result, "contents", contents);
 				} else {
 					// Check if it's a user-defined function
-					std::vector<FunctionInfo> functions = extractFunctions(documentText);
+					std::vector<FunctionInfo> functions = extractFunctions(document);
 					for (const auto& func : functions) {
 						if (func.name == word) {
 							// Build documentation for user function
@@ -717,17 +1792,12 @@ private:
 						std::string modulePath = resolveModulePath(moduleName, sourceDir);
 
 						if (!modulePath.empty()) {
-							// Read and parse the module file
-							std::ifstream file(modulePath);
-							if (file.good()) {
-								std::stringstream buffer;
-								buffer << file.rdbuf();
-								std::string moduleText = buffer.str();
+							// Parse the module file (cached until it changes)
+							const Document* module = loadFile(modulePath);
+							if (module) {
+								Qd::IAstNode* root = module->root();
 
-								Qd::Ast ast;
-								Qd::IAstNode* root = ast.generate(moduleText.c_str(), false, nullptr);
-
-								if (root && !ast.hasErrors() && root->type() == Qd::IAstNode::Type::PROGRAM) {
+								if (root && !module->hasErrors() && root->type() == Qd::IAstNode::Type::PROGRAM) {
 									// Search for the symbol
 									for (size_t i = 0; i < root->childCount(); i++) {
 										Qd::IAstNode* child = root->child(i);
@@ -840,31 +1910,16 @@ private:
 		json_object_set_new(response, "id", json_integer(std::stoi(id)));
 
 		// Get document text
-		std::string documentText;
-		auto docIter = documents_.find(uri);
-		if (docIter != documents_.end()) {
-			documentText = docIter->second;
-		} else {
-			// Try to read from disk
-			if (uri.substr(0, 7) == "file://") {
-				std::string filePath = uri.substr(7);
-				std::ifstream file(filePath);
-				if (file.good()) {
-					std::stringstream buffer;
-					buffer << file.rdbuf();
-					documentText = buffer.str();
-				}
-			}
-		}
+		const Document& document = findDocument(uri);
+		const std::string& documentText = document.text();
 
 		json_t* symbols = json_array();
 
 		if (!documentText.empty()) {
 			// Parse the document
-			Qd::Ast ast;
-			Qd::IAstNode* root = ast.generate(documentText.c_str(), false, nullptr);
+			Qd::IAstNode* root = document.root();
 
-			if (root && !ast.hasErrors() && root->type() == Qd::IAstNode::Type::PROGRAM) {
+			if (root && !document.hasErrors() && root->type() == Qd::IAstNode::Type::PROGRAM) {
 				// Iterate through program children looking for functions and imports
 				for (size_t i = 0; i < root->childCount(); i++) {
 					Qd::IAstNode* child = root->child(i);
@@ -1177,130 +2232,23 @@ private:
 		return "";
 	}
 
-	// Find a function or constant definition in an external module file
+	// Find a function, constant or struct definition in an external module
 	// Returns a JSON location object if found, or json_null() if not found
-	json_t* findDefinitionInModule(const std::string& modulePath, const std::string& symbolName, const std::string& symbolType) {
-		// Read the module file
-		std::ifstream file(modulePath);
-		if (!file.good()) {
-			return json_null();
-		}
-
-		std::stringstream buffer;
-		buffer << file.rdbuf();
-		std::string moduleText = buffer.str();
-
-		// Parse the module file
-		Qd::Ast ast;
-		Qd::IAstNode* root = ast.generate(moduleText.c_str(), false, nullptr);
-
-		if (!root || ast.hasErrors() || root->type() != Qd::IAstNode::Type::PROGRAM) {
-			return json_null();
-		}
-
-		// Search for the definition
-		for (size_t i = 0; i < root->childCount(); i++) {
-			Qd::IAstNode* child = root->child(i);
-
-			if (symbolType == "function" && child && child->type() == Qd::IAstNode::Type::FUNCTION_DECLARATION) {
-				Qd::AstNodeFunctionDeclaration* funcNode = static_cast<Qd::AstNodeFunctionDeclaration*>(child);
-				if (funcNode->name() == symbolName) {
-					// Found the function definition
-					json_t* location = json_object();
-					std::string moduleUri = "file://" + modulePath;
-					json_object_set_new(location, "uri", json_string(moduleUri.c_str()));
-
-					json_t* range = json_object();
-					json_t* start = json_object();
-					size_t lspLine = (funcNode->line() > 0) ? funcNode->line() - 1 : 0;
-					json_object_set_new(start, "line", json_integer(static_cast<json_int_t>(lspLine)));
-					json_object_set_new(start, "character", json_integer(0));
-					json_object_set_new(range, "start", start);
-
-					json_t* end = json_object();
-					json_object_set_new(end, "line", json_integer(static_cast<json_int_t>(lspLine)));
-					json_object_set_new(end, "character", json_integer(static_cast<json_int_t>(funcNode->name().length())));
-					json_object_set_new(range, "end", end);
-
-					json_object_set_new(location, "range", range);
-					return location;
-				}
-			} else if (symbolType == "constant" && child && child->type() == Qd::IAstNode::Type::CONSTANT_DECLARATION) {
-				Qd::AstNodeConstant* constNode = static_cast<Qd::AstNodeConstant*>(child);
-				if (constNode->name() == symbolName) {
-					// Found the constant definition
-					json_t* location = json_object();
-					std::string moduleUri = "file://" + modulePath;
-					json_object_set_new(location, "uri", json_string(moduleUri.c_str()));
-
-					json_t* range = json_object();
-					json_t* start = json_object();
-					size_t lspLine = (constNode->line() > 0) ? constNode->line() - 1 : 0;
-					json_object_set_new(start, "line", json_integer(static_cast<json_int_t>(lspLine)));
-					json_object_set_new(start, "character", json_integer(0));
-					json_object_set_new(range, "start", start);
-
-					json_t* end = json_object();
-					json_object_set_new(end, "line", json_integer(static_cast<json_int_t>(lspLine)));
-					json_object_set_new(end, "character", json_integer(static_cast<json_int_t>(constNode->name().length())));
-					json_object_set_new(range, "end", end);
-
-					json_object_set_new(location, "range", range);
-					return location;
-				}
-			} else if (symbolType == "struct" && child && child->type() == Qd::IAstNode::Type::STRUCT_DECLARATION) {
-				Qd::AstNodeStructDeclaration* structNode = static_cast<Qd::AstNodeStructDeclaration*>(child);
-				if (structNode->name() == symbolName) {
-					// Found the struct definition
-					json_t* location = json_object();
-					std::string moduleUri = "file://" + modulePath;
-					json_object_set_new(location, "uri", json_string(moduleUri.c_str()));
-
-					json_t* range = json_object();
-					json_t* start = json_object();
-					size_t lspLine = (structNode->line() > 0) ? structNode->line() - 1 : 0;
-					json_object_set_new(start, "line", json_integer(static_cast<json_int_t>(lspLine)));
-					json_object_set_new(start, "character", json_integer(0));
-					json_object_set_new(range, "start", start);
-
-					json_t* end = json_object();
-					json_object_set_new(end, "line", json_integer(static_cast<json_int_t>(lspLine)));
-					json_object_set_new(end, "character", json_integer(static_cast<json_int_t>(structNode->name().length())));
-					json_object_set_new(range, "end", end);
-
-					json_object_set_new(location, "range", range);
-					return location;
-				}
-			} else if (symbolType == "function" && child && child->type() == Qd::IAstNode::Type::IMPORT_STATEMENT) {
-				// Check for imported functions (like those in stdlib modules)
-				Qd::AstNodeImport* importNode = static_cast<Qd::AstNodeImport*>(child);
-				const auto& importedFuncs = importNode->functions();
-				for (const auto* importedFunc : importedFuncs) {
-					if (importedFunc->name == symbolName) {
-						// Found the imported function declaration
-						json_t* location = json_object();
-						std::string moduleUri = "file://" + modulePath;
-						json_object_set_new(location, "uri", json_string(moduleUri.c_str()));
-
-						json_t* range = json_object();
-						json_t* start = json_object();
-						size_t lspLine = (importedFunc->line > 0) ? importedFunc->line - 1 : 0;
-						json_object_set_new(start, "line", json_integer(static_cast<json_int_t>(lspLine)));
-						json_object_set_new(start, "character", json_integer(0));
-						json_object_set_new(range, "start", start);
-
-						json_t* end = json_object();
-						json_object_set_new(end, "line", json_integer(static_cast<json_int_t>(lspLine)));
-						json_object_set_new(end, "character", json_integer(static_cast<json_int_t>(importedFunc->name.length())));
-						json_object_set_new(range, "end", end);
-
-						json_object_set_new(location, "range", range);
-						return location;
-					}
-				}
+	json_t* findDefinitionInModule(const std::string& modulePath, const std::string& symbolName) {
+		// Modules outside of the indexed directories are indexed on first use
+		std::string path = normalizePath(modulePath);
+		indexFile(path);
+
+		std::filesystem::path moduleDir = std::filesystem::path(path).parent_path();
+		std::string key = SymbolIndex::key(SymbolIndex::moduleOf(path), symbolName);
+
+		std::lock_guard<std::mutex> lock(indexMutex_);
+		for (const auto& location : index_.definitions(key)) {
+			// Several installed packages may provide a module of the same name
+			if (std::filesystem::path(*location.path).parent_path() == moduleDir) {
+				return indexLocation(*location.path, *location.entry);
 			}
 		}
-
 		return json_null();
 	}
 
@@ -1481,17 +2429,12 @@ private:
 				// Resolve module path
 				std::string modulePath = resolveModulePath(moduleName, sourceDir);
 				if (!modulePath.empty()) {
-					// Parse the module file
-					std::ifstream moduleFile(modulePath);
-					if (moduleFile.good()) {
-						std::stringstream buffer;
-						buffer << moduleFile.rdbuf();
-						std::string moduleContent = buffer.str();
+					// Parse the module file (cached until it changes)
+					const Document* module = loadFile(modulePath);
+					if (module) {
+						Qd::IAstNode* moduleRoot = module->root();
 
-						Qd::Ast moduleAst;
-						Qd::IAstNode* moduleRoot = moduleAst.generate(moduleContent.c_str(), false, nullptr);
-
-						if (moduleRoot && !moduleAst.hasErrors()) {
+						if (moduleRoot && !module->hasErrors()) {
 							// Find the struct in the module
 							for (size_t i = 0; i < moduleRoot->childCount(); i++) {
 								Qd::IAstNode* child = moduleRoot->child(i);
@@ -1575,22 +2518,8 @@ private:
 		json_object_set_new(response, "id", json_integer(std::stoi(id)));
 
 		// Get document text
-		std::string documentText;
-		auto docIter = documents_.find(uri);
-		if (docIter != documents_.end()) {
-			documentText = docIter->second;
-		} else {
-			// Try to read from disk
-			if (uri.substr(0, 7) == "file://") {
-				std::string filePath = uri.substr(7);
-				std::ifstream file(filePath);
-				if (file.good()) {
-					std::stringstream buffer;
-					buffer << file.rdbuf();
-					documentText = buffer.str();
-				}
-			}
-		}
+		const Document& document = findDocument(uri);
+		const std::string& documentText = document.text();
 
 		json_t* result = json_null();
 
@@ -1599,21 +2528,13 @@ private:
 
 			if (!word.empty()) {
 				// Parse the document
-				Qd::Ast ast;
-				Qd::IAstNode* root = ast.generate(documentText.c_str(), false, nullptr);
+				Qd::IAstNode* root = document.root();
 
-				if (root && !ast.hasErrors() && root->type() == Qd::IAstNode::Type::PROGRAM) {
+				if (root && !document.hasErrors() && root->type() == Qd::IAstNode::Type::PROGRAM) {
 					// Check if we're in a field access expression (v@x)
 					// Find the character at the cursor position to see if @ is nearby
-					std::vector<std::string> lines;
-					std::istringstream stream(documentText);
-					std::string currentLine;
-					while (std::getline(stream, currentLine)) {
-						lines.push_back(currentLine);
-					}
-
-					if (line < lines.size()) {
-						const std::string& targetLine = lines[line];
+					const std::string targetLine = getLine(documentText, line);
+					if (!targetLine.empty()) {
 						// Look for @ before or after the cursor
 						bool inFieldAccess = false;
 						bool cursorOnVariable = false;
@@ -1804,13 +2725,19 @@ private:
 						std::string modulePath = resolveModulePath(moduleName, sourceDir);
 
 						if (!modulePath.empty()) {
-							// Try to find the symbol as a function first, then as a constant, then as a struct
-							result = findDefinitionInModule(modulePath, symbolName, "function");
-							if (json_is_null(result)) {
-								result = findDefinitionInModule(modulePath, symbolName, "constant");
-							}
-							if (json_is_null(result)) {
-								result = findDefinitionInModule(modulePath, symbolName, "struct");
+							result = findDefinitionInModule(modulePath, symbolName);
+						}
+					}
+
+					// Finally, other files of the same module
+					std::string path = uriToPath(uri);
+					std::string key = symbolKey(root, path, word, line);
+					if (json_is_null(result) && !path.empty() && !key.empty() && key != word) {
+						std::lock_guard<std::mutex> lock(indexMutex_);
+						for (const auto& location : index_.definitions(key)) {
+							if (*location.path != path) {
+								result = indexLocation(*location.path, *location.entry);
+								break;
 							}
 						}
 					}
@@ -1829,22 +2756,8 @@ private:
 		json_object_set_new(response, "id", json_integer(std::stoi(id)));
 
 		// Get document text
-		std::string documentText;
-		auto docIter = documents_.find(uri);
-		if (docIter != documents_.end()) {
-			documentText = docIter->second;
-		} else {
-			// Try to read from disk
-			if (uri.substr(0, 7) == "file://") {
-				std::string filePath = uri.substr(7);
-				std::ifstream file(filePath);
-				if (file.good()) {
-					std::stringstream buffer;
-					buffer << file.rdbuf();
-					documentText = buffer.str();
-				}
-			}
-		}
+		const Document& document = findDocument(uri);
+		const std::string& documentText = document.text();
 
 		json_t* locations = json_array();
 
@@ -1853,10 +2766,9 @@ private:
 
 			if (!word.empty()) {
 				// Parse the document
-				Qd::Ast ast;
-				Qd::IAstNode* root = ast.generate(documentText.c_str(), false, nullptr);
+				Qd::IAstNode* root = document.root();
 
-				if (root && !ast.hasErrors()) {
+				if (root && !document.hasErrors()) {
 					// Find all references to this identifier
 					std::vector<Qd::IAstNode*> references;
 					findIdentifiersInNode(root, word, references);
@@ -1888,6 +2800,18 @@ private:
 						json_object_set_new(location, "range", range);
 						json_array_append_new(locations, location);
 					}
+
+					// Other files from the workspace index
+					std::string path = uriToPath(uri);
+					std::string key = path.empty() ? "" : symbolKey(root, path, word, line);
+					if (!key.empty()) {
+						std::lock_guard<std::mutex> lock(indexMutex_);
+						for (const auto& location : index_.references(key)) {
+							if (*location.path != path) {
+								json_array_append_new(locations, indexLocation(*location.path, *location.entry));
+							}
+						}
+					}
 				}
 			}
 		}
@@ -1904,22 +2828,8 @@ private:
 		json_object_set_new(response, "id", json_integer(std::stoi(id)));
 
 		// Get document text
-		std::string documentText;
-		auto docIter = documents_.find(uri);
-		if (docIter != documents_.end()) {
-			documentText = docIter->second;
-		} else {
-			// Try to read from disk
-			if (uri.substr(0, 7) == "file://") {
-				std::string filePath = uri.substr(7);
-				std::ifstream file(filePath);
-				if (file.good()) {
-					std::stringstream buffer;
-					buffer << file.rdbuf();
-					documentText = buffer.str();
-				}
-			}
-		}
+		const Document& document = findDocument(uri);
+		const std::string& documentText = document.text();
 
 		json_t* workspaceEdit = json_object();
 		json_t* changes = json_object();
@@ -1929,10 +2839,9 @@ private:
 
 			if (!word.empty()) {
 				// Parse the document
-				Qd::Ast ast;
-				Qd::IAstNode* root = ast.generate(documentText.c_str(), false, nullptr);
+				Qd::IAstNode* root = document.root();
 
-				if (root && !ast.hasErrors()) {
+				if (root && !document.hasErrors()) {
 					// Find all references to rename
 					std::vector<Qd::IAstNode*> references;
 					findIdentifiersInNode(root, word, references);
@@ -1969,6 +2878,34 @@ private:
 					}
 
 					json_object_set_new(changes, uri.c_str(), edits);
+
+					// Other files from the workspace index, where only the name part is replaced
+					std::string path = uriToPath(uri);
+					std::string key = path.empty() ? "" : symbolKey(root, path, word, line);
+					if (!key.empty()) {
+						size_t scopeEnd = newName.rfind("::");
+						std::string newSymbolName =
+								scopeEnd == std::string::npos ? newName : newName.substr(scopeEnd + 2);
+
+						std::lock_guard<std::mutex> lock(indexMutex_);
+						for (const auto& location : index_.references(key)) {
+							if (*location.path == path) {
+								continue;
+							}
+
+							std::string fileUri = "file://" + *location.path;
+							json_t* fileEdits = json_object_get(changes, fileUri.c_str());
+							if (!fileEdits) {
+								fileEdits = json_array();
+								json_object_set_new(changes, fileUri.c_str(), fileEdits);
+							}
+
+							json_t* edit = json_object();
+							json_object_set_new(edit, "range", indexRange(*location.entry));
+							json_object_set_new(edit, "newText", json_string(newSymbolName.c_str()));
+							json_array_append_new(fileEdits, edit);
+						}
+					}
 				}
 			}
 		}
@@ -1979,7 +2916,62 @@ private:
 		json_decref(response);
 	}
 
+	void handleWorkspaceSymbol(const std::string& id, const std::string& query) {
+		json_t* response = json_object();
+		json_object_set_new(response, "jsonrpc", json_string("2.0"));
+		json_object_set_new(response, "id", json_integer(std::stoi(id)));
+
+		json_t* symbols = json_array();
+		{
+			// Answer from the complete index
+			std::unique_lock<std::mutex> lock(indexMutex_);
+			if (indexer_.joinable()) {
+				indexReady_.wait(lock, [this] { return indexBuilt_; });
+			}
+
+			for (const auto& location : index_.search(query, WORKSPACE_SYMBOL_LIMIT)) {
+				json_t* symbol = json_object();
+				json_object_set_new(symbol, "name", json_string(location.entry->name.c_str()));
+				json_object_set_new(symbol, "kind", json_integer(location.entry->kind));
+				json_object_set_new(symbol, "location", indexLocation(*location.path, *location.entry));
+				if (!location.entry->module.empty()) {
+					json_object_set_new(symbol, "containerName", json_string(location.entry->module.c_str()));
+				}
+				json_array_append_new(symbols, symbol);
+			}
+		}
+
+		json_object_set_new(response, "result", symbols);
+		sendMessage(response);
+		json_decref(response);
+	}
+
+	void handleDidChangeWatchedFiles(json_t* changes) {
+		for (size_t i = 0; i < json_array_size(changes); i++) {
+			json_t* change = json_array_get(changes, i);
+			std::string path = uriToPath(getJsonString(change, "uri"));
+			if (path.empty()) {
+				continue;
+			}
+
+			// FileChangeType: 1 = created, 2 = changed, 3 = deleted
+			if (json_integer_value(json_object_get(change, "type")) == 3) {
+				std::lock_guard<std::mutex> lock(indexMutex_);
+				index_.remove(path);
+			} else if (std::filesystem::path(path).extension() == ".qd") {
+				indexFile(path);
+			}
+		}
+	}
+
 	void handleShutdown(const std::string& id) {
+		{
+			std::lock_guard<std::mutex> lock(indexMutex_);
+			if (indexBuilt_ && !indexCachePath_.empty()) {
+				index_.save(indexCachePath_);
+			}
+		}
+
 		json_t* response = json_object();
 		json_object_set_new(response, "jsonrpc", json_string("2.0"));
 		json_object_set_new(response, "id", json_integer(std::stoi(id)));
@@ -1989,14 +2981,11 @@ private:
 		json_decref(response);
 	}
 
-	std::vector<FunctionInfo> extractFunctions(const std::string& text) {
+	std::vector<FunctionInfo> extractFunctions(const Document& document) {
 		std::vector<FunctionInfo> functions;
 
-		// Parse the document
-		Qd::Ast ast;
-		Qd::IAstNode* root = ast.generate(text.c_str(), false, nullptr);
-
-		if (!root || ast.hasErrors()) {
+		Qd::IAstNode* root = document.root();
+		if (!root || document.hasErrors()) {
 			return functions; // Return empty on parse errors
 		}
 
@@ -2146,14 +3135,11 @@ private:
 		return functions;
 	}
 
-	std::vector<StructInfo> extractStructs(const std::string& text) {
+	std::vector<StructInfo> extractStructs(const Document& document) {
 		std::vector<StructInfo> structs;
 
-		// Parse the document
-		Qd::Ast ast;
-		Qd::IAstNode* root = ast.generate(text.c_str(), false, nullptr);
-
-		if (!root || ast.hasErrors()) {
+		Qd::IAstNode* root = document.root();
+		if (!root || document.hasErrors()) {
 			return structs; // Return empty on parse errors
 		}
 
@@ -2190,7 +3176,43 @@ private:
 		return structs;
 	}
 
-	std::map<std::string, std::string> documents_;
+	struct CachedFile {
+		std::filesystem::file_time_type modified;
+		Document document;
+	};
+
+	struct PendingDiagnostics {
+		std::string text;
+		std::chrono::steady_clock::time_point due;
+	};
+
+	std::map<std::string, Document> documents_;
+	std::map<std::string, CachedFile> files_;
+
+	// Messages read ahead by readLoop()
+	std::mutex messagesMutex_;
+	std::condition_variable messagesReady_;
+	std::deque<json_t*> messages_;
+	std::set<std::string> queuedRequests_;
+	std::set<std::string> cancelledRequests_;
+	bool inputClosed_ = false;
+
+	// Documents waiting for diagnosticsLoop()
+	std::mutex diagnosticsMutex_;
+	std::condition_variable diagnosticsReady_;
+	std::map<std::string, PendingDiagnostics> pendingDiagnostics_;
+	bool stopping_ = false;
+
+	// Workspace symbol index, filled by buildIndex() on indexer_
+	std::mutex indexMutex_;
+	std::condition_variable indexReady_;
+	SymbolIndex index_;
+	std::string indexCachePath_;
+	bool indexBuilt_ = false;
+	bool watchFiles_ = false;
+	std::thread indexer_;
+
+	std::mutex outputMutex_;
 	[[maybe_unused]] int messageId_;
 };
 
@@ -2210,8 +3232,9 @@ void printHelp() {
 	std::cout << "  - Hover documentation\n";
 	std::cout << "  - Document symbols (outline view of functions and imports)\n";
 	std::cout << "  - Go to definition (jump to function declarations)\n";
-	std::cout << "  - Find references (locate all function calls)\n";
-	std::cout << "  - Rename symbol (rename functions across the file)\n";
+	std::cout << "  - Find references (locate all function calls in the workspace)\n";
+	std::cout << "  - Rename symbol (rename functions across the workspace)\n";
+	std::cout << "  - Workspace symbols (search functions, structs and constants)\n";
 }
 
 void printVersion() {
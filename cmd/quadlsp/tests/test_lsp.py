@@ -102,7 +102,7 @@ class LSPTester:
         result = response.get("result", {})
         capabilities = result.get("capabilities", {})
 
-        self.assert_equal(capabilities.get("textDocumentSync"), 1, "Initialize: Text sync capability")
+        self.assert_equal(capabilities.get("textDocumentSync"), 2, "Initialize: Text sync capability")
         self.assert_equal(capabilities.get("documentFormattingProvider"), True, "Initialize: Formatting capability")
         self.assert_contains(capabilities, "completionProvider", "Initialize: Completion capability")
 
@@ -5,8 +5,10 @@ Covers edge cases, error handling, and comprehensive protocol testing
 """
 
 import json
+import os
 import subprocess
 import sys
+import tempfile
 import time
 from pathlib import Path
 
@@ -47,6 +49,36 @@ class ExtendedLSPTester:
         except json.JSONDecodeError as e:
             return {"error": f"json_decode: {e}"}
 
+    def send_messages(self, messages, timeout=2, env=None):
+        """Send several JSON-RPC messages to one server and get all messages back"""
+        stream = ""
+        for message in messages:
+            body = json.dumps(message)
+            stream += f"Content-Length: {len(body)}\r\n\r\n{body}"
+
+        try:
+            result = subprocess.run(
+                [self.lsp_path],
+                input=stream.encode(),
+                capture_output=True,
+                timeout=timeout,
+                env=env
+            )
+        except subprocess.TimeoutExpired:
+            return []
+
+        output = result.stdout.decode()
+        responses = []
+        while output:
+            header_end = output.find("\r\n\r\n")
+            if header_end < 0:
+                break
+            length = int(output[len("Content-Length: "):header_end])
+            body_start = header_end + 4
+            responses.append(json.loads(output[body_start:body_start + length]))
+            output = output[body_start + length:]
+        return responses
+
     def assert_test(self, condition, test_name):
         """Assert a test condition"""
         self.test_count += 1
@@ -269,6 +301,254 @@ class ExtendedLSPTester:
         self.send_request(save_request, timeout=1)
         self.assert_test(True, "didSave notification sent")
 
+    def test_incremental_change(self):
+        """Test range edits with incremental text sync"""
+        print("\n=== Testing Incremental Change ===")
+
+        uri = "file:///tmp/incremental.qd"
+        messages = [
+            {
+                "jsonrpc": "2.0",
+                "method": "textDocument/didOpen",
+                "params": {
+                    "textDocument": {
+                        "uri": uri,
+                        "languageId": "quadrate",
+                        "version": 1,
+                        "text": "fn foo( -- ) {\n}\n\nfn main( -- ) {\n}\n"
+                    }
+                }
+            },
+            {
+                "jsonrpc": "2.0",
+                "method": "textDocument/didChange",
+                "params": {
+                    "textDocument": {"uri": uri, "version": 2},
+                    "contentChanges": [{
+                        "range": {
+                            "start": {"line": 0, "character": 3},
+                            "end": {"line": 0, "character": 6}
+                        },
+                        "text": "bar"
+                    }]
+                }
+            },
+            {
+                "jsonrpc": "2.0",
+                "id": 7,
+                "method": "textDocument/documentSymbol",
+                "params": {"textDocument": {"uri": uri}}
+            }
+        ]
+
+        responses = self.send_messages(messages)
+        symbols = []
+        for response in responses:
+            if response.get("id") == 7:
+                symbols = [symbol.get("name") for symbol in response.get("result", [])]
+
+        self.assert_test("bar" in symbols, "Edited function is renamed")
+        self.assert_test("foo" not in symbols, "Old function name is gone")
+        self.assert_test("main" in symbols, "Unchanged function is kept")
+
+    def test_cancel_request(self):
+        """Test $/cancelRequest and diagnostics published in the background"""
+        print("\n=== Testing Cancel Request ===")
+
+        uri = "file:///tmp/cancel.qd"
+        messages = [
+            {
+                "jsonrpc": "2.0",
+                "method": "textDocument/didOpen",
+                "params": {
+                    "textDocument": {
+                        "uri": uri,
+                        "languageId": "quadrate",
+                        "version": 1,
+                        "text": "fn main( -- ) {\n    undefined_function\n}\n"
+                    }
+                }
+            },
+            {
+                "jsonrpc": "2.0",
+                "id": 9,
+                "method": "textDocument/hover",
+                "params": {
+                    "textDocument": {"uri": uri},
+                    "position": {"line": 1, "character": 6}
+                }
+            },
+            {
+                "jsonrpc": "2.0",
+                "method": "$/cancelRequest",
+                "params": {"id": 9}
+            }
+        ]
+
+        responses = self.send_messages(messages)
+        hover = [r for r in responses if r.get("id") == 9]
+        diagnostics = [r for r in responses if r.get("method") == "textDocument/publishDiagnostics"]
+
+        # The hover may have been answered before the cancellation was read
+        self.assert_test(len(hover) == 1, "Request gets exactly one response")
+        if hover and "error" in hover[0]:
+            self.assert_test(hover[0]["error"].get("code") == -32800, "Cancelled request reports RequestCancelled")
+        self.assert_test(len(diagnostics) == 1, "Diagnostics published once")
+        if diagnostics:
+            self.assert_test(len(diagnostics[0]["params"]["diagnostics"]) > 0, "Diagnostics report the error")
+
+    def test_workspace_index(self):
+        """Test workspace/symbol and cross-file references from the workspace index"""
+        print("\n=== Testing Workspace Index ===")
+
+        with tempfile.TemporaryDirectory() as workspace:
+            os.makedirs(os.path.join(workspace, "shapes"))
+            with open(os.path.join(workspace, "shapes", "module.qd"), "w") as f:
+                f.write("fn square_area(side:f64 -- area:f64) {\n\tdup *\n}\n")
+            main_text = "use shapes\n\nfn main( -- ) {\n\t2.0 shapes::square_area print\n}\n"
+            with open(os.path.join(workspace, "main.qd"), "w") as f:
+                f.write(main_text)
+
+            main_uri = "file://" + os.path.join(workspace, "main.qd")
+            module_uri = "file://" + os.path.join(workspace, "shapes", "module.qd")
+            messages = [
+                {
+                    "jsonrpc": "2.0",
+                    "id": 1,
+                    "method": "initialize",
+                    "params": {"rootUri": "file://" + workspace, "capabilities": {}}
+                },
+                {
+                    "jsonrpc": "2.0",
+                    "id": 2,
+                    "method": "workspace/symbol",
+                    "params": {"query": "SQUARE"}
+                },
+                {
+                    "jsonrpc": "2.0",
+                    "method": "textDocument/didOpen",
+                    "params": {
+                        "textDocument": {"uri": main_uri, "languageId": "quadrate", "version": 1, "text": main_text}
+                    }
+                },
+                {
+                    "jsonrpc": "2.0",
+                    "id": 3,
+                    "method": "textDocument/references",
+                    "params": {
+                        "textDocument": {"uri": main_uri},
+                        "position": {"line": 3, "character": 14},
+                        "context": {"includeDeclaration": True}
+                    }
+                }
+            ]
+
+            # Keep the saved index out of the user's cache
+            env = dict(os.environ, XDG_CACHE_HOME=os.path.join(workspace, "cache"))
+            responses = self.send_messages(messages, env=env)
+            symbols = next((r.get("result") for r in responses if r.get("id") == 2), None) or []
+            references = next((r.get("result") for r in responses if r.get("id") == 3), None) or []
+
+            square = [s for s in symbols if s.get("name") == "square_area"]
+            self.assert_test(len(square) == 1, "workspace/symbol finds function in module")
+            if square:
+                self.assert_test(square[0].get("containerName") == "shapes", "Symbol reports its module")
+                self.assert_test(square[0]["location"]["uri"] == module_uri, "Symbol location is the module file")
+                self.assert_test(square[0]["location"]["range"]["start"] == {"line": 0, "character": 3},
+                                 "Symbol range starts at the name")
+
+            uris = {r["uri"] for r in references}
+            self.assert_test(main_uri in uris, "References include the current document")
+            self.assert_test(module_uri in uris, "References include the module declaration")
+
+            cache_dir = os.path.join(workspace, "cache", "quadrate", "quadlsp")
+            saved = os.listdir(cache_dir) if os.path.isdir(cache_dir) else []
+            self.assert_test(any(name.endswith(".json") for name in saved), "Index is saved between sessions")
+
+    def test_workspace_index_scoping(self):
+        """Test that locals and files outside of modules don't share names across the workspace"""
+        print("\n=== Testing Workspace Index Scoping ===")
+
+        with tempfile.TemporaryDirectory() as workspace:
+            os.makedirs(os.path.join(workspace, "shapes"))
+            module_text = "fn square_area(side:f64 -- area:f64) {\n\t-> side\n\tside side *\n}\n"
+            with open(os.path.join(workspace, "shapes", "module.qd"), "w") as f:
+                f.write(module_text)
+            with open(os.path.join(workspace, "shapes", "cube.qd"), "w") as f:
+                f.write("fn cube_volume(side:f64 -- volume:f64) {\n\t-> side\n\tside side * side *\n}\n")
+            main_text = "fn helper( -- ) {\n}\n\nfn main( -- ) {\n\thelper\n}\n"
+            with open(os.path.join(workspace, "main.qd"), "w") as f:
+                f.write(main_text)
+            with open(os.path.join(workspace, "other.qd"), "w") as f:
+                f.write("fn helper( -- ) {\n}\n\nfn run( -- ) {\n\thelper\n}\n")
+
+            main_uri = "file://" + os.path.join(workspace, "main.qd")
+            other_uri = "file://" + os.path.join(workspace, "other.qd")
+            module_uri = "file://" + os.path.join(workspace, "shapes", "module.qd")
+            cube_uri = "file://" + os.path.join(workspace, "shapes", "cube.qd")
+            messages = [
+                {
+                    "jsonrpc": "2.0",
+                    "id": 1,
+                    "method": "initialize",
+                    "params": {"rootUri": "file://" + workspace, "capabilities": {}}
+                },
+                {
+                    "jsonrpc": "2.0",
+                    "id": 2,
+                    "method": "workspace/symbol",
+                    "params": {"query": "helper"}
+                },
+                {
+                    "jsonrpc": "2.0",
+                    "method": "textDocument/didOpen",
+                    "params": {
+                        "textDocument": {"uri": main_uri, "languageId": "quadrate", "version": 1, "text": main_text}
+                    }
+                },
+                {
+                    "jsonrpc": "2.0",
+                    "method": "textDocument/didOpen",
+                    "params": {
+                        "textDocument": {"uri": module_uri, "languageId": "quadrate", "version": 1,
+                                         "text": module_text}
+                    }
+                },
+                {
+                    "jsonrpc": "2.0",
+                    "id": 3,
+                    "method": "textDocument/references",
+                    "params": {
+                        "textDocument": {"uri": main_uri},
+                        "position": {"line": 4, "character": 2},
+                        "context": {"includeDeclaration": True}
+                    }
+                },
+                {
+                    "jsonrpc": "2.0",
+                    "id": 4,
+                    "method": "textDocument/rename",
+                    "params": {
+                        "textDocument": {"uri": module_uri},
+                        "position": {"line": 2, "character": 2},
+                        "newName": "edge"
+                    }
+                }
+            ]
+
+            env = dict(os.environ, XDG_CACHE_HOME=os.path.join(workspace, "cache"))
+            responses = self.send_messages(messages, env=env)
+            references = next((r.get("result") for r in responses if r.get("id") == 3), None) or []
+            rename = next((r.get("result") for r in responses if r.get("id") == 4), None) or {}
+
+            uris = {r["uri"] for r in references}
+            self.assert_test(main_uri in uris, "References include the current document")
+            self.assert_test(other_uri not in uris, "References skip same-named functions in files outside of modules")
+
+            changes = rename.get("changes", {})
+            self.assert_test(module_uri in changes, "Rename of a local edits the current document")
+            self.assert_test(cube_uri not in changes, "Rename of a local leaves other files of the module alone")
+
     def test_completion_items_structure(self):
         """Test detailed completion items structure"""
         print("\n=== Testing Completion Items Structure ===")
@@ -502,7 +782,8 @@ class ExtendedLSPTester:
             caps = response["result"].get("capabilities", {})
 
             self.assert_test("textDocumentSync" in caps, "Has textDocumentSync capability")
-            self.assert_test(caps.get("textDocumentSync") == 1, "Text sync is Full (1)")
+            self.assert_test(caps.get("textDocumentSync") == 2, "Text sync is Incremental (2)")
+            self.assert_test(caps.get("workspaceSymbolProvider") is True, "Has workspace symbol capability")
             self.assert_test("documentFormattingProvider" in caps, "Has formatting capability")
             self.assert_test("completionProvider" in caps, "Has completion capability")
 
@@ -557,6 +838,10 @@ class ExtendedLSPTester:
 
         # Document tests
         self.test_text_document_lifecycle()
+        self.test_incremental_change()
+        self.test_cancel_request()
+        self.test_workspace_index()
+        self.test_workspace_index_scoping()
         self.test_empty_document()
         self.test_very_large_document()
         self.test_utf8_in_documents()
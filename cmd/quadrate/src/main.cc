@@ -1,17 +1,23 @@
-#include <cmath>
+#include <csetjmp>
+#include <csignal>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <dlfcn.h>
-#include <filesystem>
-#include <fstream>
 #include <iostream>
 #include <llvmgen/generator.h>
+#include <llvmgen/jit.h>
+#include <memory>
+#include <pthread.h>
 #include <qc/ast.h>
+#include <qc/ast_node_function.h>
 #include <qc/colors.h>
 #include <qc/semantic_validator.h>
-#include <random>
+#include <qdrt/context.h>
+#include <qdrt/runtime.h>
+#include <qdrt/stack.h>
 #include <readline/history.h>
 #include <readline/readline.h>
+#include <set>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -32,15 +38,37 @@
 // Stack display settings
 #define MAX_STACK_DISPLAY 5 // Show only top N elements
 
+// Stack size of the REPL context (same as compiled programs)
+#define REPL_STACK_SIZE 1024
+
+// Runtime errors abort(); the REPL survives them by jumping out of the SIGABRT handler
+//
+// This is only done for aborts on the REPL thread while a line runs: the stack
+// checks that catch most errors don't hold locks, but an abort raised inside the
+// scheduler or reactor with one of their locks held leaves that lock taken, and
+// later lines that spawn or wait on I/O may hang until the REPL is restarted.
+static sigjmp_buf abortJump;
+static pthread_t replThread;
+static volatile sig_atomic_t abortArmed = 0;
+
+static void onAbort(int) {
+	if (!abortArmed || !pthread_equal(pthread_self(), replThread)) {
+		// Not recoverable here, e.g. a failing coroutine on a worker thread: terminate as usual
+		signal(SIGABRT, SIG_DFL);
+		raise(SIGABRT);
+		return;
+	}
+	siglongjmp(abortJump, 1);
+}
+
 class ReplSession {
 public:
-	ReplSession() {
-		tempDir = createTempDir();
+	ReplSession() : ctx(qd_create_context(REPL_STACK_SIZE)), jit(std::make_unique<Qd::LlvmJit>()) {
 		lineNumber = 1;
 	}
 
 	~ReplSession() {
-		cleanup();
+		qd_free_context(ctx);
 	}
 
 	void run() {
@@ -140,45 +168,19 @@ public:
 	}
 
 private:
-	std::string tempDir;
-	std::vector<std::string> history;
+	// Each line is compiled into the JIT as a new function and runs on the live context
+	//
+	// The stack isn't copied per line, but the line's signature lists the type of
+	// every value on the stack, so parsing and validating a line still grow with
+	// the stack depth.
+	qd_context* ctx;
+	std::unique_ptr<Qd::LlvmJit> jit;
+	std::set<std::string> compiledFunctions; // Functions already in the JIT
 	std::vector<std::string> functionDefinitions;
 	std::vector<std::string> useStatements;
 	std::vector<std::string> stackValues; // Current stack state for display
 	int lineNumber;
-	size_t lastOutputLineCount = 0;
-
-	std::string createTempDir() {
-		std::random_device rd;
-		std::mt19937 gen(rd());
-		std::uniform_int_distribution<> dis(0, 15);
-
-		std::filesystem::path baseDir = std::filesystem::temp_directory_path();
-
-		for (int attempt = 0; attempt < 10; attempt++) {
-			std::stringstream ss;
-			ss << "quadrate_repl_";
-			for (int i = 0; i < 8; i++) {
-				ss << std::hex << dis(gen);
-			}
-
-			std::filesystem::path tmpDir = baseDir / ss.str();
-
-			std::error_code ec;
-			if (std::filesystem::create_directory(tmpDir, ec)) {
-				return tmpDir.string();
-			}
-		}
-
-		std::cerr << "quadrate: failed to create temporary directory" << std::endl;
-		exit(1);
-	}
-
-	void cleanup() {
-		if (!tempDir.empty()) {
-			std::filesystem::remove_all(tempDir);
-		}
-	}
+	int compiledLines = 0; // Names line functions; failed lines still occupy their JIT symbol
 
 	std::string trim(const std::string& str) {
 		size_t first = str.find_first_not_of(" \t\n\r");
@@ -234,9 +236,8 @@ private:
 	}
 
 	void clearStack() {
-		stackValues.clear();
-		history.clear();
-		lastOutputLineCount = 0;
+		qd_clear(ctx);
+		updateStackValues();
 	}
 
 	void showStack() {
@@ -252,11 +253,14 @@ private:
 	}
 
 	void reset() {
+		qd_free_context(ctx);
+		ctx = qd_create_context(REPL_STACK_SIZE);
+		jit = std::make_unique<Qd::LlvmJit>();
+		compiledFunctions.clear();
+		compiledLines = 0;
 		stackValues.clear();
 		functionDefinitions.clear();
 		useStatements.clear();
-		history.clear();
-		lastOutputLineCount = 0;
 		lineNumber = 1;
 		std::cout << COLOR_DIM << "REPL reset" << COLOR_RESET << std::endl;
 	}
@@ -353,7 +357,7 @@ private:
 		if (trimmedLine.rfind("fn ", 0) == 0) {
 			// Validate the function definition by trying to compile with it
 			functionDefinitions.push_back(line);
-			bool success = validateFunctionDefinition();
+			bool success = validateFunctionDefinition() && compileFunctionDefinitions();
 			if (!success) {
 				// Remove the invalid function definition
 				functionDefinitions.pop_back();
@@ -367,376 +371,177 @@ private:
 		return compileAndExecute(line);
 	}
 
-	void updateStackSimulation(const std::string& code) {
-		// Simulate stack operations with actual evaluation when possible
-		// Manual tokenization to handle string literals properly
-		size_t pos = 0;
-		while (pos < code.length()) {
-			// Skip whitespace
-			while (pos < code.length() && std::isspace(code[pos])) {
-				pos++;
-			}
-			if (pos >= code.length()) {
-				break;
+	// Render the live stack for the prompt (bottom first)
+	void updateStackValues() {
+		stackValues.clear();
+		size_t depth = qd_stack_size(ctx->st);
+		for (size_t i = 0; i < depth; i++) {
+			qd_stack_element_t element;
+			if (qd_stack_element(ctx->st, i, &element) != QD_STACK_OK) {
+				stackValues.push_back("?");
+				continue;
 			}
 
-			std::string token;
-
-			// Check for string literal
-			if (code[pos] == '"') {
-				size_t start = pos;
-				pos++; // Skip opening quote
-				while (pos < code.length() && code[pos] != '"') {
-					if (code[pos] == '\\' && pos + 1 < code.length()) {
-						pos += 2; // Skip escape sequence
-					} else {
-						pos++;
-					}
-				}
-				if (pos < code.length()) {
-					pos++; // Skip closing quote
+			std::stringstream value;
+			switch (element.type) {
+			case QD_STACK_TYPE_INT:
+				value << element.value.i;
+				break;
+			case QD_STACK_TYPE_FLOAT:
+				value << element.value.f;
+				// Keep floats recognizable (and colored) even when integral
+				if (value.str().find_first_of(".einf") == std::string::npos) {
+					value << ".0";
 				}
-				token = code.substr(start, pos - start);
-				// Push string literal to stack
-				stackValues.push_back(token);
-				continue;
+				break;
+			case QD_STACK_TYPE_STR:
+				value << '"' << (element.value.s ? element.value.s : "") << '"';
+				break;
+			case QD_STACK_TYPE_PTR:
+				value << '&' << element.value.p;
+				break;
+			default:
+				value << '?';
+				break;
 			}
+			stackValues.push_back(value.str());
+		}
+	}
 
-			// Regular token (identifier, number, operator)
-			size_t start = pos;
-			while (pos < code.length() && !std::isspace(code[pos])) {
-				pos++;
+	// State of the live context before a line runs, used to roll back a failing line
+	struct LineSnapshot {
+		std::vector<qd_stack_type> types; // Stack element types, bottom first
+		size_t callStackDepth;
+		int64_t errorCode;
+		char* errorMsg;
+	};
+
+	LineSnapshot takeSnapshot() {
+		LineSnapshot snapshot;
+		size_t depth = qd_stack_size(ctx->st);
+		snapshot.types.reserve(depth);
+		for (size_t i = 0; i < depth; i++) {
+			qd_stack_element_t element;
+			if (qd_stack_element(ctx->st, i, &element) != QD_STACK_OK) {
+				break;
 			}
-			token = code.substr(start, pos - start);
+			snapshot.types.push_back(element.type);
+		}
+		snapshot.callStackDepth = ctx->call_stack_depth;
+		snapshot.errorCode = ctx->error_code;
+		snapshot.errorMsg = ctx->error_msg;
+		return snapshot;
+	}
 
-			// Check for function pointer (starts with &)
-			if (token.length() > 1 && token[0] == '&') {
-				// Function pointer - push to stack
-				stackValues.push_back(token);
-				continue;
+	// Drop what a failing line left on the stack and restore the error and call stack state
+	//
+	// Only depth and types are snapshotted, so values the line consumed before it
+	// failed can't be restored: the stack is cut back to the deepest element whose
+	// type still matches, and the caller is told how many values were lost.
+	size_t rollBack(const LineSnapshot& snapshot) {
+		size_t depth = qd_stack_size(ctx->st);
+		size_t kept = 0;
+		while (kept < depth && kept < snapshot.types.size()) {
+			qd_stack_element_t element;
+			if (qd_stack_element(ctx->st, kept, &element) != QD_STACK_OK || element.type != snapshot.types[kept]) {
+				break;
+			}
+			kept++;
+		}
+		for (; depth > kept; depth--) {
+			qd_stack_element_t element;
+			if (qd_stack_pop_ref(ctx->st, &element) != QD_STACK_OK) {
+				break;
 			}
+			qd_stack_element_release(&element);
+		}
 
-			// Try to parse as number
-			bool isInt = true;
-			bool isFloat = false;
-
-			try {
-				if (token.find('.') != std::string::npos) {
-					(void)std::stod(token);
-					isFloat = true;
-					isInt = false;
-				} else {
-					(void)std::stoll(token);
-				}
-			} catch (...) {
-				isInt = false;
+		ctx->call_stack_depth = snapshot.callStackDepth;
+		ctx->error_code = snapshot.errorCode;
+		ctx->error_msg = snapshot.errorMsg;
+		return snapshot.types.size() - kept;
+	}
+
+	// Parameter list describing the live stack, so the validator checks a line against real values
+	static std::string stackParameters(const LineSnapshot& snapshot) {
+		std::stringstream params;
+		for (size_t i = 0; i < snapshot.types.size(); i++) {
+			std::string type = "any";
+			switch (snapshot.types[i]) {
+			case QD_STACK_TYPE_INT:
+				type = "i64";
+				break;
+			case QD_STACK_TYPE_FLOAT:
+				type = "f64";
+				break;
+			case QD_STACK_TYPE_STR:
+				type = "str";
+				break;
+			case QD_STACK_TYPE_PTR:
+				type = "ptr";
+				break;
+			default:
+				break;
 			}
+			params << "s" << i << ":" << type << " ";
+		}
+		return params.str();
+	}
 
-			if (isInt || isFloat) {
-				stackValues.push_back(token);
-			} else if (token == "+" || token == "-" || token == "*" || token == "/" || token == "%" || token == "add" ||
-					   token == "sub" || token == "mul" || token == "div" || token == "mod") {
-				if (stackValues.size() >= 2) {
-					std::string b = stackValues.back();
-					stackValues.pop_back();
-					std::string a = stackValues.back();
-					stackValues.pop_back();
-
-					// Try to evaluate
-					try {
-						// Check if either operand is a float
-						bool aIsFloat = (a.find('.') != std::string::npos);
-						bool bIsFloat = (b.find('.') != std::string::npos);
-
-						if (aIsFloat || bIsFloat) {
-							// Use floating-point arithmetic
-							double aVal = std::stod(a);
-							double bVal = std::stod(b);
-							double result = 0.0;
-							if (token == "add" || token == "+") {
-								result = aVal + bVal;
-							} else if (token == "sub" || token == "-") {
-								result = aVal - bVal;
-							} else if (token == "mul" || token == "*") {
-								result = aVal * bVal;
-							} else if ((token == "div" || token == "/") && bVal != 0.0) {
-								result = aVal / bVal;
-							} else if (token == "mod" || token == "%") {
-								result = std::fmod(aVal, bVal);
-							}
-							stackValues.push_back(std::to_string(result));
-						} else {
-							// Use integer arithmetic
-							long long aVal = std::stoll(a);
-							long long bVal = std::stoll(b);
-							long long result = 0;
-							if (token == "add" || token == "+") {
-								result = aVal + bVal;
-							} else if (token == "sub" || token == "-") {
-								result = aVal - bVal;
-							} else if (token == "mul" || token == "*") {
-								result = aVal * bVal;
-							} else if ((token == "div" || token == "/") && bVal != 0) {
-								result = aVal / bVal;
-							} else if ((token == "mod" || token == "%") && bVal != 0) {
-								result = aVal % bVal;
-							}
-							stackValues.push_back(std::to_string(result));
-						}
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else if (token == "dup") {
-				if (!stackValues.empty()) {
-					stackValues.push_back(stackValues.back());
-				}
-			} else if (token == "dup2") {
-				if (stackValues.size() >= 2) {
-					std::string second = stackValues[stackValues.size() - 2];
-					std::string first = stackValues[stackValues.size() - 1];
-					stackValues.push_back(second);
-					stackValues.push_back(first);
-				}
-			} else if (token == "drop" || token == "print" || token == "printv" || token == "prints" || token == "." ||
-					   token == "call") {
-				if (!stackValues.empty()) {
-					stackValues.pop_back();
-				}
-			} else if (token == "drop2") {
-				if (stackValues.size() >= 2) {
-					stackValues.pop_back();
-					stackValues.pop_back();
-				}
-			} else if (token == "swap") {
-				if (stackValues.size() >= 2) {
-					std::string top = stackValues.back();
-					stackValues.pop_back();
-					std::string second = stackValues.back();
-					stackValues.pop_back();
-					stackValues.push_back(top);
-					stackValues.push_back(second);
-				}
-			} else if (token == "swap2") {
-				if (stackValues.size() >= 4) {
-					std::string d = stackValues.back();
-					stackValues.pop_back();
-					std::string c = stackValues.back();
-					stackValues.pop_back();
-					std::string b = stackValues.back();
-					stackValues.pop_back();
-					std::string a = stackValues.back();
-					stackValues.pop_back();
-					stackValues.push_back(c);
-					stackValues.push_back(d);
-					stackValues.push_back(a);
-					stackValues.push_back(b);
-				}
-			} else if (token == "over") {
-				if (stackValues.size() >= 2) {
-					stackValues.push_back(stackValues[stackValues.size() - 2]);
-				}
-			} else if (token == "over2") {
-				if (stackValues.size() >= 4) {
-					stackValues.push_back(stackValues[stackValues.size() - 4]);
-					stackValues.push_back(stackValues[stackValues.size() - 4]);
-				}
-			} else if (token == "rot") {
-				if (stackValues.size() >= 3) {
-					std::string c = stackValues.back();
-					stackValues.pop_back();
-					std::string b = stackValues.back();
-					stackValues.pop_back();
-					std::string a = stackValues.back();
-					stackValues.pop_back();
-					stackValues.push_back(b);
-					stackValues.push_back(c);
-					stackValues.push_back(a);
-				}
-			} else if (token == "nip") {
-				if (stackValues.size() >= 2) {
-					std::string top = stackValues.back();
-					stackValues.pop_back();
-					stackValues.pop_back();
-					stackValues.push_back(top);
-				}
-			} else if (token == "tuck") {
-				if (stackValues.size() >= 2) {
-					std::string b = stackValues.back();
-					stackValues.pop_back();
-					std::string a = stackValues.back();
-					stackValues.pop_back();
-					stackValues.push_back(b);
-					stackValues.push_back(a);
-					stackValues.push_back(b);
-				}
-			} else if (token == "clear") {
-				stackValues.clear();
-			} else if (token == "depth") {
-				// Push stack depth onto stack
-				stackValues.push_back(std::to_string(stackValues.size()));
-			} else if (token == "inc") {
-				if (!stackValues.empty()) {
-					try {
-						long long val = std::stoll(stackValues.back());
-						stackValues.pop_back();
-						stackValues.push_back(std::to_string(val + 1));
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else if (token == "dec") {
-				if (!stackValues.empty()) {
-					try {
-						long long val = std::stoll(stackValues.back());
-						stackValues.pop_back();
-						stackValues.push_back(std::to_string(val - 1));
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else if (token == "neg") {
-				if (!stackValues.empty()) {
-					try {
-						std::string val = stackValues.back();
-						if (val.find('.') != std::string::npos) {
-							double d = std::stod(val);
-							stackValues.pop_back();
-							stackValues.push_back(std::to_string(-d));
-						} else {
-							long long i = std::stoll(val);
-							stackValues.pop_back();
-							stackValues.push_back(std::to_string(-i));
-						}
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else if (token == "abs") {
-				if (!stackValues.empty()) {
-					try {
-						std::string val = stackValues.back();
-						if (val.find('.') != std::string::npos) {
-							double d = std::abs(std::stod(val));
-							stackValues.pop_back();
-							stackValues.push_back(std::to_string(d));
-						} else {
-							long long i = std::abs(std::stoll(val));
-							stackValues.pop_back();
-							stackValues.push_back(std::to_string(i));
-						}
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else if (token == "sq") {
-				if (!stackValues.empty()) {
-					try {
-						std::string val = stackValues.back();
-						if (val.find('.') != std::string::npos) {
-							double d = std::stod(val);
-							stackValues.pop_back();
-							stackValues.push_back(std::to_string(d * d));
-						} else {
-							long long i = std::stoll(val);
-							stackValues.pop_back();
-							stackValues.push_back(std::to_string(i * i));
-						}
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else if (token == "sqrt") {
-				if (!stackValues.empty()) {
-					try {
-						double d = std::stod(stackValues.back());
-						stackValues.pop_back();
-						stackValues.push_back(std::to_string(std::sqrt(d)));
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else if (token == "sin" || token == "cos" || token == "tan") {
-				if (!stackValues.empty()) {
-					try {
-						double d = std::stod(stackValues.back());
-						stackValues.pop_back();
-						double result;
-						if (token == "sin") {
-							result = std::sin(d);
-						} else if (token == "cos") {
-							result = std::cos(d);
-						} else {
-							result = std::tan(d);
-						}
-						stackValues.push_back(std::to_string(result));
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else if (token == "floor" || token == "ceil" || token == "round") {
-				if (!stackValues.empty()) {
-					try {
-						double d = std::stod(stackValues.back());
-						stackValues.pop_back();
-						double result;
-						if (token == "floor") {
-							result = std::floor(d);
-						} else if (token == "ceil") {
-							result = std::ceil(d);
-						} else {
-							result = std::round(d);
-						}
-						stackValues.push_back(std::to_string(result));
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else if (token == "min" || token == "max") {
-				if (stackValues.size() >= 2) {
-					try {
-						std::string b = stackValues.back();
-						stackValues.pop_back();
-						std::string a = stackValues.back();
-						stackValues.pop_back();
-						bool aIsFloat = (a.find('.') != std::string::npos);
-						bool bIsFloat = (b.find('.') != std::string::npos);
-						if (aIsFloat || bIsFloat) {
-							double aVal = std::stod(a);
-							double bVal = std::stod(b);
-							double result = (token == "min") ? std::min(aVal, bVal) : std::max(aVal, bVal);
-							stackValues.push_back(std::to_string(result));
-						} else {
-							long long aVal = std::stoll(a);
-							long long bVal = std::stoll(b);
-							long long result = (token == "min") ? std::min(aVal, bVal) : std::max(aVal, bVal);
-							stackValues.push_back(std::to_string(result));
-						}
-					} catch (...) {
-						stackValues.push_back("?");
-					}
-				}
-			} else {
-				// Unknown operation - might be a user-defined function or module function
-				// Check if it contains "::" (namespaced function call) or looks like a function
-				// For now, we can't determine stack effects, so mark with "?"
-				// This prevents the stack from getting out of sync
-				if (token.find("::") != std::string::npos) {
-					// Namespaced function call - we don't know the signature
-					// Conservatively assume it might consume/produce values
-					// For better UX, just push a placeholder
-					stackValues.push_back("?");
-				}
-				// For other unknown tokens, just ignore them
-				// (they might be user functions we haven't analyzed yet)
+	// Source with the use statements and all function definitions, followed by extra code
+	std::string replSource(const std::string& extra) {
+		std::stringstream source;
+		for (const auto& use : useStatements) {
+			source << use << "\n";
+		}
+		if (!useStatements.empty()) {
+			source << "\n";
+		}
+		for (const auto& func : functionDefinitions) {
+			source << func << "\n";
+		}
+		if (!functionDefinitions.empty()) {
+			source << "\n";
+		}
+		source << extra;
+		return source.str();
+	}
+
+	// Compile the source into the JIT; functions compiled by earlier lines are only declared
+	bool compileIntoJit(Qd::IAstNode* root, const std::string& name) {
+		Qd::LlvmGenerator generator;
+		for (const auto& func : compiledFunctions) {
+			generator.addDeclaredFunction(func);
+		}
+		if (!generator.generate(root, name) || !generator.addToJit(*jit)) {
+			std::cerr << COLOR_YELLOW << "Code generation failed" << COLOR_RESET << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool compileFunctionDefinitions() {
+		std::string sourceCode = replSource("");
+
+		Qd::Ast ast;
+		Qd::IAstNode* root = ast.generate(sourceCode.c_str(), false, "<repl>");
+		if (!root || ast.hasErrors()) {
+			return false;
+		}
+
+		if (!compileIntoJit(root, "main")) {
+			return false;
+		}
+
+		for (size_t i = 0; i < root->childCount(); i++) {
+			if (auto funcNode = dynamic_cast<Qd::AstNodeFunctionDeclaration*>(root->child(i))) {
+				compiledFunctions.insert(funcNode->name());
 			}
 		}
+		return true;
 	}
 
 	bool compileAndExecute(const std::string& userCode) {
-		// Save stack state in case we need to rollback
-		std::vector<std::string> savedStackValues = stackValues;
-
 		// Convert 'print' to 'printv' for better REPL output (with newlines)
 		std::string processedCode = userCode;
 		size_t pos = 0;
@@ -762,45 +567,12 @@ private:
 			}
 		}
 
-		// Simulate stack state
-		updateStackSimulation(processedCode);
-
-		// Add this line to history
-		history.push_back(processedCode);
-
-		// Generate the complete source file by accumulating all history
-		std::stringstream source;
-
-		// Add use statements
-		for (const auto& use : useStatements) {
-			source << use << "\n";
-		}
-		if (!useStatements.empty()) {
-			source << "\n";
-		}
-
-		// Add function definitions
-		for (const auto& func : functionDefinitions) {
-			source << func << "\n";
-		}
-		if (!functionDefinitions.empty()) {
-			source << "\n";
-		}
-
-		// Generate main function that executes ALL history
-		source << "fn main( -- ) {\n";
-
-		// Add all historical lines
-		for (const auto& line : history) {
-			source << "\t" << line << "\n";
-		}
-
-		// Add stack depth check at the end to sync our simulation
-		source << "\tnl \"__DEPTH__\" prints depth printv\n";
-
-		source << "}\n";
-
-		std::string sourceCode = source.str();
+		// Only this line is compiled: a function whose inputs are the values on the live stack
+		// Declared fallible so it never gets a native entry point and keeps working on the stack
+		LineSnapshot snapshot = takeSnapshot();
+		std::string lineFunction = "repl_line_" + std::to_string(++compiledLines);
+		std::string sourceCode = replSource(
+				"fn " + lineFunction + "(" + stackParameters(snapshot) + "-- )! {\n\t" + processedCode + "\n}\n");
 
 		// Parse the source
 		Qd::Ast ast;
@@ -808,9 +580,6 @@ private:
 
 		if (!root || ast.hasErrors()) {
 			std::cerr << COLOR_YELLOW << "Parse error" << COLOR_RESET << std::endl;
-			// Rollback changes since compilation failed
-			stackValues = savedStackValues;
-			history.pop_back();
 			return false;
 		}
 
@@ -819,120 +588,58 @@ private:
 		size_t errorCount = validator.validate(root, "<repl>");
 		if (errorCount > 0) {
 			// Errors already printed
-			// Rollback changes since compilation failed
-			stackValues = savedStackValues;
-			history.pop_back();
 			return false;
 		}
 
-		// Generate LLVM IR and compile
-		Qd::LlvmGenerator generator;
-		if (!generator.generate(root, "main")) {
-			std::cerr << COLOR_YELLOW << "Code generation failed" << COLOR_RESET << std::endl;
-			// Rollback changes since compilation failed
-			stackValues = savedStackValues;
-			history.pop_back();
+		if (!compileIntoJit(root, "main")) {
 			return false;
 		}
 
-		// Create executable
-		std::string exePath = tempDir + "/repl_exec";
-		if (!generator.writeExecutable(exePath)) {
-			std::cerr << COLOR_YELLOW << "Failed to create executable" << COLOR_RESET << std::endl;
-			// Rollback changes since compilation failed
-			stackValues = savedStackValues;
-			history.pop_back();
+		typedef qd_exec_result (*LineFunction)(qd_context*);
+		auto lineFn = reinterpret_cast<LineFunction>(jit->lookup("usr_main_" + lineFunction));
+		if (!lineFn) {
+			std::cerr << COLOR_YELLOW << "Failed to compile line" << COLOR_RESET << std::endl;
 			return false;
 		}
 
-		// Execute and capture output
-		std::string outputFile = tempDir + "/output.txt";
-		std::string command = exePath + " > " + outputFile + " 2>&1";
-		int exitCode = system(command.c_str());
-
-		if (exitCode != 0) {
-			std::cerr << COLOR_YELLOW << "Execution failed with exit code " << (exitCode / 256) << COLOR_RESET
-					  << std::endl;
-			// Show output
-			std::ifstream outFile(outputFile);
-			if (outFile.is_open()) {
-				std::string line;
-				while (std::getline(outFile, line)) {
-					std::cerr << line << std::endl;
-				}
-			}
-			// Rollback changes since compilation failed
-			stackValues = savedStackValues;
-			history.pop_back();
-			return false;
-		}
+		// Run on the live context; a failing line is rolled back to the snapshot
+		struct sigaction onAbortAction = {};
+		struct sigaction previousAction = {};
+		onAbortAction.sa_handler = onAbort;
+		sigemptyset(&onAbortAction.sa_mask);
+		sigaction(SIGABRT, &onAbortAction, &previousAction);
 
-		// Read and display output
-		// Only show NEW output (not from previous history)
-		std::vector<std::string> outputLines;
-		std::ifstream outFile(outputFile);
-		if (outFile.is_open()) {
-			std::string outputLine;
-			while (std::getline(outFile, outputLine)) {
-				outputLines.push_back(outputLine);
-			}
+		bool aborted = false;
+		int resultCode = 0;
+		if (sigsetjmp(abortJump, 1) == 0) {
+			replThread = pthread_self();
+			abortArmed = 1;
+			resultCode = lineFn(ctx).code;
+		} else {
+			aborted = true;
 		}
+		abortArmed = 0;
+		sigaction(SIGABRT, &previousAction, nullptr);
+		fflush(stdout);
+		fflush(stderr);
 
-		// The output contains results from ALL history executions
-		// We only want to show the NEW output from this line
-		// Skip output from previous lines (we track how many output lines we've seen)
-		size_t newOutputStart = lastOutputLineCount;
-
-		// Extract actual stack depth and filter out depth markers in one pass
-		int actualDepth = -1;
-		std::vector<std::string> userOutput;
-
-		for (size_t i = 0; i < outputLines.size(); i++) {
-			if (outputLines[i] == "__DEPTH__") {
-				// Next line should be "int:N" with the actual depth
-				if (i + 1 < outputLines.size()) {
-					const std::string& depthLine = outputLines[i + 1];
-					if (depthLine.find("int:") == 0) {
-						try {
-							actualDepth = std::stoi(depthLine.substr(4));
-						} catch (...) {
-							// Failed to parse depth
-						}
-					}
-				}
-				// Skip this line and the next (int:N)
-				i++;
+		if (aborted || resultCode != 0) {
+			if (aborted) {
+				std::cerr << COLOR_YELLOW << "Execution failed" << COLOR_RESET << std::endl;
 			} else {
-				userOutput.push_back(outputLines[i]);
+				std::cerr << COLOR_YELLOW << "Execution failed with error code " << resultCode << COLOR_RESET
+						  << std::endl;
 			}
-		}
-
-		// Sync our simulated stack with actual depth
-		if (actualDepth >= 0) {
-			size_t simulatedDepth = stackValues.size();
-			if (actualDepth != static_cast<int>(simulatedDepth)) {
-				// Stack simulation is out of sync - adjust it
-				if (actualDepth > static_cast<int>(simulatedDepth)) {
-					// Actual stack has more elements - add unknowns
-					for (int i = static_cast<int>(simulatedDepth); i < actualDepth; i++) {
-						stackValues.push_back("?");
-					}
-				} else {
-					// Actual stack has fewer elements - truncate
-					stackValues.resize(static_cast<size_t>(actualDepth));
-				}
+			size_t lost = rollBack(snapshot);
+			if (lost > 0) {
+				std::cerr << COLOR_YELLOW << lost << (lost == 1 ? " value" : " values")
+						  << " consumed by the line could not be restored" << COLOR_RESET << std::endl;
 			}
+			updateStackValues();
+			return false;
 		}
 
-		// Show only NEW user output
-		for (size_t i = newOutputStart; i < userOutput.size(); i++) {
-			std::cout << userOutput[i] << std::endl;
-		}
-		std::cout.flush();
-
-		// Remember total output lines for next time (user output only, depth markers filtered out)
-		lastOutputLineCount = userOutput.size();
-
+		updateStackValues();
 		return true;
 	}
 };
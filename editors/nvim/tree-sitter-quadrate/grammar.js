@@ -234,7 +234,7 @@ module.exports = grammar({
       // I/O
       'print', 'prints', 'printv', 'printsv', 'call', 'nl', 'read',
       // Threading
-      'detach', 'spawn', 'wait',
+      'chan', 'close', 'detach', 'recv', 'send', 'spawn', 'spawn_args', 'try_recv', 'wait', 'yield',
       // Error handling
       'error',
       // Memory management
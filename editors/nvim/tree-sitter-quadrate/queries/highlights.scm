@@ -101,7 +101,7 @@
 
 ; Built-in threading operations
 [
-  "spawn" "detach" "wait"
+  "spawn" "spawn_args" "detach" "wait" "yield" "chan" "send" "recv" "try_recv" "close"
 ] @function.builtin
 
 ; Built-in error handling
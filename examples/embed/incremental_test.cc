@@ -25,6 +25,14 @@ int main(void) {
 	qd_execute(ctx, "10 5 app::sub . nl");          // 5
 	qd_execute(ctx, "10 5 app::double_sum . nl");  // (10+5)*2 = 30
 
+	// A string literal pushed by the first build stays valid after a rebuild
+	qd_add_script(app, "fn greeting( -- s:str) { \"hello\" }");
+	qd_build(app);
+	qd_execute(ctx, "app::greeting");
+	qd_add_script(app, "fn triple(a:i64 -- result:i64) { 3 * }");
+	qd_build(app);
+	qd_execute(ctx, ". nl");                        // hello
+
 	qd_free_context(ctx);
 	return 0;
 }
@@ -15,6 +15,11 @@ qd_exec_result native_random(qd_context* ctx) {
 	return qd_push_i(ctx, static_cast<int64_t>(random_val));
 }
 
+// Registered after the module was built
+qd_exec_result native_answer(qd_context* ctx) {
+	return qd_push_i(ctx, 42);
+}
+
 int main(void) {
 	srand(static_cast<unsigned int>(time(nullptr)));
 	qd_context* ctx = qd_create_context(1024);
@@ -41,6 +46,11 @@ int main(void) {
 	printf("Random number doubled: ");
 	qd_execute(ctx, "utils::random utils::double . nl");
 
+	// Functions registered after the build are callable right away
+	qd_register_function(utils, "answer", reinterpret_cast<void (*)()>(native_answer));
+	printf("Registered after build: ");
+	qd_execute(ctx, "utils::answer . nl"); // 42
+
 	qd_free_context(ctx);
 	return 0;
 }
@@ -0,0 +1,37 @@
+#include <qd/qd.h>
+#include <stdio.h>
+
+int main(void) {
+	qd_context* ctx = qd_create_context(1024);
+
+	qd_module* math_mod = qd_get_module(ctx, "math");
+	qd_add_script(math_mod, "fn square(x:i64 -- result:i64) { dup * }");
+	qd_build(math_mod);
+
+	printf("=== Prepared Calls ===\n\n");
+
+	// Parse and resolve once, then invoke many times
+	qd_call_handle* square = qd_prepare(ctx, "7 math::square");
+	if (!square) {
+		qd_free_context(ctx);
+		return 1;
+	}
+
+	for (int i = 0; i < 1000000; i++) {
+		qd_invoke(square);
+		qd_drop(ctx);
+	}
+
+	qd_invoke(square);
+	qd_execute(ctx, ". nl"); // 49
+
+	// Handles pick up rebuilt modules
+	qd_add_script(math_mod, "fn cube(x:i64 -- result:i64) { dup dup * * }");
+	qd_build(math_mod);
+	qd_invoke(square);
+	qd_execute(ctx, ". nl"); // 49
+
+	qd_free_call_handle(square);
+	qd_free_context(ctx);
+	return 0;
+}
@@ -8,8 +8,10 @@
 #ifndef LLVMGEN_GENERATOR_H
 #define LLVMGEN_GENERATOR_H
 
+#include <cstddef>
 #include <memory>
 #include <string>
+#include <vector>
 
 // Forward declarations for LLVM types
 namespace llvm {
@@ -25,6 +27,7 @@ namespace llvm {
 namespace Qd {
 
 	class IAstNode;
+	class LlvmJit;
 
 	/**
 	 * @brief LLVM code generator for Quadrate
@@ -97,6 +100,48 @@ namespace Qd {
 		void addModuleAST(const std::string& moduleName, IAstNode* moduleRoot,
 				const std::string& sourceFileName = "");
 
+		/**
+		 * @brief Link a module from a precompiled object file
+		 *
+		 * The module's AST must still be added with addModuleAST() so its
+		 * constants, structs and imports are known, but its functions are
+		 * only declared and the object file is passed to the linker instead.
+		 *
+		 * @param moduleName Name of the module, as passed to addModuleAST()
+		 * @param objectFile Object file written after generateModule()
+		 *
+		 * @note Must be called before generate()
+		 */
+		void addPrecompiledModule(const std::string& moduleName, const std::string& objectFile);
+
+		/**
+		 * @brief Declare a main file function instead of generating it
+		 *
+		 * The function is still known to the generator for calls, but its
+		 * body is expected to be defined elsewhere, e.g. compiled into the
+		 * same JIT by an earlier generator.
+		 *
+		 * @param functionName Name of the function in the main file
+		 *
+		 * @note Must be called before generate()
+		 */
+		void addDeclaredFunction(const std::string& functionName);
+
+		/**
+		 * @brief Generate LLVM IR for a single module
+		 *
+		 * Defines the functions of one module added with addModuleAST() and
+		 * only declares the functions of all other added modules. Use
+		 * writeObject() afterwards to compile the module on its own, e.g.
+		 * for a module cache.
+		 *
+		 * @param moduleName Name of the module to define, as passed to addModuleAST()
+		 * @return true if generation succeeded, false on error
+		 *
+		 * @note Replaces generate(); no main function is emitted
+		 */
+		bool generateModule(const std::string& moduleName);
+
 		/**
 		 * @brief Write LLVM IR to a text file
 		 *
@@ -129,6 +174,10 @@ namespace Qd {
 		 * Compiles and links the LLVM IR into a standalone executable.
 		 * Automatically links with the Quadrate runtime library.
 		 *
+		 * When built with lld, linking runs in-process; the system part of
+		 * the link line is asked from the clang driver once and cached.
+		 * Otherwise clang is run as the linker driver.
+		 *
 		 * @param filename Output filename (executable name)
 		 * @return true if write succeeded, false on error
 		 *
@@ -137,6 +186,30 @@ namespace Qd {
 		 */
 		bool writeExecutable(const std::string& filename);
 
+		/**
+		 * @brief Hand the generated module over to a JIT
+		 *
+		 * Optimizes the module for the JIT's target and moves it into the
+		 * JIT, without writing any files. The generator can't be used for
+		 * output afterwards.
+		 *
+		 * @param jit JIT to add the module to
+		 * @return true if the module was added, false on error
+		 *
+		 * @note Must call generate() first
+		 */
+		bool addToJit(LlvmJit& jit);
+
+		/**
+		 * @brief Get the symbols of all exported Quadrate functions
+		 *
+		 * @return Symbol names of the functions defined in the generated module
+		 *         (e.g., "usr_main_square")
+		 *
+		 * @note Must call generate() first, and before addToJit()
+		 */
+		std::vector<std::string> exportedFunctions() const;
+
 		/**
 		 * @brief Get generated IR as a string
 		 *
@@ -175,12 +248,122 @@ namespace Qd {
 		 *              2 = Moderate optimization (-O2, recommended for release)
 		 *              3 = Aggressive optimization (-O3, slowest compile, fastest execution)
 		 *
+		 * Levels 1-3 run LLVM's default pipeline for the level, extended with
+		 * passes that optimize operand stack traffic (push/pop pairs, slot
+		 * type checks and redundant qd_check_stack calls).
+		 *
 		 * @note Must be called before writeObject() or writeExecutable()
 		 * @note Default is 0 (no optimization)
 		 * @note Can be combined with debug info (-g -O2)
 		 */
 		void setOptimizationLevel(int level);
 
+		/**
+		 * @brief Enable or disable runtime stack checks at proven call sites
+		 *
+		 * When disabled, calls whose stack depth and parameter types were
+		 * proven by the semantic validator skip qd_check_stack and call an
+		 * unchecked entry point directly. Function pointers and callers from
+		 * other compilation units still go through the checked entry point.
+		 *
+		 * @param enabled True to keep all runtime checks, false to elide proven ones
+		 *
+		 * @note Must be called before generate()
+		 * @note Default is true
+		 */
+		void setRuntimeChecks(bool enabled);
+
+		/**
+		 * @brief Enable or disable the shadow call stack
+		 *
+		 * Controls whether qd_push_call/qd_pop_call are emitted around every
+		 * function body. Without them fatal errors still abort, but the
+		 * printed stack trace is empty.
+		 *
+		 * @param enabled True to maintain the call stack for stack traces
+		 *
+		 * @note Must be called before generate()
+		 * @note Default is true
+		 */
+		void setCallStackTracking(bool enabled);
+
+		/**
+		 * @brief Enable or disable link-time optimization with the runtime
+		 *
+		 * Links the LLVM bitcode installed next to libqdrt_static.a and the
+		 * imported static libraries into the module before optimizing, so
+		 * runtime functions like qd_dup or usr_math_sqrt can be inlined and
+		 * specialized. The archives are still linked and own all symbols and
+		 * state; missing bitcode files are skipped.
+		 *
+		 * @param enabled True to inline runtime and library functions
+		 *
+		 * @note Must be called before writeObject() or writeExecutable()
+		 * @note Has no effect at optimization level 0
+		 * @note Default is false
+		 */
+		void setLinkTimeOptimization(bool enabled);
+
+		/**
+		 * @brief Set the capacity of the program's data stack
+		 *
+		 * Applies to main's context; spawned tasks get stacks of the same
+		 * capacity. Programs that keep more values on the stack overflow.
+		 *
+		 * @param elements Number of stack elements, or 0 for the default
+		 *                 (1024, or 1048576 with stack growth)
+		 *
+		 * @note Must be called before generate()
+		 */
+		void setStackSize(size_t elements);
+
+		/**
+		 * @brief Reserve the data stack and commit memory as it grows
+		 *
+		 * Creates main's context with qd_create_context_growable(), so a
+		 * large stack size only costs the memory the program uses. The
+		 * stack never moves and runs into a guard page past its capacity.
+		 *
+		 * @param enabled True to reserve the stack instead of allocating it
+		 *
+		 * @note Must be called before generate()
+		 * @note Default is false
+		 */
+		void setStackGrowth(bool enabled);
+
+		/**
+		 * @brief Instrument the generated code to record a profile
+		 *
+		 * Adds LLVM IR profile counters for function entries and every
+		 * branch (if, switch and loop conditions). The program writes the
+		 * counts to profileFile when it exits; LLVM_PROFILE_FILE overrides
+		 * the name at run time. Merge raw profiles with `llvm-profdata merge`
+		 * before passing them to setProfileUse().
+		 *
+		 * @param profileFile Raw profile (.profraw) to write, or empty to disable
+		 *
+		 * @note Must be called before writeObject() or writeExecutable()
+		 * @note writeExecutable() links with the clang driver, which adds the profile runtime
+		 * @note Default is disabled
+		 */
+		void setProfileGenerate(const std::string& profileFile);
+
+		/**
+		 * @brief Optimize with a recorded profile
+		 *
+		 * Attaches the recorded branch weights and function entry counts,
+		 * marks hot and cold functions and lets the inliner favor hot call
+		 * sites. Functions that changed since the profile was recorded are
+		 * optimized without it.
+		 *
+		 * @param profileFile Indexed profile (.profdata), or empty to disable
+		 *
+		 * @note Must be called before writeObject() or writeExecutable()
+		 * @note Has no effect at optimization level 0 or together with setProfileGenerate()
+		 * @note Default is disabled
+		 */
+		void setProfileUse(const std::string& profileFile);
+
 		/**
 		 * @brief Add a library search path for linking
 		 *
@@ -0,0 +1,135 @@
+/**
+ * @file jit.h
+ * @brief In-process JIT compilation for Quadrate
+ *
+ * Provides an ORC LLJIT instance that runs modules produced by LlvmGenerator
+ * without writing object files or starting a linker.
+ */
+
+#ifndef LLVMGEN_JIT_H
+#define LLVMGEN_JIT_H
+
+#include <memory>
+#include <string>
+
+// Forward declarations for LLVM types
+namespace llvm {
+	class LLVMContext;
+	class Module;
+} // namespace llvm
+
+namespace Qd {
+
+	/**
+	 * @brief JIT compiler for generated Quadrate modules
+	 *
+	 * Wraps an LLVM ORC LLJIT instance. Runtime functions (qd_*) are resolved
+	 * from the current process; additional symbols such as native functions
+	 * can be defined before or after modules are added.
+	 *
+	 * @par Example Usage:
+	 * @code
+	 * Qd::LlvmJit jit;
+	 * Qd::LlvmGenerator gen;
+	 * if (gen.generate(root, "math") && gen.addToJit(jit)) {
+	 *     auto fn = reinterpret_cast<qd_exec_result (*)(qd_context*)>(jit.lookup("usr_main_square"));
+	 * }
+	 * @endcode
+	 *
+	 * @note Uses the Pimpl idiom to hide LLVM implementation details
+	 */
+	class LlvmJit {
+	public:
+		/**
+		 * @brief Create a JIT for the host target
+		 *
+		 * @note Errors are reported to stderr; check isValid() afterwards
+		 */
+		LlvmJit();
+
+		/**
+		 * @brief Destructor - frees all code compiled by this JIT
+		 */
+		~LlvmJit();
+
+		/**
+		 * @brief Check whether the JIT was created successfully
+		 *
+		 * @return true if modules can be added
+		 */
+		bool isValid() const;
+
+		/**
+		 * @brief Get the data layout string of the JIT's target
+		 *
+		 * @return Data layout for modules added to this JIT
+		 */
+		std::string dataLayout() const;
+
+		/**
+		 * @brief Get the target triple of the JIT
+		 *
+		 * @return Target triple for modules added to this JIT
+		 */
+		std::string targetTriple() const;
+
+		/**
+		 * @brief Define a symbol at a fixed address
+		 *
+		 * Makes an existing function (e.g. a registered native function)
+		 * callable from JIT-compiled code and visible to lookup().
+		 *
+		 * @param name Symbol name
+		 * @param address Address of the function
+		 * @return true if defined, false if the name is already defined
+		 */
+		bool defineSymbol(const std::string& name, void* address);
+
+		/**
+		 * @brief Make a library's symbols available to JIT-compiled code
+		 *
+		 * Static libraries (.a) are linked into the JIT on demand; shared
+		 * libraries are loaded into the process. Adding the same library
+		 * again has no effect.
+		 *
+		 * @param path Path or name of the library
+		 * @return true on success, false if the library can't be loaded
+		 */
+		bool addLibrary(const std::string& path);
+
+		/**
+		 * @brief Add an LLVM module to the JIT
+		 *
+		 * Takes ownership of the module and its context. Code is compiled
+		 * lazily on the first lookup() of one of its symbols. Modules may
+		 * refer to functions defined by modules added earlier.
+		 *
+		 * @param context Context the module was created in
+		 * @param module Module to add (data layout must match dataLayout())
+		 * @return true on success, false on error
+		 *
+		 * @note Usually called through LlvmGenerator::addToJit()
+		 */
+		bool addModule(std::unique_ptr<llvm::LLVMContext> context, std::unique_ptr<llvm::Module> module);
+
+		/**
+		 * @brief Look up the address of a symbol
+		 *
+		 * @param name Symbol name (e.g., "usr_main_square")
+		 * @return Address of the symbol, or NULL if it isn't defined
+		 */
+		void* lookup(const std::string& name);
+
+	private:
+		/**
+		 * @brief Private implementation (Pimpl idiom)
+		 *
+		 * Hides LLVM implementation details from the public interface.
+		 */
+		class Impl;
+		std::unique_ptr<Impl> impl; ///< Pointer to implementation
+	};
+
+} // namespace Qd
+
+#endif // LLVMGEN_JIT_H
@@ -1,23 +1,33 @@
+#include "passes.h"
 #include <llvmgen/generator.h>
+#include <llvmgen/jit.h>
 
+#include <llvm/IR/CFG.h>
 #include <llvm/IR/DIBuilder.h>
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstIterator.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Linker/Linker.h>
 #include <llvm/MC/TargetRegistry.h>
+#include <llvm/Passes/PassBuilder.h>
 #include <llvm/Support/FileSystem.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/PGOOptions.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/VirtualFileSystem.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Target/TargetMachine.h>
 #include <llvm/Target/TargetOptions.h>
 #include <llvm/TargetParser/Host.h>
-#include <llvm/Transforms/IPO.h>
-#include <llvm/Transforms/InstCombine/InstCombine.h>
-#include <llvm/Transforms/Scalar.h>
-#include <llvm/Transforms/Scalar/GVN.h>
-#include <llvm/Transforms/Utils.h>
+
+#ifdef QD_HAVE_LLD
+#include <lld/Common/Driver.h>
+LLD_HAS_DRIVER(elf)
+#endif
 
 #include <qc/ast_node.h>
 #include <qc/ast_node_break.h>
@@ -36,19 +46,26 @@
 #include <qc/ast_node_local.h>
 #include <qc/ast_node_loop.h>
 #include <qc/ast_node_parameter.h>
+#include <qc/ast_node_program.h>
 #include <qc/ast_node_return.h>
 #include <qc/ast_node_scoped.h>
 #include <qc/ast_node_struct.h>
 #include <qc/ast_node_switch.h>
 #include <qc/ast_node_use.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <cstdlib>
 #include <filesystem>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
+#include <optional>
 #include <set>
 #include <string>
+#include <unistd.h>
 #include <vector>
 
 namespace Qd {
@@ -56,6 +73,24 @@ namespace Qd {
 	// Default stack size for runtime context creation
 	static const size_t DEFAULT_STACK_SIZE = 1024;
 
+	// Default stack size with stack growth: 16 MiB of address space, committed as it is used
+	static const size_t DEFAULT_GROWABLE_STACK_SIZE = 1024 * 1024;
+
+	// Runtime type tags (qd_stack_type in qdrt/stack.h)
+	static const uint32_t QD_TYPE_INT = 0;
+	static const uint32_t QD_TYPE_FLOAT = 1;
+	static const uint32_t QD_TYPE_PTR = 2;
+
+	// Stack layout (QD_COMPACT_STACK in qdrt/stack.h): st->data is either an array of qd_stack_element_t,
+	// or an array of 8-byte values with one tag byte per slot in st->tags
+#ifdef QD_COMPACT_STACK
+	static const bool COMPACT_STACK = true;
+#else
+	static const bool COMPACT_STACK = false;
+#endif
+	static const uint8_t QD_TAG_TYPE_MASK = 0x03;
+	static const uint8_t QD_TAG_BORROWED = 0x08;
+
 	class LlvmGenerator::Impl {
 	public:
 		std::unique_ptr<llvm::LLVMContext> context;
@@ -75,6 +110,21 @@ namespace Qd {
 		// Optimization level (0-3)
 		int optimizationLevel = 0;
 
+		// Link the runtime and library bitcode in for inlining (-flto)
+		bool linkTimeOptimization = false;
+
+		// Profile-guided optimization: raw profile the instrumented program writes, and indexed profile to use
+		std::string profileGenerateFile;
+		std::string profileUseFile;
+
+		// Release mode: elide checks the validator proved, optionally drop call stack bookkeeping
+		bool runtimeChecks = true;
+		bool callStackTracking = true;
+
+		// Data stack of main's context (0: default for the growth mode); spawned tasks inherit it
+		size_t stackSize = 0;
+		bool stackGrowth = false;
+
 		// Runtime types
 		llvm::Type* contextPtrTy = nullptr;
 		llvm::Type* execResultTy = nullptr;
@@ -84,9 +134,11 @@ namespace Qd {
 		llvm::Function* createContextFn = nullptr;
 		llvm::Function* freeContextFn = nullptr;
 		llvm::Function* cloneContextFn = nullptr;
+		llvm::Function* cloneContextWindowFn = nullptr;
 		llvm::Function* pushIntFn = nullptr;
 		llvm::Function* pushFloatFn = nullptr;
 		llvm::Function* pushStrFn = nullptr;
+		llvm::Function* pushLitFn = nullptr;
 		llvm::Function* pushPtrFn = nullptr;
 		llvm::Function* callFn = nullptr;
 		llvm::Function* printsFn = nullptr;
@@ -96,6 +148,7 @@ namespace Qd {
 		llvm::Function* pushCallFn = nullptr;
 		llvm::Function* popCallFn = nullptr;
 		llvm::Function* checkStackFn = nullptr;
+		llvm::Function* checkStackNumericFn = nullptr;
 		llvm::Function* strdupFn = nullptr;
 		llvm::Function* mallocFn = nullptr;
 		llvm::Function* freeFn = nullptr;
@@ -133,11 +186,46 @@ namespace Qd {
 		// Track additional library search paths (for third-party packages)
 		std::vector<std::string> librarySearchPaths;
 
+		// Modules linked from object files (module name -> object file); their functions are only declared
+		std::map<std::string, std::string> precompiledModules;
+
+		// Set by generateModule(): only this module's functions are defined, everything else is declared
+		std::string definedModule;
+
+		// Main file functions compiled by an earlier generator (e.g. REPL lines in the same JIT)
+		std::set<std::string> declaredFunctions;
+
 		// Function context for return
 		llvm::BasicBlock* currentFunctionReturnBlock = nullptr;
 		bool currentFunctionIsFallible = false;
 		bool currentFunctionIsIntegerOnly = false;  // For type specialization
 
+		// Virtual stack: values pushed by straight-line code are held here as SSA values instead of being
+		// stored to ctx->st. They are written back (materialized) before anything that observes the real stack.
+		struct VirtualValue {
+			llvm::Value* value;
+			uint32_t type; // QD_TYPE_INT (i64), QD_TYPE_FLOAT (double) or QD_TYPE_PTR (ptr)
+		};
+		struct VirtualStackEdge {
+			llvm::BasicBlock* block;
+			std::vector<VirtualValue> values;
+		};
+		std::vector<VirtualValue> virtualStack;
+		llvm::Value* virtualStackCtx = nullptr; // Context the pending values belong to
+
+		// Fully typed functions get a native entry point taking and returning values in registers.
+		// The usr_<prefix>_<name>(qd_context*) symbol stays as a stack adapter around it.
+		struct NativeSignature {
+			llvm::Function* fn;
+			std::vector<uint32_t> inputs;
+			std::vector<uint32_t> outputs;
+		};
+		std::map<std::string, NativeSignature> nativeFunctions; // Keyed like userFunctions
+
+		// With runtime checks disabled, usr_<prefix>_<name> checks the stack and forwards to an internal
+		// unchecked body that call sites proven by the validator call directly
+		std::map<std::string, llvm::Function*> uncheckedFunctions; // Keyed like userFunctions
+
 		// Defer statements collected during function generation
 		std::vector<AstNodeDefer*> currentDeferStatements;
 
@@ -179,8 +267,12 @@ namespace Qd {
 
 		void setupRuntimeDeclarations();
 		bool generateProgram(IAstNode* root);
+		void runOptimizationPasses(llvm::TargetMachine* targetMachine = nullptr);
+		bool linkRuntimeBitcode();
 		bool generateFunction(
 				AstNodeFunctionDeclaration* funcNode, bool isMain, const std::string& namePrefix = "main");
+		bool isModuleDeclaredOnly(const std::string& moduleName) const;
+		void declareModuleFunction(AstNodeFunctionDeclaration* funcNode, const std::string& namePrefix);
 		void generateNode(IAstNode* node, llvm::Value* ctx, llvm::Value* forIterVar = nullptr);
 		void generateInstruction(AstNodeInstruction* inst, llvm::Value* ctx);
 		void generateLiteral(AstNodeLiteral* lit, llvm::Value* ctx);
@@ -188,6 +280,9 @@ namespace Qd {
 		void generateFor(AstNodeForStatement* forStmt, llvm::Value* ctx);
 		void generateLoop(AstNodeLoopStatement* loopStmt, llvm::Value* ctx);
 		void generateCtxBlock(AstNodeCtx* ctxNode, llvm::Value* ctx, llvm::Value* forIterVar);
+		std::optional<size_t> ctxBlockReach(AstNodeCtx* ctxNode, size_t* peak = nullptr);
+		bool trackStackReach(
+				IAstNode* node, int64_t& height, int64_t& low, int64_t& high, std::set<std::string>& locals);
 		void generateIdentifier(AstNodeIdentifier* ident, llvm::Value* ctx, llvm::Value* forIterVar);
 		void generateFunctionPointer(AstNodeFunctionPointerReference* funcPtr, llvm::Value* ctx);
 		void generateScopedIdentifier(AstNodeScopedIdentifier* scopedIdent, llvm::Value* ctx);
@@ -200,6 +295,24 @@ namespace Qd {
 		void generateFieldAccess(AstNodeFieldAccess* fieldAccess, llvm::Value* ctx);
 		size_t getTypeSize(const std::string& typeName);
 
+		// Stack slot addressing, shared by all inline stack operations so they work with either layout
+		struct StackSlot {
+			llvm::Value* ptr; // &data[i]: the whole element, or just its 8-byte value in the compact layout
+			llvm::Value* tag; // &tags[i] in the compact layout, nullptr otherwise
+		};
+		struct SlotContents {
+			llvm::Value* value; // The whole element, or just its 8-byte value in the compact layout
+			llvm::Value* tag;	// Tag byte in the compact layout, nullptr otherwise
+		};
+		StackSlot stackSlot(llvm::Value* st, llvm::Value* data, llvm::Value* index, const llvm::Twine& name);
+		StackSlot stackSlotOffset(const StackSlot& base, uint64_t offset, const llvm::Twine& name);
+		llvm::Value* slotValuePtr(const StackSlot& slot, const llvm::Twine& name);
+		llvm::Value* loadSlotType(const StackSlot& slot, const llvm::Twine& name);
+		llvm::Value* loadSlotBorrowed(const StackSlot& slot, const llvm::Twine& name);
+		void storeSlotType(const StackSlot& slot, llvm::Value* type);
+		SlotContents loadSlot(const StackSlot& slot, const llvm::Twine& name);
+		void storeSlot(const StackSlot& slot, const SlotContents& contents);
+
 		// Inline stack operations (performance optimization)
 		void generateInlinePushInt(llvm::Value* ctx, int64_t value);
 		void generateInlinePushIntValue(llvm::Value* ctx, llvm::Value* value);
@@ -222,6 +335,27 @@ namespace Qd {
 		void generateInlineDrop(llvm::Value* ctx);
 		void generateInlineOver(llvm::Value* ctx);
 		void generateInlineRot(llvm::Value* ctx);
+
+		// Virtual stack (register promotion of top-of-stack values)
+		bool virtualStackEnabled() const;
+		void pushVirtual(llvm::Value* ctx, llvm::Value* value, uint32_t type = QD_TYPE_INT);
+		bool generateVirtualInstruction(Opcode opcode, llvm::Value* ctx);
+		void materializeVirtualStack();
+		void mergeVirtualStacks(
+				llvm::BasicBlock* mergeBB, llvm::Value* ctx, const std::vector<VirtualStackEdge>& incoming);
+		void generateBlockChildren(IAstNode* block, llvm::Value* ctx, llvm::Value* forIterVar);
+
+		// Native calling convention
+		static bool nativeTypeFor(const std::string& typeStr, uint32_t& type);
+		llvm::Type* nativeLlvmType(uint32_t type);
+		bool hasNativeSignature(AstNodeFunctionDeclaration* funcNode);
+		bool generateNativeFunction(AstNodeFunctionDeclaration* funcNode, const std::string& namePrefix);
+		bool canCallNatively(const std::string& name, llvm::Value* ctx, const std::vector<CastDirection>& casts);
+		void generateNativeCall(const std::string& name, llvm::Value* ctx);
+		llvm::Value* loadStackValueAs(const StackSlot& slot, uint32_t type);
+		std::vector<llvm::Value*> popNativeValues(llvm::Value* ctx, const std::vector<uint32_t>& types);
+		void generateStackCheck(
+				llvm::Value* ctx, const std::vector<uint32_t>& types, llvm::Value* funcNameStr, bool numeric = false);
 	};
 
 	void LlvmGenerator::Impl::setupRuntimeDeclarations() {
@@ -231,14 +365,17 @@ namespace Qd {
 		// exec_result is a struct with one i32 field
 		execResultTy = llvm::StructType::create(*context, {builder->getInt32Ty()}, "qd_exec_result");
 
-		// qd_stack_element_t layout: { union(i64, double, ptr, ptr), i32 type, i8 is_error_tainted }
-		// Union is 8 bytes (i64/double), type is i32, bool is i8
+		// qd_stack_element_t layout: { union(i64, double, ptr, ptr), i32 type, i8 is_error_tainted, i8 is_borrowed }
+		// This is also the stack slot layout unless the runtime is built with QD_COMPACT_STACK (see stackSlot())
+		// Union is 8 bytes (i64/double), type is i32, bools are i8
 		// For simplicity, represent union as i64 since all variants fit
+		// is_borrowed must be modelled so whole-element copies (inline dup/swap) carry it along
 		stackElementTy = llvm::StructType::create(*context,
 				{
 						builder->getInt64Ty(), // union value (we'll access as i64)
 						builder->getInt32Ty(), // type
-						builder->getInt8Ty()   // is_error_tainted (bool is 1 byte, not 1 bit)
+						builder->getInt8Ty(),  // is_error_tainted (bool is 1 byte, not 1 bit)
+						builder->getInt8Ty()   // is_borrowed
 				},
 				"qd_stack_element_t");
 
@@ -257,6 +394,12 @@ namespace Qd {
 		cloneContextFn =
 				llvm::Function::Create(cloneContextFnTy, llvm::Function::ExternalLinkage, "qd_clone_context", *module);
 
+		// qd_clone_context_window(const qd_context* src, size_t depth, size_t capacity) -> qd_context*
+		auto cloneContextWindowFnTy = llvm::FunctionType::get(
+				contextPtrTy, {contextPtrTy, builder->getInt64Ty(), builder->getInt64Ty()}, false);
+		cloneContextWindowFn = llvm::Function::Create(
+				cloneContextWindowFnTy, llvm::Function::ExternalLinkage, "qd_clone_context_window", *module);
+
 		// qd_push_i(qd_context* ctx, int64_t value) -> qd_exec_result
 		auto pushIntFnTy = llvm::FunctionType::get(execResultTy, {contextPtrTy, builder->getInt64Ty()}, false);
 		pushIntFn = llvm::Function::Create(pushIntFnTy, llvm::Function::ExternalLinkage, "qd_push_i", *module);
@@ -270,6 +413,9 @@ namespace Qd {
 				llvm::FunctionType::get(execResultTy, {contextPtrTy, llvm::PointerType::getUnqual(*context)}, false);
 		pushStrFn = llvm::Function::Create(pushStrFnTy, llvm::Function::ExternalLinkage, "qd_push_s", *module);
 
+		// qd_push_lit(qd_context* ctx, const char* value) -> qd_exec_result (literal is not copied)
+		pushLitFn = llvm::Function::Create(pushStrFnTy, llvm::Function::ExternalLinkage, "qd_push_lit", *module);
+
 		// qd_push_p(qd_context* ctx, void* value) -> qd_exec_result
 		auto pushPtrFnTy =
 				llvm::FunctionType::get(execResultTy, {contextPtrTy, llvm::PointerType::getUnqual(*context)}, false);
@@ -310,6 +456,10 @@ namespace Qd {
 		checkStackFn =
 				llvm::Function::Create(checkStackFnTy, llvm::Function::ExternalLinkage, "qd_check_stack", *module);
 
+		// qd_check_stack_numeric(qd_context* ctx, size_t count, const qd_stack_type* types, const char* func_name) -> void
+		checkStackNumericFn = llvm::Function::Create(
+				checkStackFnTy, llvm::Function::ExternalLinkage, "qd_check_stack_numeric", *module);
+
 		// For if statements, we need: qd_stack_pop and qd_stack_size
 		// qd_stack_pop(qd_stack* st, qd_stack_element_t* elem) -> qd_stack_error (i32)
 		auto stackPopFnTy = llvm::FunctionType::get(builder->getInt32Ty(),
@@ -527,6 +677,87 @@ namespace Qd {
 		}
 	}
 
+	LlvmGenerator::Impl::StackSlot LlvmGenerator::Impl::stackSlot(
+			llvm::Value* st, llvm::Value* data, llvm::Value* index, const llvm::Twine& name) {
+		if (!COMPACT_STACK) {
+			return {builder->CreateGEP(stackElementTy, data, index, name), nullptr};
+		}
+
+		// Compact layout: qd_stack is { data, capacity, size, tags }
+		llvm::Type* stackTy = llvm::StructType::get(*context,
+				{llvm::PointerType::get(*context, 0), builder->getInt64Ty(), builder->getInt64Ty(),
+						llvm::PointerType::get(*context, 0)},
+				false);
+		llvm::Value* tagsPtr = builder->CreateStructGEP(stackTy, st, 3, "tags_ptr");
+		llvm::Value* tags = builder->CreateLoad(llvm::PointerType::get(*context, 0), tagsPtr, "tags");
+		return {builder->CreateGEP(builder->getInt64Ty(), data, index, name),
+				builder->CreateGEP(builder->getInt8Ty(), tags, index, name + "_tag")};
+	}
+
+	LlvmGenerator::Impl::StackSlot LlvmGenerator::Impl::stackSlotOffset(
+			const StackSlot& base, uint64_t offset, const llvm::Twine& name) {
+		if (!COMPACT_STACK) {
+			return {builder->CreateConstGEP1_64(stackElementTy, base.ptr, offset, name), nullptr};
+		}
+		return {builder->CreateConstGEP1_64(builder->getInt64Ty(), base.ptr, offset, name),
+				builder->CreateConstGEP1_64(builder->getInt8Ty(), base.tag, offset, name + "_tag")};
+	}
+
+	llvm::Value* LlvmGenerator::Impl::slotValuePtr(const StackSlot& slot, const llvm::Twine& name) {
+		if (!COMPACT_STACK) {
+			return builder->CreateStructGEP(stackElementTy, slot.ptr, 0, name);
+		}
+		return slot.ptr;
+	}
+
+	llvm::Value* LlvmGenerator::Impl::loadSlotType(const StackSlot& slot, const llvm::Twine& name) {
+		if (!COMPACT_STACK) {
+			llvm::Value* typePtr = builder->CreateStructGEP(stackElementTy, slot.ptr, 1, name + "_ptr");
+			return builder->CreateLoad(builder->getInt32Ty(), typePtr, name);
+		}
+		llvm::Value* tag = builder->CreateLoad(builder->getInt8Ty(), slot.tag, name + "_tag");
+		llvm::Value* type = builder->CreateAnd(tag, builder->getInt8(QD_TAG_TYPE_MASK), name + "_bits");
+		return builder->CreateZExt(type, builder->getInt32Ty(), name);
+	}
+
+	llvm::Value* LlvmGenerator::Impl::loadSlotBorrowed(const StackSlot& slot, const llvm::Twine& name) {
+		if (!COMPACT_STACK) {
+			llvm::Value* borrowedPtr = builder->CreateStructGEP(stackElementTy, slot.ptr, 3, name + "_ptr");
+			llvm::Value* borrowed = builder->CreateLoad(builder->getInt8Ty(), borrowedPtr, name + "_byte");
+			return builder->CreateICmpNE(borrowed, builder->getInt8(0), name);
+		}
+		llvm::Value* tag = builder->CreateLoad(builder->getInt8Ty(), slot.tag, name + "_tag");
+		llvm::Value* borrowed = builder->CreateAnd(tag, builder->getInt8(QD_TAG_BORROWED), name + "_bits");
+		return builder->CreateICmpNE(borrowed, builder->getInt8(0), name);
+	}
+
+	void LlvmGenerator::Impl::storeSlotType(const StackSlot& slot, llvm::Value* type) {
+		// Only used for non-string values, so the slot ends up untainted and not borrowed
+		if (!COMPACT_STACK) {
+			llvm::Value* typePtr = builder->CreateStructGEP(stackElementTy, slot.ptr, 1, "type_ptr");
+			builder->CreateStore(type, typePtr);
+			llvm::Value* taintedPtr = builder->CreateStructGEP(stackElementTy, slot.ptr, 2, "tainted_ptr");
+			builder->CreateStore(builder->getInt1(false), taintedPtr);
+			return;
+		}
+		builder->CreateStore(builder->CreateTrunc(type, builder->getInt8Ty(), "type_tag"), slot.tag);
+	}
+
+	LlvmGenerator::Impl::SlotContents LlvmGenerator::Impl::loadSlot(const StackSlot& slot, const llvm::Twine& name) {
+		if (!COMPACT_STACK) {
+			return {builder->CreateLoad(stackElementTy, slot.ptr, name), nullptr};
+		}
+		return {builder->CreateLoad(builder->getInt64Ty(), slot.ptr, name),
+				builder->CreateLoad(builder->getInt8Ty(), slot.tag, name + "_tag")};
+	}
+
+	void LlvmGenerator::Impl::storeSlot(const StackSlot& slot, const SlotContents& contents) {
+		builder->CreateStore(contents.value, slot.ptr);
+		if (COMPACT_STACK) {
+			builder->CreateStore(contents.tag, slot.tag);
+		}
+	}
+
 	void LlvmGenerator::Impl::generateInlinePushInt(llvm::Value* ctx, int64_t value) {
 		// Inline implementation of qd_push_i to eliminate function call overhead
 		// This directly manipulates the stack structure:
@@ -561,20 +792,15 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		// Calculate &data[size]
-		llvm::Value* elemPtr = builder->CreateGEP(stackElementTy, data, size, "elem_ptr");
+		StackSlot elemSlot = stackSlot(st, data, size, "elem_ptr");
 
 		// Set element value: elem->value.i = value (field 0)
-		llvm::Value* valuePtr = builder->CreateStructGEP(stackElementTy, elemPtr, 0, "value_ptr");
+		llvm::Value* valuePtr = slotValuePtr(elemSlot, "value_ptr");
 		llvm::Value* valueiPtr = builder->CreateBitCast(valuePtr, llvm::PointerType::get(*context, 0));
 		builder->CreateStore(builder->getInt64(static_cast<uint64_t>(value)), valueiPtr);
 
-		// Set element type: elem->type = QD_STACK_TYPE_INT (0) (field 1)
-		llvm::Value* typePtr = builder->CreateStructGEP(stackElementTy, elemPtr, 1, "type_ptr");
-		builder->CreateStore(builder->getInt32(0), typePtr);
-
-		// Set element is_error_tainted: elem->is_error_tainted = false (field 2)
-		llvm::Value* taintedPtr = builder->CreateStructGEP(stackElementTy, elemPtr, 2, "tainted_ptr");
-		builder->CreateStore(builder->getInt1(false), taintedPtr);
+		// Set element type: elem->type = QD_STACK_TYPE_INT (0), elem->is_error_tainted = false
+		storeSlotType(elemSlot, builder->getInt32(0));
 
 		// Increment size: st->size++
 		llvm::Value* newSize = builder->CreateAdd(size, builder->getInt64(1), "new_size");
@@ -603,20 +829,15 @@ namespace Qd {
 		llvm::Value* dataPtr = builder->CreateStructGEP(stackTy, st, 0, "data_ptr");
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
-		llvm::Value* elemPtr = builder->CreateGEP(stackElementTy, data, size, "elem_ptr");
+		StackSlot elemSlot = stackSlot(st, data, size, "elem_ptr");
 
 		// Store runtime value
-		llvm::Value* valuePtr = builder->CreateStructGEP(stackElementTy, elemPtr, 0, "value_ptr");
+		llvm::Value* valuePtr = slotValuePtr(elemSlot, "value_ptr");
 		llvm::Value* valueiPtr = builder->CreateBitCast(valuePtr, llvm::PointerType::get(*context, 0));
 		builder->CreateStore(value, valueiPtr);
 
-		// Set type to integer
-		llvm::Value* typePtr = builder->CreateStructGEP(stackElementTy, elemPtr, 1, "type_ptr");
-		builder->CreateStore(builder->getInt32(0), typePtr);
-
-		// Set is_error_tainted to false
-		llvm::Value* taintedPtr = builder->CreateStructGEP(stackElementTy, elemPtr, 2, "tainted_ptr");
-		builder->CreateStore(builder->getInt1(false), taintedPtr);
+		// Set type to integer (also clears is_error_tainted)
+		storeSlotType(elemSlot, builder->getInt32(0));
 
 		// Increment size
 		llvm::Value* newSize = builder->CreateAdd(size, builder->getInt64(1), "new_size");
@@ -652,15 +873,15 @@ namespace Qd {
 
 		// Load first operand: data[size - 2]
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
-		llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
+		llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 		llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 		llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
 		// Load second operand: data[size - 1]
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
-		llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
+		llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 		llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 		llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -698,14 +919,14 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
-		llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
+		llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 		llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 		llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
-		llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
+		llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 		llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 		llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -741,14 +962,14 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
-		llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
+		llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 		llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 		llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
-		llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
+		llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 		llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 		llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -790,17 +1011,14 @@ namespace Qd {
 
 		// Get pointers to top two elements
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
-
-		// Load types of both elements (field 1 of qd_stack_element_t)
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		// Load types of both elements
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		// Check if both are integers (QD_STACK_TYPE_INT = 0)
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
@@ -818,11 +1036,11 @@ namespace Qd {
 		builder->SetInsertPoint(fastPath);
 		{
 			// Load integer values (field 0, accessed as i64)
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -872,16 +1090,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
-
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -895,11 +1110,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -944,16 +1159,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
-
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -967,11 +1179,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -1011,16 +1223,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
-
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -1034,11 +1243,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -1086,16 +1295,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
-
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -1109,11 +1315,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -1160,16 +1366,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
-
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -1183,11 +1386,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -1236,19 +1439,40 @@ namespace Qd {
 
 		// Get pointer to top element (size - 1)
 		llvm::Value* topIdx = builder->CreateSub(size, builder->getInt64(1), "top_idx");
-		llvm::Value* topElemPtr = builder->CreateGEP(stackElementTy, data, topIdx, "top_elem");
+		StackSlot topSlot = stackSlot(st, data, topIdx, "top_elem");
+
+		// Owned strings need a copy of their own, let the runtime handle those
+		llvm::Value* topType = loadSlotType(topSlot, "top_type");
+		llvm::Value* topBorrowed = loadSlotBorrowed(topSlot, "top_borrowed");
+		llvm::Value* isOwnedStr = builder->CreateAnd(builder->CreateICmpEQ(topType, builder->getInt32(3)),
+				builder->CreateNot(topBorrowed), "is_owned_str"); // QD_STACK_TYPE_STR = 3
 
-		// Get pointer to new element (size)
-		llvm::Value* newElemPtr = builder->CreateGEP(stackElementTy, data, size, "new_elem");
+		llvm::Function* currentFn = builder->GetInsertBlock()->getParent();
+		llvm::BasicBlock* copyBB = llvm::BasicBlock::Create(*context, "dup_copy", currentFn);
+		llvm::BasicBlock* strBB = llvm::BasicBlock::Create(*context, "dup_str", currentFn);
+		llvm::BasicBlock* doneBB = llvm::BasicBlock::Create(*context, "dup_done", currentFn);
+		builder->CreateCondBr(isOwnedStr, strBB, copyBB);
+
+		builder->SetInsertPoint(strBB);
+		llvm::Function* dupFn = module->getFunction("qd_dup");
+		if (!dupFn) {
+			auto fnTy = llvm::FunctionType::get(execResultTy, {contextPtrTy}, false);
+			dupFn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, "qd_dup", *module);
+		}
+		builder->CreateCall(dupFn, {ctx});
+		builder->CreateBr(doneBB);
 
-		// Copy entire element (value union, type, is_error_tainted)
-		// Element size is 16 bytes (8 for union, 4 for type, 1 for bool + padding)
-		llvm::Value* topValue = builder->CreateLoad(stackElementTy, topElemPtr, "top_value");
-		builder->CreateStore(topValue, newElemPtr);
+		// Copy entire element (value union, type, is_error_tainted, is_borrowed)
+		builder->SetInsertPoint(copyBB);
+		StackSlot newSlot = stackSlot(st, data, size, "new_elem");
+		storeSlot(newSlot, loadSlot(topSlot, "top_value"));
 
 		// Increment size
 		llvm::Value* newSize = builder->CreateAdd(size, builder->getInt64(1), "new_size");
 		builder->CreateStore(newSize, sizePtr);
+		builder->CreateBr(doneBB);
+
+		builder->SetInsertPoint(doneBB);
 	}
 
 	void LlvmGenerator::Impl::generateInlineSwap(llvm::Value* ctx) {
@@ -1269,18 +1493,18 @@ namespace Qd {
 
 		// Get pointers to top two elements
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
 		// Load both elements
-		llvm::Value* elem1 = builder->CreateLoad(stackElementTy, elem1Ptr, "elem1");
-		llvm::Value* elem2 = builder->CreateLoad(stackElementTy, elem2Ptr, "elem2");
+		SlotContents elem1 = loadSlot(elem1Slot, "elem1");
+		SlotContents elem2 = loadSlot(elem2Slot, "elem2");
 
 		// Store them swapped
-		builder->CreateStore(elem2, elem1Ptr);
-		builder->CreateStore(elem1, elem2Ptr);
+		storeSlot(elem1Slot, elem2);
+		storeSlot(elem2Slot, elem1);
 	}
 
 	void LlvmGenerator::Impl::generateInlineDrop(llvm::Value* ctx) {
@@ -1318,16 +1542,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
-
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -1341,11 +1562,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -1391,16 +1612,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
-
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -1414,11 +1632,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -1464,16 +1682,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
-
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -1487,11 +1702,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -1537,16 +1752,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
-
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -1560,11 +1772,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -1608,16 +1820,13 @@ namespace Qd {
 		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
 
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(2), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(1), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
-		llvm::Value* type1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 1, "type1_ptr");
-		llvm::Value* type1 = builder->CreateLoad(builder->getInt32Ty(), type1Ptr, "type1");
-
-		llvm::Value* type2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 1, "type2_ptr");
-		llvm::Value* type2 = builder->CreateLoad(builder->getInt32Ty(), type2Ptr, "type2");
+		llvm::Value* type1 = loadSlotType(elem1Slot, "type1");
+		llvm::Value* type2 = loadSlotType(elem2Slot, "type2");
 
 		llvm::Value* type1IsInt = builder->CreateICmpEQ(type1, builder->getInt32(0), "type1_is_int");
 		llvm::Value* type2IsInt = builder->CreateICmpEQ(type2, builder->getInt32(0), "type2_is_int");
@@ -1631,11 +1840,11 @@ namespace Qd {
 
 		builder->SetInsertPoint(fastPath);
 		{
-			llvm::Value* value1Ptr = builder->CreateStructGEP(stackElementTy, elem1Ptr, 0, "value1_ptr");
+			llvm::Value* value1Ptr = slotValuePtr(elem1Slot, "value1_ptr");
 			llvm::Value* value1iPtrCast = builder->CreateBitCast(value1Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value1 = builder->CreateLoad(builder->getInt64Ty(), value1iPtrCast, "value1");
 
-			llvm::Value* value2Ptr = builder->CreateStructGEP(stackElementTy, elem2Ptr, 0, "value2_ptr");
+			llvm::Value* value2Ptr = slotValuePtr(elem2Slot, "value2_ptr");
 			llvm::Value* value2iPtrCast = builder->CreateBitCast(value2Ptr, llvm::PointerType::get(*context, 0));
 			llvm::Value* value2 = builder->CreateLoad(builder->getInt64Ty(), value2iPtrCast, "value2");
 
@@ -1680,14 +1889,13 @@ namespace Qd {
 
 		// Get second from top (size - 2)
 		llvm::Value* secondIdx = builder->CreateSub(size, builder->getInt64(2), "second_idx");
-		llvm::Value* secondElemPtr = builder->CreateGEP(stackElementTy, data, secondIdx, "second_elem");
+		StackSlot secondSlot = stackSlot(st, data, secondIdx, "second_elem");
 
 		// Get new top position (size)
-		llvm::Value* newElemPtr = builder->CreateGEP(stackElementTy, data, size, "new_elem");
+		StackSlot newSlot = stackSlot(st, data, size, "new_elem");
 
 		// Copy second element to new top
-		llvm::Value* secondValue = builder->CreateLoad(stackElementTy, secondElemPtr, "second_value");
-		builder->CreateStore(secondValue, newElemPtr);
+		storeSlot(newSlot, loadSlot(secondSlot, "second_value"));
 
 		// Increment size
 		llvm::Value* newSize = builder->CreateAdd(size, builder->getInt64(1), "new_size");
@@ -1712,23 +1920,481 @@ namespace Qd {
 
 		// Get pointers to top three elements
 		llvm::Value* idx1 = builder->CreateSub(size, builder->getInt64(3), "idx1");
-		llvm::Value* elem1Ptr = builder->CreateGEP(stackElementTy, data, idx1, "elem1_ptr");
+		StackSlot elem1Slot = stackSlot(st, data, idx1, "elem1_ptr");
 
 		llvm::Value* idx2 = builder->CreateSub(size, builder->getInt64(2), "idx2");
-		llvm::Value* elem2Ptr = builder->CreateGEP(stackElementTy, data, idx2, "elem2_ptr");
+		StackSlot elem2Slot = stackSlot(st, data, idx2, "elem2_ptr");
 
 		llvm::Value* idx3 = builder->CreateSub(size, builder->getInt64(1), "idx3");
-		llvm::Value* elem3Ptr = builder->CreateGEP(stackElementTy, data, idx3, "elem3_ptr");
+		StackSlot elem3Slot = stackSlot(st, data, idx3, "elem3_ptr");
 
 		// Load all three
-		llvm::Value* elem1 = builder->CreateLoad(stackElementTy, elem1Ptr, "elem1");
-		llvm::Value* elem2 = builder->CreateLoad(stackElementTy, elem2Ptr, "elem2");
-		llvm::Value* elem3 = builder->CreateLoad(stackElementTy, elem3Ptr, "elem3");
+		SlotContents elem1 = loadSlot(elem1Slot, "elem1");
+		SlotContents elem2 = loadSlot(elem2Slot, "elem2");
+		SlotContents elem3 = loadSlot(elem3Slot, "elem3");
 
 		// Rotate: a b c -> b c a
-		builder->CreateStore(elem2, elem1Ptr);
-		builder->CreateStore(elem3, elem2Ptr);
-		builder->CreateStore(elem1, elem3Ptr);
+		storeSlot(elem1Slot, elem2);
+		storeSlot(elem2Slot, elem3);
+		storeSlot(elem3Slot, elem1);
+	}
+
+	bool LlvmGenerator::Impl::virtualStackEnabled() const {
+		// Same policy as the inline stack operations: keep every push observable when debugging
+		return !debugInfoEnabled;
+	}
+
+	void LlvmGenerator::Impl::pushVirtual(llvm::Value* ctx, llvm::Value* value, uint32_t type) {
+		// Pending values always belong to a single context (ctx blocks run on a clone)
+		if (virtualStackCtx != ctx) {
+			materializeVirtualStack();
+			virtualStackCtx = ctx;
+		}
+		virtualStack.push_back({value, type});
+	}
+
+	bool LlvmGenerator::Impl::generateVirtualInstruction(Opcode opcode, llvm::Value* ctx) {
+		// Only operations whose operands are all pending values of a known type are handled here.
+		// Anything touching values that already live in ctx->st falls back to the regular path.
+		if (!virtualStackEnabled() || virtualStackCtx != ctx) {
+			return false;
+		}
+
+		const size_t depth = virtualStack.size();
+		auto topTypesAre = [&](size_t count, uint32_t type) {
+			if (depth < count) {
+				return false;
+			}
+			for (size_t i = depth - count; i < depth; i++) {
+				if (virtualStack[i].type != type) {
+					return false;
+				}
+			}
+			return true;
+		};
+		auto pop = [this]() {
+			llvm::Value* value = virtualStack.back().value;
+			virtualStack.pop_back();
+			return value;
+		};
+
+		switch (opcode) {
+		case Opcode::SYM_ADD:
+		case Opcode::SYM_SUB:
+		case Opcode::SYM_MUL:
+		case Opcode::ADD:
+		case Opcode::SUB:
+		case Opcode::MUL: {
+			const bool isAdd = opcode == Opcode::SYM_ADD || opcode == Opcode::ADD;
+			const bool isSub = opcode == Opcode::SYM_SUB || opcode == Opcode::SUB;
+			if (topTypesAre(2, QD_TYPE_INT)) {
+				llvm::Value* b = pop();
+				llvm::Value* a = pop();
+				llvm::Value* result = isAdd   ? builder->CreateAdd(a, b, "vs_add")
+									  : isSub ? builder->CreateSub(a, b, "vs_sub")
+											  : builder->CreateMul(a, b, "vs_mul");
+				virtualStack.push_back({result, QD_TYPE_INT});
+				return true;
+			}
+			if (topTypesAre(2, QD_TYPE_FLOAT)) {
+				llvm::Value* b = pop();
+				llvm::Value* a = pop();
+				llvm::Value* result = isAdd   ? builder->CreateFAdd(a, b, "vs_fadd")
+									  : isSub ? builder->CreateFSub(a, b, "vs_fsub")
+											  : builder->CreateFMul(a, b, "vs_fmul");
+				virtualStack.push_back({result, QD_TYPE_FLOAT});
+				return true;
+			}
+			return false;
+		}
+
+		case Opcode::SYM_LT:
+		case Opcode::SYM_GT:
+		case Opcode::SYM_EQ:
+		case Opcode::SYM_NEQ:
+		case Opcode::SYM_LTE:
+		case Opcode::SYM_GTE:
+		case Opcode::LT:
+		case Opcode::GT:
+		case Opcode::EQ:
+		case Opcode::NEQ:
+		case Opcode::LTE:
+		case Opcode::GTE: {
+			const bool isInt = topTypesAre(2, QD_TYPE_INT);
+			if (!isInt && !topTypesAre(2, QD_TYPE_FLOAT)) {
+				return false;
+			}
+			llvm::CmpInst::Predicate pred = isInt ? llvm::CmpInst::ICMP_EQ : llvm::CmpInst::FCMP_OEQ;
+			if (opcode == Opcode::SYM_LT || opcode == Opcode::LT) {
+				pred = isInt ? llvm::CmpInst::ICMP_SLT : llvm::CmpInst::FCMP_OLT;
+			} else if (opcode == Opcode::SYM_GT || opcode == Opcode::GT) {
+				pred = isInt ? llvm::CmpInst::ICMP_SGT : llvm::CmpInst::FCMP_OGT;
+			} else if (opcode == Opcode::SYM_NEQ || opcode == Opcode::NEQ) {
+				pred = isInt ? llvm::CmpInst::ICMP_NE : llvm::CmpInst::FCMP_UNE;
+			} else if (opcode == Opcode::SYM_LTE || opcode == Opcode::LTE) {
+				pred = isInt ? llvm::CmpInst::ICMP_SLE : llvm::CmpInst::FCMP_OLE;
+			} else if (opcode == Opcode::SYM_GTE || opcode == Opcode::GTE) {
+				pred = isInt ? llvm::CmpInst::ICMP_SGE : llvm::CmpInst::FCMP_OGE;
+			}
+			llvm::Value* b = pop();
+			llvm::Value* a = pop();
+			llvm::Value* cmp =
+					isInt ? builder->CreateICmp(pred, a, b, "vs_cmp") : builder->CreateFCmp(pred, a, b, "vs_cmp");
+			// Comparisons always produce an integer 0/1
+			virtualStack.push_back({builder->CreateZExt(cmp, builder->getInt64Ty(), "vs_cmp_i64"), QD_TYPE_INT});
+			return true;
+		}
+
+		case Opcode::INC:
+		case Opcode::DEC:
+		case Opcode::NEG: {
+			if (!topTypesAre(1, QD_TYPE_INT)) {
+				return false;
+			}
+			llvm::Value* a = pop();
+			llvm::Value* result = nullptr;
+			if (opcode == Opcode::INC) {
+				result = builder->CreateAdd(a, builder->getInt64(1), "vs_inc");
+			} else if (opcode == Opcode::DEC) {
+				result = builder->CreateSub(a, builder->getInt64(1), "vs_dec");
+			} else {
+				result = builder->CreateNeg(a, "vs_neg");
+			}
+			virtualStack.push_back({result, QD_TYPE_INT});
+			return true;
+		}
+
+		// Stack shuffles only rearrange the pending values, no code is emitted
+		case Opcode::DUP:
+			if (depth < 1) {
+				return false;
+			}
+			virtualStack.push_back(virtualStack[depth - 1]);
+			return true;
+		case Opcode::DROP:
+			if (depth < 1) {
+				return false;
+			}
+			virtualStack.pop_back();
+			return true;
+		case Opcode::SWAP:
+			if (depth < 2) {
+				return false;
+			}
+			std::swap(virtualStack[depth - 1], virtualStack[depth - 2]);
+			return true;
+		case Opcode::OVER:
+			if (depth < 2) {
+				return false;
+			}
+			virtualStack.push_back(virtualStack[depth - 2]);
+			return true;
+		case Opcode::NIP:
+			if (depth < 2) {
+				return false;
+			}
+			virtualStack.erase(virtualStack.end() - 2);
+			return true;
+		case Opcode::TUCK: {
+			if (depth < 2) {
+				return false;
+			}
+			// ( a b -- b a b )
+			VirtualValue top = virtualStack[depth - 1];
+			virtualStack.insert(virtualStack.end() - 2, top);
+			return true;
+		}
+		case Opcode::ROT:
+			if (depth < 3) {
+				return false;
+			}
+			// ( a b c -- b c a )
+			std::rotate(virtualStack.end() - 3, virtualStack.end() - 2, virtualStack.end());
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	void LlvmGenerator::Impl::materializeVirtualStack() {
+		if (virtualStack.empty()) {
+			virtualStackCtx = nullptr;
+			return;
+		}
+
+		// Write all pending values with a single size update:
+		// data[size + i] = { value, type, false }, then size += n
+		llvm::Type* contextTy = llvm::StructType::get(*context, {llvm::PointerType::get(*context, 0)}, false);
+		llvm::Value* stPtr = builder->CreateStructGEP(contextTy, virtualStackCtx, 0, "st_ptr");
+		llvm::Value* st = builder->CreateLoad(llvm::PointerType::get(*context, 0), stPtr, "st");
+
+		llvm::Type* stackTy = llvm::StructType::get(*context,
+				{llvm::PointerType::get(*context, 0), builder->getInt64Ty(), builder->getInt64Ty()}, false);
+
+		llvm::Value* sizePtr = builder->CreateStructGEP(stackTy, st, 2, "size_ptr");
+		llvm::Value* size = builder->CreateLoad(builder->getInt64Ty(), sizePtr, "size");
+
+		llvm::Value* dataPtr = builder->CreateStructGEP(stackTy, st, 0, "data_ptr");
+		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
+
+		StackSlot baseSlot = stackSlot(st, data, size, "vs_base");
+		for (size_t i = 0; i < virtualStack.size(); i++) {
+			StackSlot elemSlot = stackSlotOffset(baseSlot, i, "vs_elem");
+
+			// The value union is stored with the value's own LLVM type (i64, double or ptr)
+			llvm::Value* valuePtr = slotValuePtr(elemSlot, "value_ptr");
+			builder->CreateStore(virtualStack[i].value, valuePtr);
+
+			storeSlotType(elemSlot, builder->getInt32(virtualStack[i].type));
+		}
+
+		llvm::Value* newSize = builder->CreateAdd(size, builder->getInt64(virtualStack.size()), "new_size");
+		builder->CreateStore(newSize, sizePtr);
+
+		virtualStack.clear();
+		virtualStackCtx = nullptr;
+	}
+
+	void LlvmGenerator::Impl::mergeVirtualStacks(
+			llvm::BasicBlock* mergeBB, llvm::Value* ctx, const std::vector<VirtualStackEdge>& incoming) {
+		// Predecessors that are not listed (return statements, breaks) always arrive with an empty virtual stack.
+		// If every edge carries the same shape the values are joined with PHIs, otherwise each edge writes its
+		// pending values back before branching.
+		bool compatible = !incoming.empty() && incoming.size() == llvm::pred_size(mergeBB);
+		for (size_t e = 1; compatible && e < incoming.size(); e++) {
+			const auto& values = incoming[e].values;
+			compatible = values.size() == incoming[0].values.size();
+			for (size_t i = 0; compatible && i < values.size(); i++) {
+				compatible = values[i].type == incoming[0].values[i].type;
+			}
+		}
+
+		virtualStack.clear();
+		virtualStackCtx = nullptr;
+
+		if (compatible) {
+			builder->SetInsertPoint(mergeBB);
+			for (size_t i = 0; i < incoming[0].values.size(); i++) {
+				const VirtualValue& first = incoming[0].values[i];
+				bool same = true;
+				for (const auto& edge : incoming) {
+					same = same && edge.values[i].value == first.value;
+				}
+				if (same) {
+					virtualStack.push_back(first);
+					continue;
+				}
+				llvm::PHINode* phi =
+						builder->CreatePHI(first.value->getType(), static_cast<unsigned>(incoming.size()), "vs_phi");
+				for (const auto& edge : incoming) {
+					phi->addIncoming(edge.values[i].value, edge.block);
+				}
+				virtualStack.push_back({phi, first.type});
+			}
+			virtualStackCtx = virtualStack.empty() ? nullptr : ctx;
+			return;
+		}
+
+		for (const auto& edge : incoming) {
+			if (edge.values.empty()) {
+				continue;
+			}
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnull-dereference"
+			builder->SetInsertPoint(edge.block->getTerminator());
+#pragma GCC diagnostic pop
+			virtualStack = edge.values;
+			virtualStackCtx = ctx;
+			materializeVirtualStack();
+		}
+		builder->SetInsertPoint(mergeBB);
+	}
+
+	bool LlvmGenerator::Impl::nativeTypeFor(const std::string& typeStr, uint32_t& type) {
+		if (typeStr == "i64" || typeStr == "int" || typeStr == "int64") {
+			type = QD_TYPE_INT;
+		} else if (typeStr == "f64") {
+			type = QD_TYPE_FLOAT;
+		} else if (typeStr == "ptr" || (!typeStr.empty() && typeStr[0] == '*')) {
+			type = QD_TYPE_PTR;
+		} else {
+			// Untyped, str (owned) and any have no fixed register representation
+			return false;
+		}
+		return true;
+	}
+
+	llvm::Type* LlvmGenerator::Impl::nativeLlvmType(uint32_t type) {
+		if (type == QD_TYPE_FLOAT) {
+			return builder->getDoubleTy();
+		}
+		if (type == QD_TYPE_PTR) {
+			return llvm::PointerType::getUnqual(*context);
+		}
+		return builder->getInt64Ty();
+	}
+
+	bool LlvmGenerator::Impl::hasNativeSignature(AstNodeFunctionDeclaration* funcNode) {
+		if (!virtualStackEnabled() || funcNode->throws()) {
+			return false;
+		}
+		if (funcNode->inputParameters().empty() && funcNode->outputParameters().empty()) {
+			return false;
+		}
+
+		uint32_t type = 0;
+		for (const auto* param : funcNode->inputParameters()) {
+			if (!nativeTypeFor(static_cast<const AstNodeParameter*>(param)->typeString(), type)) {
+				return false;
+			}
+		}
+		for (const auto* param : funcNode->outputParameters()) {
+			if (!nativeTypeFor(static_cast<const AstNodeParameter*>(param)->typeString(), type)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static uint32_t castedType(uint32_t type, const std::vector<CastDirection>& casts, size_t index) {
+		// Implicit parameter casts recorded by the semantic validator (indexed from the deepest parameter)
+		if (index < casts.size()) {
+			if (casts[index] == CastDirection::INT_TO_FLOAT && type == QD_TYPE_INT) {
+				return QD_TYPE_FLOAT;
+			}
+			if (casts[index] == CastDirection::FLOAT_TO_INT && type == QD_TYPE_FLOAT) {
+				return QD_TYPE_INT;
+			}
+		}
+		return type;
+	}
+
+	bool LlvmGenerator::Impl::canCallNatively(
+			const std::string& name, llvm::Value* ctx, const std::vector<CastDirection>& casts) {
+		if (!virtualStackEnabled()) {
+			return false;
+		}
+		auto it = nativeFunctions.find(name);
+		if (it == nativeFunctions.end()) {
+			return false;
+		}
+
+		// Arguments must already be pending with the declared types (after implicit casts)
+		const auto& inputs = it->second.inputs;
+		if (inputs.empty()) {
+			return true;
+		}
+		if (virtualStackCtx != ctx || virtualStack.size() < inputs.size()) {
+			return false;
+		}
+		const size_t base = virtualStack.size() - inputs.size();
+		for (size_t i = 0; i < inputs.size(); i++) {
+			if (castedType(virtualStack[base + i].type, casts, i) != inputs[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void LlvmGenerator::Impl::generateNativeCall(const std::string& name, llvm::Value* ctx) {
+		const NativeSignature& sig = nativeFunctions.at(name);
+
+		std::vector<llvm::Value*> args(sig.inputs.size() + 1, nullptr);
+		args[0] = ctx;
+		for (size_t i = sig.inputs.size(); i > 0; i--) {
+			// Apply the implicit int <-> float casts canCallNatively accepted
+			const VirtualValue arg = virtualStack.back();
+			virtualStack.pop_back();
+			if (arg.type == QD_TYPE_INT && sig.inputs[i - 1] == QD_TYPE_FLOAT) {
+				args[i] = builder->CreateSIToFP(arg.value, builder->getDoubleTy(), "castf");
+			} else if (arg.type == QD_TYPE_FLOAT && sig.inputs[i - 1] == QD_TYPE_INT) {
+				args[i] = builder->CreateFPToSI(arg.value, builder->getInt64Ty(), "casti");
+			} else {
+				args[i] = arg.value;
+			}
+		}
+
+		llvm::Value* result = builder->CreateCall(sig.fn, args);
+		if (sig.outputs.size() == 1) {
+			pushVirtual(ctx, result, sig.outputs[0]);
+		} else {
+			for (unsigned i = 0; i < sig.outputs.size(); i++) {
+				pushVirtual(ctx, builder->CreateExtractValue(result, {i}, "native_result"), sig.outputs[i]);
+			}
+		}
+	}
+
+	llvm::Value* LlvmGenerator::Impl::loadStackValueAs(const StackSlot& slot, uint32_t type) {
+		// Read a stack element as the declared native type, converting between int and float
+		// the same way qd_casti/qd_castf would
+		llvm::Value* valuePtr = slotValuePtr(slot, "value_ptr");
+		if (type == QD_TYPE_PTR) {
+			return builder->CreateLoad(llvm::PointerType::getUnqual(*context), valuePtr, "native_ptr");
+		}
+
+		llvm::Value* elemType = loadSlotType(slot, "elem_type");
+		llvm::Value* bits = builder->CreateLoad(builder->getInt64Ty(), valuePtr, "native_bits");
+		llvm::Value* asFloat = builder->CreateBitCast(bits, builder->getDoubleTy(), "as_float");
+		if (type == QD_TYPE_FLOAT) {
+			llvm::Value* isInt = builder->CreateICmpEQ(elemType, builder->getInt32(QD_TYPE_INT), "is_int");
+			llvm::Value* converted = builder->CreateSIToFP(bits, builder->getDoubleTy(), "int_to_float");
+			return builder->CreateSelect(isInt, converted, asFloat, "native_f");
+		}
+		llvm::Value* isFloat = builder->CreateICmpEQ(elemType, builder->getInt32(QD_TYPE_FLOAT), "is_float");
+		llvm::Value* converted = builder->CreateFPToSI(asFloat, builder->getInt64Ty(), "float_to_int");
+		return builder->CreateSelect(isFloat, converted, bits, "native_i");
+	}
+
+	std::vector<llvm::Value*> LlvmGenerator::Impl::popNativeValues(
+			llvm::Value* ctx, const std::vector<uint32_t>& types) {
+		// Pop types.size() values from ctx->st (deepest first) without calling into the runtime
+		std::vector<llvm::Value*> values;
+		if (types.empty()) {
+			return values;
+		}
+
+		llvm::Type* contextTy = llvm::StructType::get(*context, {llvm::PointerType::get(*context, 0)}, false);
+		llvm::Value* stPtr = builder->CreateStructGEP(contextTy, ctx, 0, "st_ptr");
+		llvm::Value* st = builder->CreateLoad(llvm::PointerType::get(*context, 0), stPtr, "st");
+
+		llvm::Type* stackTy = llvm::StructType::get(*context,
+				{llvm::PointerType::get(*context, 0), builder->getInt64Ty(), builder->getInt64Ty()}, false);
+
+		llvm::Value* sizePtr = builder->CreateStructGEP(stackTy, st, 2, "size_ptr");
+		llvm::Value* size = builder->CreateLoad(builder->getInt64Ty(), sizePtr, "size");
+
+		llvm::Value* dataPtr = builder->CreateStructGEP(stackTy, st, 0, "data_ptr");
+		llvm::Value* data = builder->CreateLoad(llvm::PointerType::get(*context, 0), dataPtr, "data");
+
+		llvm::Value* newSize = builder->CreateSub(size, builder->getInt64(types.size()), "new_size");
+		StackSlot baseSlot = stackSlot(st, data, newSize, "native_base");
+		for (size_t i = 0; i < types.size(); i++) {
+			values.push_back(loadStackValueAs(stackSlotOffset(baseSlot, i, "native_elem"), types[i]));
+		}
+
+		builder->CreateStore(newSize, sizePtr);
+		return values;
+	}
+
+	void LlvmGenerator::Impl::generateBlockChildren(IAstNode* block, llvm::Value* ctx, llvm::Value* forIterVar) {
+		if (!block || block->type() != IAstNode::Type::BLOCK) {
+			generateNode(block, ctx, forIterVar);
+			return;
+		}
+		for (size_t i = 0; i < block->childCount(); i++) {
+			generateNode(block->child(i), ctx, forIterVar);
+			// Stop if we've added a terminator (return, break, continue)
+			llvm::BasicBlock* currentBlock = builder->GetInsertBlock();
+			if (currentBlock) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnull-dereference"
+				if (currentBlock->getTerminator()) {
+#pragma GCC diagnostic pop
+					break;
+				}
+			}
+		}
 	}
 
 	void LlvmGenerator::Impl::generateLiteral(AstNodeLiteral* lit, llvm::Value* ctx) {
@@ -1739,8 +2405,10 @@ namespace Qd {
 		case AstNodeLiteral::LiteralType::INTEGER: {
 			int64_t val = std::stoll(value);
 			// Use function calls when debug info is enabled for better debuggability
-			// Use inline code for release builds for better performance
-			if (debugInfoEnabled) {
+			// Otherwise keep the constant in a register until the stack is observed
+			if (virtualStackEnabled()) {
+				pushVirtual(ctx, builder->getInt64(static_cast<uint64_t>(val)));
+			} else if (debugInfoEnabled) {
 				builder->CreateCall(pushIntFn, {ctx, builder->getInt64(static_cast<uint64_t>(val))});
 			} else {
 				generateInlinePushInt(ctx, val);
@@ -1749,10 +2417,16 @@ namespace Qd {
 		}
 		case AstNodeLiteral::LiteralType::FLOAT: {
 			auto val = llvm::ConstantFP::get(builder->getDoubleTy(), std::stod(value));
-			builder->CreateCall(pushFloatFn, {ctx, val});
+			if (virtualStackEnabled()) {
+				pushVirtual(ctx, val, QD_TYPE_FLOAT);
+			} else {
+				builder->CreateCall(pushFloatFn, {ctx, val});
+			}
 			break;
 		}
 		case AstNodeLiteral::LiteralType::STRING: {
+			materializeVirtualStack();
+
 			// Extract string content (remove surrounding quotes)
 			std::string content = value;
 			if (value.size() >= 2 && value.front() == '"' && value.back() == '"') {
@@ -1820,20 +2494,28 @@ namespace Qd {
 			}
 
 			auto strValue = builder->CreateGlobalString(processed, ".str");
-			builder->CreateCall(pushStrFn, {ctx, strValue});
+			builder->CreateCall(pushLitFn, {ctx, strValue});
 			break;
 		}
 		}
 	}
 
 	void LlvmGenerator::Impl::generateInstruction(AstNodeInstruction* inst, llvm::Value* ctx) {
-		const std::string& name = inst->name();
+		const Opcode opcode = inst->opcode();
+
+		if (generateVirtualInstruction(opcode, ctx)) {
+			return;
+		}
+		materializeVirtualStack();
 
-		if (name == "prints") {
+		switch (opcode) {
+		case Opcode::PRINTS:
 			builder->CreateCall(printsFn, {ctx});
-		} else if (name == "nl") {
+			return;
+		case Opcode::NL:
 			builder->CreateCall(nlFn, {ctx});
-		} else if (name == "+") {
+			return;
+		case Opcode::SYM_ADD:
 			// When debug info is enabled, use simple function calls for better debuggability
 			if (debugInfoEnabled) {
 				builder->CreateCall(addFn, {ctx});
@@ -1845,7 +2527,7 @@ namespace Qd {
 				generateTypeAwareAdd(ctx);
 			}
 			return;
-		} else if (name == "-") {
+		case Opcode::SYM_SUB:
 			// When debug info is enabled, use simple function calls for better debuggability
 			if (debugInfoEnabled) {
 				builder->CreateCall(subFn, {ctx});
@@ -1857,7 +2539,7 @@ namespace Qd {
 				generateTypeAwareSub(ctx);
 			}
 			return;
-		} else if (name == "*") {
+		case Opcode::SYM_MUL:
 			// When debug info is enabled, use simple function calls for better debuggability
 			if (debugInfoEnabled) {
 				builder->CreateCall(mulFn, {ctx});
@@ -1869,47 +2551,47 @@ namespace Qd {
 				generateTypeAwareMul(ctx);
 			}
 			return;
-		} else if (name == "<") {
+		case Opcode::SYM_LT:
 			// Use type-aware inline less than
 			generateTypeAwareLt(ctx);
 			return;
-		} else if (name == ">") {
+		case Opcode::SYM_GT:
 			// Use type-aware inline greater than
 			generateTypeAwareGt(ctx);
 			return;
-		} else if (name == "==") {
+		case Opcode::SYM_EQ:
 			// Use type-aware inline equality
 			generateTypeAwareEq(ctx);
 			return;
-		} else if (name == "dup") {
+		case Opcode::DUP:
 			// Use inline dup (no type checking needed)
 			generateInlineDup(ctx);
 			return;
-		} else if (name == "swap") {
+		case Opcode::SWAP:
 			// Use inline swap (no string cleanup needed - just moving elements)
 			generateInlineSwap(ctx);
 			return;
-		} else if (name == "!=") {
+		case Opcode::SYM_NEQ:
 			// Use type-aware inline not-equal
 			generateTypeAwareNeq(ctx);
 			return;
-		} else if (name == "<=") {
+		case Opcode::SYM_LTE:
 			// Use type-aware inline less than or equal
 			generateTypeAwareLte(ctx);
 			return;
-		} else if (name == ">=") {
+		case Opcode::SYM_GTE:
 			// Use type-aware inline greater than or equal
 			generateTypeAwareGte(ctx);
 			return;
-		} else if (name == "/") {
+		case Opcode::SYM_DIV:
 			// Use type-aware inline division
 			generateTypeAwareDiv(ctx);
 			return;
-		} else if (name == "%") {
+		case Opcode::SYM_MOD:
 			// Use type-aware inline modulo
 			generateTypeAwareMod(ctx);
 			return;
-		} else if (name == "free") {
+		case Opcode::FREE: {
 			// Smart struct-aware free: if freeing a struct with string fields, free strings first
 			if (!lastIdentifierPushed.empty()) {
 				auto structTypeIt = localVariableStructTypes.find(lastIdentifierPushed);
@@ -1982,49 +2664,53 @@ namespace Qd {
 			}
 			builder->CreateCall(qdFreeFn, {ctx});
 			return;
+		}
+		default:
+			break;
+		}
+
+		// Map instruction name to runtime function name
+		std::string fnName;
+		if (opcode == Opcode::SYM_PRINT) {
+			fnName = "qd_print";
 		} else {
-			// Map instruction name to runtime function name
-			std::string fnName;
-			if (name == ".") {
-				fnName = "qd_print";
-			} else if (name == "/") {
-				fnName = "qd_div";
-			} else if (name == "%") {
-				fnName = "qd_mod";
-			} else if (name == ">=") {
-				fnName = "qd_gte";
-			} else if (name == "<=") {
-				fnName = "qd_lte";
-			} else if (name == "!=") {
-				fnName = "qd_neq";
-			} else {
-				fnName = "qd_" + name;
-			}
+			fnName = "qd_" + inst->name();
+		}
 
-			// Check if function already exists
-			llvm::Function* runtimeFn = module->getFunction(fnName);
-			if (!runtimeFn) {
-				// Declare it: qd_exec_result fn(qd_context*)
-				auto fnTy = llvm::FunctionType::get(execResultTy, {contextPtrTy}, false);
-				runtimeFn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, fnName, *module);
-			}
+		// Check if function already exists
+		llvm::Function* runtimeFn = module->getFunction(fnName);
+		if (!runtimeFn) {
+			// Declare it: qd_exec_result fn(qd_context*)
+			auto fnTy = llvm::FunctionType::get(execResultTy, {contextPtrTy}, false);
+			runtimeFn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, fnName, *module);
+		}
 
-			builder->CreateCall(runtimeFn, {ctx});
+		builder->CreateCall(runtimeFn, {ctx});
 
-			// Special handling for 'error' instruction in fallible functions
-			// After calling qd_error, we need to return immediately to prevent further execution
-			if (name == "error" && currentFunctionIsFallible && currentFunctionReturnBlock) {
-				builder->CreateBr(currentFunctionReturnBlock);
-			}
+		// Special handling for 'error' instruction in fallible functions
+		// After calling qd_error, we need to return immediately to prevent further execution
+		if (opcode == Opcode::ERROR && currentFunctionIsFallible && currentFunctionReturnBlock) {
+			builder->CreateBr(currentFunctionReturnBlock);
 		}
 	}
 
 	void LlvmGenerator::Impl::generateIdentifier(AstNodeIdentifier* ident, llvm::Value* ctx, llvm::Value* forIterVar) {
 		const std::string& name = ident->name();
 
-		// Check if it's a local variable
+		// The loop iterator, numeric constants and native calls keep the virtual stack, everything else needs ctx->st
 		auto localIt = localVariables.find(name);
-		if (localIt != localVariables.end()) {
+		const bool isLocal = localIt != localVariables.end();
+		const bool isIterator = !isLocal && name == "$" && forIterVar;
+		const bool isConstant = !isLocal && !isIterator && moduleConstants.find(name) != moduleConstants.end();
+		const bool isNativeCall = !isLocal && !isIterator && !isConstant &&
+								  structDefinitions.find(name) == structDefinitions.end() &&
+								  canCallNatively(name, ctx, ident->parameterCasts());
+		if (!isIterator && !isConstant && !isNativeCall) {
+			materializeVirtualStack();
+		}
+
+		// Check if it's a local variable
+		if (isLocal) {
 			// Load from local variable and push to runtime stack
 			llvm::AllocaInst* localAlloca = localIt->second;
 
@@ -2088,7 +2774,11 @@ namespace Qd {
 		// Check if it's the loop iterator variable ($)
 		if (name == "$" && forIterVar) {
 			// Push loop iterator as integer (inline for performance)
-			generateInlinePushIntValue(ctx, forIterVar);
+			if (virtualStackEnabled()) {
+				pushVirtual(ctx, forIterVar);
+			} else {
+				generateInlinePushIntValue(ctx, forIterVar);
+			}
 			return;
 		}
 
@@ -2100,19 +2790,28 @@ namespace Qd {
 			// Determine the type of the constant and push it
 			if (!value.empty() && value.size() >= 2 && value.front() == '"' && value.back() == '"') {
 				// String literal - create global string and push
+				materializeVirtualStack();
 				std::string strValue = value.substr(1, value.length() - 2);
 				llvm::Value* strConst = builder->CreateGlobalString(strValue);
-				builder->CreateCall(pushStrFn, {ctx, strConst});
+				builder->CreateCall(pushLitFn, {ctx, strConst});
 			} else if (value.find('.') != std::string::npos) {
 				// Float constant
 				double floatValue = std::stod(value);
 				llvm::Value* floatConst = llvm::ConstantFP::get(builder->getDoubleTy(), floatValue);
-				builder->CreateCall(pushFloatFn, {ctx, floatConst});
+				if (virtualStackEnabled()) {
+					pushVirtual(ctx, floatConst, QD_TYPE_FLOAT);
+				} else {
+					builder->CreateCall(pushFloatFn, {ctx, floatConst});
+				}
 			} else {
 				// Integer constant
 				int64_t intValue = std::stoll(value);
 				llvm::Value* intConst = builder->getInt64(static_cast<uint64_t>(intValue));
-				builder->CreateCall(pushIntFn, {ctx, intConst});
+				if (virtualStackEnabled()) {
+					pushVirtual(ctx, intConst, QD_TYPE_INT);
+				} else {
+					builder->CreateCall(pushIntFn, {ctx, intConst});
+				}
 			}
 			return;
 		}
@@ -2127,10 +2826,24 @@ namespace Qd {
 		// Check if it's a user-defined function call
 		auto it = userFunctions.find(name);
 		if (it != userFunctions.end()) {
+			// Arguments are already in registers: bypass the stack adapter
+			if (isNativeCall) {
+				generateNativeCall(name, ctx);
+				return;
+			}
+
 			// Generate any needed type casts before the function call
 			generateCastInstructions(ident->parameterCasts(), ctx);
 
-			builder->CreateCall(it->second, {ctx});
+			// The validator proved depth and types here, so the stack check can be skipped
+			llvm::Function* callee = it->second;
+			if (!runtimeChecks && ident->typesProven()) {
+				auto uncheckedIt = uncheckedFunctions.find(name);
+				if (uncheckedIt != uncheckedFunctions.end()) {
+					callee = uncheckedIt->second;
+				}
+			}
+			builder->CreateCall(callee, {ctx});
 
 			// Check if this function is fallible
 			auto fallibleIt = fallibleFunctions.find(name);
@@ -2226,8 +2939,16 @@ namespace Qd {
 		// Look up scoped name: scope::name
 		std::string fullName = scope + "::" + name;
 
-		// Check if this is a constant first
+		// Constants go through generateLiteral and native calls keep the virtual stack
 		auto constIt = moduleConstants.find(fullName);
+		const bool isNativeCall = constIt == moduleConstants.end() &&
+								  structDefinitions.find(name) == structDefinitions.end() &&
+								  canCallNatively(fullName, ctx, scopedIdent->parameterCasts());
+		if (constIt == moduleConstants.end() && !isNativeCall) {
+			materializeVirtualStack();
+		}
+
+		// Check if this is a constant first
 		if (constIt != moduleConstants.end()) {
 			// This is a constant - generate a literal push
 			const std::string& value = constIt->second;
@@ -2258,6 +2979,10 @@ namespace Qd {
 		}
 
 		// Not a constant or struct, must be a function
+		if (isNativeCall) {
+			generateNativeCall(fullName, ctx);
+			return;
+		}
 		std::string mangledName = "usr_" + scope + "_" + name;
 
 		// Check if we have this function
@@ -2267,6 +2992,12 @@ namespace Qd {
 			auto fnTy = llvm::FunctionType::get(execResultTy, {contextPtrTy}, false);
 			fn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, mangledName, *module);
 		}
+		if (!runtimeChecks && scopedIdent->typesProven()) {
+			auto uncheckedIt = uncheckedFunctions.find(fullName);
+			if (uncheckedIt != uncheckedFunctions.end()) {
+				fn = uncheckedIt->second;
+			}
+		}
 
 		// Generate any needed type casts before the function call
 		generateCastInstructions(scopedIdent->parameterCasts(), ctx);
@@ -2808,45 +3539,65 @@ namespace Qd {
 		// Get current function
 		llvm::Function* currentFn = builder->GetInsertBlock()->getParent();
 
-		// Create basic blocks
-		llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(*context, "if.then", currentFn);
-		llvm::BasicBlock* elseBB =
-				ifStmt->elseBody() ? llvm::BasicBlock::Create(*context, "if.else", currentFn) : nullptr;
-		llvm::BasicBlock* mergeBB = llvm::BasicBlock::Create(*context, "if.merge", currentFn);
-
-		// We need to access ctx->st to pop from the stack
-		// ctx is a pointer to a struct with first field being qd_stack* st
-		// Cast ctx to the correct pointer type and load the stack field
-		auto stackFieldPtr =
-				builder->CreateStructGEP(llvm::StructType::get(*context,
-												 {
-														 llvm::PointerType::getUnqual(*context), // qd_stack* st
-														 builder->getInt64Ty(),					 // int64_t error_code
-														 llvm::PointerType::getUnqual(*context), // char* error_msg
-														 builder->getInt32Ty(),					 // int argc
-														 llvm::PointerType::getUnqual(*context), // char** argv
-														 llvm::PointerType::getUnqual(*context)	 // char* program_name
-												 }),
-						ctx, 0, "st_ptr");
-		auto stack = builder->CreateLoad(llvm::PointerType::getUnqual(*context), stackFieldPtr, "st");
+		if (virtualStackCtx != ctx) {
+			materializeVirtualStack();
+		}
 
-		// Allocate space for the popped element
-		auto elemPtr = builder->CreateAlloca(stackElementTy, nullptr, "cond_elem");
+		llvm::Value* condValue = nullptr;
+		if (!virtualStack.empty() && virtualStack.back().type == QD_TYPE_INT) {
+			// Condition is still in a register - no need to go through the stack
+			condValue = builder->CreateTrunc(virtualStack.back().value, builder->getInt32Ty(), "cond");
+			virtualStack.pop_back();
+		} else {
+			materializeVirtualStack();
+
+			// We need to access ctx->st to pop from the stack
+			// ctx is a pointer to a struct with first field being qd_stack* st
+			// Cast ctx to the correct pointer type and load the stack field
+			auto stackFieldPtr =
+					builder->CreateStructGEP(llvm::StructType::get(*context,
+													 {
+															 llvm::PointerType::getUnqual(*context), // qd_stack* st
+															 builder->getInt64Ty(),					 // int64_t error_code
+															 llvm::PointerType::getUnqual(*context), // char* error_msg
+															 builder->getInt32Ty(),					 // int argc
+															 llvm::PointerType::getUnqual(*context), // char** argv
+															 llvm::PointerType::getUnqual(*context)	 // char* program_name
+													 }),
+							ctx, 0, "st_ptr");
+			auto stack = builder->CreateLoad(llvm::PointerType::getUnqual(*context), stackFieldPtr, "st");
+
+			// Allocate space for the popped element
+			auto elemPtr = builder->CreateAlloca(stackElementTy, nullptr, "cond_elem");
+
+			// Pop the condition value from the stack
+			builder->CreateCall(stackPopFn, {stack, elemPtr});
+
+			// Access the value field: elem.value.i
+			// stackElementTy layout: { i64 value, i32 type, i1 is_error_tainted }
+			// Get the value field (index 0) as i64, then truncate to i32
+			auto valuePtr = builder->CreateStructGEP(stackElementTy, elemPtr, 0, "value_ptr");
+			auto value64 = builder->CreateLoad(builder->getInt64Ty(), valuePtr, "value64");
+			condValue = builder->CreateTrunc(value64, builder->getInt32Ty(), "cond");
+		}
 
-		// Pop the condition value from the stack
-		builder->CreateCall(stackPopFn, {stack, elemPtr});
+		// Both branches start from the values still pending in registers
+		const std::vector<VirtualValue> entryStack = virtualStack;
+		std::vector<VirtualStackEdge> incoming;
 
-		// Access the value field: elem.value.i
-		// stackElementTy layout: { i64 value, i32 type, i1 is_error_tainted }
-		// Get the value field (index 0) as i64, then truncate to i32
-		auto valuePtr = builder->CreateStructGEP(stackElementTy, elemPtr, 0, "value_ptr");
-		auto value64 = builder->CreateLoad(builder->getInt64Ty(), valuePtr, "value64");
-		auto condValue = builder->CreateTrunc(value64, builder->getInt32Ty(), "cond");
+		// Create basic blocks
+		// An empty else block is still needed when values are pending, so the false edge has its own block
+		llvm::BasicBlock* thenBB = llvm::BasicBlock::Create(*context, "if.then", currentFn);
+		llvm::BasicBlock* elseBB = (ifStmt->elseBody() || !entryStack.empty())
+										   ? llvm::BasicBlock::Create(*context, "if.else", currentFn)
+										   : nullptr;
+		llvm::BasicBlock* mergeBB = llvm::BasicBlock::Create(*context, "if.merge", currentFn);
 
 		// Check if condition is non-zero
 		auto isTrue = builder->CreateICmpNE(condValue, builder->getInt32(0), "is_true");
 
 		// Branch based on condition
+		llvm::BasicBlock* condBlock = builder->GetInsertBlock();
 		if (elseBB) {
 			builder->CreateCondBr(isTrue, thenBB, elseBB);
 		} else {
@@ -2855,8 +3606,10 @@ namespace Qd {
 
 		// Generate then block
 		builder->SetInsertPoint(thenBB);
+		virtualStack = entryStack;
+		virtualStackCtx = entryStack.empty() ? nullptr : ctx;
 		if (ifStmt->thenBody()) {
-			generateNode(ifStmt->thenBody(), ctx, forIterVar);
+			generateBlockChildren(ifStmt->thenBody(), ctx, forIterVar);
 		}
 		// Only add branch if block doesn't already have a terminator
 		llvm::BasicBlock* thenBlock = builder->GetInsertBlock();
@@ -2865,6 +3618,7 @@ namespace Qd {
 #pragma GCC diagnostic ignored "-Wnull-dereference"
 			if (!thenBlock->getTerminator()) {
 #pragma GCC diagnostic pop
+				incoming.push_back({thenBlock, virtualStack});
 				builder->CreateBr(mergeBB);
 			}
 		}
@@ -2872,8 +3626,10 @@ namespace Qd {
 		// Generate else block if present
 		if (elseBB) {
 			builder->SetInsertPoint(elseBB);
+			virtualStack = entryStack;
+			virtualStackCtx = entryStack.empty() ? nullptr : ctx;
 			if (ifStmt->elseBody()) {
-				generateNode(ifStmt->elseBody(), ctx, forIterVar);
+				generateBlockChildren(ifStmt->elseBody(), ctx, forIterVar);
 			}
 			// Only add branch if block doesn't already have a terminator
 			llvm::BasicBlock* elseBlock = builder->GetInsertBlock();
@@ -2882,13 +3638,17 @@ namespace Qd {
 #pragma GCC diagnostic ignored "-Wnull-dereference"
 				if (!elseBlock->getTerminator()) {
 #pragma GCC diagnostic pop
+					incoming.push_back({elseBlock, virtualStack});
 					builder->CreateBr(mergeBB);
 				}
 			}
+		} else {
+			// False edge comes straight from the condition block with nothing pending
+			incoming.push_back({condBlock, {}});
 		}
 
-		// Continue in merge block
-		builder->SetInsertPoint(mergeBB);
+		// Continue in merge block, joining the pending values of both branches
+		mergeVirtualStacks(mergeBB, ctx, incoming);
 	}
 
 	void LlvmGenerator::Impl::generateFor(AstNodeForStatement* forStmt, llvm::Value* ctx) {
@@ -3042,14 +3802,189 @@ namespace Qd {
 		builder->SetInsertPoint(loopExitBB);
 	}
 
+	// How many elements below the top of the parent stack a ctx block can touch, including the element it
+	// leaves as its result, or nothing if that depends on runtime state or code outside the block (depth,
+	// pick, function calls, ...).
+	// peak receives how far above the parent's top the block's stack can grow
+	std::optional<size_t> LlvmGenerator::Impl::ctxBlockReach(AstNodeCtx* ctxNode, size_t* peak) {
+		int64_t height = 0; // Relative to the top of the parent stack on entry
+		int64_t low = 0;	// Lowest height any operation touched
+		int64_t high = 0;	// Highest height any operation left
+		std::set<std::string> locals;
+		for (size_t i = 0; i < ctxNode->childCount(); i++) {
+			if (!trackStackReach(ctxNode->child(i), height, low, high, locals)) {
+				return std::nullopt;
+			}
+		}
+		low = std::min(low, height - 1); // The result is popped from the block's stack
+		if (peak) {
+			*peak = static_cast<size_t>(high);
+		}
+		return static_cast<size_t>(-low);
+	}
+
+	bool LlvmGenerator::Impl::trackStackReach(
+			IAstNode* node, int64_t& height, int64_t& low, int64_t& high, std::set<std::string>& locals) {
+		// Apply an operation that reads `consumes` elements and leaves `produces` in their place
+		auto apply = [&](int64_t consumes, int64_t produces) {
+			low = std::min(low, height - consumes);
+			height += produces - consumes;
+			high = std::max(high, height);
+			return true;
+		};
+
+		switch (node->type()) {
+		case IAstNode::Type::COMMENT:
+			return true;
+		case IAstNode::Type::LITERAL:
+		case IAstNode::Type::FUNCTION_POINTER_REFERENCE:
+			return apply(0, 1);
+		case IAstNode::Type::LOCAL:
+			locals.insert(static_cast<AstNodeLocal*>(node)->name());
+			return apply(1, 0);
+		case IAstNode::Type::IDENTIFIER: {
+			const std::string& name = static_cast<AstNodeIdentifier*>(node)->name();
+			if (locals.count(name) || localVariables.count(name) || name == "$" || moduleConstants.count(name)) {
+				return apply(0, 1);
+			}
+			// Calls can push any amount on the way to their outputs, and inline pushes aren't bounds checked
+			return false;
+		}
+		case IAstNode::Type::SCOPED_IDENTIFIER: {
+			auto scopedIdent = static_cast<AstNodeScopedIdentifier*>(node);
+			std::string fullName = scopedIdent->scope() + "::" + scopedIdent->name();
+			if (moduleConstants.count(fullName)) {
+				return apply(0, 1);
+			}
+			return false;
+		}
+		case IAstNode::Type::CTX_STATEMENT: {
+			auto reach = ctxBlockReach(static_cast<AstNodeCtx*>(node));
+			return reach && apply(static_cast<int64_t>(*reach), static_cast<int64_t>(*reach) + 1);
+		}
+		case IAstNode::Type::BLOCK:
+			for (size_t i = 0; i < node->childCount(); i++) {
+				if (!trackStackReach(node->child(i), height, low, high, locals)) {
+					return false;
+				}
+			}
+			return true;
+		case IAstNode::Type::IF_STATEMENT: {
+			// Both branches start after the condition is popped and must agree on the height they leave
+			auto ifStmt = static_cast<AstNodeIfStatement*>(node);
+			apply(1, 0);
+			int64_t elseHeight = height;
+			if (!ifStmt->thenBody() || !trackStackReach(ifStmt->thenBody(), height, low, high, locals)) {
+				return false;
+			}
+			if (ifStmt->elseBody() && !trackStackReach(ifStmt->elseBody(), elseHeight, low, high, locals)) {
+				return false;
+			}
+			return height == elseHeight;
+		}
+		case IAstNode::Type::INSTRUCTION:
+			break;
+		default:
+			return false;
+		}
+
+		switch (static_cast<AstNodeInstruction*>(node)->opcode()) {
+		case Opcode::SYM_NEQ:
+		case Opcode::SYM_LT:
+		case Opcode::SYM_LTE:
+		case Opcode::SYM_EQ:
+		case Opcode::SYM_GT:
+		case Opcode::SYM_GTE:
+		case Opcode::SYM_MOD:
+		case Opcode::SYM_MUL:
+		case Opcode::SYM_ADD:
+		case Opcode::SYM_SUB:
+		case Opcode::SYM_DIV:
+		case Opcode::ADD:
+		case Opcode::DIV:
+		case Opcode::MOD:
+		case Opcode::MUL:
+		case Opcode::SUB:
+		case Opcode::EQ:
+		case Opcode::GT:
+		case Opcode::GTE:
+		case Opcode::LT:
+		case Opcode::LTE:
+		case Opcode::NEQ:
+		case Opcode::NIP:
+			return apply(2, 1);
+		case Opcode::WITHIN:
+			return apply(3, 1);
+		case Opcode::DEC:
+		case Opcode::INC:
+		case Opcode::NEG:
+		case Opcode::CASTF:
+		case Opcode::CASTI:
+		case Opcode::CASTS:
+		case Opcode::CHAN:
+			return apply(1, 1);
+		case Opcode::SYM_PRINT:
+		case Opcode::PRINT:
+		case Opcode::PRINTV:
+		case Opcode::DROP:
+		case Opcode::FREE:
+		case Opcode::CLOSE:
+		case Opcode::DETACH:
+		case Opcode::WAIT:
+			return apply(1, 0);
+		case Opcode::DROP2:
+		case Opcode::SEND:
+			return apply(2, 0);
+		case Opcode::DUP:
+		case Opcode::RECV:
+		case Opcode::TRY_RECV:
+			return apply(1, 2);
+		case Opcode::DUP2:
+			return apply(2, 4);
+		case Opcode::DUPD:
+		case Opcode::TUCK:
+		case Opcode::OVER:
+			return apply(2, 3);
+		case Opcode::NIPD:
+			return apply(3, 2);
+		case Opcode::OVERD:
+			return apply(3, 4);
+		case Opcode::SWAPD:
+		case Opcode::ROT:
+			return apply(3, 3);
+		case Opcode::SWAP:
+			return apply(2, 2);
+		case Opcode::SWAP2:
+			return apply(4, 4);
+		case Opcode::OVER2:
+			return apply(4, 6);
+		case Opcode::NL:
+		case Opcode::YIELD:
+		case Opcode::ERROR:
+			return true;
+		default:
+			// depth, clear, pick, roll, call, spawn, ... see (or change) the whole stack
+			return false;
+		}
+	}
+
 	void LlvmGenerator::Impl::generateCtxBlock(AstNodeCtx* ctxNode, llvm::Value* ctx, llvm::Value* forIterVar) {
-		// Clone the parent context
-		auto clonedCtx = builder->CreateCall(cloneContextFn, {ctx}, "cloned_ctx");
+		// Clone the parent context; blocks with a known reach only get that many elements of the stack, and room
+		// for the most they push on top of them
+		llvm::Value* clonedCtx;
+		size_t peak = 0;
+		if (auto reach = ctxBlockReach(ctxNode, &peak)) {
+			clonedCtx = builder->CreateCall(cloneContextWindowFn,
+					{ctx, builder->getInt64(*reach), builder->getInt64(*reach + peak)}, "cloned_ctx");
+		} else {
+			clonedCtx = builder->CreateCall(cloneContextFn, {ctx}, "cloned_ctx");
+		}
 
 		// Execute the block with the cloned context
 		for (size_t i = 0; i < ctxNode->childCount(); i++) {
 			generateNode(ctxNode->child(i), clonedCtx, forIterVar);
 		}
+		materializeVirtualStack();
 
 		// Get the stack from cloned context
 		auto stackFieldPtr =
@@ -3150,6 +4085,14 @@ namespace Qd {
 
 		auto nodeType = node->type();
 
+		// Literals, instructions, identifiers (native calls) and if statements decide themselves whether they can
+		// keep the virtual stack; everything else (loops, locals, ctx blocks, ...) observes ctx->st directly
+		if (nodeType != IAstNode::Type::LITERAL && nodeType != IAstNode::Type::INSTRUCTION &&
+				nodeType != IAstNode::Type::IDENTIFIER && nodeType != IAstNode::Type::SCOPED_IDENTIFIER &&
+				nodeType != IAstNode::Type::IF_STATEMENT) {
+			materializeVirtualStack();
+		}
+
 		switch (nodeType) {
 		case IAstNode::Type::LITERAL:
 			generateLiteral(static_cast<AstNodeLiteral*>(node), ctx);
@@ -3206,19 +4149,9 @@ namespace Qd {
 			break;
 		case IAstNode::Type::BLOCK:
 			// For blocks, just recursively generate all children
-			for (size_t i = 0; i < node->childCount(); i++) {
-				generateNode(node->child(i), ctx, forIterVar);
-				// Stop if we've added a terminator (return, break, continue)
-				llvm::BasicBlock* currentBlock = builder->GetInsertBlock();
-				if (currentBlock) {
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wnull-dereference"
-					if (currentBlock->getTerminator()) {
-#pragma GCC diagnostic pop
-						break;
-					}
-				}
-			}
+			generateBlockChildren(node, ctx, forIterVar);
+			// Block boundary: successors only see the real stack
+			materializeVirtualStack();
 			break;
 		case IAstNode::Type::FUNCTION_DECLARATION:
 			// Skip - functions are handled at the top level
@@ -3241,11 +4174,211 @@ namespace Qd {
 		}
 	}
 
+	void LlvmGenerator::Impl::generateStackCheck(
+			llvm::Value* ctx, const std::vector<uint32_t>& types, llvm::Value* funcNameStr, bool numeric) {
+		// Create global array constant
+		std::vector<llvm::Constant*> typeValues;
+		for (uint32_t type : types) {
+			typeValues.push_back(builder->getInt32(type));
+		}
+		auto arrayType = llvm::ArrayType::get(builder->getInt32Ty(), typeValues.size());
+		auto arrayInit = llvm::ConstantArray::get(arrayType, typeValues);
+		auto globalArray = new llvm::GlobalVariable(
+				*module, arrayType, true, llvm::GlobalValue::PrivateLinkage, arrayInit, "input_types");
+
+		// Call qd_check_stack(ctx, count, types, func_name), or its numeric variant
+		auto arrayPtr = builder->CreateBitCast(globalArray, llvm::PointerType::getUnqual(*context));
+		builder->CreateCall(numeric ? checkStackNumericFn : checkStackFn,
+				{ctx, builder->getInt64(types.size()), arrayPtr, funcNameStr});
+	}
+
+	bool LlvmGenerator::Impl::generateNativeFunction(
+			AstNodeFunctionDeclaration* funcNode, const std::string& namePrefix) {
+		std::string fnName = "usr_" + namePrefix + "_" + funcNode->name();
+		std::string registerName = (namePrefix == "main") ? funcNode->name() : (namePrefix + "::" + funcNode->name());
+		std::string fullFuncName = namePrefix + "::" + funcNode->name();
+
+		NativeSignature sig;
+		for (const auto* param : funcNode->inputParameters()) {
+			uint32_t type = QD_TYPE_INT;
+			nativeTypeFor(static_cast<const AstNodeParameter*>(param)->typeString(), type);
+			sig.inputs.push_back(type);
+		}
+		for (const auto* param : funcNode->outputParameters()) {
+			uint32_t type = QD_TYPE_INT;
+			nativeTypeFor(static_cast<const AstNodeParameter*>(param)->typeString(), type);
+			sig.outputs.push_back(type);
+		}
+
+		// Native entry point: <ret> usr_<prefix>_<name>.native(qd_context* ctx, <inputs>...)
+		// Zero outputs return void, one output returns it directly, more are returned as a struct
+		std::vector<llvm::Type*> argTypes = {contextPtrTy};
+		for (uint32_t type : sig.inputs) {
+			argTypes.push_back(nativeLlvmType(type));
+		}
+		std::vector<llvm::Type*> resultTypes;
+		for (uint32_t type : sig.outputs) {
+			resultTypes.push_back(nativeLlvmType(type));
+		}
+		llvm::Type* returnType = builder->getVoidTy();
+		if (resultTypes.size() == 1) {
+			returnType = resultTypes[0];
+		} else if (resultTypes.size() > 1) {
+			returnType = llvm::StructType::get(*context, resultTypes);
+		}
+		auto nativeFnTy = llvm::FunctionType::get(returnType, argTypes, false);
+		sig.fn = llvm::Function::Create(nativeFnTy, llvm::Function::InternalLinkage, fnName + ".native", *module);
+
+		// Stack adapter: qd_exec_result usr_<prefix>_<name>(qd_context* ctx)
+		// Used by call, function pointers, other compilation units and the embedding API
+		auto fnTy = llvm::FunctionType::get(execResultTy, {contextPtrTy}, false);
+		llvm::Function* fn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, fnName, *module);
+
+		// Register before generating the body so recursive calls use the native entry point
+		userFunctions[registerName] = fn;
+		fallibleFunctions[registerName] = false;
+		nativeFunctions[registerName] = sig;
+
+		{
+			auto entryBB = llvm::BasicBlock::Create(*context, "entry", fn);
+			builder->SetInsertPoint(entryBB);
+			llvm::Value* ctx = fn->getArg(0);
+			ctx->setName("ctx");
+
+			// Values coming from the dynamic stack are checked against the declared types; ints and floats are
+			// accepted for each other and converted while popping, like the implicit casts at call sites
+			auto funcNameStr = builder->CreateGlobalString(fullFuncName);
+			if (!sig.inputs.empty()) {
+				generateStackCheck(ctx, sig.inputs, funcNameStr, true);
+			}
+
+			std::vector<llvm::Value*> args = {ctx};
+			for (llvm::Value* arg : popNativeValues(ctx, sig.inputs)) {
+				args.push_back(arg);
+			}
+			llvm::Value* result = builder->CreateCall(sig.fn, args);
+
+			// Push results back onto ctx->st
+			if (sig.outputs.size() == 1) {
+				pushVirtual(ctx, result, sig.outputs[0]);
+			} else {
+				for (unsigned i = 0; i < sig.outputs.size(); i++) {
+					pushVirtual(ctx, builder->CreateExtractValue(result, {i}, "result"), sig.outputs[i]);
+				}
+			}
+			materializeVirtualStack();
+
+			auto okResult =
+					llvm::ConstantStruct::get(llvm::cast<llvm::StructType>(execResultTy), {builder->getInt32(0)});
+			builder->CreateRet(okResult);
+		}
+
+		auto entryBB = llvm::BasicBlock::Create(*context, "entry", sig.fn);
+		auto returnBB = llvm::BasicBlock::Create(*context, "return", sig.fn);
+		builder->SetInsertPoint(entryBB);
+
+		llvm::Value* ctx = sig.fn->getArg(0);
+		ctx->setName("ctx");
+
+		// Push function name onto call stack for debugging
+		if (callStackTracking) {
+			builder->CreateCall(pushCallFn, {ctx, builder->CreateGlobalString(fullFuncName)});
+		}
+
+		// Parameters start out on the virtual stack; their types are guaranteed by the caller
+		virtualStack.clear();
+		virtualStackCtx = nullptr;
+		for (size_t i = 0; i < sig.inputs.size(); i++) {
+			llvm::Value* arg = sig.fn->getArg(static_cast<unsigned>(i + 1));
+			arg->setName(static_cast<const AstNodeParameter*>(funcNode->inputParameters()[i])->name());
+			pushVirtual(ctx, arg, sig.inputs[i]);
+		}
+
+		currentFunctionReturnBlock = returnBB;
+		currentFunctionIsFallible = false;
+		currentFunctionIsIntegerOnly =
+				std::all_of(sig.inputs.begin(), sig.inputs.end(), [](uint32_t t) { return t == QD_TYPE_INT; }) &&
+				std::all_of(sig.outputs.begin(), sig.outputs.end(), [](uint32_t t) { return t == QD_TYPE_INT; });
+		currentDeferStatements.clear();
+
+		// Generate function body, keeping whatever is pending at the end for the return block
+		std::vector<VirtualStackEdge> incoming;
+		if (funcNode->body()) {
+			generateBlockChildren(funcNode->body(), ctx, nullptr);
+		}
+		llvm::BasicBlock* funcBodyBlock = builder->GetInsertBlock();
+		if (funcBodyBlock) {
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wnull-dereference"
+			if (!funcBodyBlock->getTerminator()) {
+#pragma GCC diagnostic pop
+				incoming.push_back({funcBodyBlock, virtualStack});
+				builder->CreateBr(returnBB);
+			}
+		}
+
+		currentFunctionReturnBlock = nullptr;
+		currentFunctionIsIntegerOnly = false;
+
+		// Return block: explicit returns arrive with everything on ctx->st
+		mergeVirtualStacks(returnBB, ctx, incoming);
+
+		// Execute defer statements in REVERSE order (LIFO)
+		for (auto it = currentDeferStatements.rbegin(); it != currentDeferStatements.rend(); ++it) {
+			for (size_t i = 0; i < (*it)->childCount(); i++) {
+				generateBlockChildren((*it)->child(i), ctx, nullptr);
+			}
+		}
+		currentDeferStatements.clear();
+
+		// Take the results from registers when possible, otherwise pop them from ctx->st
+		std::vector<llvm::Value*> results;
+		bool resultsPending = virtualStackCtx == ctx && virtualStack.size() >= sig.outputs.size();
+		for (size_t i = 0; resultsPending && i < sig.outputs.size(); i++) {
+			resultsPending = virtualStack[virtualStack.size() - sig.outputs.size() + i].type == sig.outputs[i];
+		}
+		if (resultsPending && !sig.outputs.empty()) {
+			const size_t base = virtualStack.size() - sig.outputs.size();
+			for (size_t i = base; i < virtualStack.size(); i++) {
+				results.push_back(virtualStack[i].value);
+			}
+			virtualStack.resize(base);
+			materializeVirtualStack();
+		} else {
+			materializeVirtualStack();
+			results = popNativeValues(ctx, sig.outputs);
+		}
+
+		// Clean up local variables (free strings)
+		generateLocalCleanup();
+
+		// Pop function from call stack before returning
+		if (callStackTracking) {
+			builder->CreateCall(popCallFn, {ctx});
+		}
+
+		if (results.empty()) {
+			builder->CreateRetVoid();
+		} else if (results.size() == 1) {
+			builder->CreateRet(results[0]);
+		} else {
+			llvm::Value* aggregate = llvm::UndefValue::get(returnType);
+			for (unsigned i = 0; i < results.size(); i++) {
+				aggregate = builder->CreateInsertValue(aggregate, results[i], {i});
+			}
+			builder->CreateRet(aggregate);
+		}
+
+		return true;
+	}
+
 	bool LlvmGenerator::Impl::generateFunction(
 			AstNodeFunctionDeclaration* funcNode, bool isMain, const std::string& namePrefix) {
 		// Clear local variables for this function
 		localVariables.clear();
 		localVariableStructTypes.clear();
+		virtualStack.clear();
+		virtualStackCtx = nullptr;
 
 		// Get the correct DIFile for this module
 		llvm::DIFile* funcDebugFile = debugFile; // Default to main file
@@ -3288,8 +4421,17 @@ namespace Qd {
 			builder->SetInsertPoint(entryBB);
 
 			// Create Quadrate context
-			auto stackSize = builder->getInt64(DEFAULT_STACK_SIZE);
-			auto ctx = builder->CreateCall(createContextFn, {stackSize}, "ctx");
+			llvm::Function* contextFn = createContextFn;
+			size_t stackElements = stackSize ? stackSize : DEFAULT_STACK_SIZE;
+			if (stackGrowth) {
+				contextFn = module->getFunction("qd_create_context_growable");
+				if (!contextFn) {
+					contextFn = llvm::Function::Create(createContextFn->getFunctionType(),
+							llvm::Function::ExternalLinkage, "qd_create_context_growable", *module);
+				}
+				stackElements = stackSize ? stackSize : DEFAULT_GROWABLE_STACK_SIZE;
+			}
+			auto ctx = builder->CreateCall(contextFn, {builder->getInt64(stackElements)}, "ctx");
 
 			// Create alloca for ctx so debugger can reliably access it
 			llvm::AllocaInst* ctxAlloca = builder->CreateAlloca(ctx->getType(), nullptr, "ctx.addr");
@@ -3320,8 +4462,9 @@ namespace Qd {
 
 			// Push "main::main" onto call stack for debugging
 			std::string fullFuncName = namePrefix + "::" + funcNode->name();
-			auto funcNameStr = builder->CreateGlobalString(fullFuncName);
-			builder->CreateCall(pushCallFn, {ctx, funcNameStr});
+			if (callStackTracking) {
+				builder->CreateCall(pushCallFn, {ctx, builder->CreateGlobalString(fullFuncName)});
+			}
 
 			// Generate function body
 			auto body = funcNode->body();
@@ -3333,7 +4476,9 @@ namespace Qd {
 			generateLocalCleanup();
 
 			// Pop from call stack
-			builder->CreateCall(popCallFn, {ctx});
+			if (callStackTracking) {
+				builder->CreateCall(popCallFn, {ctx});
+			}
 
 			// Free context
 			builder->CreateCall(freeContextFn, {ctx});
@@ -3345,11 +4490,60 @@ namespace Qd {
 			if (debugInfoEnabled && !debugScopeStack.empty()) {
 				debugScopeStack.pop_back();
 			}
+		} else if (hasNativeSignature(funcNode)) {
+			// Fully typed: native entry point plus stack adapter
+			return generateNativeFunction(funcNode, namePrefix);
 		} else {
 			// User-defined function: qd_exec_result usr_<prefix>_<name>(qd_context* ctx)
 			std::string fnName = "usr_" + namePrefix + "_" + funcNode->name();
+			std::string fullFuncName = namePrefix + "::" + funcNode->name();
 			auto fnTy = llvm::FunctionType::get(execResultTy, {contextPtrTy}, false);
-			fn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, fnName, *module);
+
+			// Runtime types of the input parameters, checked like the native adapters do: ints and floats
+			// are accepted for each other, strings must be strings, ptr and untyped accept anything
+			std::vector<uint32_t> inputTypes;
+			for (auto* paramNode : funcNode->inputParameters()) {
+				AstNodeParameter* param = static_cast<AstNodeParameter*>(paramNode);
+				std::string typeStr = param->typeString();
+				uint32_t typeValue;
+				if (typeStr.empty()) {
+					typeValue = 2; // QD_STACK_TYPE_PTR - untyped
+				} else if (typeStr == "i64" || typeStr == "int" || typeStr == "int64") {
+					typeValue = 0; // QD_STACK_TYPE_INT
+				} else if (typeStr == "f64") {
+					typeValue = 1; // QD_STACK_TYPE_FLOAT
+				} else if (typeStr == "str") {
+					typeValue = 3; // QD_STACK_TYPE_STR
+				} else if (typeStr == "ptr") {
+					typeValue = 2; // QD_STACK_TYPE_PTR
+				} else {
+					typeValue = 2; // QD_STACK_TYPE_PTR - unknown type
+				}
+				inputTypes.push_back(typeValue);
+			}
+
+			// Without runtime checks the body becomes internal and the exported symbol only checks and forwards.
+			// The check covers depth and types, so it is only skipped at call sites where the validator proved
+			// both on an exactly tracked type stack (typesProven()).
+			const bool splitEntry = !runtimeChecks && !inputTypes.empty();
+			llvm::Function* checkedFn = nullptr;
+			if (splitEntry) {
+				checkedFn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, fnName, *module);
+				fn = llvm::Function::Create(fnTy, llvm::Function::InternalLinkage, fnName + ".unchecked", *module);
+
+				builder->SetCurrentDebugLocation(llvm::DebugLoc());
+				auto checkBB = llvm::BasicBlock::Create(*context, "entry", checkedFn);
+				builder->SetInsertPoint(checkBB);
+				llvm::Value* checkCtx = checkedFn->getArg(0);
+				checkCtx->setName("ctx");
+				generateStackCheck(checkCtx, inputTypes, builder->CreateGlobalString(fullFuncName), true);
+				auto forward = builder->CreateCall(fn, {checkCtx});
+				forward->setTailCall();
+				builder->CreateRet(forward);
+			} else {
+				fn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, fnName, *module);
+				checkedFn = fn;
+			}
 
 			// Add debug info for user function
 			if (debugInfoEnabled && debugBuilder) {
@@ -3373,8 +4567,11 @@ namespace Qd {
 			// Register the function with appropriate scope
 			std::string registerName =
 					(namePrefix == "main") ? funcNode->name() : (namePrefix + "::" + funcNode->name());
-			userFunctions[registerName] = fn;
+			userFunctions[registerName] = checkedFn;
 			fallibleFunctions[registerName] = funcNode->throws();
+			if (splitEntry) {
+				uncheckedFunctions[registerName] = fn;
+			}
 
 			// Create basic blocks
 			auto entryBB = llvm::BasicBlock::Create(*context, "entry", fn);
@@ -3419,44 +4616,14 @@ namespace Qd {
 			}
 
 			// Push function name onto call stack for debugging
-			std::string fullFuncName = namePrefix + "::" + funcNode->name();
 			auto funcNameStr = builder->CreateGlobalString(fullFuncName);
-			builder->CreateCall(pushCallFn, {ctx, funcNameStr});
-
-			// Generate type check for input parameters
-			if (!funcNode->inputParameters().empty()) {
-				// Create array of types
-				std::vector<llvm::Constant*> typeValues;
-				for (auto* paramNode : funcNode->inputParameters()) {
-					AstNodeParameter* param = static_cast<AstNodeParameter*>(paramNode);
-					std::string typeStr = param->typeString();
-					uint32_t typeValue;
-					if (typeStr.empty()) {
-						typeValue = 2; // QD_STACK_TYPE_PTR - untyped
-					} else if (typeStr == "i") {
-						typeValue = 0; // QD_STACK_TYPE_INT
-					} else if (typeStr == "f") {
-						typeValue = 1; // QD_STACK_TYPE_FLOAT
-					} else if (typeStr == "s") {
-						typeValue = 3; // QD_STACK_TYPE_STR
-					} else if (typeStr == "p") {
-						typeValue = 2; // QD_STACK_TYPE_PTR
-					} else {
-						typeValue = 2; // QD_STACK_TYPE_PTR - unknown type
-					}
-					typeValues.push_back(builder->getInt32(typeValue));
-				}
-
-				// Create global array constant
-				auto arrayType = llvm::ArrayType::get(builder->getInt32Ty(), typeValues.size());
-				auto arrayInit = llvm::ConstantArray::get(arrayType, typeValues);
-				auto globalArray = new llvm::GlobalVariable(
-						*module, arrayType, true, llvm::GlobalValue::PrivateLinkage, arrayInit, "input_types");
+			if (callStackTracking) {
+				builder->CreateCall(pushCallFn, {ctx, funcNameStr});
+			}
 
-				// Call qd_check_stack(ctx, count, types, func_name)
-				auto arrayPtr = builder->CreateBitCast(globalArray, llvm::PointerType::getUnqual(*context));
-				builder->CreateCall(checkStackFn,
-						{ctx, builder->getInt64(funcNode->inputParameters().size()), arrayPtr, funcNameStr});
+			// Generate type check for input parameters (done by the exported entry point when split)
+			if (!inputTypes.empty() && !splitEntry) {
+				generateStackCheck(ctx, inputTypes, funcNameStr, true);
 			}
 
 			// Set the return target for this function
@@ -3530,6 +4697,7 @@ namespace Qd {
 					}
 				}
 			}
+			materializeVirtualStack();
 
 			// Clear defer statements after use
 			currentDeferStatements.clear();
@@ -3538,7 +4706,9 @@ namespace Qd {
 			generateLocalCleanup();
 
 			// Pop function from call stack before returning
-			builder->CreateCall(popCallFn, {ctx});
+			if (callStackTracking) {
+				builder->CreateCall(popCallFn, {ctx});
+			}
 
 			// Return success
 			auto result = llvm::ConstantStruct::get(llvm::cast<llvm::StructType>(execResultTy), {builder->getInt32(0)});
@@ -3615,8 +4785,9 @@ namespace Qd {
 						}
 						if (scopedName != mangledName && !module->getFunction(scopedName)) {
 							// Create alias with usr_ prefix that calls the actual function
+							// (weak_odr: separately compiled modules emit the same wrapper)
 							auto aliasFn =
-									llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, scopedName, *module);
+									llvm::Function::Create(fnTy, llvm::Function::WeakODRLinkage, scopedName, *module);
 							// Create a simple wrapper that forwards to the real function
 							auto entryBB = llvm::BasicBlock::Create(*context, "entry", aliasFn);
 							builder->SetInsertPoint(entryBB);
@@ -3715,7 +4886,7 @@ namespace Qd {
 					std::string scopedName = "usr_" + namespaceName + "_" + func->name;
 					if (scopedName != mangledName && !module->getFunction(scopedName)) {
 						auto aliasFn =
-								llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, scopedName, *module);
+								llvm::Function::Create(fnTy, llvm::Function::WeakODRLinkage, scopedName, *module);
 						auto entryBB = llvm::BasicBlock::Create(*context, "entry", aliasFn);
 						builder->SetInsertPoint(entryBB);
 						auto ctx = aliasFn->arg_begin();
@@ -3734,9 +4905,15 @@ namespace Qd {
 				continue;
 			}
 
+			const bool declaredOnly = isModuleDeclaredOnly(moduleName);
 			for (size_t i = 0; i < moduleRoot->childCount(); i++) {
 				auto child = moduleRoot->child(i);
 				if (auto funcNode = dynamic_cast<AstNodeFunctionDeclaration*>(child)) {
+					// Functions of precompiled modules live in another object file
+					if (declaredOnly) {
+						declareModuleFunction(funcNode, moduleName);
+						continue;
+					}
 					// Generate module function with module name as prefix
 					if (!generateFunction(funcNode, false, moduleName)) {
 						return false;
@@ -3749,7 +4926,9 @@ namespace Qd {
 		for (size_t i = 0; i < root->childCount(); i++) {
 			auto child = root->child(i);
 			if (auto funcNode = dynamic_cast<AstNodeFunctionDeclaration*>(child)) {
-				if (funcNode->name() != "main") {
+				if (declaredFunctions.count(funcNode->name())) {
+					declareModuleFunction(funcNode, "main");
+				} else if (funcNode->name() != "main") {
 					if (!generateFunction(funcNode, false)) {
 						return false;
 					}
@@ -3785,6 +4964,29 @@ namespace Qd {
 		return true;
 	}
 
+	bool LlvmGenerator::Impl::isModuleDeclaredOnly(const std::string& moduleName) const {
+		if (!definedModule.empty()) {
+			return moduleName != definedModule;
+		}
+		return precompiledModules.count(moduleName) > 0;
+	}
+
+	void LlvmGenerator::Impl::declareModuleFunction(
+			AstNodeFunctionDeclaration* funcNode, const std::string& namePrefix) {
+		// Only the usr_<prefix>_<name> stack entry point is exported, so calls into other
+		// compilation units always go through it (no native or unchecked entry points)
+		std::string fnName = "usr_" + namePrefix + "_" + funcNode->name();
+		std::string registerName =
+				(namePrefix == "main") ? funcNode->name() : (namePrefix + "::" + funcNode->name());
+		llvm::Function* fn = module->getFunction(fnName);
+		if (!fn) {
+			auto fnTy = llvm::FunctionType::get(execResultTy, {contextPtrTy}, false);
+			fn = llvm::Function::Create(fnTy, llvm::Function::ExternalLinkage, fnName, *module);
+		}
+		userFunctions[registerName] = fn;
+		fallibleFunctions[registerName] = funcNode->throws();
+	}
+
 	// LlvmGenerator implementation
 
 	LlvmGenerator::LlvmGenerator() : impl(nullptr) {
@@ -3815,6 +5017,62 @@ namespace Qd {
 		impl->optimizationLevel = level;
 	}
 
+	void LlvmGenerator::setRuntimeChecks(bool enabled) {
+		if (!impl) {
+			// Create implementation with a temporary module name - will be recreated in generate()
+			impl = std::make_unique<Impl>("temp");
+		}
+		impl->runtimeChecks = enabled;
+	}
+
+	void LlvmGenerator::setCallStackTracking(bool enabled) {
+		if (!impl) {
+			// Create implementation with a temporary module name - will be recreated in generate()
+			impl = std::make_unique<Impl>("temp");
+		}
+		impl->callStackTracking = enabled;
+	}
+
+	void LlvmGenerator::setLinkTimeOptimization(bool enabled) {
+		if (!impl) {
+			// Create implementation with a temporary module name - will be recreated in generate()
+			impl = std::make_unique<Impl>("temp");
+		}
+		impl->linkTimeOptimization = enabled;
+	}
+
+	void LlvmGenerator::setStackSize(size_t elements) {
+		if (!impl) {
+			// Create implementation with a temporary module name - will be recreated in generate()
+			impl = std::make_unique<Impl>("temp");
+		}
+		impl->stackSize = elements;
+	}
+
+	void LlvmGenerator::setStackGrowth(bool enabled) {
+		if (!impl) {
+			// Create implementation with a temporary module name - will be recreated in generate()
+			impl = std::make_unique<Impl>("temp");
+		}
+		impl->stackGrowth = enabled;
+	}
+
+	void LlvmGenerator::setProfileGenerate(const std::string& profileFile) {
+		if (!impl) {
+			// Create implementation with a temporary module name - will be recreated in generate()
+			impl = std::make_unique<Impl>("temp");
+		}
+		impl->profileGenerateFile = profileFile;
+	}
+
+	void LlvmGenerator::setProfileUse(const std::string& profileFile) {
+		if (!impl) {
+			// Create implementation with a temporary module name - will be recreated in generate()
+			impl = std::make_unique<Impl>("temp");
+		}
+		impl->profileUseFile = profileFile;
+	}
+
 	void LlvmGenerator::addLibrarySearchPath(const std::string& path) {
 		if (!impl) {
 			// Create implementation with a temporary module name - will be recreated in generate()
@@ -3839,6 +5097,34 @@ namespace Qd {
 		return impl->generateProgram(root);
 	}
 
+	bool LlvmGenerator::generateModule(const std::string& moduleName) {
+		if (!impl) {
+			impl = std::make_unique<Impl>(moduleName);
+		}
+		auto it = impl->moduleSourceFiles.find(moduleName);
+		impl->sourceFileName = (it != impl->moduleSourceFiles.end()) ? it->second : moduleName + ".qd";
+
+		// Same passes as a full program, with an empty main file
+		AstProgram emptyProgram;
+		impl->definedModule = moduleName;
+		return impl->generateProgram(&emptyProgram);
+	}
+
+	void LlvmGenerator::addDeclaredFunction(const std::string& functionName) {
+		if (!impl) {
+			impl = std::make_unique<Impl>("temp");
+		}
+		impl->declaredFunctions.insert(functionName);
+	}
+
+	void LlvmGenerator::addPrecompiledModule(const std::string& moduleName, const std::string& objectFile) {
+		if (!impl) {
+			// Create implementation with a temporary module name - will be recreated in generate()
+			impl = std::make_unique<Impl>("temp");
+		}
+		impl->precompiledModules[moduleName] = objectFile;
+	}
+
 	void LlvmGenerator::addModuleAST(
 			const std::string& moduleName, IAstNode* moduleRoot, const std::string& sourceFileName) {
 		if (!impl) {
@@ -3877,17 +5163,68 @@ namespace Qd {
 		return true;
 	}
 
+	// Optimize the module according to optimizationLevel (data layout must be set)
+	// Runs LLVM's default pipeline for the level with the Quadrate stack passes (passes.h) registered into it
+	// Profile instrumentation also runs at -O0; the profile is only used from -O1 up
+	void LlvmGenerator::Impl::runOptimizationPasses(llvm::TargetMachine* targetMachine) {
+		bool instrument = !profileGenerateFile.empty();
+		if (optimizationLevel <= 0 && !instrument) {
+			return;
+		}
+
+		std::optional<llvm::PGOOptions> pgoOptions;
+		if (instrument) {
+			pgoOptions = llvm::PGOOptions(
+					profileGenerateFile, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRInstr);
+		} else if (!profileUseFile.empty()) {
+			pgoOptions = llvm::PGOOptions(
+					profileUseFile, "", "", "", llvm::vfs::getRealFileSystem(), llvm::PGOOptions::IRUse);
+		}
+
+		llvm::LoopAnalysisManager loopAnalyses;
+		llvm::FunctionAnalysisManager functionAnalyses;
+		llvm::CGSCCAnalysisManager cgsccAnalyses;
+		llvm::ModuleAnalysisManager moduleAnalyses;
+		llvm::PassBuilder passBuilder(targetMachine, llvm::PipelineTuningOptions(), pgoOptions);
+		registerQuadratePasses(passBuilder, COMPACT_STACK);
+		passBuilder.registerModuleAnalyses(moduleAnalyses);
+		passBuilder.registerCGSCCAnalyses(cgsccAnalyses);
+		passBuilder.registerFunctionAnalyses(functionAnalyses);
+		passBuilder.registerLoopAnalyses(loopAnalyses);
+		passBuilder.crossRegisterProxies(loopAnalyses, functionAnalyses, cgsccAnalyses, moduleAnalyses);
+
+		llvm::ModulePassManager passes;
+		if (optimizationLevel <= 0) {
+			passes = passBuilder.buildO0DefaultPipeline(llvm::OptimizationLevel::O0);
+		} else {
+			llvm::OptimizationLevel level = optimizationLevel >= 3	 ? llvm::OptimizationLevel::O3
+											: optimizationLevel == 2 ? llvm::OptimizationLevel::O2
+																	 : llvm::OptimizationLevel::O1;
+			passes = passBuilder.buildPerModuleDefaultPipeline(level);
+		}
+		passes.run(*module, moduleAnalyses);
+	}
+
+	// Register all targets with LLVM
+	// Runs once per process; registration isn't thread-safe and quadc -j writes objects from several threads
+	static void initializeTargets() {
+		static const bool initialized = [] {
+			llvm::InitializeAllTargetInfos();
+			llvm::InitializeAllTargets();
+			llvm::InitializeAllTargetMCs();
+			llvm::InitializeAllAsmParsers();
+			llvm::InitializeAllAsmPrinters();
+			return true;
+		}();
+		(void)initialized;
+	}
+
 	bool LlvmGenerator::writeObject(const std::string& filename) {
 		if (!impl || !impl->module) {
 			return false;
 		}
 
-		// Initialize targets
-		llvm::InitializeAllTargetInfos();
-		llvm::InitializeAllTargets();
-		llvm::InitializeAllTargetMCs();
-		llvm::InitializeAllAsmParsers();
-		llvm::InitializeAllAsmPrinters();
+		initializeTargets();
 
 		auto targetTripleStr = llvm::sys::getDefaultTargetTriple();
 		llvm::Triple targetTriple(targetTripleStr);
@@ -3908,46 +5245,12 @@ namespace Qd {
 
 		impl->module->setDataLayout(targetMachine->createDataLayout());
 
-		// Run optimization passes if optimization level > 0
-		if (impl->optimizationLevel > 0) {
-			// Use legacy PassManager for optimization passes
-			llvm::legacy::FunctionPassManager fpm(impl->module.get());
-			llvm::legacy::PassManager mpm;
-
-			// Add function-level optimization passes based on level
-			if (impl->optimizationLevel >= 1) {
-				// Basic optimizations
-				fpm.add(llvm::createPromoteMemoryToRegisterPass()); // mem2reg
-				fpm.add(llvm::createInstructionCombiningPass());	// instcombine
-				fpm.add(llvm::createReassociatePass());				// reassociate
-				fpm.add(llvm::createCFGSimplificationPass());		// simplifycfg
-			}
-
-			if (impl->optimizationLevel >= 2) {
-				// More aggressive optimizations
-				fpm.add(llvm::createGVNPass());					// GVN (Global Value Numbering)
-				fpm.add(llvm::createDeadCodeEliminationPass()); // Dead Code Elimination
-				fpm.add(llvm::createSROAPass());				// Scalar Replacement of Aggregates
-			}
-
-			if (impl->optimizationLevel >= 3) {
-				// Most aggressive optimizations
-				fpm.add(llvm::createLICMPass()); // Loop Invariant Code Motion
-				fpm.add(llvm::createLoopUnrollPass());
-			}
-
-			// Run function passes on all functions
-			fpm.doInitialization();
-			for (auto& func : *impl->module) {
-				if (!func.isDeclaration()) {
-					fpm.run(func);
-				}
-			}
-			fpm.doFinalization();
-
-			// Run module passes
-			mpm.run(*impl->module);
+		// With -flto, runtime and library functions are inlined by the regular pipeline,
+		// which also drops their bodies afterwards (available_externally)
+		if (impl->linkTimeOptimization && impl->optimizationLevel > 0 && !impl->linkRuntimeBitcode()) {
+			return false;
 		}
+		impl->runOptimizationPasses(targetMachine.get());
 
 		std::error_code ec;
 		llvm::raw_fd_ostream dest(filename, ec, llvm::sys::fs::OF_None);
@@ -3968,126 +5271,586 @@ namespace Qd {
 		return true;
 	}
 
-	bool LlvmGenerator::writeExecutable(const std::string& filename) {
-		// Generate object file first
-		std::string objFile = filename + ".o";
-		if (!writeObject(objFile)) {
-			return false;
+	std::vector<std::string> LlvmGenerator::exportedFunctions() const {
+		std::vector<std::string> names;
+		if (!impl || !impl->module) {
+			return names;
 		}
-
-		// Determine library directory
-		std::string libDir;
-
-		// Check QUADRATE_LIBDIR environment variable first
-		if (const char* quadrateLibDir = std::getenv("QUADRATE_LIBDIR")) {
-			std::filesystem::path libPath(quadrateLibDir);
-			// Convert to absolute path if relative
-			if (libPath.is_relative()) {
-				libPath = std::filesystem::absolute(libPath);
-			}
-			if (std::filesystem::exists(libPath)) {
-				libDir = libPath.string();
+		for (const auto& func : *impl->module) {
+			if (!func.isDeclaration() && func.hasExternalLinkage() && func.getName().starts_with("usr_")) {
+				names.push_back(func.getName().str());
 			}
 		}
-		// Check ./dist/lib (development build) - use absolute path
-		if (libDir.empty()) {
+		return names;
+	}
+
+	// Find the directory containing libqdrt and the standard libraries
+	// Resolved once per process; the REPL links every line
+	static const std::string& quadrateLibDir() {
+		static const std::string libDir = [] {
+			// Check QUADRATE_LIBDIR environment variable first
+			if (const char* quadrateLibDir = std::getenv("QUADRATE_LIBDIR")) {
+				std::filesystem::path libPath(quadrateLibDir);
+				// Convert to absolute path if relative
+				if (libPath.is_relative()) {
+					libPath = std::filesystem::absolute(libPath);
+				}
+				if (std::filesystem::exists(libPath)) {
+					return libPath.string();
+				}
+			}
+			// Check ./dist/lib (development build) - use absolute path
 			std::filesystem::path distLib = std::filesystem::absolute("./dist/lib");
 			if (std::filesystem::exists(distLib)) {
-				libDir = distLib.string();
+				return distLib.string();
 			}
-		}
-		// Check relative to executable (installed binaries)
-		if (libDir.empty()) {
+			// Check relative to executable (installed binaries)
 			std::error_code ec;
 			std::filesystem::path exePath = std::filesystem::canonical("/proc/self/exe", ec);
 			if (!ec) {
 				std::filesystem::path exeDir = exePath.parent_path();
 				std::filesystem::path installedLib = exeDir / ".." / "lib";
 				if (std::filesystem::exists(installedLib)) {
-					libDir = installedLib.string();
+					return installedLib.string();
 				}
 			}
-		}
-		// Check ~/.local/lib (user installation)
-		if (libDir.empty()) {
+			// Check ~/.local/lib (user installation)
 			if (const char* home = std::getenv("HOME")) {
 				std::filesystem::path localLib = std::filesystem::path(home) / ".local" / "lib";
 				if (std::filesystem::exists(localLib)) {
-					libDir = localLib.string();
+					return localLib.string();
 				}
 			}
-		}
-		// Check system library path
-		if (libDir.empty()) {
+			// Check system library path
 			if (std::filesystem::exists("/usr/lib")) {
-				libDir = "/usr/lib";
+				return std::string("/usr/lib");
 			}
+			return std::string();
+		}();
+		return libDir;
+	}
+
+	// Resolve a static library to its path, checking package search paths first, then the library directory
+	// Results are cached per process, keyed by library name and search paths
+	static std::string resolveStaticLibrary(const std::string& library, const std::vector<std::string>& searchPaths) {
+		static std::map<std::string, std::string> resolved;
+
+		std::string key = library;
+		for (const auto& searchPath : searchPaths) {
+			key += "\n" + searchPath;
+		}
+		auto cached = resolved.find(key);
+		if (cached != resolved.end()) {
+			return cached->second;
 		}
 
-		// Build library flags - link static libraries directly
-		// Check for nested structure (build directory) first, then flat structure (dist)
-		std::string qdrtStaticPath;
-		std::string nestedPath = libDir + "/qdrt/libqdrt_static.a";
-		std::string flatPath = libDir + "/libqdrt_static.a";
+		std::string foundLibPath;
+
+		// First, check in additional library search paths (third-party packages)
+		for (const auto& searchPath : searchPaths) {
+			std::string candidatePath = searchPath + "/" + library;
+			if (std::filesystem::exists(candidatePath)) {
+				foundLibPath = candidatePath;
+				break;
+			}
+		}
 
+		// If not found in search paths, check main libDir
+		if (foundLibPath.empty()) {
+			const std::string& libDir = quadrateLibDir();
+			std::string flatLib = libDir + "/" + library;
+
+			// Extract library name for nested search
+			// Examples: "libstdmathqd_static.a" -> "stdmathqd", "libqdrt_static.a" -> "qdrt"
+			std::string libBaseName = library;
+			if (libBaseName.rfind("lib", 0) == 0) {
+				libBaseName = libBaseName.substr(3); // Remove "lib" prefix
+			}
+			// Remove ".a" suffix first
+			if (libBaseName.size() > 2 && libBaseName.substr(libBaseName.size() - 2) == ".a") {
+				libBaseName = libBaseName.substr(0, libBaseName.size() - 2);
+			}
+			// Remove "_static" suffix if present
+			if (libBaseName.size() > 7 && libBaseName.substr(libBaseName.size() - 7) == "_static") {
+				libBaseName = libBaseName.substr(0, libBaseName.size() - 7);
+			}
+			std::string nestedLib = libDir + "/" + libBaseName + "/" + library;
+
+			if (std::filesystem::exists(flatLib)) {
+				foundLibPath = flatLib;
+			} else if (std::filesystem::exists(nestedLib)) {
+				foundLibPath = nestedLib;
+			} else {
+				// Try without libDir prefix (fallback)
+				foundLibPath = library;
+			}
+		}
+
+		resolved[key] = foundLibPath;
+		return foundLibPath;
+	}
+
+	// Find libqdrt_static.a
+	// Check for nested structure (build directory) first, then flat structure (dist)
+	static std::string qdrtStaticLibrary() {
+		const std::string& libDir = quadrateLibDir();
+		std::string nestedPath = libDir + "/qdrt/libqdrt_static.a";
 		if (std::filesystem::exists(nestedPath)) {
-			qdrtStaticPath = nestedPath;
-		} else if (std::filesystem::exists(flatPath)) {
-			qdrtStaticPath = flatPath;
-		} else {
-			// Fallback to flat path (will error later if doesn't exist)
-			qdrtStaticPath = flatPath;
+			return nestedPath;
 		}
+		// Fallback to flat path (will error later if doesn't exist)
+		return libDir + "/libqdrt_static.a";
+	}
 
-		std::string libraryFlags = qdrtStaticPath;
+	// Bitcode installed next to a static library, e.g. libqdrt_static.a -> qdrt.bc
+	static std::string staticLibraryBitcode(const std::string& libraryPath) {
+		std::filesystem::path path(libraryPath);
+		std::string name = path.filename().string();
+		if (name.rfind("lib", 0) == 0) {
+			name = name.substr(3);
+		}
+		if (name.size() > 2 && name.substr(name.size() - 2) == ".a") {
+			name = name.substr(0, name.size() - 2);
+		}
+		if (name.size() > 7 && name.substr(name.size() - 7) == "_static") {
+			name = name.substr(0, name.size() - 7);
+		}
+		return (path.parent_path() / (name + ".bc")).string();
+	}
 
-		// Add imported libraries
-		for (const auto& library : impl->importedLibraries) {
-			// Check if it's already a .a file (static library)
+	// Check if a linked function depends on state that is private to its library
+	// Mutable internal globals would be duplicated by a copy of the function, and so would the
+	// internal functions that can't be copied themselves
+	static bool usesPrivateState(const llvm::Value* value, const std::set<const llvm::Function*>& copyable,
+			std::set<const llvm::Value*>& visited) {
+		if (!visited.insert(value).second) {
+			return false;
+		}
+		if (const auto* global = llvm::dyn_cast<llvm::GlobalValue>(value)) {
+			if (!global->hasLocalLinkage()) {
+				return false;
+			}
+			if (const auto* function = llvm::dyn_cast<llvm::Function>(global)) {
+				return !copyable.count(function);
+			}
+			const auto* variable = llvm::dyn_cast<llvm::GlobalVariable>(global);
+			if (!variable || !variable->isConstant()) {
+				return true;
+			}
+			return variable->hasInitializer() && usesPrivateState(variable->getInitializer(), copyable, visited);
+		}
+		if (const auto* constant = llvm::dyn_cast<llvm::Constant>(value)) {
+			for (const llvm::Use& operand : constant->operands()) {
+				if (usesPrivateState(operand.get(), copyable, visited)) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// Link the bitcode of the runtime and the imported static libraries into the module (-flto)
+	// The archives are still linked and own every symbol: linked functions become available_externally,
+	// so their bodies only serve the inliner, and linked variables become declarations again. Functions
+	// that use private state of their library are reduced to declarations, since a copy would see its
+	// own instance of that state.
+	bool LlvmGenerator::Impl::linkRuntimeBitcode() {
+		std::vector<std::string> bitcodeFiles = {staticLibraryBitcode(qdrtStaticLibrary())};
+		for (const auto& library : importedLibraries) {
 			if (library.size() >= 2 && library.substr(library.size() - 2) == ".a") {
-				// It's a static library, link it directly
-				std::string foundLibPath;
+				bitcodeFiles.push_back(staticLibraryBitcode(resolveStaticLibrary(library, librarySearchPaths)));
+			}
+		}
+
+		// Everything defined so far is generated code and stays as it is
+		std::set<const llvm::GlobalValue*> ownDefinitions;
+		for (const auto& global : module->global_values()) {
+			if (!global.isDeclaration()) {
+				ownDefinitions.insert(&global);
+			}
+		}
+
+		// Only definitions of functions the module calls are linked in, together with what they use
+		llvm::Linker linker(*module);
+		for (const auto& bitcodeFile : bitcodeFiles) {
+			if (!std::filesystem::exists(bitcodeFile)) {
+				continue;
+			}
+			llvm::SMDiagnostic diagnostic;
+			std::unique_ptr<llvm::Module> library = llvm::parseIRFile(bitcodeFile, diagnostic, *context);
+			if (!library) {
+				std::cerr << "Warning: ignoring " << bitcodeFile << ": " << diagnostic.getMessage().str() << std::endl;
+				continue;
+			}
+			library->setTargetTriple(module->getTargetTriple());
+			library->setDataLayout(module->getDataLayout());
+			if (linker.linkInModule(std::move(library), llvm::Linker::LinkOnlyNeeded)) {
+				std::cerr << "Error: failed to link " << bitcodeFile << std::endl;
+				return false;
+			}
+		}
+
+		// Find the linked functions that can be copied, until no more are ruled out
+		std::set<const llvm::Function*> copyable;
+		for (const auto& function : *module) {
+			if (!function.isDeclaration() && !ownDefinitions.count(&function)) {
+				copyable.insert(&function);
+			}
+		}
+		bool changed = true;
+		while (changed) {
+			changed = false;
+			for (auto it = copyable.begin(); it != copyable.end();) {
+				bool usesState = false;
+				std::set<const llvm::Value*> visited;
+				for (const auto& instruction : llvm::instructions(**it)) {
+					for (const llvm::Use& operand : instruction.operands()) {
+						if (llvm::isa<llvm::Constant>(operand.get()) &&
+								usesPrivateState(operand.get(), copyable, visited)) {
+							usesState = true;
+						}
+					}
+				}
+				if (usesState) {
+					it = copyable.erase(it);
+					changed = true;
+				} else {
+					++it;
+				}
+			}
+		}
 
-				// First, check in additional library search paths (third-party packages)
+		for (auto& function : *module) {
+			if (function.isDeclaration() || ownDefinitions.count(&function)) {
+				continue;
+			}
+			if (!copyable.count(&function)) {
+				// Internal functions that can't be copied are left unused and removed by GlobalDCE
+				if (!function.hasLocalLinkage()) {
+					function.deleteBody();
+				}
+				continue;
+			}
+			// The bitcode was built for the same target; let the target machine pick the features
+			function.removeFnAttr("target-cpu");
+			function.removeFnAttr("target-features");
+			function.removeFnAttr("tune-cpu");
+			if (!function.hasLocalLinkage()) {
+				function.setLinkage(llvm::GlobalValue::AvailableExternallyLinkage);
+				function.setComdat(nullptr);
+			}
+		}
+		for (auto& variable : module->globals()) {
+			if (!variable.isDeclaration() && !variable.hasLocalLinkage() && !ownDefinitions.count(&variable)) {
+				variable.setInitializer(nullptr);
+				variable.setLinkage(llvm::GlobalValue::ExternalLinkage);
+				variable.setComdat(nullptr);
+			}
+		}
+		return true;
+	}
+
+#ifdef QD_HAVE_LLD
+	// Placeholders for the output file and our own link inputs in the cached linker command
+	static const char* LINK_OUTPUT_PLACEHOLDER = "@QD_OUTPUT@";
+	static const char* LINK_INPUTS_PLACEHOLDER = "@QD_INPUTS@";
+
+	// Split a command printed by `clang -###` into its (double quoted) arguments
+	static std::vector<std::string> splitDriverCommand(const std::string& line) {
+		std::vector<std::string> args;
+		size_t i = 0;
+		while (i < line.size()) {
+			if (line[i] != '"') {
+				i++;
+				continue;
+			}
+			std::string arg;
+			for (i++; i < line.size() && line[i] != '"'; i++) {
+				if (line[i] == '\\' && i + 1 < line.size()) {
+					i++;
+				}
+				arg += line[i];
+			}
+			i++;
+			args.push_back(arg);
+		}
+		return args;
+	}
+
+	// Find an executable in PATH
+	static std::string findInPath(const std::string& name) {
+		const char* path = std::getenv("PATH");
+		if (!path) {
+			return "";
+		}
+		std::string paths = path;
+		size_t begin = 0;
+		while (begin <= paths.size()) {
+			size_t end = paths.find(':', begin);
+			if (end == std::string::npos) {
+				end = paths.size();
+			}
+			std::filesystem::path candidate = std::filesystem::path(paths.substr(begin, end - begin)) / name;
+			if (access(candidate.c_str(), X_OK) == 0) {
+				return candidate.string();
+			}
+			begin = end + 1;
+		}
+		return "";
+	}
+
+	// Where the linker command is cached, or empty if there is no cache directory
+	static std::string linkCommandCacheFile() {
+		if (const char* xdgCacheHome = std::getenv("XDG_CACHE_HOME")) {
+			return std::string(xdgCacheHome) + "/quadrate/link-command";
+		}
+		if (const char* home = std::getenv("HOME")) {
+			return std::string(home) + "/.cache/quadrate/link-command";
+		}
+		return "";
+	}
+
+	// Fingerprint of the files a linker command refers to (crt objects, library directories, the
+	// dynamic linker), so a cached command is dropped when the toolchain or libc is upgraded
+	static std::string linkCommandFingerprint(const std::vector<std::string>& command) {
+		std::string stamps;
+		for (const auto& arg : command) {
+			std::string path = arg;
+			if (path.rfind("-L", 0) == 0) {
+				path = path.substr(2);
+			}
+			if (path.empty() || path[0] != '/') {
+				continue;
+			}
+			std::error_code ec;
+			auto time = std::filesystem::last_write_time(path, ec);
+			std::string stamp = ec ? std::string("missing") : std::to_string(time.time_since_epoch().count());
+			stamps += path + "=" + stamp + ";";
+		}
+		return std::to_string(std::hash<std::string>()(stamps));
+	}
+
+	// The linker command the clang driver would run (crt objects, system library paths, dynamic linker),
+	// with placeholders for the output and our inputs. It is asked for once and kept in
+	// ~/.cache/quadrate/link-command, keyed by the clang binary and the target, and checked against the
+	// modification times of the paths it names, so later builds don't start clang at all.
+	// Returns an empty vector if the command can't be determined.
+	static std::vector<std::string> systemLinkCommand(const std::string& objectFile, const std::string& outputFile) {
+		static bool resolved = false;
+		static std::vector<std::string> command;
+		if (resolved) {
+			return command;
+		}
+		resolved = true;
+
+		std::string clangPath = findInPath("clang");
+		if (clangPath.empty()) {
+			return command;
+		}
+		std::error_code ec;
+		auto clangSize = std::filesystem::file_size(clangPath, ec);
+		auto clangTime = std::filesystem::last_write_time(clangPath, ec);
+		if (ec) {
+			return command;
+		}
+		std::string key = clangPath + " " + std::to_string(clangSize) + " " +
+						  std::to_string(clangTime.time_since_epoch().count()) + " " +
+						  llvm::sys::getDefaultTargetTriple();
+
+		std::string cacheFile = linkCommandCacheFile();
+
+		// Cached command: first line is the key, then the fingerprint, then one argument per line
+		if (!cacheFile.empty()) {
+			std::ifstream in(cacheFile);
+			std::string line;
+			std::string fingerprint;
+			if (in && std::getline(in, line) && line == key && std::getline(in, fingerprint)) {
+				while (std::getline(in, line)) {
+					command.push_back(line);
+				}
+				if (linkCommandFingerprint(command) == fingerprint) {
+					return command;
+				}
+				command.clear();
+			}
+		}
+
+		// Ask the driver; the linker is the last command it prints
+		std::string query = "'" + clangPath + "' -### -o '" + outputFile + "' '" + objectFile + "' 2>&1";
+		FILE* pipe = popen(query.c_str(), "r");
+		if (!pipe) {
+			return command;
+		}
+		std::string output;
+		char buffer[4096];
+		size_t n;
+		while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
+			output.append(buffer, n);
+		}
+		if (pclose(pipe) != 0) {
+			return command;
+		}
+		std::string lastLine;
+		size_t lineStart = 0;
+		while (lineStart < output.size()) {
+			size_t lineEnd = output.find('\n', lineStart);
+			if (lineEnd == std::string::npos) {
+				lineEnd = output.size();
+			}
+			if (lineEnd > lineStart && output[lineStart] == ' ') {
+				lastLine = output.substr(lineStart, lineEnd - lineStart);
+			}
+			lineStart = lineEnd + 1;
+		}
+
+		std::vector<std::string> args = splitDriverCommand(lastLine);
+		bool sawOutput = false;
+		bool sawInputs = false;
+		// Skip argv[0]: the linker the driver picked; lld takes its place
+		for (size_t i = 1; i < args.size(); i++) {
+			if (args[i] == outputFile) {
+				command.push_back(LINK_OUTPUT_PLACEHOLDER);
+				sawOutput = true;
+			} else if (args[i] == objectFile) {
+				command.push_back(LINK_INPUTS_PLACEHOLDER);
+				sawInputs = true;
+			} else {
+				command.push_back(args[i]);
+			}
+		}
+		if (!sawOutput || !sawInputs) {
+			command.clear();
+			return command;
+		}
+
+		if (!cacheFile.empty()) {
+			std::filesystem::create_directories(std::filesystem::path(cacheFile).parent_path(), ec);
+			std::string tempFile = cacheFile + ".tmp" + std::to_string(getpid());
+			{
+				std::ofstream out(tempFile);
+				out << key << "\n";
+				out << linkCommandFingerprint(command) << "\n";
+				for (const auto& arg : command) {
+					out << arg << "\n";
+				}
+			}
+			std::filesystem::rename(tempFile, cacheFile, ec);
+			if (ec) {
+				std::remove(tempFile.c_str());
+			}
+		}
+		return command;
+	}
+
+	// Link with the embedded lld instead of starting clang; the link result is stored in linked
+	// Returns false if lld is unusable here or fails, so the caller falls back to the clang driver
+	static bool linkInProcess(const std::string& outputFile, const std::vector<std::string>& inputs, bool& linked) {
+		// lld can't always be run twice in one process; after such a run every link goes through clang
+		static bool lldUsable = true;
+		if (!lldUsable) {
+			return false;
+		}
+
+		std::vector<std::string> systemCommand = systemLinkCommand(inputs.front(), outputFile);
+		if (systemCommand.empty()) {
+			lldUsable = false;
+			return false;
+		}
+
+		std::vector<const char*> args = {"ld.lld"};
+		for (const auto& arg : systemCommand) {
+			if (arg == LINK_OUTPUT_PLACEHOLDER) {
+				args.push_back(outputFile.c_str());
+			} else if (arg == LINK_INPUTS_PLACEHOLDER) {
+				for (const auto& input : inputs) {
+					args.push_back(input.c_str());
+				}
+			} else {
+				args.push_back(arg.c_str());
+			}
+		}
+
+		lld::Result result = lld::lldMain(args, llvm::outs(), llvm::errs(), {{lld::Gnu, &lld::elf::link}});
+		if (!result.canRunAgain) {
+			lldUsable = false;
+		}
+		if (result.retCode != 0) {
+			// The cached command may be stale in a way the fingerprint doesn't catch; drop it and let
+			// the driver, which reports the real error if there is one, do this and later links
+			std::string cacheFile = linkCommandCacheFile();
+			if (!cacheFile.empty()) {
+				std::remove(cacheFile.c_str());
+			}
+			lldUsable = false;
+			return false;
+		}
+		linked = true;
+		return true;
+	}
+#endif
+
+	bool LlvmGenerator::addToJit(LlvmJit& jit) {
+		if (!impl || !impl->module || !jit.isValid()) {
+			return false;
+		}
+
+		impl->module->setTargetTriple(llvm::Triple(jit.targetTriple()));
+		impl->module->setDataLayout(jit.dataLayout());
+		impl->runOptimizationPasses();
+
+		// Libraries from import statements are loaded into the JIT instead of being linked
+		for (const auto& library : impl->importedLibraries) {
+			std::string libraryPath = library;
+			if (library.size() >= 2 && library.substr(library.size() - 2) == ".a") {
+				libraryPath = resolveStaticLibrary(library, impl->librarySearchPaths);
+			} else {
 				for (const auto& searchPath : impl->librarySearchPaths) {
 					std::string candidatePath = searchPath + "/" + library;
 					if (std::filesystem::exists(candidatePath)) {
-						foundLibPath = candidatePath;
+						libraryPath = candidatePath;
 						break;
 					}
 				}
+			}
+			if (!jit.addLibrary(libraryPath)) {
+				return false;
+			}
+		}
 
-				// If not found in search paths, check main libDir
-				if (foundLibPath.empty()) {
-					std::string flatLib = libDir + "/" + library;
+		// The builders refer to the module and context; drop them before handing both over
+		impl->debugBuilder.reset();
+		impl->builder.reset();
+		return jit.addModule(std::move(impl->context), std::move(impl->module));
+	}
 
-					// Extract library name for nested search
-					// Examples: "libstdmathqd_static.a" -> "stdmathqd", "libqdrt_static.a" -> "qdrt"
-					std::string libBaseName = library;
-					if (libBaseName.rfind("lib", 0) == 0) {
-						libBaseName = libBaseName.substr(3); // Remove "lib" prefix
-					}
-					// Remove ".a" suffix first
-					if (libBaseName.size() > 2 && libBaseName.substr(libBaseName.size() - 2) == ".a") {
-						libBaseName = libBaseName.substr(0, libBaseName.size() - 2);
-					}
-					// Remove "_static" suffix if present
-					if (libBaseName.size() > 7 && libBaseName.substr(libBaseName.size() - 7) == "_static") {
-						libBaseName = libBaseName.substr(0, libBaseName.size() - 7);
-					}
-					std::string nestedLib = libDir + "/" + libBaseName + "/" + library;
+	bool LlvmGenerator::writeExecutable(const std::string& filename) {
+		// Generate object file first
+		std::string objFile = filename + ".o";
+		if (!writeObject(objFile)) {
+			return false;
+		}
 
-					if (std::filesystem::exists(flatLib)) {
-						foundLibPath = flatLib;
-					} else if (std::filesystem::exists(nestedLib)) {
-						foundLibPath = nestedLib;
-					} else {
-						// Try without libDir prefix (fallback)
-						foundLibPath = library;
-					}
-				}
+		// Link inputs in order: objects, library search paths, libraries
+		// Objects of precompiled modules go right after the program's own object
+		std::vector<std::string> linkInputs = {objFile};
+		for (const auto& precompiled : impl->precompiledModules) {
+			linkInputs.push_back(precompiled.second);
+		}
+
+		// Build -L flags for additional library search paths (third-party packages)
+		for (const auto& searchPath : impl->librarySearchPaths) {
+			linkInputs.push_back("-L" + searchPath);
+		}
+
+		// Link static libraries directly
+		linkInputs.push_back(qdrtStaticLibrary());
 
-				libraryFlags += " " + foundLibPath;
+		// Add imported libraries
+		for (const auto& library : impl->importedLibraries) {
+			// Check if it's already a .a file (static library)
+			if (library.size() >= 2 && library.substr(library.size() - 2) == ".a") {
+				// It's a static library, link it directly
+				linkInputs.push_back(resolveStaticLibrary(library, impl->librarySearchPaths));
 			} else {
 				// Handle .so libraries (dynamic linking)
 				std::string libName = library;
@@ -4100,27 +5863,37 @@ namespace Qd {
 					libName = libName.substr(0, libName.size() - 3);
 				}
 
-				libraryFlags += " -l" + libName;
+				linkInputs.push_back("-l" + libName);
 			}
 		}
 
 		// Add standard system libraries
-		libraryFlags += " -lm -lpthread";
-
-		// Build -L flags for additional library search paths (third-party packages)
-		std::string librarySearchFlags;
-		for (const auto& searchPath : impl->librarySearchPaths) {
-			librarySearchFlags += " -L" + searchPath;
+		linkInputs.push_back("-lm");
+		linkInputs.push_back("-lpthread");
+
+		bool linked = false;
+		bool linkedInProcess = false;
+#ifdef QD_HAVE_LLD
+		// The cached linker command lacks the profile runtime, which the driver adds for -fprofile-generate
+		if (impl->profileGenerateFile.empty()) {
+			linkedInProcess = linkInProcess(filename, linkInputs, linked);
+		}
+#endif
+		if (!linkedInProcess) {
+			std::string linkCmd = "clang -o " + filename;
+			if (!impl->profileGenerateFile.empty()) {
+				linkCmd += " -fprofile-generate";
+			}
+			for (const auto& input : linkInputs) {
+				linkCmd += " " + input;
+			}
+			linked = system(linkCmd.c_str()) == 0;
 		}
-
-		std::string linkCmd = "clang -o " + filename + " " + objFile + " " + librarySearchFlags + " " + libraryFlags;
-
-		int result = system(linkCmd.c_str());
 
 		// Clean up object file
 		std::remove(objFile.c_str());
 
-		return result == 0;
+		return linked;
 	}
 
 	// Helper function to get size of a type
@@ -4216,10 +5989,10 @@ namespace Qd {
 			// Get element pointer
 			llvm::Value* dataPtr = builder->CreateStructGEP(stackTy, st, 0, "data_ptr");
 			llvm::Value* data = builder->CreateLoad(llvm::PointerType::getUnqual(*context), dataPtr, "data");
-			llvm::Value* elemPtr = builder->CreateGEP(stackElementTy, data, newSize, "elem_ptr");
+			StackSlot elemSlot = stackSlot(st, data, newSize, "elem_ptr");
 
 			// Load value from stack element
-			llvm::Value* valuePtr = builder->CreateStructGEP(stackElementTy, elemPtr, 0, "value_ptr");
+			llvm::Value* valuePtr = slotValuePtr(elemSlot, "value_ptr");
 
 			// Store to struct field based on type
 			if (field.typeName == "f64") {
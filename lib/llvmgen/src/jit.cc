@@ -0,0 +1,134 @@
+#include <llvmgen/jit.h>
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/TargetSelect.h>
+
+#include <iostream>
+#include <set>
+
+namespace Qd {
+
+	class LlvmJit::Impl {
+	public:
+		std::unique_ptr<llvm::orc::LLJIT> jit;
+		std::set<std::string> libraries; // Added with addLibrary()
+	};
+
+	LlvmJit::LlvmJit() : impl(std::make_unique<Impl>()) {
+		llvm::InitializeNativeTarget();
+		llvm::InitializeNativeTargetAsmPrinter();
+
+		auto jit = llvm::orc::LLJITBuilder().create();
+		if (!jit) {
+			std::cerr << "Error creating JIT: " << llvm::toString(jit.takeError()) << std::endl;
+			return;
+		}
+		impl->jit = std::move(*jit);
+
+		// Runtime functions (qd_*) and libc come from the host process
+		auto processSymbols = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+				impl->jit->getDataLayout().getGlobalPrefix());
+		if (!processSymbols) {
+			std::cerr << "Error creating JIT: " << llvm::toString(processSymbols.takeError()) << std::endl;
+			impl->jit.reset();
+			return;
+		}
+		impl->jit->getMainJITDylib().addGenerator(std::move(*processSymbols));
+	}
+
+	LlvmJit::~LlvmJit() = default;
+
+	bool LlvmJit::isValid() const {
+		return impl->jit != nullptr;
+	}
+
+	std::string LlvmJit::dataLayout() const {
+		if (!impl->jit) {
+			return "";
+		}
+		return impl->jit->getDataLayout().getStringRepresentation();
+	}
+
+	std::string LlvmJit::targetTriple() const {
+		if (!impl->jit) {
+			return "";
+		}
+		return impl->jit->getTargetTriple().str();
+	}
+
+	bool LlvmJit::defineSymbol(const std::string& name, void* address) {
+		if (!impl->jit) {
+			return false;
+		}
+
+		llvm::orc::SymbolMap symbols;
+		symbols[impl->jit->mangleAndIntern(name)] = llvm::orc::ExecutorSymbolDef(
+				llvm::orc::ExecutorAddr::fromPtr(address), llvm::JITSymbolFlags::Exported | llvm::JITSymbolFlags::Callable);
+		if (auto err = impl->jit->getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(symbols)))) {
+			std::cerr << "Error defining JIT symbol " << name << ": " << llvm::toString(std::move(err)) << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	bool LlvmJit::addLibrary(const std::string& path) {
+		if (!impl->jit) {
+			return false;
+		}
+		if (!impl->libraries.insert(path).second) {
+			return true;
+		}
+
+		auto& dylib = impl->jit->getMainJITDylib();
+		if (path.size() >= 2 && path.substr(path.size() - 2) == ".a") {
+			auto generator =
+					llvm::orc::StaticLibraryDefinitionGenerator::Load(impl->jit->getObjLinkingLayer(), path.c_str());
+			if (!generator) {
+				std::cerr << "Error loading library " << path << ": " << llvm::toString(generator.takeError())
+						  << std::endl;
+				return false;
+			}
+			dylib.addGenerator(std::move(*generator));
+		} else {
+			auto generator = llvm::orc::DynamicLibrarySearchGenerator::Load(
+					path.c_str(), impl->jit->getDataLayout().getGlobalPrefix());
+			if (!generator) {
+				std::cerr << "Error loading library " << path << ": " << llvm::toString(generator.takeError())
+						  << std::endl;
+				return false;
+			}
+			dylib.addGenerator(std::move(*generator));
+		}
+		return true;
+	}
+
+	bool LlvmJit::addModule(std::unique_ptr<llvm::LLVMContext> context, std::unique_ptr<llvm::Module> module) {
+		if (!impl->jit || !context || !module) {
+			return false;
+		}
+
+		if (auto err = impl->jit->addIRModule(llvm::orc::ThreadSafeModule(std::move(module), std::move(context)))) {
+			std::cerr << "Error adding module to JIT: " << llvm::toString(std::move(err)) << std::endl;
+			return false;
+		}
+		return true;
+	}
+
+	void* LlvmJit::lookup(const std::string& name) {
+		if (!impl->jit) {
+			return nullptr;
+		}
+
+		auto address = impl->jit->lookup(name);
+		if (!address) {
+			// Missing symbols are expected (callers fall back to native functions), so no error output
+			llvm::consumeError(address.takeError());
+			return nullptr;
+		}
+		return address->toPtr<void*>();
+	}
+
+} // namespace Qd
@@ -0,0 +1,559 @@
+#include "passes.h"
+
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/DerivedTypes.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Passes/PassBuilder.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace Qd {
+
+	// Runtime type of untyped parameters, which qd_check_stack doesn't check (QD_STACK_TYPE_PTR)
+	static const uint64_t QD_TYPE_PTR = 2;
+
+	// How far StackCheckEliminationPass looks back through single-predecessor blocks
+	static const unsigned CHECK_SEARCH_BLOCKS = 8;
+
+	// Kinds of qd_stack memory, each with its own TBAA type below STACK_TBAA_ROOT
+	// SLOT is a whole stack element and the parent of VALUE and TAG, which are disjoint parts of it
+	enum class StackAccess {
+		NONE,
+		CONTEXT, // ctx->st
+		DATA,	 // st->data
+		TAGS,	 // st->tags (QD_COMPACT_STACK)
+		SIZE,	 // st->size
+		SLOT,	 // data[i]
+		VALUE,	 // data[i].value (data[i] with QD_COMPACT_STACK)
+		TAG		 // data[i].type, is_error_tainted and is_borrowed (tags[i] with QD_COMPACT_STACK)
+	};
+
+	static const char* STACK_TBAA_ROOT = "Quadrate stack TBAA";
+
+	struct StackAccessName {
+		StackAccess access;
+		const char* name;
+	};
+
+	static const StackAccessName STACK_ACCESS_NAMES[] = {
+			{StackAccess::CONTEXT, "qd.context"},
+			{StackAccess::DATA, "qd.data"},
+			{StackAccess::TAGS, "qd.tags"},
+			{StackAccess::SIZE, "qd.size"},
+			{StackAccess::SLOT, "qd.slot"},
+			{StackAccess::VALUE, "qd.value"},
+			{StackAccess::TAG, "qd.tag"},
+	};
+
+	static const char* stackAccessName(StackAccess access) {
+		for (const auto& entry : STACK_ACCESS_NAMES) {
+			if (entry.access == access) {
+				return entry.name;
+			}
+		}
+		return nullptr;
+	}
+
+	static llvm::MDNode* stackAccessTag(llvm::LLVMContext& context, StackAccess access) {
+		// Metadata nodes are uniqued, so building the same tag twice yields the same node
+		llvm::MDBuilder builder(context);
+		llvm::MDNode* root = builder.createTBAARoot(STACK_TBAA_ROOT);
+		llvm::MDNode* parent = root;
+		if (access == StackAccess::VALUE || access == StackAccess::TAG) {
+			parent = builder.createTBAAScalarTypeNode(stackAccessName(StackAccess::SLOT), root);
+		}
+		llvm::MDNode* type = builder.createTBAAScalarTypeNode(stackAccessName(access), parent);
+		return builder.createTBAAStructTagNode(type, type, 0);
+	}
+
+	// Kind of qd_stack memory an instruction accesses, from the TBAA tag set by StackAccessTaggingPass
+	static StackAccess stackAccess(const llvm::Instruction* inst) {
+		llvm::MDNode* tag = inst->getMetadata(llvm::LLVMContext::MD_tbaa);
+		if (!tag || tag->getNumOperands() < 3) {
+			return StackAccess::NONE;
+		}
+
+		auto* type = llvm::dyn_cast<llvm::MDNode>(tag->getOperand(1));
+		if (!type || type->getNumOperands() < 2) {
+			return StackAccess::NONE;
+		}
+
+		// Must be one of ours and not a type of the same name from runtime bitcode
+		llvm::MDNode* root = type;
+		while (root->getNumOperands() >= 2) {
+			root = llvm::dyn_cast<llvm::MDNode>(root->getOperand(1));
+			if (!root) {
+				return StackAccess::NONE;
+			}
+		}
+		auto* rootName = llvm::dyn_cast<llvm::MDString>(root->getOperand(0));
+		auto* name = llvm::dyn_cast<llvm::MDString>(type->getOperand(0));
+		if (!rootName || rootName->getString() != STACK_TBAA_ROOT || !name) {
+			return StackAccess::NONE;
+		}
+
+		for (const auto& entry : STACK_ACCESS_NAMES) {
+			if (name->getString() == entry.name) {
+				return entry.access;
+			}
+		}
+		return StackAccess::NONE;
+	}
+
+	// Runtime functions that don't write qd_stack memory
+	static bool isStackNeutral(const llvm::CallBase* call) {
+		const llvm::Function* callee = call->getCalledFunction();
+		if (!callee) {
+			return false;
+		}
+		llvm::StringRef name = callee->getName();
+		return name == "qd_check_stack" || name == "qd_push_call" || name == "qd_pop_call" ||
+			   name == "qd_stack_size";
+	}
+
+	// qd_stack is { data, capacity, size }, or { data, capacity, size, tags } with QD_COMPACT_STACK
+	static bool isStackType(llvm::Type* type) {
+		auto* structType = llvm::dyn_cast<llvm::StructType>(type);
+		if (!structType || !structType->isLiteral()) {
+			return false;
+		}
+		unsigned count = structType->getNumElements();
+		if (count != 3 && count != 4) {
+			return false;
+		}
+		return structType->getElementType(0)->isPointerTy() && structType->getElementType(1)->isIntegerTy(64) &&
+			   structType->getElementType(2)->isIntegerTy(64) &&
+			   (count == 3 || structType->getElementType(3)->isPointerTy());
+	}
+
+	// The context is a function argument or the result of qd_create_context; st is its first field
+	static bool isContextField(llvm::Value* pointer) {
+		while (auto* gep = llvm::dyn_cast<llvm::GetElementPtrInst>(pointer)) {
+			if (!gep->hasAllZeroIndices()) {
+				return false;
+			}
+			pointer = gep->getPointerOperand();
+		}
+		return llvm::isa<llvm::Argument>(pointer) || llvm::isa<llvm::CallBase>(pointer);
+	}
+
+	// Field index if pointer is &st->field with st loaded from ctx->st, otherwise -1
+	static int stackField(llvm::Value* pointer, llvm::LoadInst** stackLoad) {
+		auto* gep = llvm::dyn_cast<llvm::GetElementPtrInst>(pointer);
+		if (!gep || gep->getNumIndices() != 2 || !isStackType(gep->getSourceElementType())) {
+			return -1;
+		}
+		auto* first = llvm::dyn_cast<llvm::ConstantInt>(gep->getOperand(1));
+		auto* field = llvm::dyn_cast<llvm::ConstantInt>(gep->getOperand(2));
+		if (!first || !first->isZero() || !field) {
+			return -1;
+		}
+		auto* load = llvm::dyn_cast<llvm::LoadInst>(gep->getPointerOperand());
+		if (!load || !load->getType()->isPointerTy() || !isContextField(load->getPointerOperand())) {
+			return -1;
+		}
+		*stackLoad = load;
+		return static_cast<int>(field->getZExtValue());
+	}
+
+	static bool isSingleIndex(const llvm::GetElementPtrInst* gep, llvm::Type* sourceType) {
+		return gep->getNumIndices() == 1 && gep->getSourceElementType() == sourceType;
+	}
+
+	// Kind of slot memory behind pointer: &data[i] (+ field) or &tags[i], with any number of offset GEPs
+	static StackAccess slotAccess(llvm::Value* pointer, llvm::Type* accessType, llvm::StructType* elementType) {
+		std::vector<llvm::GetElementPtrInst*> chain;
+		llvm::Value* base = pointer;
+		while (auto* gep = llvm::dyn_cast<llvm::GetElementPtrInst>(base)) {
+			chain.push_back(gep);
+			base = gep->getPointerOperand();
+		}
+
+		auto* array = llvm::dyn_cast<llvm::LoadInst>(base);
+		llvm::LoadInst* stackLoad = nullptr;
+		if (chain.empty() || !array) {
+			return StackAccess::NONE;
+		}
+		int field = stackField(array->getPointerOperand(), &stackLoad);
+
+		llvm::LLVMContext& context = pointer->getContext();
+		if (field == 3) {
+			bool bytes = std::all_of(chain.begin(), chain.end(), [&](llvm::GetElementPtrInst* gep) {
+				return isSingleIndex(gep, llvm::Type::getInt8Ty(context));
+			});
+			return bytes ? StackAccess::TAG : StackAccess::NONE;
+		}
+		if (field != 0) {
+			return StackAccess::NONE;
+		}
+
+		// Compact layout: data is an array of 8-byte values
+		bool values = std::all_of(chain.begin(), chain.end(), [&](llvm::GetElementPtrInst* gep) {
+			return isSingleIndex(gep, llvm::Type::getInt64Ty(context));
+		});
+		if (values) {
+			return StackAccess::VALUE;
+		}
+		if (!elementType) {
+			return StackAccess::NONE;
+		}
+
+		// Regular layout: data is an array of qd_stack_element_t, optionally followed by a field access
+		StackAccess access = accessType == elementType ? StackAccess::SLOT : StackAccess::NONE;
+		auto elements = chain.begin();
+		llvm::GetElementPtrInst* fieldGep = chain.front();
+		if (fieldGep->getNumIndices() == 2 && fieldGep->getSourceElementType() == elementType) {
+			auto* first = llvm::dyn_cast<llvm::ConstantInt>(fieldGep->getOperand(1));
+			auto* index = llvm::dyn_cast<llvm::ConstantInt>(fieldGep->getOperand(2));
+			if (!first || !first->isZero() || !index) {
+				return StackAccess::NONE;
+			}
+			access = index->isZero() ? StackAccess::VALUE : StackAccess::TAG;
+			++elements;
+		}
+		bool slots = std::all_of(
+				elements, chain.end(), [&](llvm::GetElementPtrInst* gep) { return isSingleIndex(gep, elementType); });
+		return slots ? access : StackAccess::NONE;
+	}
+
+	llvm::PreservedAnalyses StackAccessTaggingPass::run(llvm::Module& module, llvm::ModuleAnalysisManager&) {
+		llvm::LLVMContext& context = module.getContext();
+		llvm::StructType* elementType = llvm::StructType::getTypeByName(context, "qd_stack_element_t");
+
+		auto tag = [&](llvm::Instruction* inst, StackAccess access) {
+			if (access != StackAccess::NONE && !inst->getMetadata(llvm::LLVMContext::MD_tbaa)) {
+				inst->setMetadata(llvm::LLVMContext::MD_tbaa, stackAccessTag(context, access));
+				return true;
+			}
+			return false;
+		};
+
+		bool changed = false;
+		for (auto& function : module) {
+			// Runtime bitcode linked for -flto has its own TBAA
+			if (function.isDeclaration() || function.hasAvailableExternallyLinkage()) {
+				continue;
+			}
+
+			for (auto& block : function) {
+				for (auto& inst : block) {
+					llvm::Value* pointer = nullptr;
+					llvm::Type* accessType = nullptr;
+					if (auto* load = llvm::dyn_cast<llvm::LoadInst>(&inst)) {
+						pointer = load->getPointerOperand();
+						accessType = load->getType();
+					} else if (auto* store = llvm::dyn_cast<llvm::StoreInst>(&inst)) {
+						pointer = store->getPointerOperand();
+						accessType = store->getValueOperand()->getType();
+					} else {
+						continue;
+					}
+
+					llvm::LoadInst* stackLoad = nullptr;
+					int field = stackField(pointer, &stackLoad);
+					if (field >= 0) {
+						changed |= tag(stackLoad, StackAccess::CONTEXT);
+						if (field == 0 && accessType->isPointerTy()) {
+							changed |= tag(&inst, StackAccess::DATA);
+						} else if (field == 2 && accessType->isIntegerTy(64)) {
+							changed |= tag(&inst, StackAccess::SIZE);
+						} else if (field == 3 && accessType->isPointerTy()) {
+							changed |= tag(&inst, StackAccess::TAGS);
+						}
+						continue;
+					}
+
+					changed |= tag(&inst, slotAccess(pointer, accessType, elementType));
+				}
+			}
+		}
+
+		return changed ? llvm::PreservedAnalyses::none() : llvm::PreservedAnalyses::all();
+	}
+
+	llvm::PreservedAnalyses KnownTypePropagationPass::run(
+			llvm::Function& function, llvm::FunctionAnalysisManager& analyses) {
+		llvm::AAResults& aliasAnalysis = analyses.getResult<llvm::AAManager>(function);
+
+		bool changed = false;
+		for (auto& block : function) {
+			// Constant type/tag stores whose value is still in memory
+			std::vector<llvm::StoreInst*> known;
+			auto forget = [&](llvm::Instruction* inst) {
+				known.erase(std::remove_if(known.begin(), known.end(),
+									[&](llvm::StoreInst* store) {
+										return llvm::isModSet(
+												aliasAnalysis.getModRefInfo(inst, llvm::MemoryLocation::get(store)));
+									}),
+						known.end());
+			};
+
+			for (auto it = block.begin(); it != block.end();) {
+				llvm::Instruction* inst = &*it++;
+
+				if (auto* load = llvm::dyn_cast<llvm::LoadInst>(inst)) {
+					if (!load->isSimple() || stackAccess(load) != StackAccess::TAG) {
+						continue;
+					}
+					for (llvm::StoreInst* store : known) {
+						if (store->getPointerOperand() == load->getPointerOperand() &&
+								store->getValueOperand()->getType() == load->getType()) {
+							load->replaceAllUsesWith(store->getValueOperand());
+							load->eraseFromParent();
+							changed = true;
+							break;
+						}
+					}
+					continue;
+				}
+
+				if (auto* store = llvm::dyn_cast<llvm::StoreInst>(inst)) {
+					forget(store);
+					if (store->isSimple() && stackAccess(store) == StackAccess::TAG &&
+							llvm::isa<llvm::Constant>(store->getValueOperand())) {
+						known.push_back(store);
+					}
+					continue;
+				}
+
+				auto* call = llvm::dyn_cast<llvm::CallBase>(inst);
+				if (call && isStackNeutral(call)) {
+					continue;
+				}
+				if (inst->mayWriteToMemory()) {
+					forget(inst);
+				}
+			}
+		}
+
+		if (!changed) {
+			return llvm::PreservedAnalyses::all();
+		}
+		llvm::PreservedAnalyses preserved;
+		preserved.preserveSet<llvm::CFGAnalyses>();
+		return preserved;
+	}
+
+	// First store of st->size after store, if nothing in between may read the slot
+	static llvm::StoreInst* followingSizeStore(
+			llvm::StoreInst* store, const llvm::Value* stack, llvm::AAResults& aliasAnalysis) {
+		llvm::MemoryLocation slot = llvm::MemoryLocation::get(store);
+		for (llvm::Instruction* next = store->getNextNode(); next; next = next->getNextNode()) {
+			auto* sizeStore = llvm::dyn_cast<llvm::StoreInst>(next);
+			if (sizeStore && sizeStore->isSimple() && stackAccess(sizeStore) == StackAccess::SIZE &&
+					llvm::getUnderlyingObject(sizeStore->getPointerOperand()) == stack) {
+				return sizeStore;
+			}
+			if (llvm::isRefSet(aliasAnalysis.getModRefInfo(next, slot))) {
+				return nullptr;
+			}
+		}
+		return nullptr;
+	}
+
+	llvm::PreservedAnalyses PushPopEliminationPass::run(
+			llvm::Function& function, llvm::FunctionAnalysisManager& analyses) {
+		// Bytes per slot in st->data
+		uint64_t slotSize = 8;
+		if (!mCompactStack) {
+			llvm::StructType* elementType = llvm::StructType::getTypeByName(function.getContext(), "qd_stack_element_t");
+			if (!elementType) {
+				return llvm::PreservedAnalyses::all();
+			}
+			slotSize = function.getParent()->getDataLayout().getTypeAllocSize(elementType);
+		}
+
+		llvm::AAResults& aliasAnalysis = analyses.getResult<llvm::AAManager>(function);
+		llvm::ScalarEvolution& scalarEvolution = analyses.getResult<llvm::ScalarEvolutionAnalysis>(function);
+
+		std::vector<llvm::StoreInst*> dead;
+		for (auto& block : function) {
+			for (auto& inst : block) {
+				auto* store = llvm::dyn_cast<llvm::StoreInst>(&inst);
+				if (!store || !store->isSimple()) {
+					continue;
+				}
+				StackAccess access = stackAccess(store);
+				if (access != StackAccess::SLOT && access != StackAccess::VALUE && access != StackAccess::TAG) {
+					continue;
+				}
+
+				// The array the slot is in: st->data, or st->tags for tag bytes of the compact layout
+				auto* array = llvm::dyn_cast<llvm::LoadInst>(llvm::getUnderlyingObject(store->getPointerOperand()));
+				if (!array) {
+					continue;
+				}
+				uint64_t stride = 0;
+				if (stackAccess(array) == StackAccess::DATA) {
+					stride = slotSize;
+				} else if (stackAccess(array) == StackAccess::TAGS && mCompactStack) {
+					stride = 1;
+				} else {
+					continue;
+				}
+
+				const llvm::Value* stack = llvm::getUnderlyingObject(array->getPointerOperand());
+				llvm::StoreInst* sizeStore = followingSizeStore(store, stack, aliasAnalysis);
+				if (!sizeStore) {
+					continue;
+				}
+
+				// Elements at or above the new size are dead: the slot is if its offset >= newSize * stride
+				const llvm::SCEV* offset = scalarEvolution.getMinusSCEV(
+						scalarEvolution.getSCEV(store->getPointerOperand()), scalarEvolution.getSCEV(array));
+				if (llvm::isa<llvm::SCEVCouldNotCompute>(offset) ||
+						offset->getType() != sizeStore->getValueOperand()->getType()) {
+					continue;
+				}
+				const llvm::SCEV* top = scalarEvolution.getMulExpr(scalarEvolution.getSCEV(sizeStore->getValueOperand()),
+						scalarEvolution.getConstant(offset->getType(), stride));
+				if (scalarEvolution.isKnownNonNegative(scalarEvolution.getMinusSCEV(offset, top))) {
+					dead.push_back(store);
+				}
+			}
+		}
+
+		if (dead.empty()) {
+			return llvm::PreservedAnalyses::all();
+		}
+		for (llvm::StoreInst* store : dead) {
+			store->eraseFromParent();
+		}
+		llvm::PreservedAnalyses preserved;
+		preserved.preserveSet<llvm::CFGAnalyses>();
+		return preserved;
+	}
+
+	static bool isStackCheck(const llvm::Instruction* inst) {
+		auto* call = llvm::dyn_cast<llvm::CallBase>(inst);
+		return call && call->getCalledFunction() && call->getCalledFunction()->getName() == "qd_check_stack" &&
+			   call->arg_size() == 4;
+	}
+
+	// Types a qd_check_stack call checks, bottom to top; false if they aren't constant
+	static bool checkedTypes(const llvm::CallBase* check, std::vector<uint64_t>& types) {
+		auto* count = llvm::dyn_cast<llvm::ConstantInt>(check->getArgOperand(1));
+		auto* array = llvm::dyn_cast<llvm::GlobalVariable>(check->getArgOperand(2)->stripPointerCasts());
+		if (!count || !array || !array->isConstant() || !array->hasDefinitiveInitializer()) {
+			return false;
+		}
+
+		types.clear();
+		for (uint64_t i = 0; i < count->getZExtValue(); i++) {
+			llvm::Constant* element = array->getInitializer()->getAggregateElement(static_cast<unsigned>(i));
+			auto* type = llvm::dyn_cast_or_null<llvm::ConstantInt>(element);
+			if (!type) {
+				return false;
+			}
+			types.push_back(type->getZExtValue());
+		}
+		return true;
+	}
+
+	// True if a successful check of earlier implies that later succeeds on the same stack
+	static bool coversCheck(const std::vector<uint64_t>& earlier, const std::vector<uint64_t>& later) {
+		if (earlier.size() < later.size()) {
+			return false;
+		}
+		size_t offset = earlier.size() - later.size();
+		for (size_t i = 0; i < later.size(); i++) {
+			if (later[i] != QD_TYPE_PTR && earlier[offset + i] != later[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Look for an earlier check of the same context covering check, with no stack writes in between
+	static bool hasCoveringCheck(llvm::CallBase* check, const std::vector<uint64_t>& types) {
+		std::vector<uint64_t> earlierTypes;
+		llvm::BasicBlock* block = check->getParent();
+		unsigned blocks = 0;
+		for (llvm::Instruction* inst = check->getPrevNode();; inst = inst->getPrevNode()) {
+			if (!inst) {
+				block = block->getSinglePredecessor();
+				if (!block || ++blocks > CHECK_SEARCH_BLOCKS) {
+					return false;
+				}
+				inst = block->getTerminator();
+			}
+
+			if (isStackCheck(inst)) {
+				auto* earlier = llvm::cast<llvm::CallBase>(inst);
+				if (earlier->getArgOperand(0) == check->getArgOperand(0) && checkedTypes(earlier, earlierTypes) &&
+						coversCheck(earlierTypes, types)) {
+					return true;
+				}
+				continue;
+			}
+
+			auto* call = llvm::dyn_cast<llvm::CallBase>(inst);
+			if (call && isStackNeutral(call)) {
+				continue;
+			}
+			// Values don't matter to the check, only the size and types
+			auto* store = llvm::dyn_cast<llvm::StoreInst>(inst);
+			if (store && stackAccess(store) == StackAccess::VALUE) {
+				continue;
+			}
+			if (inst->mayWriteToMemory()) {
+				return false;
+			}
+		}
+	}
+
+	llvm::PreservedAnalyses StackCheckEliminationPass::run(llvm::Function& function, llvm::FunctionAnalysisManager&) {
+		std::vector<llvm::Instruction*> dead;
+		std::vector<uint64_t> types;
+		for (auto& block : function) {
+			for (auto& inst : block) {
+				if (!isStackCheck(&inst)) {
+					continue;
+				}
+				auto* check = llvm::cast<llvm::CallBase>(&inst);
+				if (checkedTypes(check, types) && (types.empty() || hasCoveringCheck(check, types))) {
+					dead.push_back(check);
+				}
+			}
+		}
+
+		if (dead.empty()) {
+			return llvm::PreservedAnalyses::all();
+		}
+		for (llvm::Instruction* check : dead) {
+			check->eraseFromParent();
+		}
+		llvm::PreservedAnalyses preserved;
+		preserved.preserveSet<llvm::CFGAnalyses>();
+		return preserved;
+	}
+
+	void registerQuadratePasses(llvm::PassBuilder& passBuilder, bool compactStack) {
+		// Tag accesses while the generated GEPs are still intact
+		passBuilder.registerPipelineStartEPCallback([](llvm::ModulePassManager& passes, llvm::OptimizationLevel) {
+			passes.addPass(StackAccessTaggingPass());
+		});
+
+		// After each instcombine, so forwarded tags fold into the type checks that read them
+		passBuilder.registerPeepholeEPCallback([](llvm::FunctionPassManager& passes, llvm::OptimizationLevel) {
+			passes.addPass(KnownTypePropagationPass());
+			passes.addPass(StackCheckEliminationPass());
+		});
+
+		// After GVN has forwarded pushed values to their pops and DSE has merged the size updates
+		passBuilder.registerScalarOptimizerLateEPCallback(
+				[compactStack](llvm::FunctionPassManager& passes, llvm::OptimizationLevel) {
+					passes.addPass(PushPopEliminationPass(compactStack));
+				});
+	}
+
+} // namespace Qd
@@ -0,0 +1,101 @@
+/**
+ * @file passes.h
+ * @brief Quadrate-specific optimization passes
+ *
+ * Generated code keeps its operand stack in qd_stack memory, which LLVM
+ * can't reason about on its own: every push and pop is a load of ctx->st,
+ * loads and stores of st->size and st->data, and stores into the slot.
+ * These passes describe that memory to the standard pipeline and remove
+ * what it still can't prove redundant.
+ */
+
+#ifndef QD_LLVMGEN_PASSES_H
+#define QD_LLVMGEN_PASSES_H
+
+#include <llvm/IR/PassManager.h>
+
+namespace llvm {
+	class PassBuilder;
+} // namespace llvm
+
+namespace Qd {
+
+	/**
+	 * @brief Attach TBAA metadata to generated qd_stack accesses
+	 *
+	 * Recognizes the access shapes the generator emits (ctx->st, st->size,
+	 * st->data, st->tags and the slot fields) and tags them, so that a store
+	 * to a slot no longer clobbers the stack size or data pointer. This is
+	 * what lets GVN, DSE and LICM work across pushes and pops.
+	 *
+	 * Must run before anything rewrites the GEPs; accesses that aren't
+	 * recognized stay untagged and alias everything.
+	 */
+	class StackAccessTaggingPass : public llvm::PassInfoMixin<StackAccessTaggingPass> {
+	public:
+		llvm::PreservedAnalyses run(llvm::Module& module, llvm::ModuleAnalysisManager& analyses);
+	};
+
+	/**
+	 * @brief Forward constant slot types and flags to later loads
+	 *
+	 * A push stores a constant type (and is_error_tainted/is_borrowed flags,
+	 * or a tag byte) that is often read back by the next instruction's type
+	 * check. GVN already does this within straight-line code, but not across
+	 * runtime calls; this pass knows which runtime functions leave the stack
+	 * untouched (qd_check_stack, qd_push_call, qd_pop_call, qd_stack_size).
+	 */
+	class KnownTypePropagationPass : public llvm::PassInfoMixin<KnownTypePropagationPass> {
+	public:
+		llvm::PreservedAnalyses run(llvm::Function& function, llvm::FunctionAnalysisManager& analyses);
+	};
+
+	/**
+	 * @brief Remove slot stores that are popped before they are read
+	 *
+	 * After GVN forwards a pushed value to the pop that consumes it, the store
+	 * into the slot is still there: the slot is above the new stack size, but
+	 * nothing in LLVM knows that memory above st->size is dead. This pass
+	 * deletes slot stores that are followed in the same block by a size store
+	 * leaving the slot above the top of the stack.
+	 */
+	class PushPopEliminationPass : public llvm::PassInfoMixin<PushPopEliminationPass> {
+	public:
+		/**
+		 * @param compactStack Runtime is built with QD_COMPACT_STACK
+		 */
+		explicit PushPopEliminationPass(bool compactStack) : mCompactStack(compactStack) {
+		}
+
+		llvm::PreservedAnalyses run(llvm::Function& function, llvm::FunctionAnalysisManager& analyses);
+
+	private:
+		bool mCompactStack;
+	};
+
+	/**
+	 * @brief Remove qd_check_stack calls that can't fail
+	 *
+	 * A check of zero elements is dropped, as is a check that an earlier check
+	 * of the same context already covers (at least as many elements, same
+	 * types) with no stack writes in between. The latter is common once a
+	 * function is inlined: its entry check repeats the check at the call site.
+	 */
+	class StackCheckEliminationPass : public llvm::PassInfoMixin<StackCheckEliminationPass> {
+	public:
+		llvm::PreservedAnalyses run(llvm::Function& function, llvm::FunctionAnalysisManager& analyses);
+	};
+
+	/**
+	 * @brief Register the Quadrate passes with a pass builder
+	 *
+	 * Call before building a default pipeline. The passes only run at -O1 and up.
+	 *
+	 * @param passBuilder Pass builder to extend
+	 * @param compactStack Runtime is built with QD_COMPACT_STACK
+	 */
+	void registerQuadratePasses(llvm::PassBuilder& passBuilder, bool compactStack);
+
+} // namespace Qd
+
+#endif // QD_LLVMGEN_PASSES_H
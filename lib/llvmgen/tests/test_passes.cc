@@ -0,0 +1,295 @@
+#include "passes.h"
+
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <unit-check/uc.h>
+
+// Types and declarations shared by the IR below, in the shapes the generator emits
+static const std::string PRELUDE = R"(
+%qd_stack_element_t = type { i64, i32, i8, i8 }
+
+declare void @qd_push_call(ptr, ptr)
+declare void @qd_check_stack(ptr, i64, ptr, ptr)
+declare void @unknown(ptr)
+)";
+
+// Loads ctx->st, st->data and st->size, and points %value and %type at data[size]
+static const std::string TOP_SLOT = R"(
+	%st = load ptr, ptr %ctx
+	%dataPtr = getelementptr { ptr, i64, i64 }, ptr %st, i32 0, i32 0
+	%data = load ptr, ptr %dataPtr
+	%sizePtr = getelementptr { ptr, i64, i64 }, ptr %st, i32 0, i32 2
+	%size = load i64, ptr %sizePtr
+	%slot = getelementptr %qd_stack_element_t, ptr %data, i64 %size
+	%value = getelementptr %qd_stack_element_t, ptr %slot, i32 0, i32 0
+	%type = getelementptr %qd_stack_element_t, ptr %slot, i32 0, i32 1
+)";
+
+struct TestModule {
+	llvm::LLVMContext context;
+	std::unique_ptr<llvm::Module> module;
+};
+
+// The IR is part of the test, so a parse error is a broken test rather than a failure
+static void parse(TestModule& test, const std::string& body) {
+	llvm::SMDiagnostic error;
+	test.module = llvm::parseAssemblyString(PRELUDE + body, error, test.context);
+	if (!test.module) {
+		error.print("test_passes", llvm::errs());
+		std::exit(1);
+	}
+}
+
+// Runs the tagging pass, then pass on every function, with the default alias analysis pipeline
+template <typename Pass> static void run(TestModule& test, Pass pass) {
+	llvm::LoopAnalysisManager loopAnalyses;
+	llvm::FunctionAnalysisManager functionAnalyses;
+	llvm::CGSCCAnalysisManager cgsccAnalyses;
+	llvm::ModuleAnalysisManager moduleAnalyses;
+
+	llvm::PassBuilder passBuilder;
+	functionAnalyses.registerPass([&] { return passBuilder.buildDefaultAAPipeline(); });
+	passBuilder.registerModuleAnalyses(moduleAnalyses);
+	passBuilder.registerCGSCCAnalyses(cgsccAnalyses);
+	passBuilder.registerFunctionAnalyses(functionAnalyses);
+	passBuilder.registerLoopAnalyses(loopAnalyses);
+	passBuilder.crossRegisterProxies(loopAnalyses, functionAnalyses, cgsccAnalyses, moduleAnalyses);
+
+	llvm::ModulePassManager passes;
+	passes.addPass(Qd::StackAccessTaggingPass());
+	llvm::FunctionPassManager functionPasses;
+	functionPasses.addPass(std::move(pass));
+	passes.addPass(llvm::createModuleToFunctionPassAdaptor(std::move(functionPasses)));
+	passes.run(*test.module, moduleAnalyses);
+}
+
+static llvm::Instruction* find(TestModule& test, const char* name) {
+	for (auto& inst : llvm::instructions(*test.module->getFunction("test"))) {
+		if (inst.getName() == name) {
+			return &inst;
+		}
+	}
+	return nullptr;
+}
+
+static size_t countInstructions(TestModule& test, unsigned opcode) {
+	size_t result = 0;
+	for (auto& inst : llvm::instructions(*test.module->getFunction("test"))) {
+		if (inst.getOpcode() == opcode) {
+			result++;
+		}
+	}
+	return result;
+}
+
+static size_t countCalls(TestModule& test, const char* callee) {
+	size_t result = 0;
+	for (auto& inst : llvm::instructions(*test.module->getFunction("test"))) {
+		auto* call = llvm::dyn_cast<llvm::CallBase>(&inst);
+		if (call && call->getCalledFunction() && call->getCalledFunction()->getName() == callee) {
+			result++;
+		}
+	}
+	return result;
+}
+
+// Name of the TBAA type an access is tagged with, empty if untagged
+static std::string tbaaType(const llvm::Instruction* inst) {
+	llvm::MDNode* tag = inst ? inst->getMetadata(llvm::LLVMContext::MD_tbaa) : nullptr;
+	if (!tag) {
+		return "";
+	}
+	auto* type = llvm::cast<llvm::MDNode>(tag->getOperand(1));
+	return llvm::cast<llvm::MDString>(type->getOperand(0))->getString().str();
+}
+
+// The store to the pointer named pointer, or nullptr if there is none
+static llvm::StoreInst* storeTo(TestModule& test, const char* pointer) {
+	for (auto& inst : llvm::instructions(*test.module->getFunction("test"))) {
+		auto* store = llvm::dyn_cast<llvm::StoreInst>(&inst);
+		if (store && store->getPointerOperand()->getName() == pointer) {
+			return store;
+		}
+	}
+	return nullptr;
+}
+
+// A push: every generated access is tagged with its kind of stack memory
+TEST(TaggingRecognizesStackAccesses) {
+	TestModule test;
+	parse(test, "define void @test(ptr %ctx) {" + TOP_SLOT + R"(
+	store i64 42, ptr %value
+	store i32 1, ptr %type
+	%grown = add i64 %size, 1
+	store i64 %grown, ptr %sizePtr
+	%whole = load %qd_stack_element_t, ptr %slot
+	ret void
+})");
+	run(test, llvm::FunctionPassManager());
+
+	ASSERT_EQ(tbaaType(find(test, "st")), std::string("qd.context"), "ctx->st should be tagged");
+	ASSERT_EQ(tbaaType(find(test, "data")), std::string("qd.data"), "st->data should be tagged");
+	ASSERT_EQ(tbaaType(find(test, "size")), std::string("qd.size"), "st->size load should be tagged");
+	ASSERT_EQ(tbaaType(storeTo(test, "sizePtr")), std::string("qd.size"), "st->size store should be tagged");
+	ASSERT_EQ(tbaaType(storeTo(test, "value")), std::string("qd.value"), "slot value should be tagged");
+	ASSERT_EQ(tbaaType(storeTo(test, "type")), std::string("qd.tag"), "slot type should be tagged");
+	ASSERT_EQ(tbaaType(find(test, "whole")), std::string("qd.slot"), "whole slot should be tagged");
+}
+
+// Memory that isn't reached through ctx->st may alias anything and stays untagged
+TEST(TaggingIgnoresOtherMemory) {
+	TestModule test;
+	parse(test, R"(
+define void @test(ptr %ctx) {
+	%notSt = getelementptr ptr, ptr %ctx, i64 1
+	%st = load ptr, ptr %notSt
+	%sizePtr = getelementptr { ptr, i64, i64 }, ptr %st, i32 0, i32 2
+	%size = load i64, ptr %sizePtr
+	%pair = load ptr, ptr %ctx
+	%secondPtr = getelementptr { ptr, i64 }, ptr %pair, i32 0, i32 1
+	%second = load i64, ptr %secondPtr
+	ret void
+})");
+	run(test, llvm::FunctionPassManager());
+
+	ASSERT_EQ(tbaaType(find(test, "st")), std::string(""), "load at an offset from ctx should be untagged");
+	ASSERT_EQ(tbaaType(find(test, "size")), std::string(""), "field of a non-stack pointer should be untagged");
+	ASSERT_EQ(tbaaType(find(test, "pair")), std::string(""), "load of a non-stack struct should be untagged");
+	ASSERT_EQ(tbaaType(find(test, "second")), std::string(""), "field of a non-stack struct should be untagged");
+}
+
+// The type stored by a push is read back after a runtime call that leaves the stack alone
+TEST(KnownTypeForwardedAcrossNeutralCall) {
+	TestModule test;
+	parse(test, "define i32 @test(ptr %ctx) {" + TOP_SLOT + R"(
+	store i32 1, ptr %type
+	call void @qd_push_call(ptr %ctx, ptr null)
+	%reread = load i32, ptr %type
+	ret i32 %reread
+})");
+	run(test, Qd::KnownTypePropagationPass());
+
+	ASSERT(find(test, "reread") == nullptr, "type load should be removed");
+	auto* ret = llvm::cast<llvm::ReturnInst>(test.module->getFunction("test")->back().getTerminator());
+	auto* type = llvm::dyn_cast<llvm::ConstantInt>(ret->getReturnValue());
+	ASSERT(type != nullptr && type->getZExtValue() == 1, "stored type should be forwarded");
+}
+
+// An unknown call may change the type, so it has to be loaded again
+TEST(KnownTypeKeptAcrossUnknownCall) {
+	TestModule test;
+	parse(test, "define i32 @test(ptr %ctx) {" + TOP_SLOT + R"(
+	store i32 1, ptr %type
+	call void @unknown(ptr %ctx)
+	%reread = load i32, ptr %type
+	ret i32 %reread
+})");
+	run(test, Qd::KnownTypePropagationPass());
+
+	ASSERT(find(test, "reread") != nullptr, "type load should be kept");
+}
+
+// A push popped right away: the size store leaves the slot above the top, so its stores are dead
+TEST(PushPopRemovesPoppedSlot) {
+	TestModule test;
+	parse(test, "define void @test(ptr %ctx) {" + TOP_SLOT + R"(
+	store i64 42, ptr %value
+	store i32 1, ptr %type
+	store i64 %size, ptr %sizePtr
+	ret void
+})");
+	run(test, Qd::PushPopEliminationPass(false));
+
+	ASSERT(storeTo(test, "value") == nullptr, "value store should be removed");
+	ASSERT(storeTo(test, "type") == nullptr, "type store should be removed");
+	ASSERT(storeTo(test, "sizePtr") != nullptr, "size store should be kept");
+}
+
+// A call between push and pop may read the slot while it is still on the stack
+TEST(PushPopKeptAcrossCall) {
+	TestModule test;
+	parse(test, "define void @test(ptr %ctx) {" + TOP_SLOT + R"(
+	store i64 42, ptr %value
+	store i32 1, ptr %type
+	call void @unknown(ptr %ctx)
+	store i64 %size, ptr %sizePtr
+	ret void
+})");
+	run(test, Qd::PushPopEliminationPass(false));
+
+	ASSERT_EQ(countInstructions(test, llvm::Instruction::Store), static_cast<size_t>(3), "all stores should be kept");
+}
+
+// A store below the new top stays, since the slot is still on the stack
+TEST(PushPopKeptBelowTop) {
+	TestModule test;
+	parse(test, "define void @test(ptr %ctx) {" + TOP_SLOT + R"(
+	store i64 42, ptr %value
+	store i32 1, ptr %type
+	%grown = add i64 %size, 1
+	store i64 %grown, ptr %sizePtr
+	ret void
+})");
+	run(test, Qd::PushPopEliminationPass(false));
+
+	ASSERT_EQ(countInstructions(test, llvm::Instruction::Store), static_cast<size_t>(3), "all stores should be kept");
+}
+
+static const std::string CHECK_TYPES = R"(
+@intInt = private constant [2 x i32] [i32 0, i32 0]
+@int = private constant [1 x i32] [i32 0]
+@float = private constant [1 x i32] [i32 1]
+@any = private constant [1 x i32] [i32 2]
+@none = private constant [0 x i32] zeroinitializer
+@name = private constant [5 x i8] c"test\00"
+)";
+
+// Checks of nothing, and checks an earlier check already covers, can't fail
+TEST(StackCheckRemovesCoveredChecks) {
+	TestModule test;
+	parse(test, CHECK_TYPES + R"(
+define void @test(ptr %ctx) {
+	call void @qd_check_stack(ptr %ctx, i64 2, ptr @intInt, ptr @name)
+	call void @qd_push_call(ptr %ctx, ptr @name)
+	br label %next
+next:
+	call void @qd_check_stack(ptr %ctx, i64 1, ptr @int, ptr @name)
+	call void @qd_check_stack(ptr %ctx, i64 1, ptr @any, ptr @name)
+	call void @qd_check_stack(ptr %ctx, i64 0, ptr @none, ptr @name)
+	ret void
+})");
+	run(test, Qd::StackCheckEliminationPass());
+
+	ASSERT_EQ(countCalls(test, "qd_check_stack"), static_cast<size_t>(1), "only the first check should be kept");
+}
+
+// A different type, or a call that may change the stack, needs its own check
+TEST(StackCheckKeptAfterWriteOrMismatch) {
+	TestModule test;
+	parse(test, CHECK_TYPES + R"(
+define void @test(ptr %ctx) {
+	call void @qd_check_stack(ptr %ctx, i64 1, ptr @int, ptr @name)
+	call void @qd_check_stack(ptr %ctx, i64 1, ptr @float, ptr @name)
+	call void @unknown(ptr %ctx)
+	call void @qd_check_stack(ptr %ctx, i64 1, ptr @float, ptr @name)
+	ret void
+})");
+	run(test, Qd::StackCheckEliminationPass());
+
+	ASSERT_EQ(countCalls(test, "qd_check_stack"), static_cast<size_t>(3), "all checks should be kept");
+}
+
+int main() {
+	return UC_PrintResults();
+}
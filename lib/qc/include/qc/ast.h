@@ -8,6 +8,7 @@
 #ifndef QD_QC_AST_H
 #define QD_QC_AST_H
 
+#include "ast_arena.h"
 #include "error_reporter.h"
 #include <u8t/scanner.h>
 #include <vector>
@@ -94,6 +95,7 @@ namespace Qd {
 		}
 
 	private:
+		AstArena mArena;				///< Owns all nodes and identifiers
 		IAstNode* mRoot = nullptr;		///< Root node of the AST
 		size_t mErrorCount = 0;			///< Number of errors encountered
 		std::vector<ErrorInfo> mErrors; ///< Detailed error information
@@ -0,0 +1,97 @@
+/**
+ * @file ast_arena.h
+ * @brief Arena allocation for AST nodes
+ */
+
+#ifndef QD_QC_AST_ARENA_H
+#define QD_QC_AST_ARENA_H
+
+#include "ast_node.h"
+#include "symbol.h"
+#include <memory>
+#include <new>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Qd {
+
+	/**
+	 * @brief Bump allocator owning all nodes of an AST
+	 *
+	 * Nodes are placed back to back in large blocks in the order they are
+	 * created, so a traversal in source order touches memory sequentially.
+	 * Nodes don't own their children; everything is released together when
+	 * the arena is reset or destroyed.
+	 *
+	 * The arena also interns identifier strings, so each distinct name is
+	 * stored once per AST.
+	 *
+	 * @par Usage:
+	 * @code
+	 * Qd::AstArena arena;
+	 * auto* ident = arena.create<Qd::AstNodeIdentifier>(arena.intern("print"));
+	 * @endcode
+	 */
+	class AstArena {
+	public:
+		AstArena() = default;
+		~AstArena();
+
+		AstArena(const AstArena&) = delete;
+		AstArena& operator=(const AstArena&) = delete;
+
+		/**
+		 * @brief Construct a node in the arena
+		 *
+		 * @return Node owned by the arena (must not be deleted)
+		 */
+		template <typename T, typename... Args>
+		T* create(Args&&... args) {
+			void* memory = allocate(sizeof(T), alignof(T));
+			T* node = new (memory) T(std::forward<Args>(args)...);
+			mNodes.push_back(node);
+			return node;
+		}
+
+		/**
+		 * @brief Intern a string
+		 *
+		 * @param string String to intern
+		 * @return Symbol valid until the arena is reset or destroyed
+		 */
+		Symbol intern(const std::string& string);
+
+		/**
+		 * @brief Destroy all nodes and symbols
+		 *
+		 * Keeps the first block for reuse.
+		 */
+		void reset();
+
+		/**
+		 * @brief Get the number of nodes created since the last reset
+		 */
+		size_t nodeCount() const {
+			return mNodes.size();
+		}
+
+	private:
+		struct Block {
+			std::unique_ptr<char[]> data;
+			size_t size;
+		};
+
+		void* allocate(size_t size, size_t alignment);
+		void destroyNodes();
+
+		std::vector<Block> mBlocks;
+		size_t mUsed = 0;				  ///< Bytes used in the last block
+		std::vector<IAstNode*> mNodes;	  ///< Nodes to destroy, in creation order
+		std::unordered_set<std::string> mSymbols;
+	};
+
+} // namespace Qd
+
+#endif // QD_QC_AST_ARENA_H
@@ -2,12 +2,13 @@
 #define QD_QC_AST_NODE_CONSTANT_H
 
 #include "ast_node.h"
+#include "symbol.h"
 #include <string>
 
 namespace Qd {
 	class AstNodeConstant : public IAstNode {
 	public:
-		AstNodeConstant(const std::string& name, const char* value, bool isPublic = false)
+		AstNodeConstant(Symbol name, const char* value, bool isPublic = false)
 			: mName(name), mValue(value), mIsPublic(isPublic), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
@@ -57,7 +58,7 @@ namespace Qd {
 		}
 
 	private:
-		std::string mName;
+		Symbol mName;
 		std::string mValue;
 		bool mIsPublic;
 		IAstNode* mParent;
@@ -20,12 +20,6 @@ namespace Qd {
 		AstNodeCtx() : mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
-		~AstNodeCtx() override {
-			for (auto* child : mChildren) {
-				delete child;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::CTX_STATEMENT;
 		}
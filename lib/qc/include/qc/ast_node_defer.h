@@ -10,12 +10,6 @@ namespace Qd {
 		AstNodeDefer() : mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
-		~AstNodeDefer() override {
-			for (auto* child : mChildren) {
-				delete child;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::DEFER_STATEMENT;
 		}
@@ -10,12 +10,6 @@ namespace Qd {
 		AstNodeForStatement() : mParent(nullptr), mBody(nullptr), mLine(0), mColumn(0) {
 		}
 
-		~AstNodeForStatement() {
-			if (mBody) {
-				delete mBody;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::FOR_STATEMENT;
 		}
@@ -2,29 +2,18 @@
 #define QD_QC_AST_NODE_FUNCTION_H
 
 #include "ast_node.h"
+#include "symbol.h"
 #include <string>
 #include <vector>
 
 namespace Qd {
 	class AstNodeFunctionDeclaration : public IAstNode {
 	public:
-		AstNodeFunctionDeclaration(const std::string& name, bool isPublic = false)
+		AstNodeFunctionDeclaration(Symbol name, bool isPublic = false)
 			: mName(name), mParent(nullptr), mBody(nullptr), mThrows(false), mIsPublic(isPublic), mLine(0),
 			  mColumn(0) {
 		}
 
-		~AstNodeFunctionDeclaration() {
-			if (mBody) {
-				delete mBody;
-			}
-			for (auto* param : mInputParameters) {
-				delete param;
-			}
-			for (auto* param : mOutputParameters) {
-				delete param;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::FUNCTION_DECLARATION;
 		}
@@ -123,7 +112,7 @@ namespace Qd {
 		}
 
 	private:
-		std::string mName;
+		Symbol mName;
 		IAstNode* mParent;
 		IAstNode* mBody;
 		std::vector<IAstNode*> mInputParameters;
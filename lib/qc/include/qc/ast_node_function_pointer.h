@@ -2,12 +2,13 @@
 #define QD_QC_AST_NODE_FUNCTION_POINTER_H
 
 #include "ast_node.h"
+#include "symbol.h"
 #include <string>
 
 namespace Qd {
 	class AstNodeFunctionPointerReference : public IAstNode {
 	public:
-		AstNodeFunctionPointerReference(const std::string& functionName)
+		AstNodeFunctionPointerReference(Symbol functionName)
 			: mFunctionName(functionName), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
@@ -49,7 +50,7 @@ namespace Qd {
 		}
 
 	private:
-		std::string mFunctionName;
+		Symbol mFunctionName;
 		IAstNode* mParent;
 		size_t mLine;
 		size_t mColumn;
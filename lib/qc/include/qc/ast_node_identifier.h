@@ -2,6 +2,7 @@
 #define QD_QC_AST_NODE_IDENTIFIER_H
 
 #include "ast_node.h"
+#include "symbol.h"
 #include <string>
 #include <vector>
 
@@ -15,8 +16,9 @@ namespace Qd {
 
 	class AstNodeIdentifier : public IAstNode {
 	public:
-		AstNodeIdentifier(const std::string& name)
-			: mName(name), mParent(nullptr), mAbortOnError(false), mCheckError(false), mLine(0), mColumn(0) {
+		AstNodeIdentifier(Symbol name)
+			: mName(name), mParent(nullptr), mAbortOnError(false), mCheckError(false), mLine(0), mColumn(0),
+			  mTypesProven(false) {
 		}
 
 		IAstNode::Type type() const override {
@@ -81,14 +83,24 @@ namespace Qd {
 			return mParameterCasts;
 		}
 
+		// Set when the validator proved stack depth and parameter types at this call site
+		void setTypesProven(bool proven) {
+			mTypesProven = proven;
+		}
+
+		bool typesProven() const {
+			return mTypesProven;
+		}
+
 	private:
-		std::string mName;
+		Symbol mName;
 		IAstNode* mParent;
 		bool mAbortOnError;
 		bool mCheckError;
 		size_t mLine;
 		size_t mColumn;
 		std::vector<CastDirection> mParameterCasts; // Which parameters need casts (indexed from bottom of stack)
+		bool mTypesProven;
 	};
 }
 
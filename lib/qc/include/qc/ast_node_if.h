@@ -10,15 +10,6 @@ namespace Qd {
 		AstNodeIfStatement() : mParent(nullptr), mThenBody(nullptr), mElseBody(nullptr), mLine(0), mColumn(0) {
 		}
 
-		~AstNodeIfStatement() {
-			if (mThenBody) {
-				delete mThenBody;
-			}
-			if (mElseBody) {
-				delete mElseBody;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::IF_STATEMENT;
 		}
@@ -15,15 +15,6 @@ namespace Qd {
 		bool throws = false;							 // Whether the function can throw errors (marked with '!')
 		size_t line;
 		size_t column;
-
-		~ImportedFunction() {
-			for (auto* param : inputParameters) {
-				delete param;
-			}
-			for (auto* param : outputParameters) {
-				delete param;
-			}
-		}
 	};
 
 	class AstNodeImport : public IAstNode {
@@ -2,16 +2,24 @@
 #define QD_QC_AST_NODE_INSTRUCTION_H
 
 #include "ast_node.h"
+#include "instructions.h"
+#include "symbol.h"
 #include <string>
 
 namespace Qd {
 	/**
 	 * Represents a built-in instruction (print, sq, div, dup, rot, etc.)
 	 * These are distinguished from user-defined identifiers to allow proper code generation.
+	 * The opcode is resolved once by the parser, so later passes can switch on it
+	 * instead of comparing names.
 	 */
 	class AstNodeInstruction : public IAstNode {
 	public:
-		AstNodeInstruction(const std::string& name) : mName(name), mParent(nullptr), mLine(0), mColumn(0) {
+		AstNodeInstruction(Symbol name) : AstNodeInstruction(name, lookupInstruction(name.str())) {
+		}
+
+		AstNodeInstruction(Symbol name, Opcode opcode)
+			: mName(name), mOpcode(opcode), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
 		IAstNode::Type type() const override {
@@ -51,8 +59,16 @@ namespace Qd {
 			return mName;
 		}
 
+		/**
+		 * @brief Get the opcode (Opcode::NONE for aliases such as '!')
+		 */
+		Opcode opcode() const {
+			return mOpcode;
+		}
+
 	private:
-		std::string mName;
+		Symbol mName;
+		Opcode mOpcode;
 		IAstNode* mParent;
 		size_t mLine;
 		size_t mColumn;
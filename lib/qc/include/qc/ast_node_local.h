@@ -2,6 +2,7 @@
 #define QC_AST_NODE_LOCAL_H
 
 #include <qc/ast_node.h>
+#include <qc/symbol.h>
 #include <string>
 
 namespace Qd {
@@ -16,7 +17,7 @@ namespace Qd {
 	 */
 	class AstNodeLocal : public IAstNode {
 	public:
-		explicit AstNodeLocal(const std::string& name) : mName(name), mParent(nullptr), mLine(0), mColumn(0) {
+		explicit AstNodeLocal(Symbol name) : mName(name), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
 		~AstNodeLocal() override = default;
@@ -59,7 +60,7 @@ namespace Qd {
 		}
 
 	private:
-		std::string mName;
+		Symbol mName;
 		IAstNode* mParent;
 		size_t mLine;
 		size_t mColumn;
@@ -9,12 +9,6 @@ namespace Qd {
 		AstNodeLoopStatement() : mParent(nullptr), mBody(nullptr), mLine(0), mColumn(0) {
 		}
 
-		~AstNodeLoopStatement() {
-			if (mBody) {
-				delete mBody;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::LOOP_STATEMENT;
 		}
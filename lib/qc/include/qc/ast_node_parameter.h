@@ -2,12 +2,13 @@
 #define QD_QC_AST_NODE_PARAMETER_H
 
 #include "ast_node.h"
+#include "symbol.h"
 #include <string>
 
 namespace Qd {
 	class AstNodeParameter : public IAstNode {
 	public:
-		AstNodeParameter(const std::string& name, const std::string& type, bool isOutput)
+		AstNodeParameter(Symbol name, Symbol type, bool isOutput)
 			: mName(name), mType(type), mIsOutput(isOutput), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
@@ -57,8 +58,8 @@ namespace Qd {
 		}
 
 	private:
-		std::string mName;
-		std::string mType;
+		Symbol mName;
+		Symbol mType;
 		bool mIsOutput;
 		IAstNode* mParent;
 		size_t mLine;
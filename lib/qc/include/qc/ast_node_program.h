@@ -7,12 +7,6 @@
 namespace Qd {
 	class AstProgram : public IAstNode {
 	public:
-		~AstProgram() {
-			for (auto* child : mChildren) {
-				delete child;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::PROGRAM;
 		}
@@ -2,6 +2,7 @@
 #define QD_QC_AST_NODE_SCOPED_H
 
 #include "ast_node.h"
+#include "symbol.h"
 #include "ast_node_identifier.h" // For CastDirection enum
 #include <string>
 #include <vector>
@@ -9,9 +10,9 @@
 namespace Qd {
 	class AstNodeScopedIdentifier : public IAstNode {
 	public:
-		AstNodeScopedIdentifier(const std::string& scope, const std::string& name)
+		AstNodeScopedIdentifier(Symbol scope, Symbol name)
 			: mScope(scope), mName(name), mParent(nullptr), mAbortOnError(false), mCheckError(false), mLine(0),
-			  mColumn(0) {
+			  mColumn(0), mTypesProven(false) {
 		}
 
 		IAstNode::Type type() const override {
@@ -80,15 +81,25 @@ namespace Qd {
 			return mParameterCasts;
 		}
 
+		// Set when the validator proved stack depth and parameter types at this call site
+		void setTypesProven(bool proven) {
+			mTypesProven = proven;
+		}
+
+		bool typesProven() const {
+			return mTypesProven;
+		}
+
 	private:
-		std::string mScope;
-		std::string mName;
+		Symbol mScope;
+		Symbol mName;
 		IAstNode* mParent;
 		bool mAbortOnError;
 		bool mCheckError;
 		size_t mLine;
 		size_t mColumn;
 		std::vector<CastDirection> mParameterCasts; // Which parameters need casts (indexed from bottom of stack)
+		bool mTypesProven;
 	};
 }
 
@@ -2,6 +2,7 @@
 #define QD_QC_AST_NODE_STRUCT_H
 
 #include "ast_node.h"
+#include "symbol.h"
 #include <string>
 #include <vector>
 
@@ -11,7 +12,7 @@ namespace Qd {
 	 */
 	class AstNodeStructField : public IAstNode {
 	public:
-		AstNodeStructField(const std::string& name, const std::string& typeName)
+		AstNodeStructField(Symbol name, Symbol typeName)
 			: mName(name), mTypeName(typeName), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
@@ -57,8 +58,8 @@ namespace Qd {
 		}
 
 	private:
-		std::string mName;
-		std::string mTypeName;
+		Symbol mName;
+		Symbol mTypeName;
 		IAstNode* mParent;
 		size_t mLine;
 		size_t mColumn;
@@ -71,16 +72,10 @@ namespace Qd {
 	 */
 	class AstNodeStructDeclaration : public IAstNode {
 	public:
-		AstNodeStructDeclaration(const std::string& name, bool isPublic = false)
+		AstNodeStructDeclaration(Symbol name, bool isPublic = false)
 			: mName(name), mIsPublic(isPublic), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
-		~AstNodeStructDeclaration() {
-			for (auto* field : mFields) {
-				delete field;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::STRUCT_DECLARATION;
 		}
@@ -134,7 +129,7 @@ namespace Qd {
 		}
 
 	private:
-		std::string mName;
+		Symbol mName;
 		bool mIsPublic;
 		std::vector<AstNodeStructField*> mFields;
 		IAstNode* mParent;
@@ -150,7 +145,7 @@ namespace Qd {
 	 */
 	class AstNodeStructConstruction : public IAstNode {
 	public:
-		AstNodeStructConstruction(const std::string& structName)
+		AstNodeStructConstruction(Symbol structName)
 			: mStructName(structName), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
@@ -192,7 +187,7 @@ namespace Qd {
 		}
 
 	private:
-		std::string mStructName;
+		Symbol mStructName;
 		IAstNode* mParent;
 		size_t mLine;
 		size_t mColumn;
@@ -206,7 +201,7 @@ namespace Qd {
 	 */
 	class AstNodeFieldAccess : public IAstNode {
 	public:
-		AstNodeFieldAccess(const std::string& varName, const std::string& fieldName)
+		AstNodeFieldAccess(Symbol varName, Symbol fieldName)
 			: mVarName(varName), mFieldName(fieldName), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
@@ -252,8 +247,8 @@ namespace Qd {
 		}
 
 	private:
-		std::string mVarName;
-		std::string mFieldName;
+		Symbol mVarName;
+		Symbol mFieldName;
 		IAstNode* mParent;
 		size_t mLine;
 		size_t mColumn;
@@ -11,15 +11,6 @@ namespace Qd {
 			: mValue(value), mIsDefault(isDefault), mParent(nullptr), mBody(nullptr), mLine(0), mColumn(0) {
 		}
 
-		~AstNodeCase() {
-			if (mValue) {
-				delete mValue;
-			}
-			if (mBody) {
-				delete mBody;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::CASE_STATEMENT;
 		}
@@ -97,12 +88,6 @@ namespace Qd {
 		AstNodeSwitchStatement() : mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
-		~AstNodeSwitchStatement() {
-			for (auto* caseNode : mCases) {
-				delete caseNode;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::SWITCH_STATEMENT;
 		}
@@ -2,12 +2,13 @@
 #define QD_QC_AST_NODE_USE_H
 
 #include "ast_node.h"
+#include "symbol.h"
 #include <string>
 
 namespace Qd {
 	class AstNodeUse : public IAstNode {
 	public:
-		AstNodeUse(const std::string& module) : mModule(module), mParent(nullptr), mLine(0), mColumn(0) {
+		AstNodeUse(Symbol module) : mModule(module), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
 		IAstNode::Type type() const override {
@@ -48,7 +49,7 @@ namespace Qd {
 		}
 
 	private:
-		std::string mModule;
+		Symbol mModule;
 		IAstNode* mParent;
 		size_t mLine;
 		size_t mColumn;
@@ -1,6 +1,7 @@
 #ifndef QD_QC_ERROR_REPORTER_H
 #define QD_QC_ERROR_REPORTER_H
 
+#include "source_index.h"
 #include <stdio.h>
 #include <string>
 #include <u8t/scanner.h>
@@ -16,7 +17,7 @@ namespace Qd {
 	class ErrorReporter {
 	public:
 		ErrorReporter(const char* src = nullptr, const char* filename = nullptr)
-			: mSource(src), mFilename(filename), mErrorCount(0), mStoreErrors(false) {
+			: mIndex(src), mFilename(filename), mErrorCount(0), mStoreErrors(false) {
 		}
 
 		void reportError(u8t_scanner* scanner, const char* message);
@@ -39,8 +40,13 @@ namespace Qd {
 			return mErrors;
 		}
 
+		// Line index of the source, shared with the parser
+		const SourceIndex& sourceIndex() const {
+			return mIndex;
+		}
+
 	private:
-		const char* mSource;
+		SourceIndex mIndex;
 		const char* mFilename;
 		size_t mErrorCount;
 		bool mStoreErrors;
@@ -1,11 +1,98 @@
 #pragma once
 
-#include <cstring>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
 
 namespace Qd {
 	// Built-in runtime instructions
-	// These are instructions that are directly compiled into the runtime executable
-	static const char* BUILTIN_INSTRUCTIONS[] = {
+	// These are instructions that are directly compiled into the runtime executable.
+	// The order matches INSTRUCTION_NAMES below.
+	enum class Opcode : uint8_t {
+		NONE, // Not a built-in instruction
+		// Comparison operators (also available as symbols)
+		SYM_NEQ,
+		SYM_LT,
+		SYM_LTE,
+		SYM_EQ,
+		SYM_GT,
+		SYM_GTE,
+		// Arithmetic operators (also available as symbols)
+		SYM_MOD,
+		SYM_MUL,
+		SYM_ADD,
+		SYM_SUB,
+		SYM_PRINT,
+		SYM_DIV,
+		// Arithmetic instructions
+		ADD,
+		DEC,
+		DIV,
+		INC,
+		MOD,
+		MUL,
+		NEG,
+		SUB,
+		// Logical operations
+		EQ,
+		GT,
+		GTE,
+		LT,
+		LTE,
+		NEQ,
+		WITHIN,
+		// Stack operations
+		CALL,
+		CLEAR,
+		DEPTH,
+		DROP,
+		DROP2,
+		DUP,
+		DUP2,
+		DUPD,
+		FREE,
+		NIP,
+		NIPD,
+		OVER,
+		OVER2,
+		OVERD,
+		PICK,
+		ROLL,
+		ROT,
+		SWAP,
+		SWAP2,
+		SWAPD,
+		TUCK,
+		// Type casting
+		CASTF,
+		CASTI,
+		CASTS,
+		// I/O
+		NL,
+		PRINT,
+		PRINTS,
+		PRINTSV,
+		PRINTV,
+		READ,
+		// Threading
+		CHAN,
+		CLOSE,
+		DETACH,
+		RECV,
+		SEND,
+		SPAWN,
+		SPAWN_ARGS,
+		TRY_RECV,
+		WAIT,
+		YIELD,
+		// Error handling
+		ERROR,
+		COUNT
+	};
+
+	// Names of the built-in instructions, indexed by opcode - 1
+	inline constexpr std::array<std::string_view, static_cast<size_t>(Opcode::COUNT) - 1> INSTRUCTION_NAMES = {
 			// Comparison operators (also available as symbols)
 			"!=", "<", "<=", "==", ">", ">=",
 			// Arithmetic operators (also available as symbols)
@@ -22,56 +109,110 @@ namespace Qd {
 			// I/O
 			"nl", "print", "prints", "printsv", "printv", "read",
 			// Threading
-			"detach", "spawn", "wait",
+			"chan", "close", "detach", "recv", "send", "spawn", "spawn_args", "try_recv", "wait", "yield",
 			// Error handling
 			"error"};
 
-	static const size_t BUILTIN_INSTRUCTION_COUNT = sizeof(BUILTIN_INSTRUCTIONS) / sizeof(BUILTIN_INSTRUCTIONS[0]);
+	static const size_t BUILTIN_INSTRUCTION_COUNT = INSTRUCTION_NAMES.size();
 
-	// Extended instruction list for semantic validation
-	// Includes built-in instructions PLUS commonly imported library functions
-	// This prevents false "undefined function" errors when validating standard library modules
-	static const char* VALIDATOR_INSTRUCTIONS[] = {
-			// All built-in instructions
-			"!=", "%", "*", "+", "-", ".", "/", "<", "<=", "==", ">", ">=", "add", "dec", "div", "eq", "gt", "gte",
-			"inc", "lt", "lte", "mod", "mul", "neg", "neq", "sub", "within",
+	// Library functions that stdlib modules import under instruction-like names
+	// The validator accepts these as well, which prevents false "undefined function"
+	// errors when validating standard library modules
+	inline constexpr std::array<std::string_view, 27> LIBRARY_INSTRUCTION_NAMES = {
 			// Math library functions (imported by stdlib modules)
 			"abs", "acos", "asin", "atan", "cb", "cbrt", "ceil", "cos", "fac", "floor", "inv", "ln", "log10", "max",
 			"min", "pow", "round", "sin", "sq", "sqrt", "tan",
 			// Logical/bitwise operations
-			"and", "lshift", "not", "or", "rshift", "xor",
-			// Stack operations
-			"call", "clear", "depth", "drop", "drop2", "dup", "dup2", "dupd", "free", "nip", "nipd", "over", "over2", "overd",
-			"pick", "roll", "rot", "swap", "swap2", "swapd", "tuck",
-			// Type casting
-			"castf", "casti", "casts",
-			// I/O
-			"nl", "print", "prints", "printsv", "printv", "read",
-			// Threading
-			"detach", "spawn", "wait",
-			// Error handling
-			"error"};
+			"and", "lshift", "not", "or", "rshift", "xor"};
 
-	static const size_t VALIDATOR_INSTRUCTION_COUNT =
-			sizeof(VALIDATOR_INSTRUCTIONS) / sizeof(VALIDATOR_INSTRUCTIONS[0]);
+	/**
+	 * @brief Collision-free hash table over a fixed set of names
+	 *
+	 * The constructor runs at compile time and searches for a hash seed
+	 * that puts every name in its own slot, so a lookup is one hash and one
+	 * string compare.
+	 *
+	 * @tparam N Number of names
+	 * @tparam SLOTS Number of slots (a power of two, several times N)
+	 */
+	template <size_t N, size_t SLOTS>
+	class PerfectHashTable {
+	public:
+		static_assert(N < 0xFF, "Slots store 8-bit indices");
+		static_assert((SLOTS & (SLOTS - 1)) == 0, "Slot count must be a power of two");
 
-	// Helper function to check if an identifier is a built-in instruction (for parsing)
-	inline bool isBuiltInInstruction(const char* name) {
-		for (size_t i = 0; i < BUILTIN_INSTRUCTION_COUNT; i++) {
-			if (strcmp(name, BUILTIN_INSTRUCTIONS[i]) == 0) {
-				return true;
+		consteval explicit PerfectHashTable(const std::array<std::string_view, N>& names) : mNames(names) {
+			while (!tryBuild()) {
+				mSeed++;
+			}
+		}
+
+		/**
+		 * @brief Find a name
+		 *
+		 * @return Index of the name in the array passed to the constructor, or -1
+		 */
+		constexpr int find(std::string_view name) const {
+			uint8_t index = mSlots[hash(name, mSeed) & (SLOTS - 1)];
+			return index != EMPTY && mNames[index] == name ? index : -1;
+		}
+
+	private:
+		static constexpr uint8_t EMPTY = 0xFF;
+
+		// FNV-1a, mixed with the seed
+		static constexpr uint32_t hash(std::string_view name, uint32_t seed) {
+			uint32_t h = 2166136261u ^ seed;
+			for (char c : name) {
+				h ^= static_cast<uint8_t>(c);
+				h *= 16777619u;
+			}
+			return h ^ (h >> 15);
+		}
+
+		constexpr bool tryBuild() {
+			mSlots.fill(EMPTY);
+			for (size_t i = 0; i < N; i++) {
+				uint8_t& slot = mSlots[hash(mNames[i], mSeed) & (SLOTS - 1)];
+				if (slot != EMPTY) {
+					return false;
+				}
+				slot = static_cast<uint8_t>(i);
 			}
+			return true;
 		}
-		return false;
+
+		std::array<std::string_view, N> mNames;
+		std::array<uint8_t, SLOTS> mSlots{};
+		uint32_t mSeed = 0;
+	};
+
+	inline constexpr PerfectHashTable<INSTRUCTION_NAMES.size(), 512> INSTRUCTION_TABLE{INSTRUCTION_NAMES};
+	inline constexpr PerfectHashTable<LIBRARY_INSTRUCTION_NAMES.size(), 256> LIBRARY_INSTRUCTION_TABLE{
+			LIBRARY_INSTRUCTION_NAMES};
+
+	// Opcode of a built-in instruction, or Opcode::NONE
+	constexpr Opcode lookupInstruction(std::string_view name) {
+		return static_cast<Opcode>(INSTRUCTION_TABLE.find(name) + 1);
+	}
+
+	// Name of a built-in instruction
+	constexpr std::string_view instructionName(Opcode opcode) {
+		return opcode == Opcode::NONE || opcode == Opcode::COUNT ? std::string_view()
+																   : INSTRUCTION_NAMES[static_cast<size_t>(opcode) - 1];
+	}
+
+	static_assert(lookupInstruction("!=") == Opcode::SYM_NEQ && lookupInstruction("/") == Opcode::SYM_DIV);
+	static_assert(lookupInstruction("add") == Opcode::ADD && lookupInstruction("error") == Opcode::ERROR);
+	static_assert(lookupInstruction("sqrt") == Opcode::NONE && lookupInstruction("") == Opcode::NONE);
+
+	// Helper function to check if an identifier is a built-in instruction (for parsing)
+	inline bool isBuiltInInstruction(const char* name) {
+		return lookupInstruction(name) != Opcode::NONE;
 	}
 
 	// Helper function to check if an identifier is a known instruction (for validation)
 	inline bool isKnownInstruction(const char* name) {
-		for (size_t i = 0; i < VALIDATOR_INSTRUCTION_COUNT; i++) {
-			if (strcmp(name, VALIDATOR_INSTRUCTIONS[i]) == 0) {
-				return true;
-			}
-		}
-		return false;
+		return lookupInstruction(name) != Opcode::NONE || LIBRARY_INSTRUCTION_TABLE.find(name) >= 0;
 	}
 }
@@ -2,6 +2,7 @@
 #define QD_QC_SEMANTIC_VALIDATOR_H
 
 #include "ast.h"
+#include "instructions.h"
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -29,6 +30,7 @@ namespace Qd {
 		// For each PTR parameter: map of parameter name -> map of (field name -> expected field type)
 		std::unordered_map<std::string, std::unordered_map<std::string, StackValueType>> parameterFieldAccess;
 		bool throws = false;				  // Whether the function can throw errors
+		bool exact = false;					  // Whether produces was derived from an exactly modeled body
 	};
 
 	// Semantic validator - checks for errors that would slip through to GCC/runtime
@@ -73,7 +75,7 @@ namespace Qd {
 			return mModuleConstantValues;
 		}
 
-		// Enable error storage for LSP (instead of printing to stderr)
+		// Store errors and warnings instead of printing them to stderr (LSP, parallel validation)
 		void setStoreErrors(bool store) {
 			mStoreErrors = store;
 		}
@@ -83,6 +85,14 @@ namespace Qd {
 			return mStoredErrors;
 		}
 
+		// Get stored warnings (only available when setStoreErrors(true) was called)
+		const std::vector<ErrorInfo>& getWarnings() const {
+			return mStoredWarnings;
+		}
+
+		// Print the stored errors and warnings to stderr in the order they were reported
+		void printStoredDiagnostics() const;
+
 	private:
 		// Pass 1: Collect all function definitions
 		void collectDefinitions(IAstNode* node);
@@ -120,14 +130,14 @@ namespace Qd {
 		void typeCheckFunction(IAstNode* node);
 		void typeCheckBlock(IAstNode* node, std::vector<StackValueType>& typeStack,
 				std::unordered_map<std::string, StackValueType>& localVariables);
-		void typeCheckInstruction(IAstNode* node, const char* name, std::vector<StackValueType>& typeStack);
+		void typeCheckInstruction(IAstNode* node, Opcode opcode, std::vector<StackValueType>& typeStack);
 
 		// Helper: Analyze a block in isolation (for determining function signatures)
 		void analyzeBlockInIsolation(IAstNode* node, std::vector<StackValueType>& typeStack);
 
 		// Helper: Type check an instruction (with optional error suppression for signature analysis)
 		void typeCheckInstructionInternal(
-				IAstNode* node, const char* name, std::vector<StackValueType>& typeStack, bool reportErrors);
+				IAstNode* node, Opcode opcode, std::vector<StackValueType>& typeStack, bool reportErrors);
 
 		// Check if a name is a built-in instruction
 		bool isBuiltInInstruction(const char* name) const;
@@ -152,6 +162,9 @@ namespace Qd {
 		// Report a warning (gcc/clang style)
 		void reportWarning(const IAstNode* node, const char* message);
 
+		// Print an error or warning (line 0 if it has no position)
+		void printDiagnostic(size_t line, size_t column, bool warning, const std::string& message) const;
+
 		// Current filename being validated
 		const char* mFilename;
 
@@ -220,6 +233,11 @@ namespace Qd {
 		// Function signatures: stack effect of each function
 		std::unordered_map<std::string, FunctionSignature> mFunctionSignatures;
 
+		// Whether the type stack being checked still matches the runtime stack exactly. Cleared by anything
+		// the model doesn't follow (unmodeled instructions, control flow, unresolved calls); call sites are
+		// only marked as proven while it holds.
+		bool mTypeStackExact;
+
 		// Error count
 		size_t mErrorCount;
 
@@ -232,9 +250,11 @@ namespace Qd {
 		// Whether this is validating a module file (vs main entry point)
 		bool mIsModuleFile;
 
-		// Error storage for LSP
+		// Error storage for LSP and parallel validation
 		bool mStoreErrors;
 		std::vector<ErrorInfo> mStoredErrors;
+		std::vector<ErrorInfo> mStoredWarnings;
+		std::vector<bool> mStoredOrder; // Whether each stored diagnostic, in report order, is a warning
 	};
 
 } // namespace Qd
@@ -0,0 +1,118 @@
+/**
+ * @file source_index.h
+ * @brief Line offset index for source position lookups
+ *
+ * Maps byte positions to line/column pairs without rescanning the source.
+ */
+
+#ifndef QD_QC_SOURCE_INDEX_H
+#define QD_QC_SOURCE_INDEX_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace Qd {
+
+	/**
+	 * @brief Line offset index of a source buffer
+	 *
+	 * Records the start of every line once, so position lookups are a binary
+	 * search instead of a scan from the beginning of the source. Lookups that
+	 * move forward through the source, as the parser's do, are answered from
+	 * a cursor in constant time.
+	 *
+	 * Lines and columns are 1-based; columns count bytes.
+	 *
+	 * @par Usage:
+	 * @code
+	 * Qd::SourceIndex index(source);
+	 * size_t line, column;
+	 * index.lineColumn(pos, &line, &column);
+	 * @endcode
+	 *
+	 * @note The source is not copied and must outlive the index
+	 */
+	class SourceIndex {
+	public:
+		/**
+		 * @brief Build the index of a source buffer
+		 *
+		 * @param src Null-terminated source code (may be nullptr)
+		 */
+		explicit SourceIndex(const char* src = nullptr);
+
+		/**
+		 * @brief Get the indexed source
+		 *
+		 * @return Source passed to the constructor ("" if it was nullptr)
+		 */
+		const char* source() const {
+			return mSource;
+		}
+
+		/**
+		 * @brief Get the length of the source in bytes
+		 */
+		size_t length() const {
+			return mLength;
+		}
+
+		/**
+		 * @brief Get the number of lines
+		 *
+		 * @return Number of lines (at least 1)
+		 */
+		size_t lineCount() const {
+			return mLineStarts.size();
+		}
+
+		/**
+		 * @brief Get the byte offset where a line starts
+		 *
+		 * @param line 1-based line number
+		 * @return Offset of the line's first byte, or length() if there is no such line
+		 */
+		size_t lineStart(size_t line) const;
+
+		/**
+		 * @brief Get the byte offset where a line ends
+		 *
+		 * @param line 1-based line number
+		 * @return Offset of the line's '\n' (or the end of the source)
+		 */
+		size_t lineEnd(size_t line) const;
+
+		/**
+		 * @brief Convert a byte position to line and column
+		 *
+		 * @param pos Byte offset into the source (clamped to length())
+		 * @param line Receives the 1-based line number
+		 * @param column Receives the 1-based column
+		 */
+		void lineColumn(size_t pos, size_t* line, size_t* column) const;
+
+		/**
+		 * @brief Convert a UTF-8 character index to a byte offset
+		 *
+		 * Continues from the previous call when the index did not move
+		 * backwards, so walking through the source is linear overall.
+		 *
+		 * @param charIndex Index of the character (code point)
+		 * @return Byte offset of the character, or length() if past the end
+		 */
+		size_t byteOffset(size_t charIndex) const;
+
+	private:
+		const char* mSource;
+		size_t mLength;
+		std::vector<size_t> mLineStarts;
+
+		// Cursors for monotonically advancing lookups
+		mutable size_t mLineCursor;
+		mutable size_t mCharCursor;
+		mutable size_t mByteCursor;
+	};
+
+} // namespace Qd
+
+#endif // QD_QC_SOURCE_INDEX_H
@@ -0,0 +1,65 @@
+/**
+ * @file symbol.h
+ * @brief Interned identifier strings for AST nodes
+ */
+
+#ifndef QD_QC_SYMBOL_H
+#define QD_QC_SYMBOL_H
+
+#include <string>
+
+namespace Qd {
+
+	class AstArena;
+
+	/**
+	 * @brief Handle to an interned string
+	 *
+	 * Symbols are created by AstArena::intern() and stay valid as long as
+	 * the arena. Equal strings interned in the same arena share storage,
+	 * so symbols compare by pointer.
+	 */
+	class Symbol {
+	public:
+		/**
+		 * @brief Create the empty symbol
+		 */
+		Symbol() : mString(&empty()) {
+		}
+
+		/**
+		 * @brief Get the interned string
+		 */
+		const std::string& str() const {
+			return *mString;
+		}
+
+		operator const std::string&() const {
+			return *mString;
+		}
+
+		bool operator==(const Symbol& other) const {
+			return mString == other.mString;
+		}
+
+		bool operator!=(const Symbol& other) const {
+			return mString != other.mString;
+		}
+
+	private:
+		friend class AstArena;
+
+		explicit Symbol(const std::string* string) : mString(string) {
+		}
+
+		static const std::string& empty() {
+			static const std::string emptyString;
+			return emptyString;
+		}
+
+		const std::string* mString;
+	};
+
+} // namespace Qd
+
+#endif // QD_QC_SYMBOL_H
@@ -5,6 +5,7 @@
 #include <fstream>
 #include <iostream>
 #include <qc/ast.h>
+#include <qc/ast_arena.h>
 #include <qc/ast_node.h>
 #include <qc/ast_node_break.h>
 #include <qc/ast_node_constant.h>
@@ -31,65 +32,52 @@
 #include <qc/colors.h>
 #include <qc/error_reporter.h>
 #include <qc/instructions.h>
+#include <qc/source_index.h>
 #include <u8t/scanner.h>
 #include <vector>
 
 namespace Qd {
 
-	// Helper function to convert UTF-8 character index to byte offset
-	static size_t charIndexToByteOffset(const char* src, size_t charIndex) {
-		size_t byteOffset = 0;
-		size_t currentCharIndex = 0;
-
-		while (currentCharIndex < charIndex && src[byteOffset] != '\0') {
-			unsigned char c = static_cast<unsigned char>(src[byteOffset]);
-			if ((c & 0x80) == 0) {
-				// Single-byte character (ASCII)
-				byteOffset += 1;
-			} else if ((c & 0xE0) == 0xC0) {
-				// Two-byte character
-				byteOffset += 2;
-			} else if ((c & 0xF0) == 0xE0) {
-				// Three-byte character
-				byteOffset += 3;
-			} else if ((c & 0xF8) == 0xF0) {
-				// Four-byte character
-				byteOffset += 4;
-			} else {
-				// Invalid UTF-8, skip one byte
-				byteOffset += 1;
-			}
-			currentCharIndex++;
+	// Arena of the Ast being generated on this thread
+	static thread_local AstArena* sArena = nullptr;
+
+	// Makes an arena the target of makeNode() and intern() while parsing
+	class ArenaScope {
+	public:
+		explicit ArenaScope(AstArena* arena) : mPrevious(sArena) {
+			sArena = arena;
+		}
+
+		~ArenaScope() {
+			sArena = mPrevious;
 		}
 
-		return byteOffset;
+	private:
+		AstArena* mPrevious;
+	};
+
+	// Helper to allocate a node in the current arena
+	template <typename T, typename... Args>
+	static T* makeNode(Args&&... args) {
+		return sArena->create<T>(std::forward<Args>(args)...);
 	}
 
-	// Helper to calculate line and column from byte position
-	static void calculateLineColumn(const char* src, size_t pos, size_t* line, size_t* column) {
-		*line = 1;
-		*column = 1;
-		for (size_t i = 0; i < pos && src[i] != '\0'; i++) {
-			if (src[i] == '\n') {
-				(*line)++;
-				*column = 1;
-			} else {
-				(*column)++;
-			}
-		}
+	// Helper to intern an identifier in the current arena
+	static Symbol intern(const std::string& name) {
+		return sArena->intern(name);
 	}
 
 	// Helper to set position on a node from scanner
-	static void setNodePosition(IAstNode* node, u8t_scanner* scanner, const char* src) {
+	static void setNodePosition(IAstNode* node, u8t_scanner* scanner, const SourceIndex& src) {
 		size_t pos = u8t_scanner_token_start(scanner);
 		size_t line, column;
-		calculateLineColumn(src, pos, &line, &column);
+		src.lineColumn(pos, &line, &column);
 		node->setPosition(line, column);
 	}
 
 	// Helper to parse a comment (// or /* */)
 	// Returns the comment node, or nullptr if not a comment
-	static AstNodeComment* parseComment(u8t_scanner* scanner, const char* src, bool sawSlash, char32_t token) {
+	static AstNodeComment* parseComment(u8t_scanner* scanner, const SourceIndex& src, bool sawSlash, char32_t token) {
 		if (!sawSlash) {
 			return nullptr;
 		}
@@ -106,10 +94,10 @@ namespace Qd {
 		// Get character position and convert to byte offset
 		size_t charPos = u8t_scanner_token_start(scanner);
 		size_t tokenLen = u8t_scanner_token_len(scanner);
-		size_t bytePos = charIndexToByteOffset(src, charPos + tokenLen);
+		size_t bytePos = src.byteOffset(charPos + tokenLen);
 
 		// Read comment text directly from source
-		const char* commentStart = src + bytePos;
+		const char* commentStart = src.source() + bytePos;
 		const char* commentEnd = commentStart;
 
 		if (commentType == AstNodeComment::CommentType::LINE) {
@@ -148,15 +136,15 @@ namespace Qd {
 		}
 
 		// Create and return comment node
-		AstNodeComment* comment = new AstNodeComment(commentText, commentType);
+		AstNodeComment* comment = makeNode<AstNodeComment>(commentText, commentType);
 		setNodePosition(comment, scanner, src);
 		return comment;
 	}
 
-	static IAstNode* parseForStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src);
-	static IAstNode* parseLoopStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src);
-	static IAstNode* parseIfStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src);
-	static IAstNode* parseSwitchStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src);
+	static IAstNode* parseForStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src);
+	static IAstNode* parseLoopStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src);
+	static IAstNode* parseIfStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src);
+	static IAstNode* parseSwitchStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src);
 
 	// Helper to synchronize parser after an error
 	// Skips tokens until a synchronization point is found
@@ -184,7 +172,7 @@ namespace Qd {
 
 	// Helper to check if a token is an operator alias and create the corresponding instruction node
 	// Returns the instruction node if it's an operator, nullptr otherwise
-	static IAstNode* tryParseOperatorAlias(char32_t token, u8t_scanner* scanner, const char* src) {
+	static IAstNode* tryParseOperatorAlias(char32_t token, u8t_scanner* scanner, const SourceIndex& src) {
 		// Special handling for '-' to check for '->' (local variable declaration)
 		if (token == '-') {
 			// Check if the next character in source is '>' (forming '->')
@@ -192,7 +180,7 @@ namespace Qd {
 			size_t tokenLen = u8t_scanner_token_len(scanner);
 			size_t tokenEnd = tokenStart + tokenLen;
 			// If character immediately after '-' is '>', this is NOT subtraction
-			if (tokenEnd < strlen(src) && src[tokenEnd] == '>') {
+			if (tokenEnd < src.length() && src.source()[tokenEnd] == '>') {
 				return nullptr; // Not an operator alias, will be handled as local declaration
 			}
 		}
@@ -214,7 +202,7 @@ namespace Qd {
 
 		for (size_t i = 0; i < OPERATOR_COUNT; i++) {
 			if (token == OPERATOR_ALIASES[i].token) {
-				IAstNode* node = new AstNodeInstruction(OPERATOR_ALIASES[i].instruction);
+				IAstNode* node = makeNode<AstNodeInstruction>(intern(OPERATOR_ALIASES[i].instruction));
 				setNodePosition(node, scanner, src);
 				return node;
 			}
@@ -226,31 +214,32 @@ namespace Qd {
 	// Returns nullptr if token was a control keyword that was handled
 	// Returns a node if it's a literal or identifier
 	static IAstNode* parseSimpleToken(char32_t token, u8t_scanner* scanner, ErrorReporter* /*errorReporter*/, size_t* n,
-			const char* src) {
+			const SourceIndex& src) {
 		if (token == U8T_INTEGER) {
 			const char* text = u8t_scanner_token_text(scanner, n);
-			IAstNode* node = new AstNodeLiteral(text, AstNodeLiteral::LiteralType::INTEGER);
+			IAstNode* node = makeNode<AstNodeLiteral>(text, AstNodeLiteral::LiteralType::INTEGER);
 			setNodePosition(node, scanner, src);
 			return node;
 		} else if (token == U8T_FLOAT) {
 			const char* text = u8t_scanner_token_text(scanner, n);
-			IAstNode* node = new AstNodeLiteral(text, AstNodeLiteral::LiteralType::FLOAT);
+			IAstNode* node = makeNode<AstNodeLiteral>(text, AstNodeLiteral::LiteralType::FLOAT);
 			setNodePosition(node, scanner, src);
 			return node;
 		} else if (token == U8T_STRING) {
 			const char* text = u8t_scanner_token_text(scanner, n);
-			IAstNode* node = new AstNodeLiteral(text, AstNodeLiteral::LiteralType::STRING);
+			IAstNode* node = makeNode<AstNodeLiteral>(text, AstNodeLiteral::LiteralType::STRING);
 			setNodePosition(node, scanner, src);
 			return node;
 		} else if (token == U8T_IDENTIFIER) {
 			const char* text = u8t_scanner_token_text(scanner, n);
-			if (isBuiltInInstruction(text)) {
-				IAstNode* node = new AstNodeInstruction(text);
+			Opcode opcode = lookupInstruction(text);
+			if (opcode != Opcode::NONE) {
+				IAstNode* node = makeNode<AstNodeInstruction>(intern(text), opcode);
 				setNodePosition(node, scanner, src);
 				return node;
 			}
 
-			AstNodeIdentifier* node = new AstNodeIdentifier(text);
+			AstNodeIdentifier* node = makeNode<AstNodeIdentifier>(intern(text));
 			setNodePosition(node, scanner, src);
 			// Check for '!' or '?' suffix
 			char32_t nextToken = u8t_scanner_peek(scanner);
@@ -275,15 +264,15 @@ namespace Qd {
 			size_t tokenStart = u8t_scanner_token_start(scanner);
 			size_t tokenLen = u8t_scanner_token_len(scanner);
 			size_t tokenEnd = tokenStart + tokenLen;
-			if (tokenEnd < strlen(src) && src[tokenEnd] == '>') {
+			if (tokenEnd < src.length() && src.source()[tokenEnd] == '>') {
 				// This is '-> variableName'
 				u8t_scanner_scan(scanner);						// Consume '>'
 				char32_t nextToken = u8t_scanner_scan(scanner); // Get variable name
 				if (nextToken == U8T_IDENTIFIER) {
 					const char* varName = u8t_scanner_token_text(scanner, n);
-					IAstNode* node = new AstNodeLocal(std::string(varName));
+					IAstNode* node = makeNode<AstNodeLocal>(intern(varName));
 					size_t line, column;
-					calculateLineColumn(src, tokenStart, &line, &column);
+					src.lineColumn(tokenStart, &line, &column);
 					node->setPosition(line, column);
 					return node;
 				}
@@ -297,12 +286,12 @@ namespace Qd {
 			char32_t nextToken = u8t_scanner_peek(scanner);
 			if (nextToken == '=') {
 				u8t_scanner_scan(scanner); // Consume '='
-				IAstNode* node = new AstNodeInstruction("<=");
+				IAstNode* node = makeNode<AstNodeInstruction>(intern("<="));
 				setNodePosition(node, scanner, src);
 				return node;
 			}
 			// Handle '<' as alias for 'lt'
-			IAstNode* node = new AstNodeInstruction("<");
+			IAstNode* node = makeNode<AstNodeInstruction>(intern("<"));
 			setNodePosition(node, scanner, src);
 			return node;
 		} else if (token == '>') {
@@ -310,12 +299,12 @@ namespace Qd {
 			char32_t nextToken = u8t_scanner_peek(scanner);
 			if (nextToken == '=') {
 				u8t_scanner_scan(scanner); // Consume '='
-				IAstNode* node = new AstNodeInstruction(">=");
+				IAstNode* node = makeNode<AstNodeInstruction>(intern(">="));
 				setNodePosition(node, scanner, src);
 				return node;
 			}
 			// Handle '>' as alias for 'gt'
-			IAstNode* node = new AstNodeInstruction(">");
+			IAstNode* node = makeNode<AstNodeInstruction>(intern(">"));
 			setNodePosition(node, scanner, src);
 			return node;
 		} else if (token == '=') {
@@ -323,7 +312,7 @@ namespace Qd {
 			char32_t nextToken = u8t_scanner_peek(scanner);
 			if (nextToken == '=') {
 				u8t_scanner_scan(scanner); // Consume '='
-				IAstNode* node = new AstNodeInstruction("==");
+				IAstNode* node = makeNode<AstNodeInstruction>(intern("=="));
 				setNodePosition(node, scanner, src);
 				return node;
 			}
@@ -333,7 +322,7 @@ namespace Qd {
 			char32_t nextToken = u8t_scanner_peek(scanner);
 			if (nextToken == '=') {
 				u8t_scanner_scan(scanner); // Consume '='
-				IAstNode* node = new AstNodeInstruction("!=");
+				IAstNode* node = makeNode<AstNodeInstruction>(intern("!="));
 				setNodePosition(node, scanner, src);
 				return node;
 			}
@@ -341,7 +330,7 @@ namespace Qd {
 			return nullptr;
 		} else if (token == '$') {
 			// Handle '$' as for loop iterator variable
-			IAstNode* node = new AstNodeIdentifier("$");
+			IAstNode* node = makeNode<AstNodeIdentifier>(intern("$"));
 			setNodePosition(node, scanner, src);
 			return node;
 		} else if (token == '&') {
@@ -351,10 +340,10 @@ namespace Qd {
 			if (nextToken == U8T_IDENTIFIER) {
 				size_t n2;
 				const char* functionName = u8t_scanner_token_text(scanner, &n2);
-				IAstNode* node = new AstNodeFunctionPointerReference(functionName);
+				IAstNode* node = makeNode<AstNodeFunctionPointerReference>(intern(functionName));
 				// Set position to the & token
 				size_t line, column;
-				calculateLineColumn(src, ampPos, &line, &column);
+				src.lineColumn(ampPos, &line, &column);
 				node->setPosition(line, column);
 				return node;
 			}
@@ -366,13 +355,13 @@ namespace Qd {
 
 	// Forward declarations for recursive parsing
 	static void parseBlockBody(
-			AstNodeBlock* block, u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src);
+			AstNodeBlock* block, u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src);
 	static IAstNode* parseBlockStatement(char32_t token, u8t_scanner* scanner, ErrorReporter* errorReporter, size_t* n,
-			const char* src, bool allowControlFlow = true);
+			const SourceIndex& src, bool allowControlFlow = true);
 
 	// Helper function to parse a block body with proper else-handling
 	static void parseBlockBody(
-			AstNodeBlock* block, u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src) {
+			AstNodeBlock* block, u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src) {
 		size_t n;
 		char32_t token;
 		bool sawSlash = false;
@@ -392,9 +381,9 @@ namespace Qd {
 					token = u8t_scanner_scan(scanner);
 					if (token == U8T_IDENTIFIER) {
 						const char* memberName = u8t_scanner_token_text(scanner, &n);
-						AstNodeScopedIdentifier* scoped = new AstNodeScopedIdentifier(scope->name(), memberName);
+						AstNodeScopedIdentifier* scoped =
+								makeNode<AstNodeScopedIdentifier>(intern(scope->name()), intern(memberName));
 						setNodePosition(scoped, scanner, src);
-						delete scope;
 						// Check for '!' or '?' suffix
 						char32_t nextToken = u8t_scanner_peek(scanner);
 						if (nextToken == '!') {
@@ -433,7 +422,7 @@ namespace Qd {
 			if (sawSlash) {
 				sawSlash = false;
 				// Add division instruction to tempNodes
-				AstNodeInstruction* divInstr = new AstNodeInstruction("/");
+				AstNodeInstruction* divInstr = makeNode<AstNodeInstruction>(intern("/"));
 				setNodePosition(divInstr, scanner, src);
 				tempNodes.push_back(divInstr);
 			}
@@ -473,7 +462,7 @@ namespace Qd {
 						if (token != '{') {
 							errorReporter->reportError(scanner, "Expected '{' after 'else'");
 						} else {
-							AstNodeBlock* elseBody = new AstNodeBlock();
+							AstNodeBlock* elseBody = makeNode<AstNodeBlock>();
 							setNodePosition(elseBody, scanner, src);
 
 							// Recursively parse the else body
@@ -507,7 +496,7 @@ namespace Qd {
 	// Returns a node that should be added to the parent, or nullptr
 	// allowControlFlow: if false, only allows break/continue but not if/for/switch
 	static IAstNode* parseBlockStatement(char32_t token, u8t_scanner* scanner, ErrorReporter* errorReporter, size_t* n,
-			const char* src, bool allowControlFlow) {
+			const SourceIndex& src, bool allowControlFlow) {
 		// Handle local variable declaration: -> variableName
 		// Check this early before other token processing
 		if (token == '-') {
@@ -517,16 +506,16 @@ namespace Qd {
 			size_t tokenLen = u8t_scanner_token_len(scanner);
 			size_t tokenEnd = tokenStart + tokenLen;
 			// Check if character immediately after '-' is '>'
-			if (tokenEnd < strlen(src) && src[tokenEnd] == '>') {
+			if (tokenEnd < src.length() && src.source()[tokenEnd] == '>') {
 				// This is a local declaration: -> variableName
 				size_t arrowPos = tokenStart;
 				u8t_scanner_scan(scanner);		   // Consume '>'
 				token = u8t_scanner_scan(scanner); // Get next token (should be identifier)
 				if (token == U8T_IDENTIFIER) {
 					const char* varName = u8t_scanner_token_text(scanner, n);
-					IAstNode* node = new AstNodeLocal(std::string(varName));
+					IAstNode* node = makeNode<AstNodeLocal>(intern(varName));
 					size_t line, column;
-					calculateLineColumn(src, arrowPos, &line, &column);
+					src.lineColumn(arrowPos, &line, &column);
 					node->setPosition(line, column);
 					return node;
 				} else {
@@ -542,11 +531,11 @@ namespace Qd {
 
 			// break and continue are always allowed
 			if (strcmp(text, "break") == 0) {
-				IAstNode* node = new AstNodeBreak();
+				IAstNode* node = makeNode<AstNodeBreak>();
 				setNodePosition(node, scanner, src);
 				return node;
 			} else if (strcmp(text, "continue") == 0) {
-				IAstNode* node = new AstNodeContinue();
+				IAstNode* node = makeNode<AstNodeContinue>();
 				setNodePosition(node, scanner, src);
 				return node;
 			}
@@ -563,12 +552,13 @@ namespace Qd {
 				}
 			}
 
-			if (isBuiltInInstruction(text)) {
-				IAstNode* node = new AstNodeInstruction(text);
+			Opcode opcode = lookupInstruction(text);
+			if (opcode != Opcode::NONE) {
+				IAstNode* node = makeNode<AstNodeInstruction>(intern(text), opcode);
 				setNodePosition(node, scanner, src);
 				return node;
 			}
-			AstNodeIdentifier* node = new AstNodeIdentifier(text);
+			AstNodeIdentifier* node = makeNode<AstNodeIdentifier>(intern(text));
 			setNodePosition(node, scanner, src);
 			// Check for '!' or '?' suffix
 			char32_t nextToken = u8t_scanner_peek(scanner);
@@ -587,10 +577,10 @@ namespace Qd {
 			if (nextToken == U8T_IDENTIFIER) {
 				size_t n2;
 				const char* functionName = u8t_scanner_token_text(scanner, &n2);
-				IAstNode* node = new AstNodeFunctionPointerReference(functionName);
+				IAstNode* node = makeNode<AstNodeFunctionPointerReference>(intern(functionName));
 				// Set position to the & token
 				size_t line, column;
-				calculateLineColumn(src, ampPos, &line, &column);
+				src.lineColumn(ampPos, &line, &column);
 				node->setPosition(line, column);
 				return node;
 			} else {
@@ -602,15 +592,10 @@ namespace Qd {
 		return parseSimpleToken(token, scanner, errorReporter, n, src);
 	}
 
-	Ast::~Ast() {
-		if (mRoot) {
-			delete mRoot;
-			mRoot = nullptr;
-		}
-	}
+	Ast::~Ast() = default;
 
-	static IAstNode* parseFunctionDeclaration(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src,
-											   bool isPublic = false) {
+	static IAstNode* parseFunctionDeclaration(
+			u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src, bool isPublic = false) {
 		char32_t token = u8t_scanner_scan(scanner);
 		if (token != U8T_IDENTIFIER) {
 			errorReporter->reportError(scanner, "Expected function name after 'fn'");
@@ -620,14 +605,13 @@ namespace Qd {
 
 		size_t n;
 		const char* name = u8t_scanner_token_text(scanner, &n);
-		AstNodeFunctionDeclaration* func = new AstNodeFunctionDeclaration(name, isPublic);
+		AstNodeFunctionDeclaration* func = makeNode<AstNodeFunctionDeclaration>(intern(name), isPublic);
 		setNodePosition(func, scanner, src);
 
 		token = u8t_scanner_scan(scanner);
 		if (token != '(') {
 			errorReporter->reportError(scanner, "Expected '(' after function name");
 			synchronize(scanner);
-			delete func;
 			return nullptr;
 		}
 
@@ -655,7 +639,8 @@ namespace Qd {
 					token = u8t_scanner_scan(scanner);
 					if (token == U8T_IDENTIFIER) {
 						const char* paramType = u8t_scanner_token_text(scanner, &n);
-						AstNodeParameter* param = new AstNodeParameter(paramNameStr, paramType, isOutput);
+						AstNodeParameter* param =
+								makeNode<AstNodeParameter>(intern(paramNameStr), intern(paramType), isOutput);
 						setNodePosition(param, scanner, src);
 						param->setParent(func);
 						if (isOutput) {
@@ -666,7 +651,7 @@ namespace Qd {
 					}
 				} else {
 					// Untyped parameter - use empty string as type
-					AstNodeParameter* param = new AstNodeParameter(paramNameStr, "", isOutput);
+					AstNodeParameter* param = makeNode<AstNodeParameter>(intern(paramNameStr), intern(""), isOutput);
 					setNodePosition(param, scanner, src);
 					param->setParent(func);
 					if (isOutput) {
@@ -688,7 +673,7 @@ namespace Qd {
 		if (token != '{') {
 			errorReporter->reportError(scanner, "Expected '{' after function signature");
 			// Recovery: create empty body and return partial function
-			AstNodeBlock* body = new AstNodeBlock();
+			AstNodeBlock* body = makeNode<AstNodeBlock>();
 			setNodePosition(body, scanner, src);
 			body->setParent(func);
 			func->setBody(body);
@@ -696,7 +681,7 @@ namespace Qd {
 			return func;
 		}
 
-		AstNodeBlock* body = new AstNodeBlock();
+		AstNodeBlock* body = makeNode<AstNodeBlock>();
 		setNodePosition(body, scanner, src);
 
 		std::vector<IAstNode*> tempNodes;
@@ -717,7 +702,7 @@ namespace Qd {
 			if (sawSlash) {
 				sawSlash = false;
 				// Add division instruction to tempNodes
-				AstNodeInstruction* divInstr = new AstNodeInstruction("/");
+				AstNodeInstruction* divInstr = makeNode<AstNodeInstruction>(intern("/"));
 				setNodePosition(divInstr, scanner, src);
 				tempNodes.push_back(divInstr);
 			}
@@ -743,9 +728,9 @@ namespace Qd {
 					token = u8t_scanner_scan(scanner);
 					if (token == U8T_IDENTIFIER) {
 						const char* memberName = u8t_scanner_token_text(scanner, &n);
-						AstNodeScopedIdentifier* scoped = new AstNodeScopedIdentifier(scope->name(), memberName);
+						AstNodeScopedIdentifier* scoped =
+								makeNode<AstNodeScopedIdentifier>(intern(scope->name()), intern(memberName));
 						setNodePosition(scoped, scanner, src);
-						delete scope;
 						// Check for '!' or '?' suffix
 						char32_t nextToken = u8t_scanner_peek(scanner);
 						if (nextToken == '!') {
@@ -780,9 +765,9 @@ namespace Qd {
 
 					// Get the field name
 					const char* fieldName = u8t_scanner_token_text(scanner, &n);
-					AstNodeFieldAccess* fieldAccess = new AstNodeFieldAccess(varIdent->name(), fieldName);
+					AstNodeFieldAccess* fieldAccess =
+							makeNode<AstNodeFieldAccess>(intern(varIdent->name()), intern(fieldName));
 					setNodePosition(fieldAccess, scanner, src);
-					delete varIdent;
 					tempNodes.push_back(fieldAccess);
 				}
 				continue;
@@ -821,7 +806,7 @@ namespace Qd {
 						body->addChild(loopStmt);
 					}
 				} else if (strcmp(text, "break") == 0) {
-					IAstNode* breakStmt = new AstNodeBreak();
+					IAstNode* breakStmt = makeNode<AstNodeBreak>();
 					setNodePosition(breakStmt, scanner, src);
 					for (auto* node : tempNodes) {
 						node->setParent(body);
@@ -832,7 +817,7 @@ namespace Qd {
 					breakStmt->setParent(body);
 					body->addChild(breakStmt);
 				} else if (strcmp(text, "continue") == 0) {
-					IAstNode* continueStmt = new AstNodeContinue();
+					IAstNode* continueStmt = makeNode<AstNodeContinue>();
 					setNodePosition(continueStmt, scanner, src);
 					for (auto* node : tempNodes) {
 						node->setParent(body);
@@ -865,7 +850,7 @@ namespace Qd {
 						if (token != '{') {
 							errorReporter->reportError(scanner, "Expected '{' after 'else'");
 						} else {
-							AstNodeBlock* elseBody = new AstNodeBlock();
+							AstNodeBlock* elseBody = makeNode<AstNodeBlock>();
 							setNodePosition(elseBody, scanner, src);
 
 							// Use the recursive helper to parse the else body
@@ -896,7 +881,7 @@ namespace Qd {
 					}
 					tempNodes.clear();
 
-					AstNodeReturn* returnStmt = new AstNodeReturn();
+					AstNodeReturn* returnStmt = makeNode<AstNodeReturn>();
 					setNodePosition(returnStmt, scanner, src);
 					returnStmt->setParent(body);
 					body->addChild(returnStmt);
@@ -907,7 +892,7 @@ namespace Qd {
 					}
 					tempNodes.clear();
 
-					AstNodeDefer* deferStmt = new AstNodeDefer();
+					AstNodeDefer* deferStmt = makeNode<AstNodeDefer>();
 					setNodePosition(deferStmt, scanner, src);
 					token = u8t_scanner_scan(scanner);
 
@@ -923,12 +908,13 @@ namespace Qd {
 
 							if (token == U8T_IDENTIFIER) {
 								const char* deferText = u8t_scanner_token_text(scanner, &n);
-								if (isBuiltInInstruction(deferText)) {
-									IAstNode* id = new AstNodeInstruction(deferText);
+								Opcode opcode = lookupInstruction(deferText);
+								if (opcode != Opcode::NONE) {
+									IAstNode* id = makeNode<AstNodeInstruction>(intern(deferText), opcode);
 									setNodePosition(id, scanner, src);
 									deferNodes.push_back(id);
 								} else {
-									AstNodeIdentifier* id = new AstNodeIdentifier(deferText);
+									AstNodeIdentifier* id = makeNode<AstNodeIdentifier>(intern(deferText));
 									setNodePosition(id, scanner, src);
 									// Check for '!' or '?' suffix
 									char32_t nextToken = u8t_scanner_peek(scanner);
@@ -944,25 +930,26 @@ namespace Qd {
 							} else if (token == U8T_INTEGER) {
 								const char* deferText = u8t_scanner_token_text(scanner, &n);
 								AstNodeLiteral* lit =
-										new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::INTEGER);
+										makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::INTEGER);
 								setNodePosition(lit, scanner, src);
 								deferNodes.push_back(lit);
 							} else if (token == U8T_FLOAT) {
 								const char* deferText = u8t_scanner_token_text(scanner, &n);
-								AstNodeLiteral* lit = new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::FLOAT);
+								AstNodeLiteral* lit =
+										makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::FLOAT);
 								setNodePosition(lit, scanner, src);
 								deferNodes.push_back(lit);
 							} else if (token == U8T_STRING) {
 								const char* deferText = u8t_scanner_token_text(scanner, &n);
 								AstNodeLiteral* lit =
-										new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::STRING);
+										makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::STRING);
 								setNodePosition(lit, scanner, src);
 								deferNodes.push_back(lit);
 							} else if (token == ':') {
 								char32_t nextChar = u8t_scanner_peek(scanner);
 								if (nextChar == ':') {
 									u8t_scanner_scan(scanner);
-									IAstNode* colonColon = new AstNodeIdentifier("::");
+									IAstNode* colonColon = makeNode<AstNodeIdentifier>(intern("::"));
 									setNodePosition(colonColon, scanner, src);
 									deferNodes.push_back(colonColon);
 								}
@@ -981,7 +968,7 @@ namespace Qd {
 									}
 								}
 
-								AstNodeInstruction* instr = new AstNodeInstruction(instrText.c_str());
+								AstNodeInstruction* instr = makeNode<AstNodeInstruction>(intern(instrText));
 								setNodePosition(instr, scanner, src);
 								deferNodes.push_back(instr);
 							}
@@ -1000,24 +987,32 @@ namespace Qd {
 						if (token == U8T_IDENTIFIER) {
 							const char* deferText = u8t_scanner_token_text(scanner, &n);
 							hasSeenOperator = true;
-							IAstNode* id = isBuiltInInstruction(deferText)
-												   ? static_cast<IAstNode*>(new AstNodeInstruction(deferText))
-												   : static_cast<IAstNode*>(new AstNodeIdentifier(deferText));
+							Symbol deferName = intern(deferText);
+							Opcode opcode = lookupInstruction(deferText);
+							IAstNode* id = nullptr;
+							if (opcode != Opcode::NONE) {
+								id = makeNode<AstNodeInstruction>(deferName, opcode);
+							} else {
+								id = makeNode<AstNodeIdentifier>(deferName);
+							}
 							setNodePosition(id, scanner, src);
 							deferNodes.push_back(id);
 						} else if (token == U8T_INTEGER) {
 							const char* deferText = u8t_scanner_token_text(scanner, &n);
-							AstNodeLiteral* lit = new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::INTEGER);
+							AstNodeLiteral* lit =
+									makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::INTEGER);
 							setNodePosition(lit, scanner, src);
 							deferNodes.push_back(lit);
 						} else if (token == U8T_FLOAT) {
 							const char* deferText = u8t_scanner_token_text(scanner, &n);
-							AstNodeLiteral* lit = new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::FLOAT);
+							AstNodeLiteral* lit =
+									makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::FLOAT);
 							setNodePosition(lit, scanner, src);
 							deferNodes.push_back(lit);
 						} else if (token == U8T_STRING) {
 							const char* deferText = u8t_scanner_token_text(scanner, &n);
-							AstNodeLiteral* lit = new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::STRING);
+							AstNodeLiteral* lit =
+									makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::STRING);
 							setNodePosition(lit, scanner, src);
 							deferNodes.push_back(lit);
 						}
@@ -1037,12 +1032,13 @@ namespace Qd {
 										strcmp(deferText, "return") == 0 || strcmp(deferText, "defer") == 0 ||
 										strcmp(deferText, "break") == 0 || strcmp(deferText, "continue") == 0 ||
 										strcmp(deferText, "ctx") == 0) {
-									if (isBuiltInInstruction(deferText)) {
-										IAstNode* id = new AstNodeInstruction(deferText);
+									Opcode opcode = lookupInstruction(deferText);
+									if (opcode != Opcode::NONE) {
+										IAstNode* id = makeNode<AstNodeInstruction>(intern(deferText), opcode);
 										setNodePosition(id, scanner, src);
 										tempNodes.push_back(id);
 									} else {
-										AstNodeIdentifier* id = new AstNodeIdentifier(deferText);
+										AstNodeIdentifier* id = makeNode<AstNodeIdentifier>(intern(deferText));
 										setNodePosition(id, scanner, src);
 										char32_t nextToken = u8t_scanner_peek(scanner);
 										if (nextToken == '!') {
@@ -1059,12 +1055,13 @@ namespace Qd {
 
 								// Mark that we've seen an operator
 								hasSeenOperator = true;
-								if (isBuiltInInstruction(deferText)) {
-									IAstNode* id = new AstNodeInstruction(deferText);
+								Opcode opcode = lookupInstruction(deferText);
+								if (opcode != Opcode::NONE) {
+									IAstNode* id = makeNode<AstNodeInstruction>(intern(deferText), opcode);
 									setNodePosition(id, scanner, src);
 									deferNodes.push_back(id);
 								} else {
-									AstNodeIdentifier* id = new AstNodeIdentifier(deferText);
+									AstNodeIdentifier* id = makeNode<AstNodeIdentifier>(intern(deferText));
 									setNodePosition(id, scanner, src);
 									char32_t nextToken = u8t_scanner_peek(scanner);
 									if (nextToken == '!') {
@@ -1081,13 +1078,14 @@ namespace Qd {
 								if (hasSeenOperator && !deferNodes.empty() &&
 										deferNodes.back()->type() == IAstNode::Type::IDENTIFIER) {
 									AstNodeLiteral* lit =
-											new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::INTEGER);
+											makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::INTEGER);
 									setNodePosition(lit, scanner, src);
 									tempNodes.push_back(lit);
 									break;
 								}
 
-								IAstNode* lit = new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::INTEGER);
+								IAstNode* lit =
+										makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::INTEGER);
 								setNodePosition(lit, scanner, src);
 								deferNodes.push_back(lit);
 							} else if (token == U8T_FLOAT) {
@@ -1096,13 +1094,13 @@ namespace Qd {
 								if (hasSeenOperator && !deferNodes.empty() &&
 										deferNodes.back()->type() == IAstNode::Type::IDENTIFIER) {
 									AstNodeLiteral* lit =
-											new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::FLOAT);
+											makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::FLOAT);
 									setNodePosition(lit, scanner, src);
 									tempNodes.push_back(lit);
 									break;
 								}
 
-								IAstNode* lit = new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::FLOAT);
+								IAstNode* lit = makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::FLOAT);
 								setNodePosition(lit, scanner, src);
 								deferNodes.push_back(lit);
 							} else if (token == U8T_STRING) {
@@ -1111,20 +1109,21 @@ namespace Qd {
 								if (hasSeenOperator && !deferNodes.empty() &&
 										deferNodes.back()->type() == IAstNode::Type::IDENTIFIER) {
 									AstNodeLiteral* lit =
-											new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::STRING);
+											makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::STRING);
 									setNodePosition(lit, scanner, src);
 									tempNodes.push_back(lit);
 									break;
 								}
 
-								IAstNode* lit = new AstNodeLiteral(deferText, AstNodeLiteral::LiteralType::STRING);
+								IAstNode* lit =
+										makeNode<AstNodeLiteral>(deferText, AstNodeLiteral::LiteralType::STRING);
 								setNodePosition(lit, scanner, src);
 								deferNodes.push_back(lit);
 							} else if (token == ':') {
 								char32_t nextChar = u8t_scanner_peek(scanner);
 								if (nextChar == ':') {
 									u8t_scanner_scan(scanner);
-									IAstNode* colonColon = new AstNodeIdentifier("::");
+									IAstNode* colonColon = makeNode<AstNodeIdentifier>(intern("::"));
 									setNodePosition(colonColon, scanner, src);
 									deferNodes.push_back(colonColon);
 								} else {
@@ -1151,14 +1150,13 @@ namespace Qd {
 					}
 					tempNodes.clear();
 
-					AstNodeCtx* ctxStmt = new AstNodeCtx();
+					AstNodeCtx* ctxStmt = makeNode<AstNodeCtx>();
 					setNodePosition(ctxStmt, scanner, src);
 					token = u8t_scanner_scan(scanner);
 
 					// ctx requires a block
 					if (token != '{') {
 						errorReporter->reportError(scanner, "Expected '{' after 'ctx'");
-						delete ctxStmt;
 					} else {
 						// Parse ctx block inline
 						// ctx blocks can contain control flow statements
@@ -1183,7 +1181,7 @@ namespace Qd {
 
 							if (ctxSawSlash) {
 								ctxSawSlash = false;
-								AstNodeInstruction* divInstr = new AstNodeInstruction("/");
+								AstNodeInstruction* divInstr = makeNode<AstNodeInstruction>(intern("/"));
 								setNodePosition(divInstr, scanner, src);
 								ctxTempNodes.push_back(divInstr);
 							}
@@ -1217,12 +1215,13 @@ namespace Qd {
 						body->addChild(ctxStmt);
 					}
 				} else {
-					if (isBuiltInInstruction(text)) {
-						IAstNode* id = new AstNodeInstruction(text);
+					Opcode opcode = lookupInstruction(text);
+					if (opcode != Opcode::NONE) {
+						IAstNode* id = makeNode<AstNodeInstruction>(intern(text), opcode);
 						setNodePosition(id, scanner, src);
 						tempNodes.push_back(id);
 					} else {
-						AstNodeIdentifier* id = new AstNodeIdentifier(text);
+						AstNodeIdentifier* id = makeNode<AstNodeIdentifier>(intern(text));
 						setNodePosition(id, scanner, src);
 						// Check for '!' or '?' suffix
 						char32_t nextToken = u8t_scanner_peek(scanner);
@@ -1238,17 +1237,17 @@ namespace Qd {
 				}
 			} else if (token == U8T_INTEGER) {
 				const char* text = u8t_scanner_token_text(scanner, &n);
-				AstNodeLiteral* lit = new AstNodeLiteral(text, AstNodeLiteral::LiteralType::INTEGER);
+				AstNodeLiteral* lit = makeNode<AstNodeLiteral>(text, AstNodeLiteral::LiteralType::INTEGER);
 				setNodePosition(lit, scanner, src);
 				tempNodes.push_back(lit);
 			} else if (token == U8T_FLOAT) {
 				const char* text = u8t_scanner_token_text(scanner, &n);
-				AstNodeLiteral* lit = new AstNodeLiteral(text, AstNodeLiteral::LiteralType::FLOAT);
+				AstNodeLiteral* lit = makeNode<AstNodeLiteral>(text, AstNodeLiteral::LiteralType::FLOAT);
 				setNodePosition(lit, scanner, src);
 				tempNodes.push_back(lit);
 			} else if (token == U8T_STRING) {
 				const char* text = u8t_scanner_token_text(scanner, &n);
-				AstNodeLiteral* lit = new AstNodeLiteral(text, AstNodeLiteral::LiteralType::STRING);
+				AstNodeLiteral* lit = makeNode<AstNodeLiteral>(text, AstNodeLiteral::LiteralType::STRING);
 				setNodePosition(lit, scanner, src);
 				tempNodes.push_back(lit);
 			}
@@ -1262,15 +1261,15 @@ namespace Qd {
 				size_t tokenStart = u8t_scanner_token_start(scanner);
 				size_t tokenLen = u8t_scanner_token_len(scanner);
 				size_t tokenEnd = tokenStart + tokenLen;
-				if (tokenEnd < strlen(src) && src[tokenEnd] == '>') {
+				if (tokenEnd < src.length() && src.source()[tokenEnd] == '>') {
 					// This is '-> variableName'
 					u8t_scanner_scan(scanner);						// Consume '>'
 					char32_t nextToken = u8t_scanner_scan(scanner); // Get variable name
 					if (nextToken == U8T_IDENTIFIER) {
 						const char* varName = u8t_scanner_token_text(scanner, &n);
-						IAstNode* node = new AstNodeLocal(std::string(varName));
+						IAstNode* node = makeNode<AstNodeLocal>(intern(varName));
 						size_t line, column;
-						calculateLineColumn(src, tokenStart, &line, &column);
+						src.lineColumn(tokenStart, &line, &column);
 						node->setPosition(line, column);
 						tempNodes.push_back(node);
 					} else {
@@ -1282,12 +1281,12 @@ namespace Qd {
 				char32_t nextToken = u8t_scanner_peek(scanner);
 				if (nextToken == '=') {
 					u8t_scanner_scan(scanner); // Consume '='
-					AstNodeInstruction* instr = new AstNodeInstruction("<=");
+					AstNodeInstruction* instr = makeNode<AstNodeInstruction>(intern("<="));
 					setNodePosition(instr, scanner, src);
 					tempNodes.push_back(instr);
 				} else {
 					// Handle '<' as alias for 'lt'
-					AstNodeInstruction* instr = new AstNodeInstruction("<");
+					AstNodeInstruction* instr = makeNode<AstNodeInstruction>(intern("<"));
 					setNodePosition(instr, scanner, src);
 					tempNodes.push_back(instr);
 				}
@@ -1296,12 +1295,12 @@ namespace Qd {
 				char32_t nextToken = u8t_scanner_peek(scanner);
 				if (nextToken == '=') {
 					u8t_scanner_scan(scanner); // Consume '='
-					AstNodeInstruction* instr = new AstNodeInstruction(">=");
+					AstNodeInstruction* instr = makeNode<AstNodeInstruction>(intern(">="));
 					setNodePosition(instr, scanner, src);
 					tempNodes.push_back(instr);
 				} else {
 					// Handle '>' as alias for 'gt'
-					AstNodeInstruction* instr = new AstNodeInstruction(">");
+					AstNodeInstruction* instr = makeNode<AstNodeInstruction>(intern(">"));
 					setNodePosition(instr, scanner, src);
 					tempNodes.push_back(instr);
 				}
@@ -1310,7 +1309,7 @@ namespace Qd {
 				char32_t nextToken = u8t_scanner_peek(scanner);
 				if (nextToken == '=') {
 					u8t_scanner_scan(scanner); // Consume '='
-					AstNodeInstruction* instr = new AstNodeInstruction("==");
+					AstNodeInstruction* instr = makeNode<AstNodeInstruction>(intern("=="));
 					setNodePosition(instr, scanner, src);
 					tempNodes.push_back(instr);
 				}
@@ -1319,18 +1318,18 @@ namespace Qd {
 				char32_t nextToken = u8t_scanner_peek(scanner);
 				if (nextToken == '=') {
 					u8t_scanner_scan(scanner); // Consume '='
-					AstNodeInstruction* instr = new AstNodeInstruction("!=");
+					AstNodeInstruction* instr = makeNode<AstNodeInstruction>(intern("!="));
 					setNodePosition(instr, scanner, src);
 					tempNodes.push_back(instr);
 				} else {
 					// Handle '!' as alias for 'not'
-					AstNodeInstruction* instr = new AstNodeInstruction("!");
+					AstNodeInstruction* instr = makeNode<AstNodeInstruction>(intern("!"));
 					setNodePosition(instr, scanner, src);
 					tempNodes.push_back(instr);
 				}
 			} else if (token == '$') {
 				// Handle '$' as for loop iterator variable
-				AstNodeIdentifier* ident = new AstNodeIdentifier("$");
+				AstNodeIdentifier* ident = makeNode<AstNodeIdentifier>(intern("$"));
 				setNodePosition(ident, scanner, src);
 				tempNodes.push_back(ident);
 			} else if (token == '&') {
@@ -1339,9 +1338,10 @@ namespace Qd {
 				char32_t nextToken = u8t_scanner_scan(scanner);
 				if (nextToken == U8T_IDENTIFIER) {
 					const char* functionName = u8t_scanner_token_text(scanner, &n);
-					AstNodeFunctionPointerReference* funcPtr = new AstNodeFunctionPointerReference(functionName);
+					AstNodeFunctionPointerReference* funcPtr =
+							makeNode<AstNodeFunctionPointerReference>(intern(functionName));
 					size_t line, column;
-					calculateLineColumn(src, ampPos, &line, &column);
+					src.lineColumn(ampPos, &line, &column);
 					funcPtr->setPosition(line, column);
 					tempNodes.push_back(funcPtr);
 				} else {
@@ -1361,7 +1361,7 @@ namespace Qd {
 		return func;
 	}
 
-	static IAstNode* parseStructDeclaration(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src,
+	static IAstNode* parseStructDeclaration(u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src,
 											 bool isPublic = false) {
 		size_t n;
 		char32_t token = u8t_scanner_scan(scanner);
@@ -1372,14 +1372,13 @@ namespace Qd {
 		}
 
 		const char* name = u8t_scanner_token_text(scanner, &n);
-		AstNodeStructDeclaration* structDecl = new AstNodeStructDeclaration(name, isPublic);
+		AstNodeStructDeclaration* structDecl = makeNode<AstNodeStructDeclaration>(intern(name), isPublic);
 		setNodePosition(structDecl, scanner, src);
 
 		token = u8t_scanner_scan(scanner);
 		if (token != '{') {
 			errorReporter->reportError(scanner, "Expected '{' after struct name");
 			synchronize(scanner);
-			delete structDecl;
 			return nullptr;
 		}
 
@@ -1424,7 +1423,7 @@ namespace Qd {
 					fieldType = typeName;
 				}
 
-				AstNodeStructField* field = new AstNodeStructField(fieldNameStr, fieldType);
+				AstNodeStructField* field = makeNode<AstNodeStructField>(intern(fieldNameStr), intern(fieldType));
 				setNodePosition(field, scanner, src);
 				field->setParent(structDecl);
 				structDecl->addField(field);
@@ -1434,15 +1433,15 @@ namespace Qd {
 		return structDecl;
 	}
 
-	static IAstNode* parseForStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src) {
+	static IAstNode* parseForStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src) {
 		char32_t token = u8t_scanner_scan(scanner);
 
 		if (token != '{') {
 			errorReporter->reportError(scanner, "Expected '{' after 'for'");
 			// Recovery: create empty for statement and synchronize
-			AstNodeForStatement* forStmt = new AstNodeForStatement();
+			AstNodeForStatement* forStmt = makeNode<AstNodeForStatement>();
 			setNodePosition(forStmt, scanner, src);
-			AstNodeBlock* body = new AstNodeBlock();
+			AstNodeBlock* body = makeNode<AstNodeBlock>();
 			setNodePosition(body, scanner, src);
 			body->setParent(forStmt);
 			forStmt->setBody(body);
@@ -1450,9 +1449,9 @@ namespace Qd {
 			return forStmt;
 		}
 
-		AstNodeForStatement* forStmt = new AstNodeForStatement();
+		AstNodeForStatement* forStmt = makeNode<AstNodeForStatement>();
 		setNodePosition(forStmt, scanner, src);
-		AstNodeBlock* body = new AstNodeBlock();
+		AstNodeBlock* body = makeNode<AstNodeBlock>();
 		setNodePosition(body, scanner, src);
 
 		parseBlockBody(body, scanner, errorReporter, src);
@@ -1463,15 +1462,15 @@ namespace Qd {
 		return forStmt;
 	}
 
-	static IAstNode* parseLoopStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src) {
+	static IAstNode* parseLoopStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src) {
 		char32_t token = u8t_scanner_scan(scanner);
 
 		if (token != '{') {
 			errorReporter->reportError(scanner, "Expected '{' after 'loop'");
 			// Recovery: create empty loop statement and synchronize
-			AstNodeLoopStatement* loopStmt = new AstNodeLoopStatement();
+			AstNodeLoopStatement* loopStmt = makeNode<AstNodeLoopStatement>();
 			setNodePosition(loopStmt, scanner, src);
-			AstNodeBlock* body = new AstNodeBlock();
+			AstNodeBlock* body = makeNode<AstNodeBlock>();
 			setNodePosition(body, scanner, src);
 			body->setParent(loopStmt);
 			loopStmt->setBody(body);
@@ -1479,9 +1478,9 @@ namespace Qd {
 			return loopStmt;
 		}
 
-		AstNodeLoopStatement* loopStmt = new AstNodeLoopStatement();
+		AstNodeLoopStatement* loopStmt = makeNode<AstNodeLoopStatement>();
 		setNodePosition(loopStmt, scanner, src);
-		AstNodeBlock* body = new AstNodeBlock();
+		AstNodeBlock* body = makeNode<AstNodeBlock>();
 		setNodePosition(body, scanner, src);
 
 		parseBlockBody(body, scanner, errorReporter, src);
@@ -1492,15 +1491,15 @@ namespace Qd {
 		return loopStmt;
 	}
 
-	static IAstNode* parseIfStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src) {
+	static IAstNode* parseIfStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src) {
 		char32_t token = u8t_scanner_scan(scanner);
 
 		if (token != '{') {
 			errorReporter->reportError(scanner, "Expected '{' after 'if'");
 			// Recovery: create empty if statement and synchronize
-			AstNodeIfStatement* ifStmt = new AstNodeIfStatement();
+			AstNodeIfStatement* ifStmt = makeNode<AstNodeIfStatement>();
 			setNodePosition(ifStmt, scanner, src);
-			AstNodeBlock* thenBody = new AstNodeBlock();
+			AstNodeBlock* thenBody = makeNode<AstNodeBlock>();
 			setNodePosition(thenBody, scanner, src);
 			thenBody->setParent(ifStmt);
 			ifStmt->setThenBody(thenBody);
@@ -1508,9 +1507,9 @@ namespace Qd {
 			return ifStmt;
 		}
 
-		AstNodeIfStatement* ifStmt = new AstNodeIfStatement();
+		AstNodeIfStatement* ifStmt = makeNode<AstNodeIfStatement>();
 		setNodePosition(ifStmt, scanner, src);
-		AstNodeBlock* thenBody = new AstNodeBlock();
+		AstNodeBlock* thenBody = makeNode<AstNodeBlock>();
 		setNodePosition(thenBody, scanner, src);
 
 		// Use parseBlockBody to handle nested else clauses properly
@@ -1522,20 +1521,20 @@ namespace Qd {
 		return ifStmt;
 	}
 
-	static IAstNode* parseSwitchStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const char* src) {
+	static IAstNode* parseSwitchStatement(u8t_scanner* scanner, ErrorReporter* errorReporter, const SourceIndex& src) {
 		size_t n;
 		char32_t token = u8t_scanner_scan(scanner);
 
 		if (token != '{') {
 			errorReporter->reportError(scanner, "Expected '{' after 'switch'");
 			// Recovery: create empty switch statement and synchronize
-			AstNodeSwitchStatement* switchStmt = new AstNodeSwitchStatement();
+			AstNodeSwitchStatement* switchStmt = makeNode<AstNodeSwitchStatement>();
 			setNodePosition(switchStmt, scanner, src);
 			synchronize(scanner);
 			return switchStmt;
 		}
 
-		AstNodeSwitchStatement* switchStmt = new AstNodeSwitchStatement();
+		AstNodeSwitchStatement* switchStmt = makeNode<AstNodeSwitchStatement>();
 		setNodePosition(switchStmt, scanner, src);
 
 		while ((token = u8t_scanner_scan(scanner)) != U8T_EOF) {
@@ -1554,7 +1553,7 @@ namespace Qd {
 						continue;
 					}
 
-					AstNodeBlock* defaultBody = new AstNodeBlock();
+					AstNodeBlock* defaultBody = makeNode<AstNodeBlock>();
 					setNodePosition(defaultBody, scanner, src);
 					while ((token = u8t_scanner_scan(scanner)) != U8T_EOF) {
 						if (token == '}') {
@@ -1568,7 +1567,7 @@ namespace Qd {
 						}
 					}
 
-					AstNodeCase* defaultCase = new AstNodeCase(nullptr, true);
+					AstNodeCase* defaultCase = makeNode<AstNodeCase>(nullptr, true);
 					setNodePosition(defaultCase, scanner, src);
 					defaultBody->setParent(defaultCase);
 					defaultCase->setBody(defaultBody);
@@ -1582,15 +1581,15 @@ namespace Qd {
 			IAstNode* caseValue = nullptr;
 			if (token == U8T_INTEGER) {
 				const char* valueText = u8t_scanner_token_text(scanner, &n);
-				caseValue = new AstNodeLiteral(valueText, AstNodeLiteral::LiteralType::INTEGER);
+				caseValue = makeNode<AstNodeLiteral>(valueText, AstNodeLiteral::LiteralType::INTEGER);
 				setNodePosition(caseValue, scanner, src);
 			} else if (token == U8T_FLOAT) {
 				const char* valueText = u8t_scanner_token_text(scanner, &n);
-				caseValue = new AstNodeLiteral(valueText, AstNodeLiteral::LiteralType::FLOAT);
+				caseValue = makeNode<AstNodeLiteral>(valueText, AstNodeLiteral::LiteralType::FLOAT);
 				setNodePosition(caseValue, scanner, src);
 			} else if (token == U8T_STRING) {
 				const char* valueText = u8t_scanner_token_text(scanner, &n);
-				caseValue = new AstNodeLiteral(valueText, AstNodeLiteral::LiteralType::STRING);
+				caseValue = makeNode<AstNodeLiteral>(valueText, AstNodeLiteral::LiteralType::STRING);
 				setNodePosition(caseValue, scanner, src);
 			} else if (token == U8T_IDENTIFIER) {
 				const char* valueText = u8t_scanner_token_text(scanner, &n);
@@ -1604,14 +1603,17 @@ namespace Qd {
 						char32_t nameToken = u8t_scanner_scan(scanner);
 						if (nameToken == U8T_IDENTIFIER) {
 							const char* nameText = u8t_scanner_token_text(scanner, &n);
-							caseValue = new AstNodeScopedIdentifier(valueText, nameText);
+							caseValue = makeNode<AstNodeScopedIdentifier>(intern(valueText), intern(nameText));
 							setNodePosition(caseValue, scanner, src);
 						}
 					}
 				} else {
-					caseValue = isBuiltInInstruction(valueText)
-										? static_cast<IAstNode*>(new AstNodeInstruction(valueText))
-										: static_cast<IAstNode*>(new AstNodeIdentifier(valueText));
+					Opcode opcode = lookupInstruction(valueText);
+					if (opcode != Opcode::NONE) {
+						caseValue = makeNode<AstNodeInstruction>(intern(valueText), opcode);
+					} else {
+						caseValue = makeNode<AstNodeIdentifier>(intern(valueText));
+					}
 					setNodePosition(caseValue, scanner, src);
 				}
 			}
@@ -1624,11 +1626,10 @@ namespace Qd {
 			token = u8t_scanner_scan(scanner);
 			if (token != '{') {
 				errorReporter->reportError(scanner, "Expected '{' after case value");
-				delete caseValue;
 				continue;
 			}
 
-			AstNodeBlock* caseBody = new AstNodeBlock();
+			AstNodeBlock* caseBody = makeNode<AstNodeBlock>();
 			setNodePosition(caseBody, scanner, src);
 			while ((token = u8t_scanner_scan(scanner)) != U8T_EOF) {
 				if (token == '}') {
@@ -1642,7 +1643,7 @@ namespace Qd {
 				}
 			}
 
-			AstNodeCase* caseNode = new AstNodeCase(caseValue, false);
+			AstNodeCase* caseNode = makeNode<AstNodeCase>(caseValue, false);
 			setNodePosition(caseNode, scanner, src);
 			caseBody->setParent(caseNode);
 			caseNode->setBody(caseBody);
@@ -1696,12 +1697,14 @@ namespace Qd {
 
 		ErrorReporter errorReporter(src, filename);
 		errorReporter.setStoreErrors(true);
+		const SourceIndex& index = errorReporter.sourceIndex();
 
-		if (mRoot) {
-			delete mRoot;
-		}
-		AstProgram* program = new AstProgram();
-		setNodePosition(program, &scanner, src);
+		// Nodes of a previous generate() are released together
+		mArena.reset();
+		ArenaScope arenaScope(&mArena);
+
+		AstProgram* program = makeNode<AstProgram>();
+		setNodePosition(program, &scanner, index);
 		mRoot = program;
 
 		char32_t token;
@@ -1710,7 +1713,7 @@ namespace Qd {
 			size_t n;
 
 			// Handle comments (// and /* */)
-			AstNodeComment* comment = parseComment(&scanner, src, sawSlash, token);
+			AstNodeComment* comment = parseComment(&scanner, index, sawSlash, token);
 			if (comment != nullptr) {
 				sawSlash = false;
 				comment->setParent(program);
@@ -1738,13 +1741,13 @@ namespace Qd {
 					if (token == U8T_IDENTIFIER) {
 						const char* nextText = u8t_scanner_token_text(&scanner, &n);
 						if (strcmp(nextText, "fn") == 0) {
-							IAstNode* func = parseFunctionDeclaration(&scanner, &errorReporter, src, true);
+							IAstNode* func = parseFunctionDeclaration(&scanner, &errorReporter, index, true);
 							if (func) {
 								func->setParent(program);
 								program->addChild(func);
 							}
 						} else if (strcmp(nextText, "struct") == 0) {
-							IAstNode* structDecl = parseStructDeclaration(&scanner, &errorReporter, src, true);
+							IAstNode* structDecl = parseStructDeclaration(&scanner, &errorReporter, index, true);
 							if (structDecl) {
 								structDecl->setParent(program);
 								program->addChild(structDecl);
@@ -1761,21 +1764,23 @@ namespace Qd {
 									AstNodeLiteral* value = nullptr;
 									if (token == U8T_INTEGER) {
 										const char* valueText = u8t_scanner_token_text(&scanner, &n);
-										value = new AstNodeLiteral(valueText, AstNodeLiteral::LiteralType::INTEGER);
-										setNodePosition(value, &scanner, src);
+										value = makeNode<AstNodeLiteral>(
+												valueText, AstNodeLiteral::LiteralType::INTEGER);
+										setNodePosition(value, &scanner, index);
 									} else if (token == U8T_FLOAT) {
 										const char* valueText = u8t_scanner_token_text(&scanner, &n);
-										value = new AstNodeLiteral(valueText, AstNodeLiteral::LiteralType::FLOAT);
-										setNodePosition(value, &scanner, src);
+										value = makeNode<AstNodeLiteral>(valueText, AstNodeLiteral::LiteralType::FLOAT);
+										setNodePosition(value, &scanner, index);
 									} else if (token == U8T_STRING) {
 										const char* valueText = u8t_scanner_token_text(&scanner, &n);
-										value = new AstNodeLiteral(valueText, AstNodeLiteral::LiteralType::STRING);
-										setNodePosition(value, &scanner, src);
+										value = makeNode<AstNodeLiteral>(
+												valueText, AstNodeLiteral::LiteralType::STRING);
+										setNodePosition(value, &scanner, index);
 									}
 									if (value) {
-										AstNodeConstant* constDecl = new AstNodeConstant(constNameStr, value->value().c_str(), true);
-										setNodePosition(constDecl, &scanner, src);
-										delete value; // Value is copied, no longer needed
+										AstNodeConstant* constDecl = makeNode<AstNodeConstant>(
+												intern(constNameStr), value->value().c_str(), true);
+										setNodePosition(constDecl, &scanner, index);
 										constDecl->setParent(program);
 										program->addChild(constDecl);
 									}
@@ -1793,13 +1798,13 @@ namespace Qd {
 						synchronize(&scanner);
 					}
 				} else if (strcmp(text, "fn") == 0) {
-					IAstNode* func = parseFunctionDeclaration(&scanner, &errorReporter, src, false);
+					IAstNode* func = parseFunctionDeclaration(&scanner, &errorReporter, index, false);
 					if (func) {
 						func->setParent(program);
 						program->addChild(func);
 					}
 				} else if (strcmp(text, "struct") == 0) {
-					IAstNode* structDecl = parseStructDeclaration(&scanner, &errorReporter, src, false);
+					IAstNode* structDecl = parseStructDeclaration(&scanner, &errorReporter, index, false);
 					if (structDecl) {
 						structDecl->setParent(program);
 						program->addChild(structDecl);
@@ -1843,8 +1848,8 @@ namespace Qd {
 					}
 
 					if (!moduleNameStr.empty()) {
-						AstNodeUse* useStmt = new AstNodeUse(moduleNameStr.c_str());
-						setNodePosition(useStmt, &scanner, src);
+						AstNodeUse* useStmt = makeNode<AstNodeUse>(intern(moduleNameStr));
+						setNodePosition(useStmt, &scanner, index);
 						useStmt->setParent(program);
 						program->addChild(useStmt);
 					}
@@ -1894,8 +1899,8 @@ namespace Qd {
 						break;
 					}
 
-					AstNodeImport* importStmt = new AstNodeImport(library, namespaceName);
-					setNodePosition(importStmt, &scanner, src);
+					AstNodeImport* importStmt = makeNode<AstNodeImport>(library, namespaceName);
+					setNodePosition(importStmt, &scanner, index);
 
 					// Parse function declarations
 					while (true) {
@@ -1918,7 +1923,7 @@ namespace Qd {
 
 								size_t funcLine, funcColumn;
 								size_t pos = u8t_scanner_token_start(&scanner);
-								calculateLineColumn(src, pos, &funcLine, &funcColumn);
+								index.lineColumn(pos, &funcLine, &funcColumn);
 								func->line = funcLine;
 								func->column = funcColumn;
 
@@ -1957,8 +1962,8 @@ namespace Qd {
 															const char* paramType =
 																	u8t_scanner_token_text(&scanner, &n);
 															std::string paramTypeStr(paramType);
-															AstNodeParameter* param = new AstNodeParameter(
-																	paramNameStr, paramTypeStr, true);
+															AstNodeParameter* param = makeNode<AstNodeParameter>(
+																	intern(paramNameStr), intern(paramTypeStr), true);
 															func->outputParameters.push_back(param);
 														}
 													}
@@ -1980,8 +1985,8 @@ namespace Qd {
 											if (token == U8T_IDENTIFIER) {
 												const char* paramType = u8t_scanner_token_text(&scanner, &n);
 												std::string paramTypeStr(paramType);
-												AstNodeParameter* param =
-														new AstNodeParameter(paramNameStr, paramTypeStr, false);
+												AstNodeParameter* param = makeNode<AstNodeParameter>(
+														intern(paramNameStr), intern(paramTypeStr), false);
 												func->inputParameters.push_back(param);
 											}
 										}
@@ -2016,21 +2021,21 @@ namespace Qd {
 							AstNodeLiteral* value = nullptr;
 							if (token == U8T_INTEGER) {
 								const char* valueText = u8t_scanner_token_text(&scanner, &n);
-								value = new AstNodeLiteral(valueText, AstNodeLiteral::LiteralType::INTEGER);
-								setNodePosition(value, &scanner, src);
+								value = makeNode<AstNodeLiteral>(valueText, AstNodeLiteral::LiteralType::INTEGER);
+								setNodePosition(value, &scanner, index);
 							} else if (token == U8T_FLOAT) {
 								const char* valueText = u8t_scanner_token_text(&scanner, &n);
-								value = new AstNodeLiteral(valueText, AstNodeLiteral::LiteralType::FLOAT);
-								setNodePosition(value, &scanner, src);
+								value = makeNode<AstNodeLiteral>(valueText, AstNodeLiteral::LiteralType::FLOAT);
+								setNodePosition(value, &scanner, index);
 							} else if (token == U8T_STRING) {
 								const char* valueText = u8t_scanner_token_text(&scanner, &n);
-								value = new AstNodeLiteral(valueText, AstNodeLiteral::LiteralType::STRING);
-								setNodePosition(value, &scanner, src);
+								value = makeNode<AstNodeLiteral>(valueText, AstNodeLiteral::LiteralType::STRING);
+								setNodePosition(value, &scanner, index);
 							}
 							if (value) {
-								AstNodeConstant* constDecl = new AstNodeConstant(constNameStr, value->value().c_str());
-								setNodePosition(constDecl, &scanner, src);
-								delete value; // Value is copied, no longer needed
+								AstNodeConstant* constDecl =
+										makeNode<AstNodeConstant>(intern(constNameStr), value->value().c_str());
+								setNodePosition(constDecl, &scanner, index);
 								constDecl->setParent(program);
 								program->addChild(constDecl);
 							}
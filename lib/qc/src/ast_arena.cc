@@ -0,0 +1,47 @@
+#include <qc/ast_arena.h>
+
+namespace Qd {
+
+	static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+	AstArena::~AstArena() {
+		destroyNodes();
+	}
+
+	Symbol AstArena::intern(const std::string& string) {
+		return Symbol(&*mSymbols.insert(string).first);
+	}
+
+	void AstArena::reset() {
+		destroyNodes();
+		mSymbols.clear();
+		if (mBlocks.size() > 1) {
+			mBlocks.resize(1);
+		}
+		mUsed = 0;
+	}
+
+	void AstArena::destroyNodes() {
+		// Nodes only reference each other, so the order doesn't matter
+		for (IAstNode* node : mNodes) {
+			node->~IAstNode();
+		}
+		mNodes.clear();
+	}
+
+	void* AstArena::allocate(size_t size, size_t alignment) {
+		if (!mBlocks.empty()) {
+			size_t offset = (mUsed + alignment - 1) & ~(alignment - 1);
+			if (offset + size <= mBlocks.back().size) {
+				mUsed = offset + size;
+				return mBlocks.back().data.get() + offset;
+			}
+		}
+
+		size_t blockSize = size > BLOCK_SIZE ? size : BLOCK_SIZE;
+		mBlocks.push_back(Block{std::unique_ptr<char[]>(new char[blockSize]), blockSize});
+		mUsed = size;
+		return mBlocks.back().data.get();
+	}
+
+} // namespace Qd
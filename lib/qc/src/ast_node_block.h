@@ -7,12 +7,6 @@
 namespace Qd {
 	class AstNodeBlock : public IAstNode {
 	public:
-		~AstNodeBlock() {
-			for (auto* child : mChildren) {
-				delete child;
-			}
-		}
-
 		IAstNode::Type type() const override {
 			return Type::BLOCK;
 		}
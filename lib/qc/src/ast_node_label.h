@@ -2,12 +2,13 @@
 #define QD_QC_AST_NODE_LABEL_H
 
 #include <qc/ast_node.h>
+#include <qc/symbol.h>
 #include <string>
 
 namespace Qd {
 	class AstNodeLabel : public IAstNode {
 	public:
-		AstNodeLabel(const std::string& name) : mName(name), mParent(nullptr), mLine(0), mColumn(0) {
+		AstNodeLabel(Symbol name) : mName(name), mParent(nullptr), mLine(0), mColumn(0) {
 		}
 
 		IAstNode::Type type() const override {
@@ -48,7 +49,7 @@ namespace Qd {
 		}
 
 	private:
-		std::string mName;
+		Symbol mName;
 		IAstNode* mParent;
 		size_t mLine;
 		size_t mColumn;
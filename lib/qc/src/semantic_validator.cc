@@ -159,7 +159,8 @@ namespace Qd {
 		return StackValueType::INT;
 	}
 	SemanticValidator::SemanticValidator()
-		: mFilename(nullptr), mErrorCount(0), mWarningCount(0), mWerror(false), mIsModuleFile(false), mStoreErrors(false) {
+		: mFilename(nullptr), mTypeStackExact(false), mErrorCount(0), mWarningCount(0), mWerror(false),
+		  mIsModuleFile(false), mStoreErrors(false) {
 	}
 
 	bool SemanticValidator::isBuiltInInstruction(const char* name) const {
@@ -188,14 +189,9 @@ namespace Qd {
 			err.column = 0;
 			err.message = message;
 			mStoredErrors.push_back(err);
+			mStoredOrder.push_back(false);
 		} else {
-			// GCC/Clang style: quadc: filename: error: message
-			std::cerr << Colors::bold() << "quadc: " << Colors::reset();
-			if (mFilename) {
-				std::cerr << Colors::bold() << mFilename << ":" << Colors::reset() << " ";
-			}
-			std::cerr << Colors::bold() << Colors::red() << "error:" << Colors::reset() << " ";
-			std::cerr << Colors::bold() << message << Colors::reset() << std::endl;
+			printDiagnostic(0, 0, false, message);
 		}
 	}
 
@@ -212,17 +208,9 @@ namespace Qd {
 			err.column = node ? node->column() : 0;
 			err.message = message;
 			mStoredErrors.push_back(err);
+			mStoredOrder.push_back(false);
 		} else {
-			// GCC/Clang style: quadc: filename:line:column: error: message
-			std::cerr << Colors::bold() << "quadc: " << Colors::reset();
-			if (mFilename && node) {
-				std::cerr << Colors::bold() << mFilename << ":" << node->line() << ":" << node->column() << ":"
-						  << Colors::reset() << " ";
-			} else if (mFilename) {
-				std::cerr << Colors::bold() << mFilename << ":" << Colors::reset() << " ";
-			}
-			std::cerr << Colors::bold() << Colors::red() << "error:" << Colors::reset() << " ";
-			std::cerr << Colors::bold() << message << Colors::reset() << std::endl;
+			printDiagnostic(node ? node->line() : 0, node ? node->column() : 0, false, message);
 		}
 	}
 
@@ -233,17 +221,43 @@ namespace Qd {
 			return;
 		}
 
-		// GCC/Clang style: quadc: filename:line:column: warning: message
+		mWarningCount++;
+
+		if (mStoreErrors) {
+			ErrorInfo warning;
+			warning.line = node ? node->line() : 0;
+			warning.column = node ? node->column() : 0;
+			warning.message = message;
+			mStoredWarnings.push_back(warning);
+			mStoredOrder.push_back(true);
+		} else {
+			printDiagnostic(node ? node->line() : 0, node ? node->column() : 0, true, message);
+		}
+	}
+
+	void SemanticValidator::printDiagnostic(size_t line, size_t column, bool warning, const std::string& message) const {
+		// GCC/Clang style: quadc: filename:line:column: error: message
 		std::cerr << Colors::bold() << "quadc: " << Colors::reset();
-		if (mFilename && node) {
-			std::cerr << Colors::bold() << mFilename << ":" << node->line() << ":" << node->column() << ":"
-					  << Colors::reset() << " ";
+		if (mFilename && line > 0) {
+			std::cerr << Colors::bold() << mFilename << ":" << line << ":" << column << ":" << Colors::reset() << " ";
 		} else if (mFilename) {
 			std::cerr << Colors::bold() << mFilename << ":" << Colors::reset() << " ";
 		}
-		std::cerr << Colors::bold() << Colors::magenta() << "warning:" << Colors::reset() << " ";
+		if (warning) {
+			std::cerr << Colors::bold() << Colors::magenta() << "warning:" << Colors::reset() << " ";
+		} else {
+			std::cerr << Colors::bold() << Colors::red() << "error:" << Colors::reset() << " ";
+		}
 		std::cerr << Colors::bold() << message << Colors::reset() << std::endl;
-		mWarningCount++;
+	}
+
+	void SemanticValidator::printStoredDiagnostics() const {
+		size_t nextError = 0;
+		size_t nextWarning = 0;
+		for (bool warning : mStoredOrder) {
+			const ErrorInfo& info = warning ? mStoredWarnings[nextWarning++] : mStoredErrors[nextError++];
+			printDiagnostic(info.line, info.column, warning, info.message);
+		}
 	}
 
 	size_t SemanticValidator::validate(IAstNode* program, const char* filename, bool isModuleFile, bool werror) {
@@ -1506,6 +1520,7 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			}
 
 			// Analyze the function body in isolation (without resolving function calls)
+			mTypeStackExact = true;
 			if (func->body()) {
 				analyzeBlockInIsolation(func->body(), typeStack);
 			}
@@ -1559,6 +1574,7 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 
 			sig.produces = typeStack;
 			sig.throws = func->throws();
+			sig.exact = mTypeStackExact;
 			mFunctionSignatures[func->name()] = sig;
 		}
 
@@ -1677,7 +1693,7 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			case IAstNode::Type::INSTRUCTION: {
 				AstNodeInstruction* instr = static_cast<AstNodeInstruction*>(child);
 				// During signature analysis, don't report errors - just simulate the stack
-				typeCheckInstructionInternal(child, instr->name().c_str(), typeStack, false);
+				typeCheckInstructionInternal(child, instr->opcode(), typeStack, false);
 				break;
 			}
 
@@ -1691,6 +1707,10 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 				// Apply function signature if known (for iterative analysis)
 				AstNodeIdentifier* ident = static_cast<AstNodeIdentifier*>(child);
 				const std::string& name = ident->name();
+				// Only constants are modeled exactly here: calls don't consume their inputs and locals aren't tracked
+				if (mFunctionSignatures.count(name) || !mConstantValues.count(name)) {
+					mTypeStackExact = false;
+				}
 			auto sigIt = mFunctionSignatures.find(name);
 			if (sigIt != mFunctionSignatures.end()) {
 				// Apply the known signature
@@ -1751,6 +1771,7 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			const std::string& fieldName = fieldAccess->fieldName();
 
 			StackValueType fieldType = StackValueType::UNKNOWN;
+			mTypeStackExact = false; // The first struct with such a field is a guess
 			// Search in local structs
 			for (const auto& structEntry : mStructFieldTypes) {
 				const auto& fields = structEntry.second;
@@ -1775,6 +1796,7 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 				const std::string& moduleName = scoped->scope();
 				const std::string& functionName = scoped->name();
 				std::string qualifiedName = moduleName + "::" + functionName;
+				mTypeStackExact = false;
 
 				auto sigIt = mFunctionSignatures.find(qualifiedName);
 				if (sigIt != mFunctionSignatures.end()) {
@@ -1793,8 +1815,12 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 				typeStack.push_back(StackValueType::PTR);
 				break;
 
+			case IAstNode::Type::COMMENT:
+				break;
+
 			default:
-				// Other node types don't affect the type stack during signature analysis
+				// Other node types (locals, control flow, ...) aren't simulated here
+				mTypeStackExact = false;
 				break;
 			}
 		}
@@ -1837,6 +1863,7 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			}
 
 			// Type check the function body
+			mTypeStackExact = true;
 			if (func->body()) {
 				typeCheckBlock(func->body(), typeStack, localVariables);
 			}
@@ -1887,7 +1914,7 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 
 			case IAstNode::Type::INSTRUCTION: {
 				AstNodeInstruction* instr = static_cast<AstNodeInstruction*>(child);
-				typeCheckInstruction(child, instr->name().c_str(), typeStack);
+				typeCheckInstruction(child, instr->opcode(), typeStack);
 				// TODO: Track struct types through stack operations (dup, swap, etc.)
 				// For now, assume instructions don't preserve struct type info
 				break;
@@ -1902,12 +1929,14 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			case IAstNode::Type::IF_STATEMENT: {
 				// For now, skip control flow type checking
 				// (more complex - would need to merge type states from branches)
+				mTypeStackExact = false;
 				break;
 			}
 
 			case IAstNode::Type::FOR_STATEMENT:
 			case IAstNode::Type::LOOP_STATEMENT: {
 				// For now, skip loop type checking
+				mTypeStackExact = false;
 				break;
 			}
 
@@ -1917,6 +1946,7 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 				// The runtime enforces the single-value constraint anyway
 				// Just push a generic type to the parent stack
 				typeStack.push_back(StackValueType::INT);
+				mTypeStackExact = false; // The result's type is a guess
 				break;
 			}
 
@@ -2245,6 +2275,9 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 					// Track which parameters need casts
 					std::vector<CastDirection> paramCasts(sig.consumes.size(), CastDirection::NONE);
 
+					// Depth is known here; types are proven unless a slot can't be determined
+					bool typesProven = true;
+
 					// Check if the types match
 					for (size_t j = 0; j < sig.consumes.size(); j++) {
 						size_t stackIdx = typeStack.size() - sig.consumes.size() + j;
@@ -2253,11 +2286,16 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 
 						// Skip check if expected type is ANY or UNKNOWN
 						if (expected == StackValueType::ANY || expected == StackValueType::UNKNOWN) {
+							if (expected == StackValueType::UNKNOWN || actual == StackValueType::UNKNOWN ||
+									actual == StackValueType::TAINTED) {
+								typesProven = false;
+							}
 							continue;
 						}
 
 						// Skip check if actual type is UNKNOWN (can't determine type)
 						if (actual == StackValueType::UNKNOWN) {
+							typesProven = false;
 							continue;
 						}
 
@@ -2297,12 +2335,14 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 								errorMsg += ", but got ";
 								errorMsg += stackValueTypeToString(actual);
 								reportError(ident, errorMsg.c_str());
+								typesProven = false;
 							}
 						}
 					}
 
 					// Store cast information in the identifier node
 					ident->setParameterCasts(paramCasts);
+					ident->setTypesProven(typesProven && mTypeStackExact);
 
 					// Validate struct field requirements for PTR parameters
 					if (!sig.parameterFieldAccess.empty()) {
@@ -2413,6 +2453,9 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 							structTypeStack.push_back(""); // TODO: Track struct types through function calls
 						}
 					}
+					mTypeStackExact = mTypeStackExact && sig.exact;
+				} else {
+					mTypeStackExact = false;
 				}
 				// If it's not a user function, it must be a built-in (already validated in pass 2)
 				// Built-ins are handled as Instructions, not Identifiers in the AST
@@ -2695,6 +2738,9 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 					// Track which parameters need casts
 					std::vector<CastDirection> paramCasts(sig.consumes.size(), CastDirection::NONE);
 
+					// Depth is known here; types are proven unless a slot can't be determined
+					bool typesProven = true;
+
 					// Check if the types match
 					for (size_t j = 0; j < sig.consumes.size(); j++) {
 						size_t stackIdx = typeStack.size() - sig.consumes.size() + j;
@@ -2703,11 +2749,16 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 
 						// Skip check if expected type is ANY or UNKNOWN
 						if (expected == StackValueType::ANY || expected == StackValueType::UNKNOWN) {
+							if (expected == StackValueType::UNKNOWN || actual == StackValueType::UNKNOWN ||
+									actual == StackValueType::TAINTED) {
+								typesProven = false;
+							}
 							continue;
 						}
 
 						// Skip check if actual type is UNKNOWN (can't determine type)
 						if (actual == StackValueType::UNKNOWN) {
+							typesProven = false;
 							continue;
 						}
 
@@ -2747,12 +2798,14 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 								errorMsg += ", but got ";
 								errorMsg += stackValueTypeToString(actual);
 								reportError(scoped, errorMsg.c_str());
+								typesProven = false;
 							}
 						}
 					}
 
 					// Store cast information in the scoped identifier node
 					scoped->setParameterCasts(paramCasts);
+					scoped->setTypesProven(typesProven && mTypeStackExact);
 
 					// Consume the parameters from the stack
 					for (size_t j = 0; j < sig.consumes.size(); j++) {
@@ -2787,6 +2840,9 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 							structTypeStack.push_back(""); // TODO: Track struct types through function calls
 						}
 					}
+					mTypeStackExact = mTypeStackExact && sig.exact;
+				} else {
+					mTypeStackExact = false;
 				}
 				// If signature not found, module wasn't loaded or analyzed
 				// This was already checked in validation pass, so we can skip silently
@@ -2798,39 +2854,77 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 				typeStack.push_back(StackValueType::PTR);
 				break;
 
+			case IAstNode::Type::COMMENT:
+				break;
+
 			default:
-				// Other node types don't affect the type stack
+				// Other node types aren't modeled
+				mTypeStackExact = false;
 				break;
 			}
 		}
 	}
 
 	void SemanticValidator::typeCheckInstruction(
-			IAstNode* node, const char* name, std::vector<StackValueType>& typeStack) {
-		typeCheckInstructionInternal(node, name, typeStack, true);
+			IAstNode* node, Opcode opcode, std::vector<StackValueType>& typeStack) {
+		typeCheckInstructionInternal(node, opcode, typeStack, true);
 	}
 
 	void SemanticValidator::typeCheckInstructionInternal(
-			IAstNode* node, const char* name, std::vector<StackValueType>& typeStack, bool reportErrors) {
+			IAstNode* node, Opcode opcode, std::vector<StackValueType>& typeStack, bool reportErrors) {
 		// Handle instruction aliases
-		if (strcmp(name, ".") == 0) {
-			name = "print";
-		} else if (strcmp(name, "/") == 0) {
-			name = "div";
-		} else if (strcmp(name, "*") == 0) {
-			name = "mul";
-		} else if (strcmp(name, "+") == 0) {
-			name = "add";
-		} else if (strcmp(name, "-") == 0) {
-			name = "sub";
+		switch (opcode) {
+		case Opcode::SYM_PRINT:
+			opcode = Opcode::PRINT;
+			break;
+		case Opcode::SYM_DIV:
+			opcode = Opcode::DIV;
+			break;
+		case Opcode::SYM_MUL:
+			opcode = Opcode::MUL;
+			break;
+		case Opcode::SYM_ADD:
+			opcode = Opcode::ADD;
+			break;
+		case Opcode::SYM_SUB:
+			opcode = Opcode::SUB;
+			break;
+		case Opcode::SYM_MOD:
+			opcode = Opcode::MOD;
+			break;
+		case Opcode::SYM_NEQ:
+			opcode = Opcode::NEQ;
+			break;
+		case Opcode::SYM_LT:
+			opcode = Opcode::LT;
+			break;
+		case Opcode::SYM_LTE:
+			opcode = Opcode::LTE;
+			break;
+		case Opcode::SYM_EQ:
+			opcode = Opcode::EQ;
+			break;
+		case Opcode::SYM_GT:
+			opcode = Opcode::GT;
+			break;
+		case Opcode::SYM_GTE:
+			opcode = Opcode::GTE;
+			break;
+		default:
+			break;
 		}
+		const std::string_view name = instructionName(opcode);
 
-		// error instruction: sets error flag (for use in 'throws' functions)
-		// Stack: [...] -> [...] (unchanged)
-		if (strcmp(name, "error") == 0) {
-			// No stack changes, just sets ctx->has_error = true at runtime
-			return;
-		}
+		// Pure stack effects: pop `consumes` values and push `produces`. Underflows are left to the runtime
+		// check (the model may have lost track of values before); they only end exact tracking.
+		auto applyEffect = [&](size_t consumes, std::initializer_list<StackValueType> produces) {
+			if (typeStack.size() < consumes) {
+				mTypeStackExact = false;
+				return;
+			}
+			typeStack.resize(typeStack.size() - consumes);
+			typeStack.insert(typeStack.end(), produces);
+		};
 
 		// read instruction: reads command-line arguments
 		// Stack: [...] -> [...] arg0 arg1 ... argN argc
@@ -2838,104 +2932,27 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 		// to allow reasonable operations after read (assumes up to 16 arguments)
 		static const int READ_INSTRUCTION_MAX_ARGS = 16; // Maximum expected command-line arguments
 		static const int READ_INSTRUCTION_STACK_DEPTH = READ_INSTRUCTION_MAX_ARGS + 1; // +1 for argc itself
-		if (strcmp(name, "read") == 0) {
+
+		switch (opcode) {
+		// error instruction: sets error flag (for use in 'throws' functions)
+		// Stack: [...] -> [...] (unchanged)
+		case Opcode::ERROR:
+			// No stack changes, just sets ctx->has_error = true at runtime
+			break;
+		case Opcode::NL:
+			break;
+		case Opcode::READ:
+			mTypeStackExact = false; // argc is only known at runtime
 			typeStack.clear();
 			// Push 16 values (enough for most use cases) + argc
 			// This is a workaround for not knowing argc at compile time
 			for (int i = 0; i < READ_INSTRUCTION_STACK_DEPTH; i++) {
 				typeStack.push_back(StackValueType::INT);
 			}
-			return;
-		}
-
-		// Arithmetic operations: abs, sq (preserve type)
-		if (strcmp(name, "abs") == 0 || strcmp(name, "sq") == 0) {
-			if (typeStack.empty()) {
-				std::string errorMsg = "Type error in '";
-				errorMsg += name;
-				errorMsg += "': Stack underflow (requires 1 numeric value)";
-				reportErrorConditional(node, errorMsg.c_str(), reportErrors);
-				return;
-			}
-
-			StackValueType top = typeStack.back();
-			if (!isNumericType(top)) {
-				std::string errorMsg = "Type error in '";
-				errorMsg += name;
-				errorMsg += "': Expected numeric type, got ";
-				errorMsg += typeToString(top);
-				reportErrorConditional(node, errorMsg.c_str(), reportErrors);
-				return;
-			}
-			// Type remains the same (already on stack)
-		}
-		// Trigonometric functions: sin, cos, tan, asin, acos, atan (always return float)
-		else if (strcmp(name, "sin") == 0 || strcmp(name, "cos") == 0 || strcmp(name, "tan") == 0 ||
-				 strcmp(name, "asin") == 0 || strcmp(name, "acos") == 0 || strcmp(name, "atan") == 0) {
-			if (typeStack.empty()) {
-				std::string errorMsg = "Type error in '";
-				errorMsg += name;
-				errorMsg += "': Stack underflow (requires 1 numeric value)";
-				reportError(node, errorMsg.c_str());
-				return;
-			}
-
-			StackValueType top = typeStack.back();
-			if (!isNumericType(top)) {
-				std::string errorMsg = "Type error in '";
-				errorMsg += name;
-				errorMsg += "': Expected numeric type, got ";
-				errorMsg += typeToString(top);
-				reportError(node, errorMsg.c_str());
-				return;
-			}
-			// Pop and push float (trig functions always return float)
-			typeStack.pop_back();
-			typeStack.push_back(StackValueType::FLOAT);
-		}
-		// Math functions: sqrt, cb, cbrt, ceil, floor, ln, log10, round (always return float)
-		else if (strcmp(name, "sqrt") == 0 || strcmp(name, "cb") == 0 || strcmp(name, "cbrt") == 0 ||
-				 strcmp(name, "ceil") == 0 || strcmp(name, "floor") == 0 || strcmp(name, "ln") == 0 ||
-				 strcmp(name, "log10") == 0 || strcmp(name, "round") == 0) {
-			if (typeStack.empty()) {
-				std::string errorMsg = "Type error in '";
-				errorMsg += name;
-				errorMsg += "': Stack underflow (requires 1 numeric value)";
-				reportError(node, errorMsg.c_str());
-				return;
-			}
-
-			StackValueType top = typeStack.back();
-			if (!isNumericType(top)) {
-				std::string errorMsg = "Type error in '";
-				errorMsg += name;
-				errorMsg += "': Expected numeric type, got ";
-				errorMsg += typeToString(top);
-				reportError(node, errorMsg.c_str());
-				return;
-			}
-			// Pop and push float (math functions always return float)
-			typeStack.pop_back();
-			typeStack.push_back(StackValueType::FLOAT);
-		}
-		// Factorial function: fac (integer only, returns integer)
-		else if (strcmp(name, "fac") == 0) {
-			if (typeStack.empty()) {
-				reportError(node, "Type error in 'fac': Stack underflow (requires 1 integer value)");
-				return;
-			}
-
-			StackValueType top = typeStack.back();
-			if (top != StackValueType::INT) {
-				std::string errorMsg = "Type error in 'fac': Expected integer type, got ";
-				errorMsg += typeToString(top);
-				reportError(node, errorMsg.c_str());
-				return;
-			}
-			// Type remains integer (already on stack)
-		}
+			break;
 		// Increment/Decrement functions: inc, dec (preserve type)
-		else if (strcmp(name, "inc") == 0 || strcmp(name, "dec") == 0) {
+		case Opcode::INC:
+		case Opcode::DEC: {
 			if (typeStack.empty()) {
 				std::string errorMsg = "Type error in '";
 				errorMsg += name;
@@ -2954,28 +2971,13 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 				return;
 			}
 			// Type remains the same (already on stack)
+			break;
 		}
-		// Inverse function: inv (numeric input, returns float)
-		else if (strcmp(name, "inv") == 0) {
-			if (typeStack.empty()) {
-				reportError(node, "Type error in 'inv': Stack underflow (requires 1 numeric value)");
-				return;
-			}
-
-			StackValueType top = typeStack.back();
-			if (!isNumericType(top)) {
-				std::string errorMsg = "Type error in 'inv': Expected numeric type, got ";
-				errorMsg += typeToString(top);
-				reportError(node, errorMsg.c_str());
-				return;
-			}
-			// Pop and push float (inv always returns float)
-			typeStack.pop_back();
-			typeStack.push_back(StackValueType::FLOAT);
-		}
-		// Binary arithmetic operations: add, sub, mul, div, pow
-		else if (strcmp(name, "add") == 0 || strcmp(name, "sub") == 0 || strcmp(name, "mul") == 0 ||
-				 strcmp(name, "div") == 0 || strcmp(name, "pow") == 0) {
+		// Binary arithmetic operations: add, sub, mul, div
+		case Opcode::ADD:
+		case Opcode::SUB:
+		case Opcode::MUL:
+		case Opcode::DIV: {
 			if (typeStack.size() < 2) {
 				std::string errorMsg = "Type error in '";
 				errorMsg += name;
@@ -3004,9 +3006,11 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			StackValueType result = (a == StackValueType::FLOAT || b == StackValueType::FLOAT) ? StackValueType::FLOAT
 																							   : StackValueType::INT;
 			typeStack.push_back(result);
+			break;
 		}
 		// Print operations: print, printv
-		else if (strcmp(name, "print") == 0 || strcmp(name, "printv") == 0) {
+		case Opcode::PRINT:
+		case Opcode::PRINTV: {
 			if (typeStack.empty()) {
 				std::string errorMsg = "Type error in '";
 				errorMsg += name;
@@ -3015,22 +3019,25 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 				return;
 			}
 			typeStack.pop_back(); // Pop the value
+			break;
 		}
 		// Non-destructive print: prints, printsv
-		else if (strcmp(name, "prints") == 0 || strcmp(name, "printsv") == 0) {
+		case Opcode::PRINTS:
+		case Opcode::PRINTSV:
 			// These don't modify the stack
-		}
+			break;
 		// Stack operations: dup
-		else if (strcmp(name, "dup") == 0) {
+		case Opcode::DUP: {
 			if (typeStack.empty()) {
 				reportErrorConditional(node, "Type error in 'dup': Stack underflow (requires 1 value)", reportErrors);
 				return;
 			}
 			StackValueType top = typeStack.back();
 			typeStack.push_back(top); // Duplicate
+			break;
 		}
 		// Stack operations: dup2 ( a b -- a b a b )
-		else if (strcmp(name, "dup2") == 0) {
+		case Opcode::DUP2: {
 			if (typeStack.size() < 2) {
 				reportError(node, "Type error in 'dup2': Stack underflow (requires 2 values)");
 				return;
@@ -3041,22 +3048,21 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			// Push copies of both
 			typeStack.push_back(second);
 			typeStack.push_back(top);
+			break;
 		}
 		// Stack operations: dupd ( a b -- a a b )
-		else if (strcmp(name, "dupd") == 0) {
+		case Opcode::DUPD: {
 			if (typeStack.size() < 2) {
 				reportError(node, "Type error in 'dupd': Stack underflow (requires 2 values)");
 				return;
 			}
-			// Get the second and top elements
+			// Insert a copy of the second element below the top
 			StackValueType second = typeStack[typeStack.size() - 2];
-			StackValueType top = typeStack.back();
-			// Push: second (duplicate of second), then top
-			typeStack.push_back(second);
-			typeStack.push_back(top);
+			typeStack.insert(typeStack.end() - 1, second);
+			break;
 		}
 		// Stack operations: swapd ( a b c -- b a c )
-		else if (strcmp(name, "swapd") == 0) {
+		case Opcode::SWAPD: {
 			if (typeStack.size() < 3) {
 				reportError(node, "Type error in 'swapd': Stack underflow (requires 3 values)");
 				return;
@@ -3073,20 +3079,21 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			typeStack.push_back(second);
 			typeStack.push_back(third);
 			typeStack.push_back(top);
+			break;
 		}
 		// Stack operations: overd ( a b c -- a b a c )
-		else if (strcmp(name, "overd") == 0) {
+		case Opcode::OVERD: {
 			if (typeStack.size() < 3) {
 				reportError(node, "Type error in 'overd': Stack underflow (requires 3 values)");
 				return;
 			}
-			// Get the third element
+			// Insert a copy of the third element below the top
 			StackValueType third = typeStack[typeStack.size() - 3];
-			// Push a copy of it to the top
-			typeStack.push_back(third);
+			typeStack.insert(typeStack.end() - 1, third);
+			break;
 		}
 		// Stack operations: nipd ( a b c -- a c )
-		else if (strcmp(name, "nipd") == 0) {
+		case Opcode::NIPD: {
 			if (typeStack.size() < 3) {
 				reportError(node, "Type error in 'nipd': Stack underflow (requires 3 values)");
 				return;
@@ -3098,9 +3105,10 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			typeStack.pop_back();
 			// Push top back
 			typeStack.push_back(top);
+			break;
 		}
 		// Stack operations: swap
-		else if (strcmp(name, "swap") == 0) {
+		case Opcode::SWAP: {
 			if (typeStack.size() < 2) {
 				reportErrorConditional(node, "Type error in 'swap': Stack underflow (requires 2 values)", reportErrors);
 				return;
@@ -3111,9 +3119,10 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			typeStack.pop_back();
 			typeStack.push_back(a);
 			typeStack.push_back(b);
+			break;
 		}
 		// Stack operations: over ( a b -- a b a )
-		else if (strcmp(name, "over") == 0) {
+		case Opcode::OVER: {
 			if (typeStack.size() < 2) {
 				reportError(node, "Type error in 'over': Stack underflow (requires 2 values)");
 				return;
@@ -3122,9 +3131,10 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			StackValueType second = typeStack[typeStack.size() - 2];
 			// Push a copy of it to the top
 			typeStack.push_back(second);
+			break;
 		}
 		// Stack operations: nip ( a b -- b )
-		else if (strcmp(name, "nip") == 0) {
+		case Opcode::NIP: {
 			if (typeStack.size() < 2) {
 				reportError(node, "Type error in 'nip': Stack underflow (requires 2 values)");
 				return;
@@ -3133,19 +3143,22 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			typeStack.pop_back();
 			typeStack.pop_back();	  // Remove second element
 			typeStack.push_back(top); // Push top back
+			break;
 		}
 		// Stack operations: clear (empties the entire stack)
-		else if (strcmp(name, "clear") == 0) {
+		case Opcode::CLEAR: {
 			// Clear all elements from the type stack
 			typeStack.clear();
+			break;
 		}
 		// Stack operations: depth (pushes the current stack depth as an integer)
-		else if (strcmp(name, "depth") == 0) {
+		case Opcode::DEPTH: {
 			// Push an int type onto the stack (depth is always an integer)
 			typeStack.push_back(StackValueType::INT);
+			break;
 		}
 		// call - invoke function pointer from stack
-		else if (strcmp(name, "call") == 0) {
+		case Opcode::CALL: {
 			if (typeStack.empty()) {
 				reportErrorConditional(node, "Type error in 'call': Stack underflow (requires 1 value)", reportErrors);
 				return;
@@ -3154,9 +3167,11 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			typeStack.pop_back();
 			// We don't know what the called function will do to the stack
 			// So we can't track types accurately after this point
+			mTypeStackExact = false;
+			break;
 		}
 		// free - deallocate memory pointed to by a pointer
-		else if (strcmp(name, "free") == 0) {
+		case Opcode::FREE: {
 			if (typeStack.empty()) {
 				reportErrorConditional(node, "Type error in 'free': Stack underflow (requires 1 pointer)", reportErrors);
 				return;
@@ -3170,6 +3185,149 @@ if (node->type() == IAstNode::Type::STRUCT_DECLARATION) {
 			}
 			// Pop the pointer
 			typeStack.pop_back();
+			break;
+		}
+		// chan - create a channel from a capacity
+		case Opcode::CHAN: {
+			if (typeStack.empty()) {
+				reportErrorConditional(node, "Type error in 'chan': Stack underflow (requires 1 integer)", reportErrors);
+				return;
+			}
+			StackValueType top = typeStack.back();
+			if (top != StackValueType::INT && top != StackValueType::ANY && top != StackValueType::UNKNOWN) {
+				std::string errorMsg = "Type error in 'chan': Expected int type, got ";
+				errorMsg += typeToString(top);
+				reportErrorConditional(node, errorMsg.c_str(), reportErrors);
+				return;
+			}
+			typeStack.back() = StackValueType::PTR;
+			break;
+		}
+		// send - pop a channel and a value
+		case Opcode::SEND: {
+			if (typeStack.size() < 2) {
+				reportErrorConditional(
+						node, "Type error in 'send': Stack underflow (requires a channel and a value)", reportErrors);
+				return;
+			}
+			typeStack.pop_back();
+			typeStack.pop_back();
+			break;
+		}
+		// recv, try_recv - replace a channel with the received value (any type) and an ok flag
+		case Opcode::RECV:
+		case Opcode::TRY_RECV: {
+			if (typeStack.empty()) {
+				std::string errorMsg = "Type error in '";
+				errorMsg += name;
+				errorMsg += "': Stack underflow (requires 1 channel)";
+				reportErrorConditional(node, errorMsg.c_str(), reportErrors);
+				return;
+			}
+			typeStack.back() = StackValueType::ANY;
+			typeStack.push_back(StackValueType::INT);
+			break;
+		}
+		// close - pop a channel
+		case Opcode::CLOSE: {
+			if (typeStack.empty()) {
+				reportErrorConditional(node, "Type error in 'close': Stack underflow (requires 1 channel)", reportErrors);
+				return;
+			}
+			typeStack.pop_back();
+			break;
+		}
+		// drop ( a -- ), drop2 ( a b -- )
+		case Opcode::DROP:
+			applyEffect(1, {});
+			break;
+		case Opcode::DROP2:
+			applyEffect(2, {});
+			break;
+		// rot ( a b c -- b c a )
+		case Opcode::ROT:
+			if (typeStack.size() >= 3) {
+				std::rotate(typeStack.end() - 3, typeStack.end() - 2, typeStack.end());
+			} else {
+				mTypeStackExact = false;
+			}
+			break;
+		// tuck ( a b -- b a b )
+		case Opcode::TUCK:
+			if (typeStack.size() >= 2) {
+				StackValueType top = typeStack.back();
+				std::swap(typeStack[typeStack.size() - 2], typeStack.back());
+				typeStack.push_back(top);
+			} else {
+				mTypeStackExact = false;
+			}
+			break;
+		// over2 ( a b c d -- a b c d a b )
+		case Opcode::OVER2:
+			if (typeStack.size() >= 4) {
+				StackValueType a = typeStack[typeStack.size() - 4];
+				StackValueType b = typeStack[typeStack.size() - 3];
+				typeStack.push_back(a);
+				typeStack.push_back(b);
+			} else {
+				mTypeStackExact = false;
+			}
+			break;
+		// swap2 ( a b c d -- c d a b )
+		case Opcode::SWAP2:
+			if (typeStack.size() >= 4) {
+				std::rotate(typeStack.end() - 4, typeStack.end() - 2, typeStack.end());
+			} else {
+				mTypeStackExact = false;
+			}
+			break;
+		// Comparisons push 0 or 1
+		case Opcode::EQ:
+		case Opcode::NEQ:
+		case Opcode::LT:
+		case Opcode::LTE:
+		case Opcode::GT:
+		case Opcode::GTE:
+		case Opcode::MOD:
+			applyEffect(2, {StackValueType::INT});
+			break;
+		case Opcode::WITHIN:
+			applyEffect(3, {StackValueType::INT});
+			break;
+		// neg keeps the type of its operand
+		case Opcode::NEG:
+			if (typeStack.empty()) {
+				mTypeStackExact = false;
+			}
+			break;
+		case Opcode::CASTF:
+			applyEffect(1, {StackValueType::FLOAT});
+			break;
+		case Opcode::CASTI:
+			applyEffect(1, {StackValueType::INT});
+			break;
+		case Opcode::CASTS:
+			applyEffect(1, {StackValueType::STRING});
+			break;
+		// spawn ( fn:ptr -- task:i ), wait and detach ( task:i -- )
+		case Opcode::SPAWN:
+			applyEffect(1, {StackValueType::INT});
+			break;
+		case Opcode::WAIT:
+		case Opcode::DETACH:
+			applyEffect(1, {});
+			break;
+		case Opcode::YIELD:
+			break;
+		// spawn_args ( args... fn:ptr n:i -- task:i ): how many arguments move is only known at runtime
+		case Opcode::SPAWN_ARGS:
+			applyEffect(2, {StackValueType::INT});
+			mTypeStackExact = false;
+			break;
+		default:
+			// pick, roll, ...: the model no longer matches the runtime stack
+			mTypeStackExact = false;
+			break;
 		}
 	}
 
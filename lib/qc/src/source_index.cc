@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <qc/source_index.h>
+
+namespace Qd {
+
+	SourceIndex::SourceIndex(const char* src)
+		: mSource(src ? src : ""), mLength(0), mLineCursor(0), mCharCursor(0), mByteCursor(0) {
+		mLineStarts.push_back(0);
+		for (; mSource[mLength] != '\0'; mLength++) {
+			if (mSource[mLength] == '\n') {
+				mLineStarts.push_back(mLength + 1);
+			}
+		}
+	}
+
+	size_t SourceIndex::lineStart(size_t line) const {
+		if (line == 0 || line > mLineStarts.size()) {
+			return mLength;
+		}
+		return mLineStarts[line - 1];
+	}
+
+	size_t SourceIndex::lineEnd(size_t line) const {
+		if (line == 0 || line > mLineStarts.size()) {
+			return mLength;
+		}
+		if (line < mLineStarts.size()) {
+			return mLineStarts[line] - 1;
+		}
+		return mLength;
+	}
+
+	void SourceIndex::lineColumn(size_t pos, size_t* line, size_t* column) const {
+		if (pos > mLength) {
+			pos = mLength;
+		}
+
+		// Fast path: same line as the last lookup, or one of the next lines
+		size_t index = mLineCursor;
+		if (pos >= mLineStarts[index]) {
+			while (index + 1 < mLineStarts.size() && pos >= mLineStarts[index + 1] && index < mLineCursor + 2) {
+				index++;
+			}
+		}
+		if (pos < mLineStarts[index] || (index + 1 < mLineStarts.size() && pos >= mLineStarts[index + 1])) {
+			auto it = std::upper_bound(mLineStarts.begin(), mLineStarts.end(), pos);
+			index = static_cast<size_t>(it - mLineStarts.begin()) - 1;
+		}
+		mLineCursor = index;
+
+		*line = index + 1;
+		*column = pos - mLineStarts[index] + 1;
+	}
+
+	size_t SourceIndex::byteOffset(size_t charIndex) const {
+		if (charIndex < mCharCursor) {
+			mCharCursor = 0;
+			mByteCursor = 0;
+		}
+
+		while (mCharCursor < charIndex && mByteCursor < mLength) {
+			unsigned char c = static_cast<unsigned char>(mSource[mByteCursor]);
+			size_t width = 1; // ASCII or invalid UTF-8
+			if ((c & 0xE0) == 0xC0) {
+				width = 2;
+			} else if ((c & 0xF0) == 0xE0) {
+				width = 3;
+			} else if ((c & 0xF8) == 0xF0) {
+				width = 4;
+			}
+			mByteCursor = std::min(mByteCursor + width, mLength);
+			mCharCursor++;
+		}
+
+		return mByteCursor;
+	}
+
+} // namespace Qd
@@ -1,6 +1,9 @@
 #include <cstring>
 #include <qc/ast.h>
+#include <qc/ast_node_identifier.h>
+#include <qc/ast_node_instruction.h>
 #include <qc/ast_printer.h>
+#include <qc/source_index.h>
 #include <unit-check/uc.h>
 
 TEST(SimpleFunctionDeclaration) {
@@ -412,6 +415,86 @@ TEST(ErrorRecoveryMultipleErrors) {
 	ASSERT(root->childCount() >= 1, "should have at least 1 function");
 }
 
+TEST(SourceIndexLineColumn) {
+	Qd::SourceIndex index("ab\ncd\n\nef");
+	size_t line, column;
+
+	ASSERT(index.lineCount() == 4, "should have 4 lines");
+
+	index.lineColumn(0, &line, &column);
+	ASSERT(line == 1 && column == 1, "start of first line");
+	index.lineColumn(4, &line, &column);
+	ASSERT(line == 2 && column == 2, "second line");
+	index.lineColumn(8, &line, &column);
+	ASSERT(line == 4 && column == 2, "last line");
+	index.lineColumn(1, &line, &column);
+	ASSERT(line == 1 && column == 2, "lookup backwards");
+	index.lineColumn(100, &line, &column);
+	ASSERT(line == 4 && column == 3, "position past the end is clamped");
+
+	ASSERT(index.lineStart(3) == 6 && index.lineEnd(3) == 6, "empty line");
+	ASSERT(index.lineEnd(4) == 9, "last line ends at end of source");
+}
+
+TEST(SourceIndexByteOffset) {
+	Qd::SourceIndex index("a\xc3\xa9" "b\xe2\x82\xac" "c");
+
+	ASSERT(index.byteOffset(1) == 1, "after ASCII");
+	ASSERT(index.byteOffset(2) == 3, "after two-byte character");
+	ASSERT(index.byteOffset(4) == 7, "after three-byte character");
+	ASSERT(index.byteOffset(0) == 0, "lookup backwards");
+	ASSERT(index.byteOffset(10) == 8, "index past the end");
+}
+
+TEST(NodePositions) {
+	Qd::Ast ast;
+	const char* src = "fn first() {}\n\n  fn second() {}";
+	Qd::IAstNode* root = ast.generate(src, false, nullptr);
+
+	ASSERT(root != nullptr, "root should not be null");
+	ASSERT(root->childCount() == 2, "should have 2 functions");
+	ASSERT(root->child(0)->line() == 1, "first function on line 1");
+	ASSERT(root->child(1)->line() == 3, "second function on line 3");
+}
+
+TEST(InternedIdentifiers) {
+	Qd::Ast ast;
+	const char* src = "fn test() { helper helper }";
+	Qd::IAstNode* root = ast.generate(src, false, nullptr);
+
+	ASSERT(root != nullptr, "root should not be null");
+	Qd::IAstNode* body = root->child(0)->child(0);
+	ASSERT(body != nullptr && body->childCount() == 2, "body should have 2 children");
+	ASSERT(body->child(0)->type() == Qd::IAstNode::Type::IDENTIFIER, "should be identifier");
+
+	auto* first = static_cast<Qd::AstNodeIdentifier*>(body->child(0));
+	auto* second = static_cast<Qd::AstNodeIdentifier*>(body->child(1));
+	ASSERT(first->name() == "helper", "name should be helper");
+	ASSERT(&first->name() == &second->name(), "equal names should share storage");
+}
+
+TEST(InstructionOpcodes) {
+	for (size_t i = 0; i < Qd::BUILTIN_INSTRUCTION_COUNT; i++) {
+		Qd::Opcode opcode = static_cast<Qd::Opcode>(i + 1);
+		ASSERT(Qd::lookupInstruction(Qd::INSTRUCTION_NAMES[i]) == opcode, "every instruction should be found");
+		ASSERT(Qd::instructionName(opcode) == Qd::INSTRUCTION_NAMES[i], "opcode should map back to its name");
+	}
+	ASSERT(Qd::lookupInstruction("dupx") == Qd::Opcode::NONE, "unknown names should not be found");
+	ASSERT(!Qd::isBuiltInInstruction("sqrt") && Qd::isKnownInstruction("sqrt"), "sqrt is a library function");
+
+	Qd::Ast ast;
+	const char* src = "fn test() { 1 2 + dup add }";
+	Qd::IAstNode* root = ast.generate(src, false, nullptr);
+
+	ASSERT(root != nullptr, "root should not be null");
+	Qd::IAstNode* body = root->child(0)->child(0);
+	ASSERT(body != nullptr && body->childCount() == 5, "body should have 5 children");
+	ASSERT(body->child(2)->type() == Qd::IAstNode::Type::INSTRUCTION, "should be instruction");
+	ASSERT(static_cast<Qd::AstNodeInstruction*>(body->child(2))->opcode() == Qd::Opcode::SYM_ADD, "should be +");
+	ASSERT(static_cast<Qd::AstNodeInstruction*>(body->child(3))->opcode() == Qd::Opcode::DUP, "should be dup");
+	ASSERT(static_cast<Qd::AstNodeInstruction*>(body->child(4))->opcode() == Qd::Opcode::ADD, "should be add");
+}
+
 int main() {
 	return UC_PrintResults();
 }
@@ -1,5 +1,6 @@
 #include <cstring>
 #include <qc/ast.h>
+#include <qc/ast_node_identifier.h>
 #include <qc/semantic_validator.h>
 #include <unit-check/uc.h>
 
@@ -469,6 +470,28 @@ TEST(ImplicitCastFloatToInt) {
 	ASSERT(validator.warningCount() == 2, "should have 2 warnings for implicit casts");
 }
 
+// Test stored warnings: kept with the errors instead of being printed
+TEST(StoredWarnings) {
+	const char* src = R"(
+		fn add_int(a:i64 b:i64 -- result:i64) {
+			+
+		}
+		fn main() {
+			10.5 20.3 add_int printv
+		}
+	)";
+	Qd::Ast ast;
+	Qd::IAstNode* root = ast.generate(src, false, nullptr);
+	Qd::SemanticValidator validator;
+	validator.setStoreErrors(true);
+	size_t errors = validator.validate(root, "test.qd");
+	ASSERT(errors == 0, "implicit casts should succeed");
+	ASSERT(validator.warningCount() == 2, "should count 2 stored warnings");
+	ASSERT(validator.getWarnings().size() == 2, "should store 2 warnings");
+	ASSERT(validator.getWarnings()[0].line == 6, "warning should keep its line");
+	ASSERT(validator.getErrors().empty(), "should store no errors");
+}
+
 // Test werror: warnings treated as errors
 TEST(WerrorTreatsWarningsAsErrors) {
 	const char* src = R"(
@@ -523,6 +546,195 @@ TEST(MultipleImplicitCasts) {
 	ASSERT(validator.warningCount() == 3, "should have 3 warnings (all params need casts)");
 }
 
+// Helper function to find the first call of a function in the AST
+static const Qd::AstNodeIdentifier* findCall(const Qd::IAstNode* node, const char* name) {
+	if (!node) {
+		return nullptr;
+	}
+	if (node->type() == Qd::IAstNode::Type::IDENTIFIER) {
+		auto ident = static_cast<const Qd::AstNodeIdentifier*>(node);
+		if (ident->name() == name) {
+			return ident;
+		}
+	}
+	for (size_t i = 0; i < node->childCount(); i++) {
+		if (auto found = findCall(node->child(i), name)) {
+			return found;
+		}
+	}
+	return nullptr;
+}
+
+// Helper function to validate code and report whether the call of `take` was proven
+static bool callProven(const char* src, size_t* errors) {
+	Qd::Ast ast;
+	Qd::IAstNode* root = ast.generate(src, false, nullptr);
+	Qd::SemanticValidator validator;
+	*errors = validator.validate(root, "test.qd");
+	const Qd::AstNodeIdentifier* call = findCall(root, "take");
+	return call && call->typesProven();
+}
+
+// Test proven call site: depth and types known from literals
+TEST(CallSiteProven) {
+	const char* src = R"(
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			1 take
+		}
+	)";
+	size_t errors;
+	ASSERT(callProven(src, &errors), "call after a literal should be proven");
+	ASSERT(errors == 0, "should have no errors");
+}
+
+// Test drop is modeled: the value below it is what the call sees
+TEST(DropBeforeCallModeled) {
+	const char* src = R"(
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			"s" 1 drop take
+		}
+	)";
+	size_t errors;
+	ASSERT(!callProven(src, &errors), "call after drop should keep the check");
+	ASSERT(errors == 1, "should have 1 error for the string left by drop");
+}
+
+// Test drop that empties the stack leaves no proven call behind
+TEST(DropUnderflowKeepsCheck) {
+	const char* src = R"(
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			1 drop take
+		}
+	)";
+	size_t errors;
+	ASSERT(!callProven(src, &errors), "call after drop should keep the check");
+	ASSERT(errors == 1, "should have 1 error for stack underflow");
+}
+
+// Test rot is modeled: ( a b c -- b c a )
+TEST(RotBeforeCallModeled) {
+	const char* src = R"(
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			1 2 "s" rot take
+		}
+	)";
+	size_t errors;
+	ASSERT(callProven(src, &errors), "call after rot of known values should be proven");
+	ASSERT(errors == 0, "should have no errors");
+}
+
+// Test rot below the modeled values keeps the check
+TEST(RotUnderflowKeepsCheck) {
+	const char* src = R"(
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			1 2 rot take
+		}
+	)";
+	size_t errors;
+	ASSERT(!callProven(src, &errors), "call after rot of unknown values should keep the check");
+}
+
+// Test control flow before a call keeps the check
+TEST(IfBeforeCallKeepsCheck) {
+	const char* src = R"(
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			1 2 1 if {
+				drop
+			}
+			take
+		}
+	)";
+	size_t errors;
+	ASSERT(!callProven(src, &errors), "call after if should keep the check");
+	ASSERT(errors == 0, "should have no errors");
+}
+
+// Test instructions without a modeled stack effect keep the check
+TEST(PickBeforeCallKeepsCheck) {
+	const char* src = R"(
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			1 2 0 pick take
+		}
+	)";
+	size_t errors;
+	ASSERT(!callProven(src, &errors), "call after pick should keep the check");
+}
+
+// Test results of a function with control flow aren't trusted
+TEST(InexactCalleeKeepsCheck) {
+	const char* src = R"(
+		fn maybe( -- ) {
+			1 if {
+				2
+			}
+		}
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			1 maybe take
+		}
+	)";
+	size_t errors;
+	ASSERT(!callProven(src, &errors), "call after a function with control flow should keep the check");
+}
+
+// Test spawn leaves the task handle on the caller's stack
+TEST(SpawnBeforeCallModeled) {
+	const char* src = R"(
+		fn work() {
+		}
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			"s" &work spawn take drop
+		}
+	)";
+	size_t errors;
+	ASSERT(callProven(src, &errors), "call after spawn should be proven");
+	ASSERT_EQ(errors, 0, "spawn should push a task handle");
+}
+
+// Test spawn_args keeps the check, since the argument count is a runtime value
+TEST(SpawnArgsBeforeCallKeepsCheck) {
+	const char* src = R"(
+		fn work(a:i64 -- ) {
+			drop
+		}
+		fn take(a:i64 -- ) {
+			drop
+		}
+		fn main() {
+			1 &work 1 spawn_args take
+		}
+	)";
+	size_t errors;
+	ASSERT(!callProven(src, &errors), "call after spawn_args should keep the check");
+	ASSERT_EQ(errors, 0, "spawn_args should push a task handle");
+}
+
 int main() {
 	return UC_PrintResults();
 }
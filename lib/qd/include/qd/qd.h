@@ -26,6 +26,13 @@ extern "C" {
  */
 typedef struct qd_module qd_module;
 
+/**
+ * @brief Opaque prepared call
+ *
+ * Code prepared once with qd_prepare() and run with qd_invoke().
+ */
+typedef struct qd_call_handle qd_call_handle;
+
 // Context management functions are now in qdrt/runtime.h (included above)
 
 /**
@@ -67,6 +74,8 @@ void qd_add_script(qd_module* mod, const char* script);
  * @param fn Function pointer (must not be NULL)
  *
  * @note Function pointers are stored as void*, cast appropriately when calling
+ * @note Functions registered after qd_build() are callable right away;
+ *       replacing an already registered function rebuilds the module
  */
 void qd_register_function(qd_module* mod, const char* name, void (*fn)(void));
 
@@ -79,6 +88,9 @@ void qd_register_function(qd_module* mod, const char* name, void (*fn)(void));
  * @param mod Target module
  *
  * @note If compilation fails, errors are reported to stderr
+ * @note Rebuilding keeps the code of earlier builds alive, since string
+ *       literals they pushed may still be on a stack; it is released with
+ *       the module
  */
 void qd_build(qd_module* mod);
 
@@ -95,6 +107,41 @@ void qd_build(qd_module* mod);
  */
 void qd_execute(qd_context* ctx, const char* fn);
 
+/**
+ * @brief Prepare code for repeated execution
+ *
+ * Parses code in the same syntax as qd_execute() (literals, built-in
+ * operations and "module::function" calls) and resolves every function
+ * once. Invoking the handle then only pushes the literals and calls the
+ * resolved functions.
+ *
+ * @param ctx Execution context the code runs on
+ * @param code Code to prepare (e.g., "5 math::square")
+ * @return Prepared call, or NULL if the code can't be parsed or a
+ *         function can't be resolved (errors are reported to stderr)
+ *
+ * @note Rebuilding a module with qd_build() is picked up by existing handles
+ * @note Free the handle with qd_free_call_handle()
+ */
+qd_call_handle* qd_prepare(qd_context* ctx, const char* code);
+
+/**
+ * @brief Run prepared code
+ *
+ * @param handle Prepared call from qd_prepare()
+ * @return Result of the first failing operation, or a code of 0 on success
+ *
+ * @note Execution stops at the first failing operation
+ */
+qd_exec_result qd_invoke(qd_call_handle* handle);
+
+/**
+ * @brief Free a prepared call
+ *
+ * @param handle Prepared call from qd_prepare() (may be NULL)
+ */
+void qd_free_call_handle(qd_call_handle* handle);
+
 #ifdef __cplusplus
 }
 #endif
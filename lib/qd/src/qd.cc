@@ -1,11 +1,11 @@
 #include <qd/qd.h>
 
-#include <dlfcn.h>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <filesystem>
 #include <llvmgen/generator.h>
+#include <llvmgen/jit.h>
+#include <memory>
 #include <qc/ast.h>
 #include <qc/ast_node.h>
 #include <qc/semantic_validator.h>
@@ -14,33 +14,43 @@
 #include <unordered_map>
 #include <vector>
 
-namespace fs = std::filesystem;
-
 // Module implementation
 struct qd_module {
 	std::string name;
 	std::vector<std::string> scripts;
 	std::unordered_map<std::string, void (*)()> native_functions;
 	std::unordered_map<std::string, std::string> symbol_map; // function_name -> full_symbol_name
-	void* dl_handle; // dlopen handle
-	fs::path temp_dir;
-	fs::path so_path;
+	std::unique_ptr<Qd::LlvmJit> jit; // Compiled code of the last successful build
+	// Earlier builds; string literals they pushed borrow their constant data and may still be on a stack
+	std::vector<std::unique_ptr<Qd::LlvmJit>> retired_jits;
+	unsigned build_count; // Incremented on every successful build, so prepared calls notice rebuilds
 	bool compiled;
 
-	qd_module(const std::string& n) : name(n), dl_handle(nullptr), compiled(false) {
+	qd_module(const std::string& n) : name(n), build_count(0), compiled(false) {
 	}
+};
 
-	~qd_module() {
-		// Clean up dynamic library
-		if (dl_handle) {
-			dlclose(dl_handle);
-		}
-		// Clean up temp directory
-		if (!temp_dir.empty() && fs::exists(temp_dir)) {
-			std::error_code ec;
-			fs::remove_all(temp_dir, ec);
-		}
-	}
+// Function signature of compiled and native functions: qd_exec_result (*)(qd_context*)
+typedef qd_exec_result (*qd_func_t)(qd_context*);
+
+// One operation of parsed code
+struct qd_call_op {
+	enum kind_t { PUSH_I, PUSH_F, PUSH_S, BUILTIN, CALL } kind;
+	int64_t int_val;
+	double float_val;
+	std::string str_val;
+	qd_func_t func;
+
+	// Module function calls: resolved again if the module was rebuilt since
+	qd_module* mod;
+	unsigned build_count;
+	std::string func_name;
+};
+
+// Prepared call
+struct qd_call_handle {
+	qd_context* ctx;
+	std::vector<qd_call_op> ops;
 };
 
 // Global module registry (stored per-context would be better, but API doesn't support it)
@@ -77,7 +87,24 @@ void qd_register_function(qd_module* mod, const char* name, void (*fn)()) {
 	if (!mod || !name || !fn) {
 		return;
 	}
+
+	auto previous = mod->native_functions.find(name);
+	bool added = previous == mod->native_functions.end();
+	if (!added && previous->second == fn) {
+		return;
+	}
 	mod->native_functions[name] = fn;
+
+	// A built module sees the function right away, unless a script defines one of the same name
+	if (!mod->compiled || !mod->jit || mod->symbol_map.find(name) != mod->symbol_map.end()) {
+		return;
+	}
+	if (added) {
+		mod->jit->defineSymbol("usr_" + mod->name + "_" + name, reinterpret_cast<void*>(fn));
+	} else {
+		// Compiled code may already be bound to the old address
+		qd_build(mod);
+	}
 }
 
 void qd_build(qd_module* mod) {
@@ -91,15 +118,6 @@ void qd_build(qd_module* mod) {
 	}
 
 	try {
-		// Create temporary directory for compilation
-		char temp_template[] = "/tmp/qd_embed_XXXXXX";
-		char* temp_path = mkdtemp(temp_template);
-		if (!temp_path) {
-			fprintf(stderr, "qd_build: Failed to create temporary directory\n");
-			return;
-		}
-		mod->temp_dir = temp_path;
-
 		// Combine all scripts into one source file
 		// Prepend package declaration to ensure correct symbol names
 		std::string combined_source = "package " + mod->name + "\n\n";
@@ -107,20 +125,12 @@ void qd_build(qd_module* mod) {
 			combined_source += script;
 			combined_source += "\n";
 		}
-
-		// Write source to file
-		fs::path source_file = mod->temp_dir / "script.qd";
-		FILE* f = fopen(source_file.c_str(), "w");
-		if (!f) {
-			fprintf(stderr, "qd_build: Failed to write source file\n");
-			return;
-		}
-		fwrite(combined_source.c_str(), 1, combined_source.size(), f);
-		fclose(f);
+		// Name used in diagnostics; nothing is written to disk
+		std::string source_name = mod->name + ".qd";
 
 		// Parse the source
 		Qd::Ast ast;
-		Qd::IAstNode* root = ast.generate(combined_source.c_str(), false, source_file.string().c_str());
+		Qd::IAstNode* root = ast.generate(combined_source.c_str(), false, source_name.c_str());
 		if (!root) {
 			fprintf(stderr, "qd_build: Failed to parse script\n");
 			return;
@@ -128,7 +138,7 @@ void qd_build(qd_module* mod) {
 
 		// Validate semantics (pass true for isModuleFile since this is dynamically loaded code)
 		Qd::SemanticValidator validator;
-		size_t error_count = validator.validate(root, source_file.string().c_str(), true, false);
+		size_t error_count = validator.validate(root, source_name.c_str(), true, false);
 		if (error_count > 0) {
 			fprintf(stderr, "qd_build: Semantic validation failed with %zu error(s)\n", error_count);
 			return;
@@ -142,85 +152,48 @@ void qd_build(qd_module* mod) {
 			return;
 		}
 
-		// Write object file
-		fs::path obj_file = mod->temp_dir / "script.o";
-		if (!generator.writeObject(obj_file.string())) {
-			fprintf(stderr, "qd_build: Failed to write object file\n");
-			return;
-		}
-
-		// Link to shared library
-		mod->so_path = mod->temp_dir / ("lib" + mod->name + ".so");
-
-		// Check what symbols are in the object file and store them for lookup
-		std::string nm_cmd = "nm " + obj_file.string() + " | grep ' T usr_' || true";
-		FILE* nm_output = popen(nm_cmd.c_str(), "r");
-		std::unordered_map<std::string, std::string> symbol_map; // function_name -> full_symbol
-		if (nm_output) {
-			char buffer[256];
-			while (fgets(buffer, sizeof(buffer), nm_output)) {
-				// Parse symbol: "0000000000000000 T usr_package_function"
-				char* symbol_start = strstr(buffer, "usr_");
-				if (symbol_start) {
-					std::string full_symbol = symbol_start;
-					// Remove newline
-					if (!full_symbol.empty() && full_symbol.back() == '\n') {
-						full_symbol.pop_back();
-					}
-					// Extract function name after the second underscore
-					// usr_package_function -> function
-					size_t first_us = full_symbol.find('_');
-					if (first_us != std::string::npos) {
-						size_t second_us = full_symbol.find('_', first_us + 1);
-						if (second_us != std::string::npos) {
-							std::string func_name = full_symbol.substr(second_us + 1);
-							symbol_map[func_name] = full_symbol;
-						}
-					}
+		// Map function names to their symbols: usr_package_function -> function
+		std::unordered_map<std::string, std::string> symbol_map;
+		for (const auto& full_symbol : generator.exportedFunctions()) {
+			size_t first_us = full_symbol.find('_');
+			if (first_us != std::string::npos) {
+				size_t second_us = full_symbol.find('_', first_us + 1);
+				if (second_us != std::string::npos) {
+					symbol_map[full_symbol.substr(second_us + 1)] = full_symbol;
 				}
 			}
-			pclose(nm_output);
 		}
 
-		// Store symbol map in module for later lookup
-		mod->symbol_map = symbol_map;
-
-		// Use clang/gcc to link the object file into a shared library
-		fs::path qdrt_lib_path = fs::path(MESON_BUILD_ROOT) / "lib" / "qdrt";
-		std::string link_cmd = "clang++ -shared ";
-		link_cmd += obj_file.string();
-		link_cmd += " -o ";
-		link_cmd += mod->so_path.string();
-		link_cmd += " -L" + qdrt_lib_path.string();
-		link_cmd += " -lqdrt";
-		link_cmd += " -Wl,-rpath,$ORIGIN";
-		link_cmd += " 2>&1";
-
-		FILE* link_output = popen(link_cmd.c_str(), "r");
-		if (!link_output) {
-			fprintf(stderr, "qd_build: Failed to execute linker\n");
+		// Compile in-process; runtime functions resolve against this process
+		auto jit = std::make_unique<Qd::LlvmJit>();
+		if (!jit->isValid()) {
+			fprintf(stderr, "qd_build: Failed to create JIT\n");
 			return;
 		}
-
-		char buffer[256];
-		std::string link_errors;
-		while (fgets(buffer, sizeof(buffer), link_output)) {
-			link_errors += buffer;
-		}
-		int link_result = pclose(link_output);
-
-		if (link_result != 0) {
-			fprintf(stderr, "qd_build: Linking failed:\n%s\n", link_errors.c_str());
+		if (!generator.addToJit(*jit)) {
+			fprintf(stderr, "qd_build: Failed to compile module '%s'\n", mod->name.c_str());
 			return;
 		}
 
-		// Load the shared library
-		mod->dl_handle = dlopen(mod->so_path.c_str(), RTLD_NOW | RTLD_LOCAL);
-		if (!mod->dl_handle) {
-			fprintf(stderr, "qd_build: Failed to load shared library: %s\n", dlerror());
-			return;
+		// Native functions are visible through the JIT under their module symbol,
+		// unless a script defines a function of the same name
+		for (const auto& native : mod->native_functions) {
+			if (symbol_map.find(native.first) != symbol_map.end()) {
+				continue;
+			}
+			std::string symbol = "usr_" + mod->name + "_" + native.first;
+			if (!jit->defineSymbol(symbol, reinterpret_cast<void*>(native.second))) {
+				return;
+			}
 		}
 
+		// Replace the previous build only once the new one succeeded
+		mod->symbol_map = std::move(symbol_map);
+		if (mod->jit) {
+			mod->retired_jits.push_back(std::move(mod->jit));
+		}
+		mod->jit = std::move(jit);
+		mod->build_count++;
 		mod->compiled = true;
 
 	} catch (const std::exception& e) {
@@ -228,24 +201,63 @@ void qd_build(qd_module* mod) {
 	}
 }
 
-void qd_execute(qd_context* ctx, const char* code) {
-	if (!ctx || !code) {
-		return;
+// Built-in operations available in executed code
+static qd_func_t builtin_operation(const std::string& token) {
+	static const std::unordered_map<std::string, qd_func_t> builtins = {
+			{".", qd_print},
+			{"nl", qd_nl},
+			{"dup", qd_dup},
+			{"swap", qd_swap},
+			{"drop", qd_drop},
+			{"+", qd_add},
+			{"-", qd_sub},
+			{"*", qd_mul},
+			{"/", qd_div},
+	};
+	auto it = builtins.find(token);
+	return (it != builtins.end()) ? it->second : nullptr;
+}
+
+// Resolve a function of a compiled module; errors are reported with the caller's name
+static qd_func_t resolve_function(qd_module* mod, const std::string& func_name, const char* caller) {
+	if (!mod->compiled || !mod->jit) {
+		fprintf(stderr, "%s: Module '%s' not compiled\n", caller, mod->name.c_str());
+		return nullptr;
 	}
 
+	// Look up function in symbol map first
+	std::string symbol_name;
+	auto symbol_it = mod->symbol_map.find(func_name);
+	if (symbol_it != mod->symbol_map.end()) {
+		symbol_name = symbol_it->second;
+	} else {
+		// Fall back to expected name
+		symbol_name = "usr_" + mod->name + "_" + func_name;
+	}
+
+	// Script functions and registered native functions are both in the JIT's symbol table
+	qd_func_t func = reinterpret_cast<qd_func_t>(mod->jit->lookup(symbol_name));
+	if (!func) {
+		fprintf(stderr, "%s: Function '%s' (symbol '%s') not found in module '%s'\n", caller, func_name.c_str(),
+				symbol_name.c_str(), mod->name.c_str());
+	}
+	return func;
+}
+
+// Parse code into operations and resolve its functions
+// With skip_errors, unknown tokens and functions are reported and skipped instead of failing
+static bool parse_code(qd_context* ctx, const char* code, const char* caller, bool skip_errors,
+		std::vector<qd_call_op>& ops) {
 	// Parse the function call/code
 	// For simple cases, we support "module::function" syntax
 	// For inline code, we support direct operations like "123.34 . hello::world"
 
-	std::string code_str(code);
-
-	// Try to tokenize and execute the code
-	// This is a simple interpreter for basic operations
-
-	std::istringstream iss(code_str);
+	std::istringstream iss(code);
 	std::string token;
 
 	while (iss >> token) {
+		qd_call_op op{};
+
 		// Check if it's a number (integer or float)
 		char* endptr;
 
@@ -253,7 +265,9 @@ void qd_execute(qd_context* ctx, const char* code) {
 		long long int_val = strtoll(token.c_str(), &endptr, 10);
 		if (*endptr == '\0') {
 			// It's an integer
-			qd_push_i(ctx, int_val);
+			op.kind = qd_call_op::PUSH_I;
+			op.int_val = int_val;
+			ops.push_back(std::move(op));
 			continue;
 		}
 
@@ -261,7 +275,9 @@ void qd_execute(qd_context* ctx, const char* code) {
 		double float_val = strtod(token.c_str(), &endptr);
 		if (*endptr == '\0') {
 			// It's a float
-			qd_push_f(ctx, float_val);
+			op.kind = qd_call_op::PUSH_F;
+			op.float_val = float_val;
+			ops.push_back(std::move(op));
 			continue;
 		}
 
@@ -277,29 +293,17 @@ void qd_execute(qd_context* ctx, const char* code) {
 			} else {
 				str_val.pop_back(); // Remove closing quote
 			}
-			qd_push_s(ctx, str_val.c_str());
+			op.kind = qd_call_op::PUSH_S;
+			op.str_val = str_val;
+			ops.push_back(std::move(op));
 			continue;
 		}
 
 		// Check for built-in operations
-		if (token == ".") {
-			qd_print(ctx);
-		} else if (token == "nl") {
-			qd_nl(ctx);
-		} else if (token == "dup") {
-			qd_dup(ctx);
-		} else if (token == "swap") {
-			qd_swap(ctx);
-		} else if (token == "drop") {
-			qd_drop(ctx);
-		} else if (token == "+") {
-			qd_add(ctx);
-		} else if (token == "-") {
-			qd_sub(ctx);
-		} else if (token == "*") {
-			qd_mul(ctx);
-		} else if (token == "/") {
-			qd_div(ctx);
+		if (qd_func_t builtin = builtin_operation(token)) {
+			op.kind = qd_call_op::BUILTIN;
+			op.func = builtin;
+			ops.push_back(std::move(op));
 		} else if (token.find("::") != std::string::npos) {
 			// Module-qualified function call
 			size_t sep_pos = token.find("::");
@@ -309,63 +313,118 @@ void qd_execute(qd_context* ctx, const char* code) {
 			// Look up module
 			auto ctx_it = g_context_modules.find(ctx);
 			if (ctx_it == g_context_modules.end()) {
-				fprintf(stderr, "qd_execute: No modules registered for context\n");
-				continue;
+				fprintf(stderr, "%s: No modules registered for context\n", caller);
+				if (skip_errors) {
+					continue;
+				}
+				return false;
 			}
 
 			auto mod_it = ctx_it->second.find(module_name);
 			if (mod_it == ctx_it->second.end()) {
-				fprintf(stderr, "qd_execute: Module '%s' not found\n", module_name.c_str());
-				continue;
-			}
-
-			qd_module* mod = mod_it->second;
-			if (!mod->compiled || !mod->dl_handle) {
-				fprintf(stderr, "qd_execute: Module '%s' not compiled\n", module_name.c_str());
-				continue;
-			}
-
-			// Look up function in symbol map first
-			std::string symbol_name;
-			auto symbol_it = mod->symbol_map.find(func_name);
-			if (symbol_it != mod->symbol_map.end()) {
-				symbol_name = symbol_it->second;
-			} else {
-				// Fall back to expected name
-				symbol_name = "usr_" + module_name + "_" + func_name;
-			}
-
-			// Function signature: qd_exec_result (*)(qd_context*)
-			typedef qd_exec_result (*qd_func_t)(qd_context*);
-
-			void* sym = dlsym(mod->dl_handle, symbol_name.c_str());
-			qd_func_t func = reinterpret_cast<qd_func_t>(sym);
-			if (!func) {
-				// Check native functions
-				auto native_it = mod->native_functions.find(func_name);
-				if (native_it != mod->native_functions.end()) {
-					// Call native function
-					// Note: This assumes native functions follow the same signature
-					func = reinterpret_cast<qd_func_t>(native_it->second);
-				} else {
-					fprintf(stderr, "qd_execute: Function '%s' (symbol '%s') not found in module '%s': %s\n",
-					        func_name.c_str(), symbol_name.c_str(), module_name.c_str(), dlerror());
+				fprintf(stderr, "%s: Module '%s' not found\n", caller, module_name.c_str());
+				if (skip_errors) {
 					continue;
 				}
+				return false;
 			}
 
-			// Call the function
-			qd_exec_result result = func(ctx);
-			if (result.code != 0) {
-				fprintf(stderr, "qd_execute: Function '%s::%s' returned error code %d\n",
-				        module_name.c_str(), func_name.c_str(), result.code);
+			op.kind = qd_call_op::CALL;
+			op.mod = mod_it->second;
+			op.build_count = op.mod->build_count;
+			op.func_name = func_name;
+			op.func = resolve_function(op.mod, func_name, caller);
+			if (!op.func) {
+				if (skip_errors) {
+					continue;
+				}
+				return false;
 			}
+			ops.push_back(std::move(op));
 		} else {
-			fprintf(stderr, "qd_execute: Unknown token '%s'\n", token.c_str());
+			fprintf(stderr, "%s: Unknown token '%s'\n", caller, token.c_str());
+			if (!skip_errors) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Run one parsed operation
+static qd_exec_result run_op(qd_context* ctx, qd_call_op& op, const char* caller) {
+	switch (op.kind) {
+	case qd_call_op::PUSH_I:
+		return qd_push_i(ctx, op.int_val);
+	case qd_call_op::PUSH_F:
+		return qd_push_f(ctx, op.float_val);
+	case qd_call_op::PUSH_S:
+		return qd_push_s(ctx, op.str_val.c_str());
+	case qd_call_op::BUILTIN:
+		return op.func(ctx);
+	case qd_call_op::CALL:
+		// The module was rebuilt since the function was resolved; its old code is gone
+		if (op.build_count != op.mod->build_count) {
+			op.func = resolve_function(op.mod, op.func_name, caller);
+			op.build_count = op.mod->build_count;
+		}
+		if (!op.func) {
+			return qd_exec_result{1};
+		}
+		return op.func(ctx);
+	}
+	return qd_exec_result{0};
+}
+
+void qd_execute(qd_context* ctx, const char* code) {
+	if (!ctx || !code) {
+		return;
+	}
+
+	std::vector<qd_call_op> ops;
+	parse_code(ctx, code, "qd_execute", true, ops);
+
+	for (auto& op : ops) {
+		qd_exec_result result = run_op(ctx, op, "qd_execute");
+		if (op.kind == qd_call_op::CALL && result.code != 0) {
+			fprintf(stderr, "qd_execute: Function '%s::%s' returned error code %d\n", op.mod->name.c_str(),
+					op.func_name.c_str(), result.code);
 		}
 	}
 }
 
+qd_call_handle* qd_prepare(qd_context* ctx, const char* code) {
+	if (!ctx || !code) {
+		return nullptr;
+	}
+
+	qd_call_handle* handle = new qd_call_handle;
+	handle->ctx = ctx;
+	if (!parse_code(ctx, code, "qd_prepare", false, handle->ops)) {
+		delete handle;
+		return nullptr;
+	}
+	return handle;
+}
+
+qd_exec_result qd_invoke(qd_call_handle* handle) {
+	if (!handle) {
+		return qd_exec_result{1};
+	}
+
+	for (auto& op : handle->ops) {
+		qd_exec_result result = run_op(handle->ctx, op, "qd_invoke");
+		if (result.code != 0) {
+			return result;
+		}
+	}
+	return qd_exec_result{0};
+}
+
+void qd_free_call_handle(qd_call_handle* handle) {
+	delete handle;
+}
+
 // Clean up modules when context is freed (best effort)
 // Note: This is a workaround since we can't intercept qd_free_context
 // In production, we'd need to modify the context structure or use atexit
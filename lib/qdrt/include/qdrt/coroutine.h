@@ -0,0 +1,68 @@
+/**
+ * @file coroutine.h
+ * @brief Blocking primitives that park spawned tasks instead of their thread
+ *
+ * Spawned tasks run as coroutines on the runtime's worker pool. Native
+ * functions that would block (sockets, timers) use these calls so that a
+ * waiting task gives its worker thread to other tasks until an epoll
+ * reactor resumes it. Outside a task (in main, or in plain C threads) they
+ * block the calling thread like the system calls they replace.
+ *
+ * @par Typical Usage:
+ * @code
+ * ssize_t n;
+ * while ((n = read(fd, buffer, size)) < 0 && errno == EAGAIN) {
+ *     qd_wait_fd(fd, QD_WAIT_READ);
+ * }
+ * @endcode
+ *
+ * @note A task can resume on a different thread than the one it parked on.
+ *       Don't keep thread-local state (including the address of errno) across
+ *       these calls, and don't hold a mutex while calling them.
+ */
+
+#ifndef QD_QUADRATE_RUNTIME_COROUTINE_H
+#define QD_QUADRATE_RUNTIME_COROUTINE_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Wait until a file descriptor is readable
+ */
+#define QD_WAIT_READ 1
+
+/**
+ * @brief Wait until a file descriptor is writable
+ */
+#define QD_WAIT_WRITE 2
+
+/**
+ * @brief Wait until a file descriptor is ready
+ *
+ * The descriptor should be non-blocking so that the retried call can't block
+ * if another task consumed the readiness first. Errors and hangups count as
+ * ready; the retried call reports them. Descriptors epoll can't watch, such
+ * as regular files, are always ready.
+ *
+ * @param fd File descriptor
+ * @param events QD_WAIT_READ or QD_WAIT_WRITE
+ * @return 0 on success, -1 if waiting failed (outside a task only, errno is set)
+ */
+int qd_wait_fd(int fd, int events);
+
+/**
+ * @brief Sleep for a duration
+ *
+ * @param nanoseconds Duration; 0 only lets other tasks run
+ */
+void qd_sleep(int64_t nanoseconds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // QD_QUADRATE_RUNTIME_COROUTINE_H
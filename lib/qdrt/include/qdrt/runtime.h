@@ -56,6 +56,18 @@ qd_exec_result qd_push_f(qd_context* ctx, double value);
  */
 qd_exec_result qd_push_s(qd_context* ctx, const char* value);
 
+/**
+ * @brief Push an interned string literal onto the stack
+ *
+ * @param ctx Execution context
+ * @param value Literal with static storage duration (not copied)
+ * @return Execution result (0 on success)
+ *
+ * @note Used by generated code for string literals; no allocation happens
+ *       unless a consumer needs its own copy
+ */
+qd_exec_result qd_push_lit(qd_context* ctx, const char* value);
+
 /**
  * @brief Push a pointer onto the stack
  *
@@ -487,7 +499,16 @@ qd_exec_result qd_casts(qd_context* ctx);
  */
 
 /**
- * @brief Spawn a new thread
+ * @brief Spawn a new task
+ *
+ * Pops a function pointer and queues the function to run with a fresh
+ * context on the runtime's worker pool (one thread per core, QD_WORKERS
+ * overrides the count). Each task is a coroutine with its own machine
+ * stack, so thousands of them can be blocked at once without holding a
+ * thread each. Pushes a handle that must be passed to wait or detach
+ * exactly once. The task's data stack has the same capacity as the
+ * spawning context's, and grows the same way. The task starts with an empty
+ * stack; use qd_spawn_args() to pass it values.
  *
  * @param ctx Execution context
  * @return Execution result (0 on success)
@@ -495,7 +516,39 @@ qd_exec_result qd_casts(qd_context* ctx);
 qd_exec_result qd_spawn(qd_context* ctx);
 
 /**
- * @brief Detach a thread
+ * @brief Spawn a new task with arguments
+ *
+ * Pops an argument count and a function pointer, then moves that many
+ * elements from below them onto the new task's stack, in the same order:
+ * ( args... fn n -- task ). Strings are handed over, not copied. Otherwise
+ * like qd_spawn().
+ *
+ * @param ctx Execution context
+ * @return Execution result (0 on success)
+ */
+qd_exec_result qd_spawn_args(qd_context* ctx);
+
+/**
+ * @brief Spawn a new task with its own data stack size
+ *
+ * Pops a function pointer and moves the arg_count elements below it onto the
+ * new task's stack, like qd_spawn_args() but with the count passed directly.
+ * The task's data stack holds stack_size elements instead of inheriting the
+ * spawner's capacity; it still grows the same way as the spawner's. This is
+ * for embedders and runtime code, programs use spawn and spawn_args.
+ *
+ * @param ctx Execution context
+ * @param arg_count Number of elements to pass
+ * @param stack_size Capacity of the task's data stack in elements (0 to inherit)
+ * @return Execution result (0 on success)
+ */
+qd_exec_result qd_spawn_sized(qd_context* ctx, size_t arg_count, size_t stack_size);
+
+/**
+ * @brief Detach a task
+ *
+ * Pops a task handle and releases it; the task still runs to completion
+ * unless the process exits first.
  *
  * @param ctx Execution context
  * @return Execution result (0 on success)
@@ -503,13 +556,87 @@ qd_exec_result qd_spawn(qd_context* ctx);
 qd_exec_result qd_detach(qd_context* ctx);
 
 /**
- * @brief Wait for a thread to complete
+ * @brief Wait for a task to complete
+ *
+ * Pops a task handle. If no worker has started the task yet, it runs on
+ * the calling thread instead of blocking. A task that waits parks until the
+ * other one is done.
  *
  * @param ctx Execution context
  * @return Execution result (0 on success)
  */
 qd_exec_result qd_wait(qd_context* ctx);
 
+/**
+ * @brief Let other tasks run
+ *
+ * In a task, requeues it behind the tasks that are ready to run. Blocking
+ * network and timer calls in a task park it the same way until they can
+ * proceed, so a worker thread is never held up waiting. Elsewhere this only
+ * yields the thread.
+ *
+ * @param ctx Execution context
+ * @return Execution result (0 on success)
+ */
+qd_exec_result qd_yield(qd_context* ctx);
+
+/**
+ * @brief Create a channel
+ *
+ * Pops a capacity and pushes a bounded channel for passing values between
+ * tasks. Any number of tasks can send and receive on it; values come out in
+ * the order they went in. The channel is released with mem::free once no
+ * task uses it anymore.
+ *
+ * @param ctx Execution context
+ * @return Execution result (0 on success)
+ */
+qd_exec_result qd_chan(qd_context* ctx);
+
+/**
+ * @brief Send a value to a channel
+ *
+ * Pops a value and a channel and appends the value, waiting while the
+ * channel is full. Strings move to the receiver without being copied.
+ * Sending on a closed channel is a fatal error.
+ *
+ * @param ctx Execution context
+ * @return Execution result (0 on success)
+ */
+qd_exec_result qd_send(qd_context* ctx);
+
+/**
+ * @brief Receive a value from a channel
+ *
+ * Pops a channel and waits for a value, then pushes it followed by 1. Once
+ * the channel is closed and empty, pushes 0 and 0 instead.
+ *
+ * @param ctx Execution context
+ * @return Execution result (0 on success)
+ */
+qd_exec_result qd_recv(qd_context* ctx);
+
+/**
+ * @brief Receive a value from a channel without waiting
+ *
+ * Like qd_recv(), but pushes 0 and 0 right away if the channel is empty.
+ *
+ * @param ctx Execution context
+ * @return Execution result (0 on success)
+ */
+qd_exec_result qd_try_recv(qd_context* ctx);
+
+/**
+ * @brief Close a channel
+ *
+ * Pops a channel. Waiting senders and receivers wake up; receivers still
+ * get the values that were sent before. Closing twice has no effect.
+ *
+ * @param ctx Execution context
+ * @return Execution result (0 on success)
+ */
+qd_exec_result qd_close(qd_context* ctx);
+
 /** @} */ // end of Threading group
 
 /**
@@ -576,6 +703,20 @@ qd_exec_result qd_err_push(qd_context* ctx, qd_stack_error value);
  */
 void qd_check_stack(qd_context* ctx, size_t count, const qd_stack_type* types, const char* func_name);
 
+/**
+ * @brief Check stack size and types, accepting int for float and vice versa
+ *
+ * Like qd_check_stack(), but an int or float parameter accepts either
+ * numeric type. Used by the stack adapters of native entry points, which
+ * convert between the two the same way castf and casti do.
+ *
+ * @param ctx Execution context
+ * @param count Number of elements to check
+ * @param types Array of expected types (length must be >= count)
+ * @param func_name Function name for error messages
+ */
+void qd_check_stack_numeric(qd_context* ctx, size_t count, const qd_stack_type* types, const char* func_name);
+
 /** @} */ // end of StackValidation group
 
 /**
@@ -597,6 +738,21 @@ void qd_check_stack(qd_context* ctx, size_t count, const qd_stack_type* types, c
  */
 qd_context* qd_create_context(size_t stack_size);
 
+/**
+ * @brief Create a new execution context whose stack commits memory as it grows
+ *
+ * Like qd_create_context(), but the stack only reserves address space for
+ * stack_size elements (see qd_stack_init_growable()), so deep recursion or
+ * bulk data on the stack can use a large capacity without paying for it
+ * up front. Tasks spawned from the context get the same kind of stack.
+ *
+ * @param stack_size Maximum number of elements the stack can hold
+ * @return Pointer to the new context, or NULL on failure
+ *
+ * @note The caller is responsible for freeing the context with qd_free_context()
+ */
+qd_context* qd_create_context_growable(size_t stack_size);
+
 /**
  * @brief Free an execution context
  *
@@ -621,6 +777,24 @@ void qd_free_context(qd_context* ctx);
  */
 qd_context* qd_clone_context(const qd_context* src);
 
+/**
+ * @brief Clone an execution context with only the top of its stack
+ *
+ * Like qd_clone_context(), but the clone's stack holds only the top depth
+ * elements of the source stack, and room for capacity elements (see
+ * qd_stack_clone_top()). The compiler uses this for ctx blocks whose reach
+ * below the top of the stack and peak height are known, so entering them
+ * costs neither a copy nor an allocation of the whole stack.
+ *
+ * @param src Source context to clone
+ * @param depth Number of elements to copy from the top (clamped to the stack size)
+ * @param capacity Capacity of the clone's stack
+ * @return Pointer to the cloned context, or NULL on failure
+ *
+ * @note The caller is responsible for freeing the cloned context with qd_free_context()
+ */
+qd_context* qd_clone_context_window(const qd_context* src, size_t depth, size_t capacity);
+
 /** @} */ // end of ContextManagement group
 
 /**
@@ -48,19 +48,65 @@ typedef enum {
  *
  * Each stack element contains a value, its type tag, and an error taint flag
  * used for error propagation in Quadrate programs.
+ *
+ * Strings are either owned (heap copies freed by the stack or whoever pops
+ * them) or borrowed (interned literals that outlive the stack and are never
+ * freed). The borrowed flag lives in the padding after the taint flag, so
+ * the element stays 16 bytes.
  */
 typedef struct {
 	union {
 		int64_t i; ///< Integer value
 		double f;  ///< Float value
 		void* p;   ///< Pointer value
-		char* s;   ///< String value (owned by stack)
+		char* s;   ///< String value (owned by stack unless is_borrowed)
 	} value;
 
 	qd_stack_type type;	   ///< Type of the stored value
 	bool is_error_tainted; ///< Error propagation flag
+	bool is_borrowed;	   ///< String is not owned and must not be freed (QD_STACK_TYPE_STR only)
 } qd_stack_element_t;
 
+#ifdef QD_COMPACT_STACK
+
+/**
+ * @brief Untagged 8-byte stack slot (compact layout only)
+ */
+typedef union {
+	int64_t i; ///< Integer value
+	double f;  ///< Float value
+	void* p;   ///< Pointer value
+	char* s;   ///< String value (owned by stack unless borrowed)
+} qd_stack_value_t;
+
+/**
+ * @defgroup CompactTags Compact Stack Tag Bits
+ * @brief Layout of the per-slot tag byte when built with QD_COMPACT_STACK
+ * @{
+ */
+#define QD_STACK_TAG_TYPE_MASK 0x03u ///< qd_stack_type of the slot
+#define QD_STACK_TAG_TAINTED 0x04u	 ///< Error propagation flag
+#define QD_STACK_TAG_BORROWED 0x08u	 ///< String is not owned and must not be freed
+/** @} */
+
+/**
+ * @brief Stack structure (compact layout)
+ *
+ * Values and tags are kept in two parallel arrays, so a slot costs 9 bytes
+ * instead of 16 and the value array packs eight slots per cache line.
+ * The first three fields keep the positions of the default layout, so
+ * LLVM codegen only differs in how it addresses a slot.
+ */
+typedef struct qd_stack {
+	qd_stack_value_t* data; ///< Array of slot values
+	size_t capacity;		///< Maximum stack capacity
+	size_t size;			///< Current number of elements
+	uint8_t* tags;			///< Array of slot tags (type and flag bits)
+	size_t reserved;		///< Bytes mapped for both arrays by qd_stack_init_growable(), 0 if allocated
+} qd_stack;
+
+#else
+
 /**
  * @brief Stack structure
  *
@@ -71,8 +117,13 @@ typedef struct qd_stack {
 	qd_stack_element_t* data;  ///< Array of stack elements
 	size_t capacity;            ///< Maximum stack capacity
 	size_t size;                ///< Current number of elements
+	size_t reserved;            ///< Bytes mapped for data by qd_stack_init_growable(), 0 if allocated
 } qd_stack;
 
+#endif
+
+#define QD_STACK_CLONE_MIN_CAPACITY 16 ///< Smallest capacity qd_stack_clone_top() gives a clone
+
 /**
  * @brief Initialize a new stack with the specified capacity
  *
@@ -84,6 +135,23 @@ typedef struct qd_stack {
  */
 qd_stack_error qd_stack_init(qd_stack** stack, size_t capacity);
 
+/**
+ * @brief Initialize a stack that only uses memory as it grows
+ *
+ * Reserves address space for capacity elements instead of allocating it.
+ * The kernel commits pages the first time the stack reaches them, so a
+ * large capacity only costs the memory that is actually used, and the
+ * element array never moves. A guard page after the array makes a write
+ * past the capacity fault instead of corrupting memory.
+ *
+ * @param[out] stack Pointer to receive the allocated stack
+ * @param capacity Maximum number of elements the stack can hold
+ * @return QD_STACK_OK on success, error code otherwise
+ *
+ * @note Destroy it with qd_stack_destroy() like any other stack
+ */
+qd_stack_error qd_stack_init_growable(qd_stack** stack, size_t capacity);
+
 /**
  * @brief Destroy a stack and free all associated resources
  *
@@ -96,18 +164,38 @@ void qd_stack_destroy(qd_stack* stack);
 /**
  * @brief Clone a stack (deep copy)
  *
- * Creates a deep copy of the source stack, including all string values.
+ * Creates a deep copy of the source stack, including all owned string values.
  * The cloned stack will have the same capacity and contents as the source.
+ * It is never growable, even if the source is; only long-lived stacks such as
+ * task and main stacks are worth reserving a growable mapping for.
  *
  * @param[out] dest Pointer to receive the cloned stack
  * @param src Source stack to clone
  * @return QD_STACK_OK on success, error code otherwise
  *
  * @note The caller is responsible for calling qd_stack_destroy() on the cloned stack
- * @note All strings in the stack are deep copied
+ * @note Owned strings are deep copied, borrowed strings are shared
  */
 qd_stack_error qd_stack_clone(qd_stack** dest, const qd_stack* src);
 
+/**
+ * @brief Clone the top elements of a stack (deep copy)
+ *
+ * Like qd_stack_clone(), but only the top count elements are copied; they
+ * become the whole contents of the clone, in the same order. The clone holds
+ * capacity elements, raised to at least count and QD_STACK_CLONE_MIN_CAPACITY,
+ * so cost depends on the window, not on the depth or capacity of the source.
+ *
+ * @param[out] dest Pointer to receive the cloned stack
+ * @param src Source stack to clone
+ * @param count Number of elements to copy from the top (clamped to the size of src)
+ * @param capacity Capacity of the clone
+ * @return QD_STACK_OK on success, error code otherwise
+ *
+ * @note The caller is responsible for calling qd_stack_destroy() on the cloned stack
+ */
+qd_stack_error qd_stack_clone_top(qd_stack** dest, const qd_stack* src, size_t count, size_t capacity);
+
 /**
  * @brief Push a 64-bit integer onto the stack
  *
@@ -148,6 +236,56 @@ qd_stack_error qd_stack_push_ptr(qd_stack* stack, void* value);
  */
 qd_stack_error qd_stack_push_str(qd_stack* stack, const char* value);
 
+/**
+ * @brief Push a string onto the stack without copying it
+ *
+ * @param stack Target stack
+ * @param value String to push (not copied, never freed)
+ * @return QD_STACK_OK on success, error code otherwise
+ *
+ * @note Intended for interned string literals; the string must outlive the stack
+ * @note Popping with qd_stack_pop() hands out an owned copy, qd_stack_pop_ref() does not
+ */
+qd_stack_error qd_stack_push_str_borrowed(qd_stack* stack, const char* value);
+
+/**
+ * @brief Push a heap-allocated string onto the stack, taking ownership
+ *
+ * @param stack Target stack
+ * @param value String allocated with malloc() (not copied)
+ * @return QD_STACK_OK on success, error code otherwise
+ *
+ * @note On success the stack owns the string; on failure the caller still does
+ */
+qd_stack_error qd_stack_push_str_owned(qd_stack* stack, char* value);
+
+/**
+ * @brief Push a copy of an element onto the stack
+ *
+ * Owned strings are duplicated, borrowed strings share the same storage.
+ * The pushed copy is not error-tainted.
+ *
+ * @param stack Target stack
+ * @param element Element to copy (may point into the same stack)
+ * @return QD_STACK_OK on success, error code otherwise
+ */
+qd_stack_error qd_stack_push_copy(qd_stack* stack, const qd_stack_element_t* element);
+
+/**
+ * @brief Push an element, taking ownership of its string
+ *
+ * Pushes an element obtained from qd_stack_pop() or qd_stack_pop_ref()
+ * without copying it, e.g. to move a value from one stack to another.
+ * The pushed element is not error-tainted.
+ *
+ * @param stack Target stack
+ * @param element Element to move
+ * @return QD_STACK_OK on success, error code otherwise
+ *
+ * @note On success the stack owns the string; on failure the caller still does
+ */
+qd_stack_error qd_stack_push_move(qd_stack* stack, const qd_stack_element_t* element);
+
 /**
  * @brief Peek at the top element without removing it
  *
@@ -157,6 +295,55 @@ qd_stack_error qd_stack_push_str(qd_stack* stack, const char* value);
  */
 qd_stack_error qd_stack_peek(qd_stack* stack, qd_stack_element_t* element);
 
+/**
+ * @brief Get the type of the top element
+ *
+ * @param stack Source stack
+ * @param[out] type Receives the type of the top element
+ * @return QD_STACK_OK on success, QD_STACK_ERR_UNDERFLOW if stack is empty
+ */
+qd_stack_error qd_stack_top_type(const qd_stack* stack, qd_stack_type* type);
+
+/**
+ * @brief Read the top element as an integer without removing it
+ *
+ * @param stack Source stack
+ * @param[out] value Receives the integer
+ * @return QD_STACK_OK on success, QD_STACK_ERR_UNDERFLOW if stack is empty,
+ *         QD_STACK_ERR_TYPE_MISMATCH if the top is not an integer
+ */
+qd_stack_error qd_stack_top_int(const qd_stack* stack, int64_t* value);
+
+/**
+ * @brief Read the top element as a float without removing it
+ *
+ * @param stack Source stack
+ * @param[out] value Receives the float
+ * @return QD_STACK_OK on success, QD_STACK_ERR_UNDERFLOW if stack is empty,
+ *         QD_STACK_ERR_TYPE_MISMATCH if the top is not a float
+ */
+qd_stack_error qd_stack_top_double(const qd_stack* stack, double* value);
+
+/**
+ * @brief Read the top element as a pointer without removing it
+ *
+ * @param stack Source stack
+ * @param[out] value Receives the pointer
+ * @return QD_STACK_OK on success, QD_STACK_ERR_UNDERFLOW if stack is empty,
+ *         QD_STACK_ERR_TYPE_MISMATCH if the top is not a pointer
+ */
+qd_stack_error qd_stack_top_ptr(const qd_stack* stack, void** value);
+
+/**
+ * @brief Read the top element as a string without removing it
+ *
+ * @param stack Source stack
+ * @param[out] value Receives the string, which still belongs to the stack
+ * @return QD_STACK_OK on success, QD_STACK_ERR_UNDERFLOW if stack is empty,
+ *         QD_STACK_ERR_TYPE_MISMATCH if the top is not a string
+ */
+qd_stack_error qd_stack_top_str(const qd_stack* stack, const char** value);
+
 /**
  * @brief Get element at a specific index (0 = bottom, size-1 = top)
  *
@@ -173,9 +360,58 @@ qd_stack_error qd_stack_element(qd_stack* stack, size_t index, qd_stack_element_
  * @param stack Source stack
  * @param[out] element Receives the popped element
  * @return QD_STACK_OK on success, QD_STACK_ERR_UNDERFLOW if stack is empty
+ *
+ * @note The caller owns a popped string; borrowed strings are copied first
  */
 qd_stack_error qd_stack_pop(qd_stack* stack, qd_stack_element_t* element);
 
+/**
+ * @brief Pop the top element without taking ownership of borrowed strings
+ *
+ * Unlike qd_stack_pop(), a borrowed string is handed out as-is instead of
+ * being copied. Release the element with qd_stack_element_release().
+ *
+ * @param stack Source stack
+ * @param[out] element Receives the popped element
+ * @return QD_STACK_OK on success, QD_STACK_ERR_UNDERFLOW if stack is empty
+ */
+qd_stack_error qd_stack_pop_ref(qd_stack* stack, qd_stack_element_t* element);
+
+/**
+ * @brief Release resources held by a popped element
+ *
+ * Frees owned strings; borrowed strings and other types are left alone.
+ *
+ * @param element Element obtained from qd_stack_pop() or qd_stack_pop_ref() (can be NULL)
+ */
+void qd_stack_element_release(qd_stack_element_t* element);
+
+/**
+ * @brief Move an element to the top of the stack
+ *
+ * The element @p depth positions below the top is moved to the top and the
+ * elements above it shift down by one, without copying any strings.
+ * Depth 1 is swap, depth 2 is rot. Moved elements are not error-tainted.
+ *
+ * @param stack Target stack
+ * @param depth Position of the element to move (0 = top, which is a no-op)
+ * @return QD_STACK_OK on success, QD_STACK_ERR_UNDERFLOW if depth is out of range
+ */
+qd_stack_error qd_stack_roll(qd_stack* stack, size_t depth);
+
+/**
+ * @brief Remove an element from inside the stack
+ *
+ * The element @p depth positions below the top is released and the
+ * elements above it shift down by one. Depth 1 is nip.
+ * Moved elements are not error-tainted.
+ *
+ * @param stack Target stack
+ * @param depth Position of the element to remove (0 = top)
+ * @return QD_STACK_OK on success, QD_STACK_ERR_UNDERFLOW if depth is out of range
+ */
+qd_stack_error qd_stack_remove(qd_stack* stack, size_t depth);
+
 /**
  * @brief Get the current number of elements on the stack
  *
@@ -192,6 +428,25 @@ size_t qd_stack_size(const qd_stack* stack);
  */
 size_t qd_stack_capacity(const qd_stack* stack);
 
+/**
+ * @brief Check if the stack was created with qd_stack_init_growable()
+ *
+ * @param stack Target stack
+ * @return true if the stack commits memory as it grows, false otherwise
+ */
+bool qd_stack_is_growable(const qd_stack* stack);
+
+/**
+ * @brief Return the memory of a growable stack's unused pages to the system
+ *
+ * Pages above the elements in use are released (the first page is kept),
+ * so a stack that once grew deep stops holding on to that memory. The
+ * address space stays reserved and is committed again when reached.
+ *
+ * @param stack Target stack; stacks that aren't growable are left alone
+ */
+void qd_stack_release_unused(qd_stack* stack);
+
 /**
  * @brief Check if the stack is empty
  *
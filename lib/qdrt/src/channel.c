@@ -0,0 +1,238 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "channel.h"
+#include "scheduler.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Keeps the producer and consumer positions from sharing a cache line
+#define QD_CACHE_LINE 64
+
+// Each slot's sequence says whose turn it is: pos when free for the sender claiming position pos,
+// pos + 1 once that value is in it, pos + slot_count after it was received (free for the next lap).
+// With a single slot "full" and "free for the next lap" would both be pos + 1, so there are always at
+// least two slots and capacity bounds the values in flight separately.
+typedef struct {
+	_Atomic size_t sequence;
+	qd_stack_element_t element;
+} qd_channel_slot;
+
+// A task or thread waiting for the channel to change
+typedef struct qd_channel_waiter {
+	qd_task* task; // NULL for threads outside the pool, which wait on the channel's condition variable
+	bool woken;
+	struct qd_channel_waiter* next;
+} qd_channel_waiter;
+
+typedef struct {
+	qd_channel_waiter* head;
+	qd_channel_waiter* tail;
+	_Atomic size_t count; // Waiters in the list or about to be, read without the lock
+} qd_waiter_list;
+
+struct qd_channel {
+	_Alignas(QD_CACHE_LINE) _Atomic size_t tail; // Next position to send to
+	_Alignas(QD_CACHE_LINE) _Atomic size_t head; // Next position to receive from
+	_Alignas(QD_CACHE_LINE) _Atomic bool closed;
+	size_t capacity;   // Values it holds before send waits
+	size_t slot_count; // Slots in the ring, at least 2
+
+	pthread_mutex_t lock; // Waiter lists
+	pthread_cond_t wake;
+	qd_waiter_list senders;
+	qd_waiter_list receivers;
+
+	qd_channel_slot slots[];
+};
+
+qd_channel* qd_channel_create(size_t capacity) {
+	size_t slot_count = capacity < 2 ? 2 : capacity;
+	size_t size = sizeof(qd_channel) + sizeof(qd_channel_slot) * slot_count;
+	size = (size + QD_CACHE_LINE - 1) / QD_CACHE_LINE * QD_CACHE_LINE;
+	qd_channel* channel = aligned_alloc(QD_CACHE_LINE, size);
+	if (!channel) {
+		return NULL;
+	}
+	memset(channel, 0, size);
+
+	channel->capacity = capacity;
+	channel->slot_count = slot_count;
+	pthread_mutex_init(&channel->lock, NULL);
+	pthread_cond_init(&channel->wake, NULL);
+	for (size_t i = 0; i < slot_count; i++) {
+		atomic_init(&channel->slots[i].sequence, i);
+	}
+	return channel;
+}
+
+static bool try_send(qd_channel* channel, const qd_stack_element_t* element) {
+	size_t pos = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+	for (;;) {
+		qd_channel_slot* slot = &channel->slots[pos % channel->slot_count];
+		size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+		if (diff == 0) {
+			// Only needed when there are more slots than capacity; head only moves forward, so a stale
+			// value can only make the channel look full
+			if (channel->capacity < channel->slot_count &&
+					pos - atomic_load_explicit(&channel->head, memory_order_acquire) >= channel->capacity) {
+				return false;
+			}
+			if (atomic_compare_exchange_weak_explicit(
+						&channel->tail, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				slot->element = *element;
+				atomic_store_explicit(&slot->sequence, pos + 1, memory_order_release);
+				return true;
+			}
+		} else if (diff < 0) {
+			return false; // Full: the slot still holds a value from the previous lap
+		} else {
+			pos = atomic_load_explicit(&channel->tail, memory_order_relaxed);
+		}
+	}
+}
+
+static bool try_recv(qd_channel* channel, qd_stack_element_t* element) {
+	size_t pos = atomic_load_explicit(&channel->head, memory_order_relaxed);
+	for (;;) {
+		qd_channel_slot* slot = &channel->slots[pos % channel->slot_count];
+		size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+		intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+		if (diff == 0) {
+			if (atomic_compare_exchange_weak_explicit(
+						&channel->head, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				*element = slot->element;
+				atomic_store_explicit(&slot->sequence, pos + channel->slot_count, memory_order_release);
+				return true;
+			}
+		} else if (diff < 0) {
+			return false; // Empty
+		} else {
+			pos = atomic_load_explicit(&channel->head, memory_order_relaxed);
+		}
+	}
+}
+
+// Called with the lock held
+static void wake_waiter(qd_channel* channel, qd_waiter_list* list) {
+	qd_channel_waiter* waiter = list->head;
+	list->head = waiter->next;
+	if (!list->head) {
+		list->tail = NULL;
+	}
+	atomic_fetch_sub(&list->count, 1);
+
+	// The waiter lives on its owner's stack: don't touch it once the owner may run again
+	qd_task* task = waiter->task;
+	waiter->woken = true;
+	if (task) {
+		qd_task_ready(task);
+	} else {
+		pthread_cond_broadcast(&channel->wake);
+	}
+}
+
+// After a send or receive: wake one waiter on the other side, if any. Waiters announce themselves
+// in count before retrying their operation, so either they see our change or we see them.
+static void wake_one(qd_channel* channel, qd_waiter_list* list) {
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load(&list->count) == 0) {
+		return;
+	}
+	pthread_mutex_lock(&channel->lock);
+	if (list->head) {
+		wake_waiter(channel, list);
+	}
+	pthread_mutex_unlock(&channel->lock);
+}
+
+// Called with the lock held and count already incremented; returns with the lock released
+static void wait_in(qd_channel* channel, qd_waiter_list* list) {
+	qd_channel_waiter waiter = {.task = qd_task_current(), .woken = false, .next = NULL};
+	if (list->tail) {
+		list->tail->next = &waiter;
+	} else {
+		list->head = &waiter;
+	}
+	list->tail = &waiter;
+
+	if (waiter.task) {
+		qd_task_park(&channel->lock);
+		return;
+	}
+	while (!waiter.woken) {
+		pthread_cond_wait(&channel->wake, &channel->lock);
+	}
+	pthread_mutex_unlock(&channel->lock);
+}
+
+bool qd_channel_send(qd_channel* channel, const qd_stack_element_t* element) {
+	for (;;) {
+		if (atomic_load(&channel->closed)) {
+			return false;
+		}
+		if (try_send(channel, element)) {
+			wake_one(channel, &channel->receivers);
+			return true;
+		}
+
+		// Full: announce, then check again before waiting
+		pthread_mutex_lock(&channel->lock);
+		atomic_fetch_add(&channel->senders.count, 1);
+		if (atomic_load(&channel->closed)) {
+			atomic_fetch_sub(&channel->senders.count, 1);
+			pthread_mutex_unlock(&channel->lock);
+			return false;
+		}
+		if (try_send(channel, element)) {
+			atomic_fetch_sub(&channel->senders.count, 1);
+			pthread_mutex_unlock(&channel->lock);
+			wake_one(channel, &channel->receivers);
+			return true;
+		}
+		wait_in(channel, &channel->senders);
+	}
+}
+
+bool qd_channel_recv(qd_channel* channel, qd_stack_element_t* element, bool block) {
+	for (;;) {
+		if (try_recv(channel, element)) {
+			wake_one(channel, &channel->senders);
+			return true;
+		}
+		if (!block) {
+			return false;
+		}
+
+		// Empty: announce, then check again before waiting
+		pthread_mutex_lock(&channel->lock);
+		atomic_fetch_add(&channel->receivers.count, 1);
+		if (try_recv(channel, element)) {
+			atomic_fetch_sub(&channel->receivers.count, 1);
+			pthread_mutex_unlock(&channel->lock);
+			wake_one(channel, &channel->senders);
+			return true;
+		}
+		if (atomic_load(&channel->closed)) {
+			atomic_fetch_sub(&channel->receivers.count, 1);
+			pthread_mutex_unlock(&channel->lock);
+			return false;
+		}
+		wait_in(channel, &channel->receivers);
+	}
+}
+
+void qd_channel_close(qd_channel* channel) {
+	pthread_mutex_lock(&channel->lock);
+	atomic_store(&channel->closed, true);
+	while (channel->senders.head) {
+		wake_waiter(channel, &channel->senders);
+	}
+	while (channel->receivers.head) {
+		wake_waiter(channel, &channel->receivers);
+	}
+	pthread_mutex_unlock(&channel->lock);
+}
@@ -0,0 +1,63 @@
+/**
+ * @file channel.h
+ * @brief Bounded multi-producer multi-consumer channels of stack elements
+ *
+ * Values live in a lock-free ring buffer; sending and receiving only take a
+ * lock when the channel is full or empty and someone has to wait. Waiting
+ * tasks park (see scheduler.h), other threads block.
+ */
+
+#ifndef QD_QDRT_CHANNEL_H
+#define QD_QDRT_CHANNEL_H
+
+#include <qdrt/stack.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * @brief Channel handle
+ */
+typedef struct qd_channel qd_channel;
+
+/**
+ * @brief Create a channel
+ *
+ * The channel is a single allocation and can be released with free() once
+ * nothing uses it anymore.
+ *
+ * @param capacity Number of values it holds before send waits (at least 1)
+ * @return New channel, or NULL if out of memory
+ */
+qd_channel* qd_channel_create(size_t capacity);
+
+/**
+ * @brief Send a value, waiting while the channel is full
+ *
+ * @param channel Channel
+ * @param element Value; the channel takes ownership of its string on success
+ * @return false if the channel is closed
+ */
+bool qd_channel_send(qd_channel* channel, const qd_stack_element_t* element);
+
+/**
+ * @brief Receive a value
+ *
+ * Values sent before the channel was closed are still delivered.
+ *
+ * @param channel Channel
+ * @param[out] element Receives the value; the caller owns its string
+ * @param block Wait while the channel is empty and open
+ * @return false if no value was received (closed and drained, or empty with block false)
+ */
+bool qd_channel_recv(qd_channel* channel, qd_stack_element_t* element, bool block);
+
+/**
+ * @brief Close a channel
+ *
+ * Wakes everything waiting on it; further sends fail. Closing twice is harmless.
+ *
+ * @param channel Channel
+ */
+void qd_channel_close(qd_channel* channel);
+
+#endif // QD_QDRT_CHANNEL_H
@@ -0,0 +1,272 @@
+#define _GNU_SOURCE
+
+#include "reactor.h"
+#include <qdrt/coroutine.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+// Events taken from epoll per wakeup
+#define QD_REACTOR_EVENTS 256
+
+typedef struct {
+	qd_task** tasks;
+	size_t count;
+	size_t capacity;
+} qd_task_list;
+
+// Tasks parked on one file descriptor; any number of tasks can wait on the same one
+typedef struct {
+	qd_task_list readers;
+	qd_task_list writers;
+} qd_fd_waiters;
+
+typedef struct {
+	int64_t deadline; // CLOCK_MONOTONIC, nanoseconds
+	qd_task* task;
+} qd_timer;
+
+static struct {
+	pthread_once_t once;
+	pthread_mutex_t lock; // Everything below
+	int epoll_fd;
+	int timer_fd;
+
+	qd_fd_waiters* fds; // Indexed by file descriptor
+	size_t fd_capacity;
+
+	qd_timer* timers; // Min-heap on deadline
+	size_t timer_count;
+	size_t timer_capacity;
+} reactor = {
+		.once = PTHREAD_ONCE_INIT,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static void* reactor_main(void* arg);
+
+static int64_t monotonic_now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000LL + (int64_t)ts.tv_nsec;
+}
+
+static void reactor_init(void) {
+	reactor.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	reactor.timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (reactor.epoll_fd < 0 || reactor.timer_fd < 0) {
+		fprintf(stderr, "Fatal error in reactor: Failed to create epoll instance (%s)\n", strerror(errno));
+		abort();
+	}
+
+	struct epoll_event event = {.events = EPOLLIN, .data.fd = reactor.timer_fd};
+	epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, reactor.timer_fd, &event);
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pthread_t thread;
+	int result = pthread_create(&thread, &attr, reactor_main, NULL);
+	pthread_attr_destroy(&attr);
+	if (result != 0) {
+		fprintf(stderr, "Fatal error in reactor: pthread_create failed with error %d\n", result);
+		abort();
+	}
+}
+
+static void list_push(qd_task_list* list, qd_task* task) {
+	if (list->count == list->capacity) {
+		size_t capacity = list->capacity ? list->capacity * 2 : 4;
+		qd_task** tasks = realloc(list->tasks, sizeof(qd_task*) * capacity);
+		if (!tasks) {
+			fprintf(stderr, "Fatal error in reactor: Failed to allocate wait list\n");
+			abort();
+		}
+		list->tasks = tasks;
+		list->capacity = capacity;
+	}
+	list->tasks[list->count++] = task;
+}
+
+static void list_wake(qd_task_list* list) {
+	for (size_t i = 0; i < list->count; i++) {
+		qd_task_ready(list->tasks[i]);
+	}
+	list->count = 0;
+}
+
+// (Re)arm the one-shot registration of a descriptor for whatever its waiters need
+static bool fd_arm(int fd) {
+	qd_fd_waiters* waiters = &reactor.fds[fd];
+	uint32_t events = (waiters->readers.count ? EPOLLIN : 0) | (waiters->writers.count ? EPOLLOUT : 0);
+	if (!events) {
+		return true;
+	}
+
+	struct epoll_event event = {.events = events | EPOLLONESHOT, .data.fd = fd};
+	if (epoll_ctl(reactor.epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0) {
+		return true;
+	}
+	// Registrations disappear when a descriptor is closed, so a reused number needs ADD again
+	return errno == ENOENT && epoll_ctl(reactor.epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+void qd_reactor_watch(qd_task* task, int fd, int events) {
+	pthread_once(&reactor.once, reactor_init);
+
+	if (fd < 0 || fd == reactor.epoll_fd || fd == reactor.timer_fd) {
+		qd_task_ready(task);
+		return;
+	}
+
+	pthread_mutex_lock(&reactor.lock);
+	if ((size_t)fd >= reactor.fd_capacity) {
+		size_t capacity = reactor.fd_capacity ? reactor.fd_capacity : 64;
+		while (capacity <= (size_t)fd) {
+			capacity *= 2;
+		}
+		qd_fd_waiters* fds = realloc(reactor.fds, sizeof(qd_fd_waiters) * capacity);
+		if (!fds) {
+			fprintf(stderr, "Fatal error in reactor: Failed to allocate wait list\n");
+			abort();
+		}
+		memset(fds + reactor.fd_capacity, 0, sizeof(qd_fd_waiters) * (capacity - reactor.fd_capacity));
+		reactor.fds = fds;
+		reactor.fd_capacity = capacity;
+	}
+
+	qd_fd_waiters* waiters = &reactor.fds[fd];
+	list_push((events & QD_WAIT_READ) ? &waiters->readers : &waiters->writers, task);
+	if (!fd_arm(fd)) {
+		// Not pollable (EPERM for regular files) or invalid: let the retried call find out
+		list_wake(&waiters->readers);
+		list_wake(&waiters->writers);
+	}
+	pthread_mutex_unlock(&reactor.lock);
+}
+
+// Arm the timerfd for the earliest deadline, or disarm it
+static void timer_arm(void) {
+	struct itimerspec spec = {0};
+	if (reactor.timer_count > 0) {
+		int64_t deadline = reactor.timers[0].deadline;
+		spec.it_value.tv_sec = deadline / 1000000000LL;
+		spec.it_value.tv_nsec = deadline % 1000000000LL;
+		if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+			spec.it_value.tv_nsec = 1; // All zero would disarm
+		}
+	}
+	timerfd_settime(reactor.timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+void qd_reactor_sleep(qd_task* task, int64_t nanoseconds) {
+	pthread_once(&reactor.once, reactor_init);
+
+	pthread_mutex_lock(&reactor.lock);
+	if (reactor.timer_count == reactor.timer_capacity) {
+		size_t capacity = reactor.timer_capacity ? reactor.timer_capacity * 2 : 64;
+		qd_timer* timers = realloc(reactor.timers, sizeof(qd_timer) * capacity);
+		if (!timers) {
+			fprintf(stderr, "Fatal error in reactor: Failed to allocate timer\n");
+			abort();
+		}
+		reactor.timers = timers;
+		reactor.timer_capacity = capacity;
+	}
+
+	// Sift up
+	qd_timer timer = {.deadline = monotonic_now() + nanoseconds, .task = task};
+	size_t index = reactor.timer_count++;
+	while (index > 0 && reactor.timers[(index - 1) / 2].deadline > timer.deadline) {
+		reactor.timers[index] = reactor.timers[(index - 1) / 2];
+		index = (index - 1) / 2;
+	}
+	reactor.timers[index] = timer;
+
+	if (index == 0) {
+		timer_arm();
+	}
+	pthread_mutex_unlock(&reactor.lock);
+}
+
+static void timers_expire(void) {
+	uint64_t expirations;
+	while (read(reactor.timer_fd, &expirations, sizeof(expirations)) > 0) {
+	}
+
+	int64_t now = monotonic_now();
+	while (reactor.timer_count > 0 && reactor.timers[0].deadline <= now) {
+		qd_task_ready(reactor.timers[0].task);
+
+		// Sift the last timer down from the root
+		qd_timer last = reactor.timers[--reactor.timer_count];
+		size_t index = 0;
+		for (;;) {
+			size_t child = index * 2 + 1;
+			if (child >= reactor.timer_count) {
+				break;
+			}
+			if (child + 1 < reactor.timer_count &&
+					reactor.timers[child + 1].deadline < reactor.timers[child].deadline) {
+				child++;
+			}
+			if (reactor.timers[child].deadline >= last.deadline) {
+				break;
+			}
+			reactor.timers[index] = reactor.timers[child];
+			index = child;
+		}
+		if (reactor.timer_count > 0) {
+			reactor.timers[index] = last;
+		}
+	}
+	timer_arm();
+}
+
+static void* reactor_main(void* arg) {
+	(void)arg;
+	struct epoll_event events[QD_REACTOR_EVENTS];
+
+	for (;;) {
+		int count = epoll_wait(reactor.epoll_fd, events, QD_REACTOR_EVENTS, -1);
+		if (count < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			fprintf(stderr, "Fatal error in reactor: epoll_wait failed (%s)\n", strerror(errno));
+			abort();
+		}
+
+		pthread_mutex_lock(&reactor.lock);
+		for (int i = 0; i < count; i++) {
+			int fd = events[i].data.fd;
+			if (fd == reactor.timer_fd) {
+				timers_expire();
+				continue;
+			}
+
+			// Errors and hangups wake both sides; the retried calls report them
+			qd_fd_waiters* waiters = &reactor.fds[fd];
+			uint32_t ready = events[i].events;
+			if (ready & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+				list_wake(&waiters->readers);
+			}
+			if (ready & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+				list_wake(&waiters->writers);
+			}
+			if (!fd_arm(fd)) {
+				list_wake(&waiters->readers);
+				list_wake(&waiters->writers);
+			}
+		}
+		pthread_mutex_unlock(&reactor.lock);
+	}
+	return NULL;
+}
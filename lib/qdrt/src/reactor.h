@@ -0,0 +1,36 @@
+/**
+ * @file reactor.h
+ * @brief epoll reactor that resumes tasks parked on file descriptors and timers
+ *
+ * A single thread, started with the first parked task, waits on an epoll
+ * instance and a timerfd armed for the earliest sleeper, and hands tasks
+ * back to the scheduler with qd_task_ready().
+ */
+
+#ifndef QD_QDRT_REACTOR_H
+#define QD_QDRT_REACTOR_H
+
+#include "scheduler.h"
+#include <stdint.h>
+
+/**
+ * @brief Resume a parked task when a file descriptor is ready
+ *
+ * If the descriptor can't be watched (a regular file, a closed descriptor),
+ * the task is resumed right away and the call it retries reports the error.
+ *
+ * @param task Parked task
+ * @param fd File descriptor
+ * @param events QD_WAIT_READ or QD_WAIT_WRITE
+ */
+void qd_reactor_watch(qd_task* task, int fd, int events);
+
+/**
+ * @brief Resume a parked task after a delay
+ *
+ * @param task Parked task
+ * @param nanoseconds Delay
+ */
+void qd_reactor_sleep(qd_task* task, int64_t nanoseconds);
+
+#endif // QD_QDRT_REACTOR_H
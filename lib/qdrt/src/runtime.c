@@ -1,12 +1,13 @@
 #define _POSIX_C_SOURCE 200809L
 
+#include "channel.h"
+#include "scheduler.h"
 #include <qdrt/runtime.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
-#include <pthread.h>
 
 static void dump_stack(qd_context* ctx);
 
@@ -34,6 +35,14 @@ qd_exec_result qd_push_s(qd_context* ctx, const char* value) {
 	return (qd_exec_result){0};
 }
 
+qd_exec_result qd_push_lit(qd_context* ctx, const char* value) {
+	qd_stack_error err = qd_stack_push_str_borrowed(ctx->st, value);
+	if (err != QD_STACK_OK) {
+		return (qd_exec_result){-2};
+	}
+	return (qd_exec_result){0};
+}
+
 qd_exec_result qd_push_p(qd_context* ctx, void* value) {
 	qd_stack_error err = qd_stack_push_ptr(ctx->st, value);
 	if (err != QD_STACK_OK) {
@@ -45,7 +54,7 @@ qd_exec_result qd_push_p(qd_context* ctx, void* value) {
 qd_exec_result qd_print(qd_context* ctx) {
 	// Pop and print the top element
 	qd_stack_element_t val;
-	qd_stack_error err = qd_stack_pop(ctx->st, &val);
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &val);
 	if (err != QD_STACK_OK) {
 		return (qd_exec_result){-2};
 	}
@@ -59,7 +68,7 @@ qd_exec_result qd_print(qd_context* ctx) {
 			break;
 		case QD_STACK_TYPE_STR:
 			printf("%s", val.value.s);
-			free(val.value.s);  // Free the string memory after printing
+			qd_stack_element_release(&val);  // Free the string memory after printing
 			break;
 		default:
 			return (qd_exec_result){-3};
@@ -130,7 +139,7 @@ qd_exec_result qd_prints(qd_context* ctx) {
 qd_exec_result qd_printv(qd_context* ctx) {
 	// Forth-style verbose: pop and print the top element with type info
 	qd_stack_element_t val;
-	qd_stack_error err = qd_stack_pop(ctx->st, &val);
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &val);
 	if (err != QD_STACK_OK) {
 		return (qd_exec_result){-2};
 	}
@@ -149,7 +158,7 @@ qd_exec_result qd_printv(qd_context* ctx) {
 			} else {
 				printf("string:%s\n", val.value.s);
 			}
-			free(val.value.s);  // Free the string memory after printing
+			qd_stack_element_release(&val);  // Free the string memory after printing
 			break;
 		default:
 			return (qd_exec_result){-3};
@@ -293,9 +302,7 @@ static inline double to_double(const qd_stack_element_t* elem) {
 
 // Helper function to free string values if needed
 static void free_if_string(qd_stack_element_t* elem) {
-	if (elem->type == QD_STACK_TYPE_STR) {
-		free(elem->value.s);
-	}
+	qd_stack_element_release(elem);
 }
 
 qd_exec_result qd_div(qd_context* ctx) {
@@ -447,25 +454,11 @@ qd_exec_result qd_dup(qd_context* ctx) {
 		abort();
 	}
 
-	// Push a copy of the top element
-	switch (top.type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, top.value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, top.value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			// Need to duplicate the string
-			err = qd_stack_push_str(ctx->st, top.value.s);
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, top.value.p);
-			break;
-		default:
-			return (qd_exec_result){-3};
+	// Push a copy of the top element (borrowed strings are shared, owned ones duplicated)
+	err = qd_stack_push_copy(ctx->st, &top);
+	if (err == QD_STACK_ERR_TYPE_MISMATCH) {
+		return (qd_exec_result){-3};
 	}
-
 	if (err != QD_STACK_OK) {
 		return (qd_exec_result){-2};
 	}
@@ -947,61 +940,8 @@ qd_exec_result qd_swap(qd_context* ctx) {
 		abort();
 	}
 
-	// Pop top two elements
-	qd_stack_element_t a, b;
-	qd_stack_error err = qd_stack_pop(ctx->st, &b);  // b is top
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-	err = qd_stack_pop(ctx->st, &a);  // a is second
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-
-	// Push them back in swapped order (b first, then a)
-	// Push b (was top, now will be second)
-	switch (b.type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, b.value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, b.value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			err = qd_stack_push_str(ctx->st, b.value.s);
-			free(b.value.s);  // Free the original since push_str makes a copy
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, b.value.p);
-			break;
-		default:
-			return (qd_exec_result){-3};
-	}
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-
-	// Push a (was second, now will be top)
-	switch (a.type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, a.value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, a.value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			err = qd_stack_push_str(ctx->st, a.value.s);
-			free(a.value.s);  // Free the original since push_str makes a copy
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, a.value.p);
-			break;
-		default:
-			return (qd_exec_result){-3};
-	}
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
+	// Swap in place so strings keep their storage (moved values are untainted, like fresh pushes)
+	qd_stack_roll(ctx->st, 1);
 
 	return (qd_exec_result){0};
 }
@@ -1027,24 +967,10 @@ qd_exec_result qd_over(qd_context* ctx) {
 	}
 
 	// Push a copy of the second element to the top
-	switch (second.type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, second.value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, second.value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			// Need to duplicate the string
-			err = qd_stack_push_str(ctx->st, second.value.s);
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, second.value.p);
-			break;
-		default:
-			return (qd_exec_result){-3};
+	err = qd_stack_push_copy(ctx->st, &second);
+	if (err == QD_STACK_ERR_TYPE_MISMATCH) {
+		return (qd_exec_result){-3};
 	}
-
 	if (err != QD_STACK_OK) {
 		return (qd_exec_result){-2};
 	}
@@ -1062,47 +988,8 @@ qd_exec_result qd_nip(qd_context* ctx) {
 		abort();
 	}
 
-	// Pop the top element
-	qd_stack_element_t top;
-	qd_stack_error err = qd_stack_pop(ctx->st, &top);
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-
-	// Pop the second element (which we want to discard)
-	qd_stack_element_t second;
-	err = qd_stack_pop(ctx->st, &second);
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-
-	// Free string memory if necessary
-	if (second.type == QD_STACK_TYPE_STR) {
-		free(second.value.s);
-	}
-
-	// Push the top element back
-	switch (top.type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, top.value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, top.value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			err = qd_stack_push_str(ctx->st, top.value.s);
-			free(top.value.s);  // Free the original since push_str makes a copy
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, top.value.p);
-			break;
-		default:
-			return (qd_exec_result){-3};
-	}
-
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
+	// Free string memory if necessary, then move the top element down in place
+	qd_stack_remove(ctx->st, 1);
 
 	return (qd_exec_result){0};
 }
@@ -1861,7 +1748,8 @@ static void dump_stack(qd_context* ctx) {
 	}
 }
 
-void qd_check_stack(qd_context* ctx, size_t count, const qd_stack_type* types, const char* func_name) {
+// With numeric set, int and float parameters accept either numeric type
+static void check_stack(qd_context* ctx, size_t count, const qd_stack_type* types, const char* func_name, bool numeric) {
 	// Check stack has enough elements
 	size_t stack_size = qd_stack_size(ctx->st);
 	if (stack_size < count) {
@@ -1888,7 +1776,7 @@ void qd_check_stack(qd_context* ctx, size_t count, const qd_stack_type* types, c
 			abort();
 		}
 
-		if (elem.type != types[i]) {
+		if (elem.type != types[i] && !(numeric && is_numeric_type(elem.type) && is_numeric_type(types[i]))) {
 			const char* expected_type_name = "";
 			const char* actual_type_name = "";
 
@@ -1915,6 +1803,14 @@ void qd_check_stack(qd_context* ctx, size_t count, const qd_stack_type* types, c
 	}
 }
 
+void qd_check_stack(qd_context* ctx, size_t count, const qd_stack_type* types, const char* func_name) {
+	check_stack(ctx, count, types, func_name, false);
+}
+
+void qd_check_stack_numeric(qd_context* ctx, size_t count, const qd_stack_type* types, const char* func_name) {
+	check_stack(ctx, count, types, func_name, true);
+}
+
 // drop - remove top element from stack: ( a -- )
 qd_exec_result qd_drop(qd_context* ctx) {
 	size_t stack_size = qd_stack_size(ctx->st);
@@ -1925,17 +1821,12 @@ qd_exec_result qd_drop(qd_context* ctx) {
 		abort();
 	}
 
-	qd_stack_element_t val;
-	qd_stack_error err = qd_stack_pop(ctx->st, &val);
+	// Popping without an element frees owned strings
+	qd_stack_error err = qd_stack_pop(ctx->st, NULL);
 	if (err != QD_STACK_OK) {
 		return (qd_exec_result){-2};
 	}
 
-	// Free string if needed
-	if (val.type == QD_STACK_TYPE_STR) {
-		free(val.value.s);
-	}
-
 	return (qd_exec_result){0};
 }
 
@@ -1949,24 +1840,15 @@ qd_exec_result qd_drop2(qd_context* ctx) {
 		abort();
 	}
 
-	qd_stack_element_t val;
-	// Drop first element
-	qd_stack_error err = qd_stack_pop(ctx->st, &val);
+	// Drop both elements; popping without an element frees owned strings
+	qd_stack_error err = qd_stack_pop(ctx->st, NULL);
 	if (err != QD_STACK_OK) {
 		return (qd_exec_result){-2};
 	}
-	if (val.type == QD_STACK_TYPE_STR) {
-		free(val.value.s);
-	}
-
-	// Drop second element
-	err = qd_stack_pop(ctx->st, &val);
+	err = qd_stack_pop(ctx->st, NULL);
 	if (err != QD_STACK_OK) {
 		return (qd_exec_result){-2};
 	}
-	if (val.type == QD_STACK_TYPE_STR) {
-		free(val.value.s);
-	}
 
 	return (qd_exec_result){0};
 }
@@ -2011,87 +1893,8 @@ qd_exec_result qd_rot(qd_context* ctx) {
 		abort();
 	}
 
-	// Pop c, b, a
-	qd_stack_element_t c, b, a;
-	qd_stack_error err = qd_stack_pop(ctx->st, &c);
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-	err = qd_stack_pop(ctx->st, &b);
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-	err = qd_stack_pop(ctx->st, &a);
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-
-	// Push in order: b, c, a
-	// Push b
-	switch (b.type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, b.value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, b.value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			err = qd_stack_push_str(ctx->st, b.value.s);
-			free(b.value.s);
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, b.value.p);
-			break;
-		default:
-			return (qd_exec_result){-3};
-	}
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-
-	// Push c
-	switch (c.type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, c.value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, c.value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			err = qd_stack_push_str(ctx->st, c.value.s);
-			free(c.value.s);
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, c.value.p);
-			break;
-		default:
-			return (qd_exec_result){-3};
-	}
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
-
-	// Push a
-	switch (a.type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, a.value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, a.value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			err = qd_stack_push_str(ctx->st, a.value.s);
-			free(a.value.s);
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, a.value.p);
-			break;
-		default:
-			return (qd_exec_result){-3};
-	}
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
+	// Rotate in place: ( a b c -- b c a )
+	qd_stack_roll(ctx->st, 2);
 
 	return (qd_exec_result){0};
 }
@@ -2242,23 +2045,10 @@ qd_exec_result qd_pick(qd_context* ctx) {
 	}
 
 	// Push a copy of that element
-	switch (elem.type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, elem.value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, elem.value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			err = qd_stack_push_str(ctx->st, elem.value.s);
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, elem.value.p);
-			break;
-		default:
-			return (qd_exec_result){-3};
+	err = qd_stack_push_copy(ctx->st, &elem);
+	if (err == QD_STACK_ERR_TYPE_MISMATCH) {
+		return (qd_exec_result){-3};
 	}
-
 	if (err != QD_STACK_OK) {
 		return (qd_exec_result){-2};
 	}
@@ -2310,74 +2100,8 @@ qd_exec_result qd_roll(qd_context* ctx) {
 		abort();
 	}
 
-	// Allocate temporary storage for n elements
-	qd_stack_element_t* temp = malloc(sizeof(qd_stack_element_t) * (size_t)n);
-	if (!temp) {
-		fprintf(stderr, "Fatal error in roll: Memory allocation failed\n");
-		abort();
-	}
-
-	// Pop n elements
-	for (int64_t i = 0; i < n; i++) {
-		err = qd_stack_pop(ctx->st, &temp[n - 1 - i]);
-		if (err != QD_STACK_OK) {
-			free(temp);
-			return (qd_exec_result){-2};
-		}
-	}
-
-	// Push back in rotated order: the bottom element (temp[0]) goes to top
-	// Order after: temp[1], temp[2], ..., temp[n-1], temp[0]
-	for (int64_t i = 1; i < n; i++) {
-		switch (temp[i].type) {
-			case QD_STACK_TYPE_INT:
-				err = qd_stack_push_int(ctx->st, temp[i].value.i);
-				break;
-			case QD_STACK_TYPE_FLOAT:
-				err = qd_stack_push_float(ctx->st, temp[i].value.f);
-				break;
-			case QD_STACK_TYPE_STR:
-				err = qd_stack_push_str(ctx->st, temp[i].value.s);
-				free(temp[i].value.s);
-				break;
-			case QD_STACK_TYPE_PTR:
-				err = qd_stack_push_ptr(ctx->st, temp[i].value.p);
-				break;
-			default:
-				free(temp);
-				return (qd_exec_result){-3};
-		}
-		if (err != QD_STACK_OK) {
-			free(temp);
-			return (qd_exec_result){-2};
-		}
-	}
-
-	// Push temp[0] last (it becomes the top)
-	switch (temp[0].type) {
-		case QD_STACK_TYPE_INT:
-			err = qd_stack_push_int(ctx->st, temp[0].value.i);
-			break;
-		case QD_STACK_TYPE_FLOAT:
-			err = qd_stack_push_float(ctx->st, temp[0].value.f);
-			break;
-		case QD_STACK_TYPE_STR:
-			err = qd_stack_push_str(ctx->st, temp[0].value.s);
-			free(temp[0].value.s);
-			break;
-		case QD_STACK_TYPE_PTR:
-			err = qd_stack_push_ptr(ctx->st, temp[0].value.p);
-			break;
-		default:
-			free(temp);
-			return (qd_exec_result){-3};
-	}
-
-	free(temp);
-
-	if (err != QD_STACK_OK) {
-		return (qd_exec_result){-2};
-	}
+	// Rotate in place: the nth element moves to the top without copying strings
+	qd_stack_roll(ctx->st, (size_t)n - 1);
 
 	return (qd_exec_result){0};
 }
@@ -2641,34 +2365,11 @@ qd_exec_result qd_neg(qd_context* ctx) {
 
 // max - maximum of top 2 elements: ( a b -- max(a,b) )
 
-// Threading support
-typedef struct {
-	qd_context* ctx;
-	void* func_ptr;
-} qd_thread_info_t;
-
-// Wrapper function for pthread that calls the Quadrate function
-static void* qd_thread_wrapper(void* arg) {
-	qd_thread_info_t* info = (qd_thread_info_t*)arg;
+// Threading support: tasks run on the work-stealing pool in scheduler.c
 
-	// Call the function
-	typedef qd_exec_result (*qd_function_ptr)(qd_context*);
-	qd_function_ptr func;
-	memcpy(&func, &info->func_ptr, sizeof(func));
-
-	if (func) {
-		func(info->ctx);
-	}
-
-	// Clean up context
-	qd_free_context(info->ctx);
-	free(info);
-
-	return NULL;
-}
-
-// spawn - create a new thread ( fn:ptr -- thread_id:i )
-qd_exec_result qd_spawn(qd_context* ctx) {
+// Pop a function pointer and arg_count arguments below it, and start the function as a task
+// with a stack_size element data stack (0 sizes it like the spawner's)
+static qd_exec_result spawn_task(qd_context* ctx, size_t arg_count, size_t stack_size) {
 	// Pop function pointer
 	qd_stack_element_t val;
 	qd_stack_error err = qd_stack_pop(ctx->st, &val);
@@ -2688,43 +2389,43 @@ qd_exec_result qd_spawn(qd_context* ctx) {
 		abort();
 	}
 
-	// Create new context for the thread
-	qd_context* thread_ctx = qd_create_context(1024);
-	if (!thread_ctx) {
-		fprintf(stderr, "Fatal error in spawn: Failed to create context\n");
+	if (qd_stack_size(ctx->st) < arg_count) {
+		fprintf(stderr, "Fatal error in spawn: Stack underflow (task expects %zu arguments)\n", arg_count);
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
 		abort();
 	}
 
-	// Create thread info
-	qd_thread_info_t* info = malloc(sizeof(qd_thread_info_t));
-	if (!info) {
-		fprintf(stderr, "Fatal error in spawn: Failed to allocate thread info\n");
-		qd_free_context(thread_ctx);
-		abort();
+	// Move the arguments over, keeping their order
+	qd_stack_element_t* args = NULL;
+	if (arg_count > 0) {
+		args = malloc(sizeof(qd_stack_element_t) * arg_count);
+		if (!args) {
+			fprintf(stderr, "Fatal error in spawn: Failed to allocate task arguments\n");
+			abort();
+		}
+		for (size_t i = arg_count; i > 0; i--) {
+			qd_stack_pop_ref(ctx->st, &args[i - 1]);
+		}
 	}
-	info->ctx = thread_ctx;
-	info->func_ptr = val.value.p;
 
-	// Create thread
-	pthread_t* thread = malloc(sizeof(pthread_t));
-	if (!thread) {
-		fprintf(stderr, "Fatal error in spawn: Failed to allocate pthread_t\n");
-		qd_free_context(thread_ctx);
-		free(info);
-		abort();
+	if (stack_size == 0) {
+		stack_size = qd_stack_capacity(ctx->st);
 	}
-
-	int result = pthread_create(thread, NULL, qd_thread_wrapper, info);
-	if (result != 0) {
-		fprintf(stderr, "Fatal error in spawn: pthread_create failed with error %d\n", result);
-		qd_free_context(thread_ctx);
-		free(info);
-		free(thread);
+	if (stack_size < arg_count) {
+		fprintf(stderr, "Fatal error in spawn: Task stack of %zu elements can't hold %zu arguments\n", stack_size,
+				arg_count);
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
 		abort();
 	}
 
-	// Push thread ID (as pointer cast to int64_t)
-	err = qd_stack_push_int(ctx->st, (int64_t)(uintptr_t)thread);
+	// The task's stack grows like the spawner's
+	qd_task* task = qd_task_spawn(val.value.p, args, arg_count, stack_size, qd_stack_is_growable(ctx->st));
+	free(args);
+
+	// Push task handle (as pointer cast to int64_t)
+	err = qd_stack_push_int(ctx->st, (int64_t)(uintptr_t)task);
 	if (err != QD_STACK_OK) {
 		return (qd_exec_result){-2};
 	}
@@ -2732,7 +2433,39 @@ qd_exec_result qd_spawn(qd_context* ctx) {
 	return (qd_exec_result){0};
 }
 
-// detach - detach a thread ( thread_id:i -- )
+// spawn - run a function as a task ( fn:ptr -- thread_id:i )
+qd_exec_result qd_spawn(qd_context* ctx) {
+	return spawn_task(ctx, 0, 0);
+}
+
+// spawn_args - run a function as a task with arguments ( args... fn:ptr n:i -- thread_id:i )
+qd_exec_result qd_spawn_args(qd_context* ctx) {
+	// Pop argument count
+	qd_stack_element_t val;
+	qd_stack_error err = qd_stack_pop(ctx->st, &val);
+
+	if (err != QD_STACK_OK) {
+		fprintf(stderr, "Fatal error in spawn_args: Stack underflow\n");
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
+		abort();
+	}
+
+	if (val.type != QD_STACK_TYPE_INT || val.value.i < 0) {
+		fprintf(stderr, "Fatal error in spawn_args: Expected a non-negative argument count\n");
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
+		abort();
+	}
+
+	return spawn_task(ctx, (size_t)val.value.i, 0);
+}
+
+qd_exec_result qd_spawn_sized(qd_context* ctx, size_t arg_count, size_t stack_size) {
+	return spawn_task(ctx, arg_count, stack_size);
+}
+
+// detach - let a task finish on its own ( thread_id:i -- )
 qd_exec_result qd_detach(qd_context* ctx) {
 	// Pop thread ID
 	qd_stack_element_t val;
@@ -2753,23 +2486,13 @@ qd_exec_result qd_detach(qd_context* ctx) {
 		abort();
 	}
 
-	// Get pthread_t pointer
-	pthread_t* thread = (pthread_t*)(uintptr_t)val.value.i;
-
-	// Detach thread
-	int result = pthread_detach(*thread);
-	if (result != 0) {
-		fprintf(stderr, "Fatal error in detach: pthread_detach failed with error %d\n", result);
-		abort();
-	}
-
-	// Free the thread pointer (it's no longer needed after detach)
-	free(thread);
+	// The task keeps running; its handle is no longer valid
+	qd_task_detach((qd_task*)(uintptr_t)val.value.i);
 
 	return (qd_exec_result){0};
 }
 
-// wait - join/wait for a thread ( thread_id:i -- )
+// wait - wait for a task to finish ( thread_id:i -- )
 qd_exec_result qd_wait(qd_context* ctx) {
 	// Pop thread ID
 	qd_stack_element_t val;
@@ -2790,22 +2513,149 @@ qd_exec_result qd_wait(qd_context* ctx) {
 		abort();
 	}
 
-	// Get pthread_t pointer
-	pthread_t* thread = (pthread_t*)(uintptr_t)val.value.i;
+	// Runs the task here if no worker has started it yet
+	qd_task_wait((qd_task*)(uintptr_t)val.value.i);
+
+	return (qd_exec_result){0};
+}
+
+// yield - let other tasks run ( -- )
+qd_exec_result qd_yield(qd_context* ctx) {
+	(void)ctx;
+	qd_task_yield();
+	return (qd_exec_result){0};
+}
+
+// Pop a channel pointer for the named instruction
+static qd_channel* pop_channel(qd_context* ctx, const char* name) {
+	qd_stack_element_t val;
+	qd_stack_error err = qd_stack_pop(ctx->st, &val);
+
+	if (err != QD_STACK_OK) {
+		fprintf(stderr, "Fatal error in %s: Stack underflow\n", name);
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
+		abort();
+	}
 
-	// Join thread
-	int result = pthread_join(*thread, NULL);
-	if (result != 0) {
-		fprintf(stderr, "Fatal error in wait: pthread_join failed with error %d\n", result);
+	if (val.type != QD_STACK_TYPE_PTR || val.value.p == NULL) {
+		fprintf(stderr, "Fatal error in %s: Expected channel, got type %d\n", name, val.type);
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
 		abort();
 	}
 
-	// Free the thread pointer
-	free(thread);
+	return (qd_channel*)val.value.p;
+}
+
+// Push a received value and ok, or 0 and 0 if nothing was received
+static qd_exec_result push_received(qd_context* ctx, bool received, const qd_stack_element_t* value) {
+	qd_stack_error err = received ? qd_stack_push_move(ctx->st, value) : qd_stack_push_int(ctx->st, 0);
+	if (err != QD_STACK_OK) {
+		if (received) {
+			qd_stack_element_t owned = *value;
+			qd_stack_element_release(&owned);
+		}
+		return (qd_exec_result){-2};
+	}
+
+	err = qd_stack_push_int(ctx->st, received ? 1 : 0);
+	if (err != QD_STACK_OK) {
+		return (qd_exec_result){-2};
+	}
 
 	return (qd_exec_result){0};
 }
 
+// chan - create a channel ( capacity:i -- channel:p )
+qd_exec_result qd_chan(qd_context* ctx) {
+	qd_stack_element_t val;
+	qd_stack_error err = qd_stack_pop(ctx->st, &val);
+
+	if (err != QD_STACK_OK) {
+		fprintf(stderr, "Fatal error in chan: Stack underflow\n");
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
+		abort();
+	}
+
+	if (val.type != QD_STACK_TYPE_INT) {
+		fprintf(stderr, "Fatal error in chan: Expected integer type, got %d\n", val.type);
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
+		abort();
+	}
+
+	if (val.value.i < 1) {
+		fprintf(stderr, "Fatal error in chan: Capacity must be at least 1, got %lld\n", (long long)val.value.i);
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
+		abort();
+	}
+
+	qd_channel* channel = qd_channel_create((size_t)val.value.i);
+	if (!channel) {
+		fprintf(stderr, "Fatal error in chan: Failed to allocate channel\n");
+		abort();
+	}
+
+	err = qd_stack_push_ptr(ctx->st, channel);
+	if (err != QD_STACK_OK) {
+		free(channel);
+		return (qd_exec_result){-2};
+	}
+
+	return (qd_exec_result){0};
+}
+
+// send - send a value to a channel, waiting while it is full ( channel:p value -- )
+qd_exec_result qd_send(qd_context* ctx) {
+	qd_stack_element_t value;
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &value);
+
+	if (err != QD_STACK_OK) {
+		fprintf(stderr, "Fatal error in send: Stack underflow\n");
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
+		abort();
+	}
+
+	qd_channel* channel = pop_channel(ctx, "send");
+
+	// Strings are moved, not copied: the receiver takes over ownership
+	if (!qd_channel_send(channel, &value)) {
+		qd_stack_element_release(&value);
+		fprintf(stderr, "Fatal error in send: Channel is closed\n");
+		dump_stack(ctx);
+		qd_print_stack_trace(ctx);
+		abort();
+	}
+
+	return (qd_exec_result){0};
+}
+
+// recv - receive a value, waiting while the channel is empty ( channel:p -- value ok:i )
+qd_exec_result qd_recv(qd_context* ctx) {
+	qd_channel* channel = pop_channel(ctx, "recv");
+	qd_stack_element_t value;
+	bool received = qd_channel_recv(channel, &value, true);
+	return push_received(ctx, received, &value);
+}
+
+// try_recv - receive a value if one is available ( channel:p -- value ok:i )
+qd_exec_result qd_try_recv(qd_context* ctx) {
+	qd_channel* channel = pop_channel(ctx, "try_recv");
+	qd_stack_element_t value;
+	bool received = qd_channel_recv(channel, &value, false);
+	return push_received(ctx, received, &value);
+}
+
+// close - close a channel; receivers drain it, then get ok 0 ( channel:p -- )
+qd_exec_result qd_close(qd_context* ctx) {
+	qd_channel_close(pop_channel(ctx, "close"));
+	return (qd_exec_result){0};
+}
+
 qd_exec_result qd_err(qd_context* ctx) {
 	// Check if top of stack is error-tainted and push error code, message, and status
 	// Stack before: [value (tainted)]
@@ -3070,10 +2920,11 @@ qd_exec_result qd_read(qd_context* ctx) {
 }
 
 // Context management functions
-qd_context* qd_create_context(size_t stack_size) {
+static qd_context* create_context(size_t stack_size, bool growable) {
 	qd_context* ctx = (qd_context*)malloc(sizeof(qd_context));
 	if (ctx) {
-		qd_stack_error err = qd_stack_init(&ctx->st, stack_size);
+		qd_stack_error err =
+				growable ? qd_stack_init_growable(&ctx->st, stack_size) : qd_stack_init(&ctx->st, stack_size);
 		if (err != QD_STACK_OK) {
 			free(ctx);
 			return NULL;
@@ -3088,6 +2939,14 @@ qd_context* qd_create_context(size_t stack_size) {
 	return ctx;
 }
 
+qd_context* qd_create_context(size_t stack_size) {
+	return create_context(stack_size, false);
+}
+
+qd_context* qd_create_context_growable(size_t stack_size) {
+	return create_context(stack_size, true);
+}
+
 void qd_free_context(qd_context* ctx) {
 	if (ctx == NULL) {
 		return;
@@ -3106,6 +2965,13 @@ qd_context* qd_clone_context(const qd_context* src) {
 	if (src == NULL) {
 		return NULL;
 	}
+	return qd_clone_context_window(src, qd_stack_size(src->st), qd_stack_capacity(src->st));
+}
+
+qd_context* qd_clone_context_window(const qd_context* src, size_t depth, size_t capacity) {
+	if (src == NULL) {
+		return NULL;
+	}
 
 	/* Allocate new context */
 	qd_context* ctx = (qd_context*)malloc(sizeof(qd_context));
@@ -3113,8 +2979,8 @@ qd_context* qd_clone_context(const qd_context* src) {
 		return NULL;
 	}
 
-	/* Clone the stack */
-	qd_stack_error err = qd_stack_clone(&ctx->st, src->st);
+	/* Clone the top of the stack */
+	qd_stack_error err = qd_stack_clone_top(&ctx->st, src->st, depth, capacity);
 	if (err != QD_STACK_OK) {
 		free(ctx);
 		return NULL;
@@ -0,0 +1,782 @@
+#define _GNU_SOURCE
+
+#include "scheduler.h"
+#include "reactor.h"
+#include <qdrt/coroutine.h>
+#include <qdrt/runtime.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+// Machine stack of a task's coroutine, reserved but only committed as it is used
+#define QD_COROUTINE_STACK_SIZE (1024 * 1024)
+
+// Most workers the pool will run, including the ones added for blocked tasks
+#define QD_MAX_WORKERS 256
+
+// Initial number of slots in a worker deque (a power of two, grows as needed)
+#define QD_DEQUE_CAPACITY 256
+
+// Task contexts and coroutine stacks kept for reuse
+#define QD_MAX_FREE_CONTEXTS 256
+#define QD_MAX_FREE_STACKS 256
+
+// Initial number of slots in the shared queue (grows as needed)
+#define QD_SHARED_QUEUE_CAPACITY 256
+
+// How often the monitor checks whether queued tasks are making progress
+#define QD_MONITOR_INTERVAL_MS 10
+
+enum {
+	QD_TASK_QUEUED,	 // Spawned, not started
+	QD_TASK_READY,	 // Parked, queued to resume
+	QD_TASK_RUNNING, // Claimed by a thread
+	QD_TASK_PARKED,
+	QD_TASK_DONE
+};
+
+// What a coroutine asks its resumer to do once it has switched away from the coroutine's stack
+enum {
+	QD_PARK_FINISHED,
+	QD_PARK_YIELD,
+	QD_PARK_UNLOCK, // Unlock park_lock; whoever takes the lock next can make the task ready
+	QD_PARK_FD,
+	QD_PARK_SLEEP
+};
+
+struct qd_task {
+	void* func_ptr;
+	qd_stack_element_t* args; // Moved onto the task's stack when it starts
+	size_t arg_count;
+	size_t stack_size; // Data stack of the task's context
+	bool stack_growable;
+	_Atomic int state;
+	_Atomic int refs; // The handle, each queue entry, and the coroutine until it finishes
+	bool waiting;	  // A thread waits on done (protected by lock)
+	qd_task* waiter;  // A task parked until this one is done (protected by lock)
+	pthread_mutex_t lock;
+	pthread_cond_t done;
+	qd_task* next; // Free list
+
+	char* stack; // Coroutine stack including its guard page, NULL until the task first runs
+	ucontext_t coroutine;
+	ucontext_t* resumer; // Where the coroutine switches to when it parks or finishes
+	int park_action;
+	pthread_mutex_t* park_lock;
+	int park_fd;
+	int park_events;
+	int64_t park_nanoseconds;
+};
+
+// Circular array of a deque; replaced arrays are kept since a thief may still be reading them
+typedef struct qd_deque_array {
+	int64_t capacity;
+	struct qd_deque_array* retired;
+	_Atomic(qd_task*) items[];
+} qd_deque_array;
+
+// Chase-Lev deque: the owner pushes and pops at the bottom, thieves take from the top
+typedef struct {
+	_Atomic int64_t top;
+	_Atomic int64_t bottom;
+	_Atomic(qd_deque_array*) array;
+	unsigned seed; // Victim selection
+} qd_worker;
+
+static struct {
+	pthread_once_t once;
+	pthread_mutex_t lock; // Sleeping workers, the shared queue and the monitor
+	pthread_cond_t work;
+	pthread_cond_t monitor;
+
+	qd_worker* workers[QD_MAX_WORKERS];
+	_Atomic size_t worker_count;
+	_Atomic size_t sleepers;
+	_Atomic bool monitor_idle;
+
+	_Atomic int64_t pending;   // Tasks queued and not started or resumed
+	_Atomic uint64_t started;  // Tasks started or resumed so far, progress indicator for the monitor
+	_Atomic size_t shared_count;
+	qd_task** shared_items; // Ring of tasks spawned outside the pool and ready tasks
+	size_t shared_capacity;
+	size_t shared_head;
+
+	pthread_mutex_t free_lock;
+	qd_task* free_tasks;
+	qd_context* free_contexts[QD_MAX_FREE_CONTEXTS];
+	size_t free_context_count;
+	char* free_stacks[QD_MAX_FREE_STACKS];
+	size_t free_stack_count;
+	size_t page_size;
+} pool = {
+		.once = PTHREAD_ONCE_INIT,
+		.lock = PTHREAD_MUTEX_INITIALIZER,
+		.work = PTHREAD_COND_INITIALIZER,
+		.monitor = PTHREAD_COND_INITIALIZER,
+		.free_lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// Worker running on this thread, NULL outside the pool
+static _Thread_local qd_worker* current_worker;
+
+// Task whose coroutine runs on this thread, NULL outside tasks
+static _Thread_local qd_task* current_task;
+
+// A coroutine can park on one thread and resume on another. Thread-locals are only read through
+// these out-of-line functions so the compiler can't reuse an address computed before a switch.
+static __attribute__((noinline)) qd_worker* this_worker(void) {
+	return current_worker;
+}
+
+static __attribute__((noinline)) qd_task* running_task(void) {
+	return current_task;
+}
+
+static __attribute__((noinline)) void set_running_task(qd_task* task) {
+	current_task = task;
+}
+
+static qd_deque_array* deque_array_create(int64_t capacity) {
+	qd_deque_array* array = malloc(sizeof(qd_deque_array) + sizeof(_Atomic(qd_task*)) * (size_t)capacity);
+	if (!array) {
+		fprintf(stderr, "Fatal error in spawn: Failed to allocate task queue\n");
+		abort();
+	}
+	array->capacity = capacity;
+	array->retired = NULL;
+	return array;
+}
+
+static qd_deque_array* deque_grow(qd_worker* worker, qd_deque_array* array, int64_t top, int64_t bottom) {
+	qd_deque_array* grown = deque_array_create(array->capacity * 2);
+	for (int64_t i = top; i < bottom; i++) {
+		qd_task* task = atomic_load_explicit(&array->items[i & (array->capacity - 1)], memory_order_relaxed);
+		atomic_store_explicit(&grown->items[i & (grown->capacity - 1)], task, memory_order_relaxed);
+	}
+	grown->retired = array;
+	atomic_store_explicit(&worker->array, grown, memory_order_release);
+	return grown;
+}
+
+static void deque_push(qd_worker* worker, qd_task* task) {
+	int64_t bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed);
+	int64_t top = atomic_load_explicit(&worker->top, memory_order_acquire);
+	qd_deque_array* array = atomic_load_explicit(&worker->array, memory_order_relaxed);
+	if (bottom - top > array->capacity - 1) {
+		array = deque_grow(worker, array, top, bottom);
+	}
+	atomic_store_explicit(&array->items[bottom & (array->capacity - 1)], task, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+}
+
+static qd_task* deque_pop(qd_worker* worker) {
+	int64_t bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed) - 1;
+	qd_deque_array* array = atomic_load_explicit(&worker->array, memory_order_relaxed);
+	atomic_store_explicit(&worker->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t top = atomic_load_explicit(&worker->top, memory_order_relaxed);
+
+	if (top > bottom) {
+		atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+		return NULL;
+	}
+
+	qd_task* task = atomic_load_explicit(&array->items[bottom & (array->capacity - 1)], memory_order_relaxed);
+	if (top == bottom) {
+		// Last task: race the thieves for it
+		if (!atomic_compare_exchange_strong_explicit(
+					&worker->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+			task = NULL;
+		}
+		atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+	}
+	return task;
+}
+
+static qd_task* deque_steal(qd_worker* worker) {
+	int64_t top = atomic_load_explicit(&worker->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	int64_t bottom = atomic_load_explicit(&worker->bottom, memory_order_acquire);
+	if (top >= bottom) {
+		return NULL;
+	}
+
+	qd_deque_array* array = atomic_load_explicit(&worker->array, memory_order_acquire);
+	qd_task* task = atomic_load_explicit(&array->items[top & (array->capacity - 1)], memory_order_relaxed);
+	if (!atomic_compare_exchange_strong_explicit(
+				&worker->top, &top, top + 1, memory_order_seq_cst, memory_order_relaxed)) {
+		return NULL;
+	}
+	return task;
+}
+
+static qd_task* task_alloc(void) {
+	pthread_mutex_lock(&pool.free_lock);
+	qd_task* task = pool.free_tasks;
+	if (task) {
+		pool.free_tasks = task->next;
+	}
+	pthread_mutex_unlock(&pool.free_lock);
+
+	if (!task) {
+		task = malloc(sizeof(qd_task));
+		if (!task) {
+			fprintf(stderr, "Fatal error in spawn: Failed to allocate task\n");
+			abort();
+		}
+		pthread_mutex_init(&task->lock, NULL);
+		pthread_cond_init(&task->done, NULL);
+		task->stack = NULL;
+	}
+	task->next = NULL;
+	task->waiting = false;
+	task->waiter = NULL;
+	return task;
+}
+
+// Drop a reference; the last one returns the task to the free list
+static void task_release(qd_task* task) {
+	if (atomic_fetch_sub(&task->refs, 1) != 1) {
+		return;
+	}
+	pthread_mutex_lock(&pool.free_lock);
+	task->next = pool.free_tasks;
+	pool.free_tasks = task;
+	pthread_mutex_unlock(&pool.free_lock);
+}
+
+// Take a queued or ready task for running; fails if a waiter or another worker got it first
+static bool task_claim(qd_task* task) {
+	int expected = atomic_load(&task->state);
+	if ((expected != QD_TASK_QUEUED && expected != QD_TASK_READY) ||
+			!atomic_compare_exchange_strong(&task->state, &expected, QD_TASK_RUNNING)) {
+		return false;
+	}
+	atomic_fetch_sub(&pool.pending, 1);
+	atomic_fetch_add(&pool.started, 1);
+	return true;
+}
+
+// Reuse a free context whose stack has the given capacity and growth mode, or create one
+static qd_context* context_acquire(size_t stack_size, bool growable) {
+	qd_context* ctx = NULL;
+	pthread_mutex_lock(&pool.free_lock);
+	for (size_t i = pool.free_context_count; i > 0; i--) {
+		qd_context* candidate = pool.free_contexts[i - 1];
+		if (qd_stack_capacity(candidate->st) == stack_size && qd_stack_is_growable(candidate->st) == growable) {
+			ctx = candidate;
+			pool.free_contexts[i - 1] = pool.free_contexts[--pool.free_context_count];
+			break;
+		}
+	}
+	pthread_mutex_unlock(&pool.free_lock);
+
+	if (!ctx) {
+		ctx = growable ? qd_create_context_growable(stack_size) : qd_create_context(stack_size);
+		if (!ctx) {
+			fprintf(stderr, "Fatal error in spawn: Failed to create context\n");
+			abort();
+		}
+	}
+	return ctx;
+}
+
+// Reset a context to the state qd_create_context() leaves it in and keep it for the next task
+static void context_recycle(qd_context* ctx) {
+	qd_stack_element_t elem;
+	while (qd_stack_pop(ctx->st, &elem) == QD_STACK_OK) {
+		qd_stack_element_release(&elem);
+	}
+	free(ctx->error_msg);
+	free(ctx->program_name);
+	ctx->error_code = 0;
+	ctx->error_msg = NULL;
+	ctx->argc = 0;
+	ctx->argv = NULL;
+	ctx->program_name = NULL;
+	ctx->call_stack_depth = 0;
+	// A task that grew its stack deep shouldn't leave the pooled context holding that memory
+	qd_stack_release_unused(ctx->st);
+
+	pthread_mutex_lock(&pool.free_lock);
+	if (pool.free_context_count < QD_MAX_FREE_CONTEXTS) {
+		pool.free_contexts[pool.free_context_count++] = ctx;
+		ctx = NULL;
+	}
+	pthread_mutex_unlock(&pool.free_lock);
+	qd_free_context(ctx);
+}
+
+static char* stack_acquire(void) {
+	char* stack = NULL;
+	pthread_mutex_lock(&pool.free_lock);
+	if (pool.free_stack_count > 0) {
+		stack = pool.free_stacks[--pool.free_stack_count];
+	}
+	pthread_mutex_unlock(&pool.free_lock);
+
+	if (!stack) {
+		stack = mmap(NULL, pool.page_size + QD_COROUTINE_STACK_SIZE, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+		if (stack == MAP_FAILED) {
+			fprintf(stderr, "Fatal error in spawn: Failed to allocate task stack\n");
+			abort();
+		}
+		// Guard page below the stack: an overflow faults instead of corrupting memory
+		mprotect(stack, pool.page_size, PROT_NONE);
+	}
+	return stack;
+}
+
+static void stack_recycle(char* stack) {
+	pthread_mutex_lock(&pool.free_lock);
+	if (pool.free_stack_count < QD_MAX_FREE_STACKS) {
+		pool.free_stacks[pool.free_stack_count++] = stack;
+		stack = NULL;
+	}
+	pthread_mutex_unlock(&pool.free_lock);
+	if (stack) {
+		munmap(stack, pool.page_size + QD_COROUTINE_STACK_SIZE);
+	}
+}
+
+// Switch from a task's coroutine back to its resumer, which carries out park_action
+static void task_park(qd_task* self, int action) {
+	self->park_action = action;
+	swapcontext(&self->coroutine, self->resumer);
+}
+
+static void coroutine_main(void) {
+	qd_task* task = running_task();
+
+	typedef qd_exec_result (*qd_function_ptr)(qd_context*);
+	qd_function_ptr func;
+	memcpy(&func, &task->func_ptr, sizeof(func));
+
+	qd_context* ctx = context_acquire(task->stack_size, task->stack_growable);
+	for (size_t i = 0; i < task->arg_count; i++) {
+		if (qd_stack_push_move(ctx->st, &task->args[i]) != QD_STACK_OK) {
+			fprintf(stderr, "Fatal error in spawn: Too many arguments for the task stack\n");
+			abort();
+		}
+	}
+	free(task->args);
+	task->args = NULL;
+	if (func) {
+		func(ctx);
+	}
+	context_recycle(ctx);
+
+	// Reread: the task may have moved to another thread
+	task = running_task();
+	task->park_action = QD_PARK_FINISHED;
+	setcontext(task->resumer);
+}
+
+static void task_finish(qd_task* task) {
+	stack_recycle(task->stack);
+	task->stack = NULL;
+
+	pthread_mutex_lock(&task->lock);
+	atomic_store(&task->state, QD_TASK_DONE);
+	qd_task* waiter = task->waiter;
+	task->waiter = NULL;
+	if (task->waiting) {
+		pthread_cond_broadcast(&task->done);
+	}
+	pthread_mutex_unlock(&task->lock);
+
+	if (waiter) {
+		qd_task_ready(waiter);
+	}
+	task_release(task); // The coroutine's reference
+}
+
+// Run a claimed task until it parks or finishes, then do what it parked for, now that
+// nothing runs on its stack anymore and another thread may resume it
+static void task_resume(qd_task* task) {
+	if (!task->stack) {
+		task->stack = stack_acquire();
+		getcontext(&task->coroutine);
+		task->coroutine.uc_stack.ss_sp = task->stack + pool.page_size;
+		task->coroutine.uc_stack.ss_size = QD_COROUTINE_STACK_SIZE;
+		task->coroutine.uc_link = NULL;
+		makecontext(&task->coroutine, coroutine_main, 0);
+	}
+
+	qd_task* previous = running_task();
+	ucontext_t resumer;
+	task->resumer = &resumer;
+	set_running_task(task);
+	swapcontext(&resumer, &task->coroutine);
+	set_running_task(previous);
+
+	if (task->park_action == QD_PARK_FINISHED) {
+		task_finish(task);
+		return;
+	}
+
+	atomic_store(&task->state, QD_TASK_PARKED);
+	switch (task->park_action) {
+	case QD_PARK_YIELD:
+		qd_task_ready(task);
+		break;
+	case QD_PARK_UNLOCK:
+		pthread_mutex_unlock(task->park_lock);
+		break;
+	case QD_PARK_FD:
+		qd_reactor_watch(task, task->park_fd, task->park_events);
+		break;
+	case QD_PARK_SLEEP:
+		qd_reactor_sleep(task, task->park_nanoseconds);
+		break;
+	default:
+		break;
+	}
+}
+
+// Run a task taken from a queue, unless it already ran, and drop the queue's reference
+static void task_run_entry(qd_task* task) {
+	if (task_claim(task)) {
+		task_resume(task);
+	}
+	task_release(task);
+}
+
+// Append to the shared queue; a task can be in it more than once (stale entries are skipped by task_claim)
+static void shared_queue_push(qd_task* task) {
+	pthread_mutex_lock(&pool.lock);
+	size_t count = atomic_load(&pool.shared_count);
+	if (count == pool.shared_capacity) {
+		size_t capacity = pool.shared_capacity ? pool.shared_capacity * 2 : QD_SHARED_QUEUE_CAPACITY;
+		qd_task** items = malloc(sizeof(qd_task*) * capacity);
+		if (!items) {
+			fprintf(stderr, "Fatal error in spawn: Failed to allocate task queue\n");
+			abort();
+		}
+		for (size_t i = 0; i < count; i++) {
+			items[i] = pool.shared_items[(pool.shared_head + i) % pool.shared_capacity];
+		}
+		free(pool.shared_items);
+		pool.shared_items = items;
+		pool.shared_capacity = capacity;
+		pool.shared_head = 0;
+	}
+	pool.shared_items[(pool.shared_head + count) % pool.shared_capacity] = task;
+	atomic_store(&pool.shared_count, count + 1);
+	pthread_mutex_unlock(&pool.lock);
+}
+
+static qd_task* shared_queue_take(void) {
+	if (atomic_load(&pool.shared_count) == 0) {
+		return NULL;
+	}
+	qd_task* task = NULL;
+	pthread_mutex_lock(&pool.lock);
+	size_t count = atomic_load(&pool.shared_count);
+	if (count > 0) {
+		task = pool.shared_items[pool.shared_head];
+		pool.shared_head = (pool.shared_head + 1) % pool.shared_capacity;
+		atomic_store(&pool.shared_count, count - 1);
+	}
+	pthread_mutex_unlock(&pool.lock);
+	return task;
+}
+
+// Next task for a worker: its own deque first, then the shared queue, then the other workers
+static qd_task* find_task(qd_worker* self) {
+	qd_task* task = deque_pop(self);
+	if (task) {
+		return task;
+	}
+	task = shared_queue_take();
+	if (task) {
+		return task;
+	}
+
+	size_t count = atomic_load(&pool.worker_count);
+	self->seed = self->seed * 1103515245u + 12345u;
+	size_t start = self->seed % count;
+	for (size_t i = 0; i < count; i++) {
+		qd_worker* victim = pool.workers[(start + i) % count];
+		if (victim != self) {
+			task = deque_steal(victim);
+			if (task) {
+				return task;
+			}
+		}
+	}
+	return NULL;
+}
+
+static void* worker_main(void* arg) {
+	qd_worker* self = arg;
+	current_worker = self;
+
+	for (;;) {
+		qd_task* task = find_task(self);
+		if (task) {
+			task_run_entry(task);
+			continue;
+		}
+
+		// Sleep until a task is queued; pending is checked after announcing the sleeper (see wake_worker)
+		pthread_mutex_lock(&pool.lock);
+		atomic_fetch_add(&pool.sleepers, 1);
+		while (atomic_load(&pool.pending) == 0) {
+			pthread_cond_wait(&pool.work, &pool.lock);
+		}
+		atomic_fetch_sub(&pool.sleepers, 1);
+		pthread_mutex_unlock(&pool.lock);
+	}
+	return NULL;
+}
+
+// Only called while initializing the pool and from the monitor, never concurrently
+static void add_worker(void) {
+	size_t index = atomic_load(&pool.worker_count);
+	if (index >= QD_MAX_WORKERS) {
+		return;
+	}
+
+	qd_worker* worker = calloc(1, sizeof(qd_worker));
+	if (!worker) {
+		return;
+	}
+	atomic_init(&worker->array, deque_array_create(QD_DEQUE_CAPACITY));
+	worker->seed = (unsigned)index * 2654435761u + 1u;
+
+	// Thieves may look at the deque as soon as the count includes it
+	pool.workers[index] = worker;
+	atomic_store(&pool.worker_count, index + 1);
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pthread_t thread;
+	int result = pthread_create(&thread, &attr, worker_main, worker);
+	pthread_attr_destroy(&attr);
+	if (result != 0 && index == 0) {
+		fprintf(stderr, "Fatal error in spawn: pthread_create failed with error %d\n", result);
+		abort();
+	}
+	// Otherwise the pool keeps running with fewer workers; the unused deque stays empty
+}
+
+// Adds a worker when queued tasks stop starting because every worker is busy, typically
+// with tasks that block or never finish (servers, consumers), so those can't starve the rest
+static void* monitor_main(void* arg) {
+	(void)arg;
+	uint64_t last_started = atomic_load(&pool.started);
+
+	pthread_mutex_lock(&pool.lock);
+	for (;;) {
+		if (atomic_load(&pool.pending) == 0) {
+			atomic_store(&pool.monitor_idle, true);
+			while (atomic_load(&pool.pending) == 0) {
+				pthread_cond_wait(&pool.monitor, &pool.lock);
+			}
+			atomic_store(&pool.monitor_idle, false);
+			last_started = atomic_load(&pool.started);
+		}
+
+		struct timespec deadline;
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_nsec += QD_MONITOR_INTERVAL_MS * 1000000L;
+		if (deadline.tv_nsec >= 1000000000L) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= 1000000000L;
+		}
+		int result = 0;
+		while (result != ETIMEDOUT) {
+			result = pthread_cond_timedwait(&pool.monitor, &pool.lock, &deadline);
+		}
+
+		uint64_t started = atomic_load(&pool.started);
+		if (atomic_load(&pool.pending) > 0 && atomic_load(&pool.sleepers) == 0 && started == last_started) {
+			pthread_mutex_unlock(&pool.lock);
+			add_worker();
+			pthread_mutex_lock(&pool.lock);
+		}
+		last_started = started;
+	}
+	return NULL;
+}
+
+static void pool_init(void) {
+	long page_size = sysconf(_SC_PAGESIZE);
+	pool.page_size = page_size > 0 ? (size_t)page_size : 4096;
+
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t count = cores > 0 ? (size_t)cores : 1;
+	const char* workers = getenv("QD_WORKERS");
+	if (workers) {
+		long requested = strtol(workers, NULL, 10);
+		if (requested > 0) {
+			count = (size_t)requested;
+		}
+	}
+	if (count > QD_MAX_WORKERS) {
+		count = QD_MAX_WORKERS;
+	}
+
+	for (size_t i = 0; i < count; i++) {
+		add_worker();
+	}
+
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	pthread_t thread;
+	pthread_create(&thread, &attr, monitor_main, NULL);
+	pthread_attr_destroy(&attr);
+}
+
+// Wake a sleeping worker for a new task, and the monitor if it stopped watching
+// The spawner increments pending before reading sleepers and monitor_idle, while sleepers
+// announce themselves before reading pending, so one side always sees the other
+static void wake_worker(void) {
+	if (atomic_load(&pool.sleepers) > 0) {
+		pthread_mutex_lock(&pool.lock);
+		pthread_cond_signal(&pool.work);
+		pthread_mutex_unlock(&pool.lock);
+	}
+	if (atomic_load(&pool.monitor_idle)) {
+		pthread_mutex_lock(&pool.lock);
+		pthread_cond_signal(&pool.monitor);
+		pthread_mutex_unlock(&pool.lock);
+	}
+}
+
+qd_task* qd_task_spawn(
+		void* func_ptr, const qd_stack_element_t* args, size_t arg_count, size_t stack_size, bool growable) {
+	pthread_once(&pool.once, pool_init);
+
+	qd_task* task = task_alloc();
+	task->func_ptr = func_ptr;
+	task->stack_size = stack_size;
+	task->stack_growable = growable;
+	task->args = NULL;
+	task->arg_count = arg_count;
+	if (arg_count > 0) {
+		task->args = malloc(sizeof(qd_stack_element_t) * arg_count);
+		if (!task->args) {
+			fprintf(stderr, "Fatal error in spawn: Failed to allocate task arguments\n");
+			abort();
+		}
+		memcpy(task->args, args, sizeof(qd_stack_element_t) * arg_count);
+	}
+	atomic_store(&task->state, QD_TASK_QUEUED);
+	atomic_store(&task->refs, 3);
+	atomic_fetch_add(&pool.pending, 1);
+
+	qd_worker* worker = this_worker();
+	if (worker) {
+		deque_push(worker, task);
+	} else {
+		shared_queue_push(task);
+	}
+
+	wake_worker();
+	return task;
+}
+
+void qd_task_ready(qd_task* task) {
+	atomic_fetch_add(&task->refs, 1);
+	atomic_store(&task->state, QD_TASK_READY);
+	atomic_fetch_add(&pool.pending, 1);
+	shared_queue_push(task);
+	wake_worker();
+}
+
+void qd_task_wait(qd_task* task) {
+	// Not started yet: run it here instead of blocking
+	if (task_claim(task)) {
+		task_resume(task);
+	}
+
+	qd_task* self = running_task();
+	pthread_mutex_lock(&task->lock);
+	if (atomic_load(&task->state) != QD_TASK_DONE && self) {
+		// task_finish makes us ready
+		task->waiter = self;
+		qd_task_park(&task->lock);
+	} else {
+		while (atomic_load(&task->state) != QD_TASK_DONE) {
+			task->waiting = true;
+			pthread_cond_wait(&task->done, &task->lock);
+		}
+		pthread_mutex_unlock(&task->lock);
+	}
+
+	task_release(task);
+}
+
+void qd_task_detach(qd_task* task) {
+	task_release(task);
+}
+
+qd_task* qd_task_current(void) {
+	return running_task();
+}
+
+void qd_task_park(pthread_mutex_t* lock) {
+	qd_task* self = running_task();
+	self->park_lock = lock;
+	task_park(self, QD_PARK_UNLOCK);
+}
+
+void qd_task_yield(void) {
+	qd_task* self = running_task();
+	if (self) {
+		task_park(self, QD_PARK_YIELD);
+	} else {
+		sched_yield();
+	}
+}
+
+int qd_wait_fd(int fd, int events) {
+	qd_task* self = running_task();
+	if (!self) {
+		struct pollfd poll_fd = {.fd = fd, .events = (events & QD_WAIT_READ) ? POLLIN : POLLOUT};
+		int result;
+		do {
+			result = poll(&poll_fd, 1, -1);
+		} while (result < 0 && errno == EINTR);
+		return result < 0 ? -1 : 0;
+	}
+
+	self->park_fd = fd;
+	self->park_events = events;
+	task_park(self, QD_PARK_FD);
+	return 0;
+}
+
+void qd_sleep(int64_t nanoseconds) {
+	qd_task* self = running_task();
+	if (!self) {
+		struct timespec ts = {.tv_sec = nanoseconds / 1000000000, .tv_nsec = nanoseconds % 1000000000};
+		while (nanosleep(&ts, &ts) < 0 && errno == EINTR) {
+		}
+		return;
+	}
+
+	if (nanoseconds <= 0) {
+		task_park(self, QD_PARK_YIELD);
+		return;
+	}
+	self->park_nanoseconds = nanoseconds;
+	task_park(self, QD_PARK_SLEEP);
+}
@@ -0,0 +1,94 @@
+/**
+ * @file scheduler.h
+ * @brief Work-stealing task pool behind spawn, wait and detach
+ *
+ * Tasks run on a pool of worker threads sized to the number of cores
+ * (QD_WORKERS overrides it). Each worker has its own deque: tasks spawned
+ * by a task go to the front of its worker's deque, idle workers steal from
+ * the back of the others. Tasks spawned from other threads, and parked tasks
+ * that became ready again, go to a shared queue. Task contexts are recycled
+ * instead of being created per spawn.
+ *
+ * Every task is a coroutine with its own machine stack, so it can park
+ * (waiting for a task, a file descriptor or a timer, or yielding) without
+ * holding up its worker, and resume later on any worker.
+ */
+
+#ifndef QD_QDRT_SCHEDULER_H
+#define QD_QDRT_SCHEDULER_H
+
+#include <qdrt/context.h>
+#include <pthread.h>
+
+/**
+ * @brief Handle of a spawned task
+ */
+typedef struct qd_task qd_task;
+
+/**
+ * @brief Queue a Quadrate function to run on the worker pool
+ *
+ * The function gets a fresh context whose stack holds the arguments.
+ *
+ * @param func_ptr Function of type qd_exec_result (*)(qd_context*)
+ * @param args Elements to push for the task, bottom first; the task takes ownership of their strings
+ * @param arg_count Number of elements in args
+ * @param stack_size Capacity of the task's data stack
+ * @param growable Reserve the data stack and commit it as it grows (see qd_stack_init_growable())
+ * @return Task handle; must be passed to qd_task_wait() or qd_task_detach() exactly once
+ */
+qd_task* qd_task_spawn(
+		void* func_ptr, const qd_stack_element_t* args, size_t arg_count, size_t stack_size, bool growable);
+
+/**
+ * @brief Wait for a task to finish and release its handle
+ *
+ * Runs the task on the calling thread if no worker has started it yet.
+ * A task that waits parks until the other one is done; other threads block.
+ *
+ * @param task Task handle from qd_task_spawn()
+ */
+void qd_task_wait(qd_task* task);
+
+/**
+ * @brief Release a task handle without waiting for the task
+ *
+ * @param task Task handle from qd_task_spawn()
+ */
+void qd_task_detach(qd_task* task);
+
+/**
+ * @brief Let other tasks run before continuing
+ *
+ * Outside a task this yields the thread.
+ */
+void qd_task_yield(void);
+
+/**
+ * @brief Task running on this thread
+ *
+ * @return The task, or NULL outside tasks
+ */
+qd_task* qd_task_current(void);
+
+/**
+ * @brief Park the running task until qd_task_ready() is called for it
+ *
+ * The caller holds lock and has registered the task wherever the waker will
+ * find it. The lock is released once the task is off its thread, so the waker
+ * can't resume it early. Returns with the lock released.
+ *
+ * @param lock Mutex that protects the waker's list
+ */
+void qd_task_park(pthread_mutex_t* lock);
+
+/**
+ * @brief Queue a parked task to resume
+ *
+ * Called by whatever the task parked on (the reactor, a finishing task).
+ *
+ * @param task Parked task
+ */
+void qd_task_ready(qd_task* task);
+
+#endif // QD_QDRT_SCHEDULER_H
@@ -1,12 +1,100 @@
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE
 
 #include <qdrt/stack.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 // Stack structure is now defined in the header for inline access
 
+/* Slot accessors hide the difference between the default array of
+ * qd_stack_element_t and the compact value/tag arrays (QD_COMPACT_STACK) */
+#ifdef QD_COMPACT_STACK
+
+static inline qd_stack_element_t slot_load(const qd_stack* stack, size_t i) {
+	qd_stack_element_t e;
+	uint8_t tag = stack->tags[i];
+	e.value.i = stack->data[i].i;
+	e.type = (qd_stack_type)(tag & QD_STACK_TAG_TYPE_MASK);
+	e.is_error_tainted = (tag & QD_STACK_TAG_TAINTED) != 0;
+	e.is_borrowed = (tag & QD_STACK_TAG_BORROWED) != 0;
+	return e;
+}
+
+static inline void slot_store(qd_stack* stack, size_t i, const qd_stack_element_t* e) {
+	uint8_t tag = (uint8_t)((unsigned)e->type & QD_STACK_TAG_TYPE_MASK);
+	if (e->is_error_tainted) {
+		tag |= QD_STACK_TAG_TAINTED;
+	}
+	if (e->type == QD_STACK_TYPE_STR && e->is_borrowed) {
+		tag |= QD_STACK_TAG_BORROWED;
+	}
+	stack->data[i].i = e->value.i;
+	stack->tags[i] = tag;
+}
+
+static inline void slot_move(qd_stack* stack, size_t dst, size_t src) {
+	stack->data[dst] = stack->data[src];
+	stack->tags[dst] = (uint8_t)(stack->tags[src] & ~QD_STACK_TAG_TAINTED);
+}
+
+static inline qd_stack_type slot_type(const qd_stack* stack, size_t i) {
+	return (qd_stack_type)(stack->tags[i] & QD_STACK_TAG_TYPE_MASK);
+}
+
+static inline void slot_set_tainted(qd_stack* stack, size_t i, bool tainted) {
+	if (tainted) {
+		stack->tags[i] |= QD_STACK_TAG_TAINTED;
+	} else {
+		stack->tags[i] &= (uint8_t)~QD_STACK_TAG_TAINTED;
+	}
+}
+
+static inline bool slot_tainted(const qd_stack* stack, size_t i) {
+	return (stack->tags[i] & QD_STACK_TAG_TAINTED) != 0;
+}
+
+#else
+
+static inline qd_stack_element_t slot_load(const qd_stack* stack, size_t i) {
+	return stack->data[i];
+}
+
+static inline void slot_store(qd_stack* stack, size_t i, const qd_stack_element_t* e) {
+	stack->data[i] = *e;
+}
+
+static inline void slot_move(qd_stack* stack, size_t dst, size_t src) {
+	stack->data[dst] = stack->data[src];
+	stack->data[dst].is_error_tainted = false;
+}
+
+static inline qd_stack_type slot_type(const qd_stack* stack, size_t i) {
+	return stack->data[i].type;
+}
+
+static inline void slot_set_tainted(qd_stack* stack, size_t i, bool tainted) {
+	stack->data[i].is_error_tainted = tainted;
+}
+
+static inline bool slot_tainted(const qd_stack* stack, size_t i) {
+	return stack->data[i].is_error_tainted;
+}
+
+#endif
+
+static inline qd_stack_element_t make_element(qd_stack_type type, bool borrowed) {
+	qd_stack_element_t e;
+	e.value.i = 0;
+	e.type = type;
+	e.is_error_tainted = false;
+	e.is_borrowed = borrowed;
+	return e;
+}
+
 qd_stack_error qd_stack_init(qd_stack** stack, size_t capacity) {
 	if (stack == NULL) {
 		return QD_STACK_ERR_NULL_POINTER;
@@ -20,14 +108,76 @@ qd_stack_error qd_stack_init(qd_stack** stack, size_t capacity) {
 		return QD_STACK_ERR_ALLOC;
 	}
 
+#ifdef QD_COMPACT_STACK
+	s->data = (qd_stack_value_t*)malloc(sizeof(qd_stack_value_t) * capacity);
+	s->tags = (uint8_t*)malloc(capacity);
+	if (s->data == NULL || s->tags == NULL) {
+		free(s->data);
+		free(s->tags);
+		free(s);
+		return QD_STACK_ERR_ALLOC;
+	}
+#else
 	s->data = (qd_stack_element_t*)malloc(sizeof(qd_stack_element_t) * capacity);
 	if (s->data == NULL) {
 		free(s);
 		return QD_STACK_ERR_ALLOC;
 	}
+#endif
+
+	s->capacity = capacity;
+	s->size = 0;
+	s->reserved = 0;
+	*stack = s;
+	return QD_STACK_OK;
+}
+
+// Round up to whole pages and add a guard page
+static size_t guarded_size(size_t bytes, size_t page_size) {
+	return (bytes + page_size - 1) / page_size * page_size + page_size;
+}
+
+qd_stack_error qd_stack_init_growable(qd_stack** stack, size_t capacity) {
+	if (stack == NULL) {
+		return QD_STACK_ERR_NULL_POINTER;
+	}
+	if (capacity == 0 || capacity > SIZE_MAX / 2 / sizeof(qd_stack_element_t)) {
+		return QD_STACK_ERR_INVALID_CAPACITY;
+	}
+
+	qd_stack* s = (qd_stack*)malloc(sizeof(qd_stack));
+	if (s == NULL) {
+		return QD_STACK_ERR_ALLOC;
+	}
+
+	// Reserve address space only: MAP_NORESERVE pages are committed when first touched
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+#ifdef QD_COMPACT_STACK
+	size_t data_size = guarded_size(sizeof(qd_stack_value_t) * capacity, page_size);
+	size_t reserved = data_size + guarded_size(capacity, page_size);
+#else
+	size_t data_size = guarded_size(sizeof(qd_stack_element_t) * capacity, page_size);
+	size_t reserved = data_size;
+#endif
+	char* base = mmap(NULL, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (base == MAP_FAILED) {
+		free(s);
+		return QD_STACK_ERR_ALLOC;
+	}
+
+	// Guard pages after each array
+	mprotect(base + data_size - page_size, page_size, PROT_NONE);
+#ifdef QD_COMPACT_STACK
+	mprotect(base + reserved - page_size, page_size, PROT_NONE);
+	s->tags = (uint8_t*)(base + data_size);
+	s->data = (qd_stack_value_t*)base;
+#else
+	s->data = (qd_stack_element_t*)base;
+#endif
 
 	s->capacity = capacity;
 	s->size = 0;
+	s->reserved = reserved;
 	*stack = s;
 	return QD_STACK_OK;
 }
@@ -37,52 +187,75 @@ void qd_stack_destroy(qd_stack* stack) {
 		return;
 	}
 
-	/* Free all string allocations */
+	/* Free all owned string allocations */
 	for (size_t i = 0; i < stack->size; i++) {
-		if (stack->data[i].type == QD_STACK_TYPE_STR) {
-			free(stack->data[i].value.s);
-		}
+		qd_stack_element_t e = slot_load(stack, i);
+		qd_stack_element_release(&e);
+	}
+
+	if (stack->reserved) {
+		munmap(stack->data, stack->reserved);
+		free(stack);
+		return;
 	}
 
+#ifdef QD_COMPACT_STACK
+	free(stack->tags);
+#endif
 	free(stack->data);
 	free(stack);
 }
 
 qd_stack_error qd_stack_clone(qd_stack** dest, const qd_stack* src) {
+	if (src == NULL) {
+		return QD_STACK_ERR_NULL_POINTER;
+	}
+	return qd_stack_clone_top(dest, src, src->size, src->capacity);
+}
+
+qd_stack_error qd_stack_clone_top(qd_stack** dest, const qd_stack* src, size_t count, size_t capacity) {
 	if (dest == NULL || src == NULL) {
 		return QD_STACK_ERR_NULL_POINTER;
 	}
 
-	/* Create new stack with same capacity */
-	qd_stack_error err = qd_stack_init(dest, src->capacity);
+	if (count > src->size) {
+		count = src->size;
+	}
+	if (capacity < count) {
+		capacity = count;
+	}
+	if (capacity < QD_STACK_CLONE_MIN_CAPACITY) {
+		capacity = QD_STACK_CLONE_MIN_CAPACITY;
+	}
+
+	/* Clones are short-lived, so never reserve a growable mapping */
+	qd_stack_error err = qd_stack_init(dest, capacity);
 	if (err != QD_STACK_OK) {
 		return err;
 	}
 
 	qd_stack* d = *dest;
+	size_t base = src->size - count;
 
-	/* Copy all elements */
-	for (size_t i = 0; i < src->size; i++) {
-		d->data[i].type = src->data[i].type;
-		d->data[i].is_error_tainted = src->data[i].is_error_tainted;
+	/* Copy the top count elements to the bottom of the new stack */
+	for (size_t i = 0; i < count; i++) {
+		qd_stack_element_t e = slot_load(src, base + i);
 
-		/* Deep copy strings */
-		if (src->data[i].type == QD_STACK_TYPE_STR) {
-			d->data[i].value.s = strdup(src->data[i].value.s);
-			if (d->data[i].value.s == NULL) {
+		/* Deep copy owned strings, borrowed ones are shared */
+		if (e.type == QD_STACK_TYPE_STR && !e.is_borrowed) {
+			e.value.s = strdup(e.value.s);
+			if (e.value.s == NULL) {
 				/* Cleanup on failure */
 				d->size = i; /* Set size to cleaned-up elements */
 				qd_stack_destroy(d);
 				*dest = NULL;
 				return QD_STACK_ERR_ALLOC;
 			}
-		} else {
-			/* Shallow copy for non-string types */
-			d->data[i].value = src->data[i].value;
 		}
+		slot_store(d, i, &e);
 	}
 
-	d->size = src->size;
+	d->size = count;
 	return QD_STACK_OK;
 }
 
@@ -94,9 +267,9 @@ qd_stack_error qd_stack_push_int(qd_stack* stack, int64_t value) {
 		return QD_STACK_ERR_OVERFLOW;
 	}
 
-	stack->data[stack->size].value.i = value;
-	stack->data[stack->size].type = QD_STACK_TYPE_INT;
-	stack->data[stack->size].is_error_tainted = false;
+	qd_stack_element_t e = make_element(QD_STACK_TYPE_INT, false);
+	e.value.i = value;
+	slot_store(stack, stack->size, &e);
 	stack->size++;
 	return QD_STACK_OK;
 }
@@ -109,9 +282,9 @@ qd_stack_error qd_stack_push_float(qd_stack* stack, double value) {
 		return QD_STACK_ERR_OVERFLOW;
 	}
 
-	stack->data[stack->size].value.f = value;
-	stack->data[stack->size].type = QD_STACK_TYPE_FLOAT;
-	stack->data[stack->size].is_error_tainted = false;
+	qd_stack_element_t e = make_element(QD_STACK_TYPE_FLOAT, false);
+	e.value.f = value;
+	slot_store(stack, stack->size, &e);
 	stack->size++;
 	return QD_STACK_OK;
 }
@@ -124,9 +297,9 @@ qd_stack_error qd_stack_push_ptr(qd_stack* stack, void* value) {
 		return QD_STACK_ERR_OVERFLOW;
 	}
 
-	stack->data[stack->size].value.p = value;
-	stack->data[stack->size].type = QD_STACK_TYPE_PTR;
-	stack->data[stack->size].is_error_tainted = false;
+	qd_stack_element_t e = make_element(QD_STACK_TYPE_PTR, false);
+	e.value.p = value;
+	slot_store(stack, stack->size, &e);
 	stack->size++;
 	return QD_STACK_OK;
 }
@@ -147,13 +320,77 @@ qd_stack_error qd_stack_push_str(qd_stack* stack, const char* value) {
 	}
 	memcpy(copy, value, len + 1);
 
-	stack->data[stack->size].value.s = copy;
-	stack->data[stack->size].type = QD_STACK_TYPE_STR;
-	stack->data[stack->size].is_error_tainted = false;
+	qd_stack_element_t e = make_element(QD_STACK_TYPE_STR, false);
+	e.value.s = copy;
+	slot_store(stack, stack->size, &e);
 	stack->size++;
 	return QD_STACK_OK;
 }
 
+qd_stack_error qd_stack_push_str_borrowed(qd_stack* stack, const char* value) {
+	if (stack == NULL || value == NULL) {
+		return QD_STACK_ERR_NULL_POINTER;
+	}
+	if (stack->size >= stack->capacity) {
+		return QD_STACK_ERR_OVERFLOW;
+	}
+
+	/* Literals are never freed, so the stack can point at them directly */
+	qd_stack_element_t e = make_element(QD_STACK_TYPE_STR, true);
+	e.value.s = (char*)value;
+	slot_store(stack, stack->size, &e);
+	stack->size++;
+	return QD_STACK_OK;
+}
+
+qd_stack_error qd_stack_push_str_owned(qd_stack* stack, char* value) {
+	if (stack == NULL || value == NULL) {
+		return QD_STACK_ERR_NULL_POINTER;
+	}
+	if (stack->size >= stack->capacity) {
+		return QD_STACK_ERR_OVERFLOW;
+	}
+
+	qd_stack_element_t e = make_element(QD_STACK_TYPE_STR, false);
+	e.value.s = value;
+	slot_store(stack, stack->size, &e);
+	stack->size++;
+	return QD_STACK_OK;
+}
+
+qd_stack_error qd_stack_push_copy(qd_stack* stack, const qd_stack_element_t* element) {
+	if (stack == NULL || element == NULL) {
+		return QD_STACK_ERR_NULL_POINTER;
+	}
+
+	switch (element->type) {
+		case QD_STACK_TYPE_INT:
+			return qd_stack_push_int(stack, element->value.i);
+		case QD_STACK_TYPE_FLOAT:
+			return qd_stack_push_float(stack, element->value.f);
+		case QD_STACK_TYPE_PTR:
+			return qd_stack_push_ptr(stack, element->value.p);
+		case QD_STACK_TYPE_STR:
+			if (element->is_borrowed) {
+				return qd_stack_push_str_borrowed(stack, element->value.s);
+			}
+			return qd_stack_push_str(stack, element->value.s);
+		default:
+			return QD_STACK_ERR_TYPE_MISMATCH;
+	}
+}
+
+qd_stack_error qd_stack_push_move(qd_stack* stack, const qd_stack_element_t* element) {
+	if (stack == NULL || element == NULL) {
+		return QD_STACK_ERR_NULL_POINTER;
+	}
+
+	if (element->type == QD_STACK_TYPE_STR && !element->is_borrowed) {
+		return qd_stack_push_str_owned(stack, element->value.s);
+	}
+	return qd_stack_push_copy(stack, element);
+}
+
 qd_stack_error qd_stack_element(qd_stack* stack, size_t index, qd_stack_element_t* element) {
 	if (stack == NULL || element == NULL) {
 		return QD_STACK_ERR_NULL_POINTER;
@@ -162,7 +399,7 @@ qd_stack_error qd_stack_element(qd_stack* stack, size_t index, qd_stack_element_
 		return QD_STACK_ERR_UNDERFLOW;
 	}
 
-	*element = stack->data[index];
+	*element = slot_load(stack, index);
 	return QD_STACK_OK;
 }
 
@@ -174,7 +411,7 @@ qd_stack_error qd_stack_peek(qd_stack* stack, qd_stack_element_t* element) {
 		return QD_STACK_ERR_UNDERFLOW;
 	}
 
-	*element = stack->data[stack->size - 1];
+	*element = slot_load(stack, stack->size - 1);
 	return QD_STACK_OK;
 }
 
@@ -185,17 +422,87 @@ qd_stack_error qd_stack_pop(qd_stack* stack, qd_stack_element_t* element) {
 	if (stack->size == 0) {
 		return QD_STACK_ERR_UNDERFLOW;
 	}
-	stack->size--;
-	if (element != NULL) {
-		*element = stack->data[stack->size];
-	} else {
-		if (stack->data[stack->size].type == QD_STACK_TYPE_STR) {
-			free(stack->data[stack->size].value.s);
+
+	qd_stack_element_t top = slot_load(stack, stack->size - 1);
+	if (element == NULL) {
+		qd_stack_element_release(&top);
+		stack->size--;
+		return QD_STACK_OK;
+	}
+
+	/* Callers of qd_stack_pop own the string they get, so borrowed strings are copied here */
+	if (top.type == QD_STACK_TYPE_STR && top.is_borrowed) {
+		char* copy = strdup(top.value.s);
+		if (copy == NULL) {
+			return QD_STACK_ERR_ALLOC;
 		}
+		top.value.s = copy;
+		top.is_borrowed = false;
 	}
+
+	stack->size--;
+	*element = top;
 	return QD_STACK_OK;
 }
 
+qd_stack_error qd_stack_pop_ref(qd_stack* stack, qd_stack_element_t* element) {
+	if (stack == NULL || element == NULL) {
+		return QD_STACK_ERR_NULL_POINTER;
+	}
+	if (stack->size == 0) {
+		return QD_STACK_ERR_UNDERFLOW;
+	}
+
+	stack->size--;
+	*element = slot_load(stack, stack->size);
+	return QD_STACK_OK;
+}
+
+qd_stack_error qd_stack_roll(qd_stack* stack, size_t depth) {
+	if (stack == NULL) {
+		return QD_STACK_ERR_NULL_POINTER;
+	}
+	if (depth >= stack->size) {
+		return QD_STACK_ERR_UNDERFLOW;
+	}
+
+	size_t top = stack->size - 1;
+	qd_stack_element_t moved = slot_load(stack, top - depth);
+	for (size_t i = top - depth; i < top; i++) {
+		slot_move(stack, i, i + 1);
+	}
+	moved.is_error_tainted = false;
+	slot_store(stack, top, &moved);
+	return QD_STACK_OK;
+}
+
+qd_stack_error qd_stack_remove(qd_stack* stack, size_t depth) {
+	if (stack == NULL) {
+		return QD_STACK_ERR_NULL_POINTER;
+	}
+	if (depth >= stack->size) {
+		return QD_STACK_ERR_UNDERFLOW;
+	}
+
+	size_t top = stack->size - 1;
+	qd_stack_element_t removed = slot_load(stack, top - depth);
+	qd_stack_element_release(&removed);
+	for (size_t i = top - depth; i < top; i++) {
+		slot_move(stack, i, i + 1);
+	}
+	stack->size--;
+	return QD_STACK_OK;
+}
+
+void qd_stack_element_release(qd_stack_element_t* element) {
+	if (element == NULL) {
+		return;
+	}
+	if (element->type == QD_STACK_TYPE_STR && !element->is_borrowed) {
+		free(element->value.s);
+	}
+}
+
 qd_stack_error qd_stack_top_type(const qd_stack* stack, qd_stack_type* type) {
 	if (stack == NULL || type == NULL) {
 		return QD_STACK_ERR_NULL_POINTER;
@@ -204,7 +511,7 @@ qd_stack_error qd_stack_top_type(const qd_stack* stack, qd_stack_type* type) {
 		return QD_STACK_ERR_UNDERFLOW;
 	}
 
-	*type = stack->data[stack->size - 1].type;
+	*type = slot_type(stack, stack->size - 1);
 	return QD_STACK_OK;
 }
 
@@ -215,11 +522,11 @@ qd_stack_error qd_stack_top_int(const qd_stack* stack, int64_t* value) {
 	if (stack->size == 0) {
 		return QD_STACK_ERR_UNDERFLOW;
 	}
-	if (stack->data[stack->size - 1].type != QD_STACK_TYPE_INT) {
+	if (slot_type(stack, stack->size - 1) != QD_STACK_TYPE_INT) {
 		return QD_STACK_ERR_TYPE_MISMATCH;
 	}
 
-	*value = stack->data[stack->size - 1].value.i;
+	*value = slot_load(stack, stack->size - 1).value.i;
 	return QD_STACK_OK;
 }
 
@@ -230,11 +537,11 @@ qd_stack_error qd_stack_top_double(const qd_stack* stack, double* value) {
 	if (stack->size == 0) {
 		return QD_STACK_ERR_UNDERFLOW;
 	}
-	if (stack->data[stack->size - 1].type != QD_STACK_TYPE_FLOAT) {
+	if (slot_type(stack, stack->size - 1) != QD_STACK_TYPE_FLOAT) {
 		return QD_STACK_ERR_TYPE_MISMATCH;
 	}
 
-	*value = stack->data[stack->size - 1].value.f;
+	*value = slot_load(stack, stack->size - 1).value.f;
 	return QD_STACK_OK;
 }
 
@@ -245,11 +552,11 @@ qd_stack_error qd_stack_top_ptr(const qd_stack* stack, void** value) {
 	if (stack->size == 0) {
 		return QD_STACK_ERR_UNDERFLOW;
 	}
-	if (stack->data[stack->size - 1].type != QD_STACK_TYPE_PTR) {
+	if (slot_type(stack, stack->size - 1) != QD_STACK_TYPE_PTR) {
 		return QD_STACK_ERR_TYPE_MISMATCH;
 	}
 
-	*value = stack->data[stack->size - 1].value.p;
+	*value = slot_load(stack, stack->size - 1).value.p;
 	return QD_STACK_OK;
 }
 
@@ -260,11 +567,11 @@ qd_stack_error qd_stack_top_str(const qd_stack* stack, const char** value) {
 	if (stack->size == 0) {
 		return QD_STACK_ERR_UNDERFLOW;
 	}
-	if (stack->data[stack->size - 1].type != QD_STACK_TYPE_STR) {
+	if (slot_type(stack, stack->size - 1) != QD_STACK_TYPE_STR) {
 		return QD_STACK_ERR_TYPE_MISMATCH;
 	}
 
-	*value = stack->data[stack->size - 1].value.s;
+	*value = slot_load(stack, stack->size - 1).value.s;
 	return QD_STACK_OK;
 }
 
@@ -282,6 +589,41 @@ size_t qd_stack_capacity(const qd_stack* stack) {
 	return stack->capacity;
 }
 
+bool qd_stack_is_growable(const qd_stack* stack) {
+	if (stack == NULL) {
+		return false;
+	}
+	return stack->reserved != 0;
+}
+
+// Drop the pages of an array above the ones in use, always keeping the first one
+static void release_pages(char* base, size_t used, size_t size, size_t page_size) {
+	size_t keep = (used + page_size - 1) / page_size * page_size;
+	if (keep < page_size) {
+		keep = page_size;
+	}
+	if (keep < size) {
+		madvise(base + keep, size - keep, MADV_DONTNEED);
+	}
+}
+
+void qd_stack_release_unused(qd_stack* stack) {
+	if (stack == NULL || stack->reserved == 0) {
+		return;
+	}
+
+	// The arrays end in a guard page, which is never committed
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+#ifdef QD_COMPACT_STACK
+	size_t data_size = guarded_size(sizeof(qd_stack_value_t) * stack->capacity, page_size);
+	release_pages((char*)stack->data, sizeof(qd_stack_value_t) * stack->size, data_size - page_size, page_size);
+	release_pages((char*)stack->tags, stack->size, stack->reserved - data_size - page_size, page_size);
+#else
+	size_t used = sizeof(qd_stack_element_t) * stack->size;
+	release_pages((char*)stack->data, used, stack->reserved - page_size, page_size);
+#endif
+}
+
 bool qd_stack_is_empty(const qd_stack* stack) {
 	if (stack == NULL) {
 		return true;
@@ -300,21 +642,21 @@ bool qd_stack_is_top_tainted(const qd_stack* stack) {
 	if (stack == NULL || stack->size == 0) {
 		return false;
 	}
-	return stack->data[stack->size - 1].is_error_tainted;
+	return slot_tainted(stack, stack->size - 1);
 }
 
 void qd_stack_mark_top_tainted(qd_stack* stack) {
 	if (stack == NULL || stack->size == 0) {
 		return;
 	}
-	stack->data[stack->size - 1].is_error_tainted = true;
+	slot_set_tainted(stack, stack->size - 1, true);
 }
 
 void qd_stack_clear_top_taint(qd_stack* stack) {
 	if (stack == NULL || stack->size == 0) {
 		return;
 	}
-	stack->data[stack->size - 1].is_error_tainted = false;
+	slot_set_tainted(stack, stack->size - 1, false);
 }
 
 const char* qd_stack_error_string(qd_stack_error error) {
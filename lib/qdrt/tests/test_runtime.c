@@ -1,9 +1,15 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <qdrt/runtime.h>
 #include <qdrt/context.h>
+#include <qdrt/coroutine.h>
 #include <qdrt/stack.h>
 #include <unit-check/uc.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <math.h>
+#include <time.h>
+#include <unistd.h>
 
 // Helper to compare floats with tolerance
 static int float_eq(double a, double b) {
@@ -2844,3 +2850,691 @@ TEST(Over2Test) {
 
 	destroy_test_context(ctx);
 }
+
+// ========== interned string literal tests ==========
+
+TEST(PushLitDoesNotCopyTest) {
+	qd_context* ctx = create_test_context();
+
+	static const char literal[] = "hello";
+	qd_exec_result result = qd_push_lit(ctx, literal);
+	ASSERT_EQ(result.code, 0, "push_lit should succeed");
+
+	qd_stack_element_t elem;
+	qd_stack_error err = qd_stack_peek(ctx->st, &elem);
+	ASSERT_EQ(err, QD_STACK_OK, "peek should succeed");
+	ASSERT_EQ(elem.type, QD_STACK_TYPE_STR, "element should be string");
+	ASSERT_EQ((int)elem.is_borrowed, 1, "literal should be borrowed");
+	ASSERT_EQ((int)(elem.value.s == literal), 1, "literal should not be copied");
+
+	destroy_test_context(ctx);
+}
+
+TEST(PopLitReturnsOwnedCopyTest) {
+	qd_context* ctx = create_test_context();
+
+	static const char literal[] = "hello";
+	qd_push_lit(ctx, literal);
+
+	qd_stack_element_t elem;
+	qd_stack_error err = qd_stack_pop(ctx->st, &elem);
+	ASSERT_EQ(err, QD_STACK_OK, "pop should succeed");
+	ASSERT_EQ((int)elem.is_borrowed, 0, "popped string should be owned");
+	ASSERT_EQ((int)(elem.value.s != literal), 1, "popped string should be a copy");
+	ASSERT_STR_EQ(elem.value.s, "hello", "popped string should be 'hello'");
+	free(elem.value.s);
+
+	destroy_test_context(ctx);
+}
+
+TEST(PopRefLitIsBorrowedTest) {
+	qd_context* ctx = create_test_context();
+
+	static const char literal[] = "hello";
+	qd_push_lit(ctx, literal);
+
+	qd_stack_element_t elem;
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &elem);
+	ASSERT_EQ(err, QD_STACK_OK, "pop_ref should succeed");
+	ASSERT_EQ((int)(elem.value.s == literal), 1, "pop_ref should hand out the literal");
+	qd_stack_element_release(&elem);
+	ASSERT_EQ((int)qd_stack_size(ctx->st), 0, "stack should be empty");
+
+	destroy_test_context(ctx);
+}
+
+TEST(DupLitSharesStorageTest) {
+	qd_context* ctx = create_test_context();
+
+	static const char literal[] = "hello";
+	qd_push_lit(ctx, literal);
+	qd_exec_result result = qd_dup(ctx);
+	ASSERT_EQ(result.code, 0, "dup should succeed");
+
+	qd_stack_element_t elem1, elem2;
+	qd_stack_element(ctx->st, 0, &elem1);
+	qd_stack_element(ctx->st, 1, &elem2);
+	ASSERT_EQ((int)(elem1.value.s == literal), 1, "original should be the literal");
+	ASSERT_EQ((int)(elem2.value.s == literal), 1, "copy should share the literal");
+
+	destroy_test_context(ctx);
+}
+
+TEST(SwapLitAndOwnedStringsTest) {
+	qd_context* ctx = create_test_context();
+
+	static const char literal[] = "hello";
+	qd_push_lit(ctx, literal);
+	qd_push_s(ctx, "world");
+	qd_exec_result result = qd_swap(ctx);
+	ASSERT_EQ(result.code, 0, "swap should succeed");
+
+	qd_stack_element_t elem;
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &elem);
+	ASSERT_EQ(err, QD_STACK_OK, "pop_ref should succeed");
+	ASSERT_EQ((int)(elem.value.s == literal), 1, "literal should be on top after swap");
+	qd_stack_element_release(&elem);
+
+	err = qd_stack_pop(ctx->st, &elem);
+	ASSERT_EQ(err, QD_STACK_OK, "pop should succeed");
+	ASSERT_STR_EQ(elem.value.s, "world", "owned string should be second");
+	free(elem.value.s);
+
+	destroy_test_context(ctx);
+}
+
+TEST(CloneSharesLitStorageTest) {
+	qd_stack* st = NULL;
+	qd_stack_init(&st, 8);
+
+	static const char literal[] = "hello";
+	qd_stack_push_str_borrowed(st, literal);
+	qd_stack_push_str(st, "world");
+
+	qd_stack* clone = NULL;
+	qd_stack_error err = qd_stack_clone(&clone, st);
+	ASSERT_EQ(err, QD_STACK_OK, "clone should succeed");
+
+	qd_stack_element_t elem;
+	qd_stack_element(clone, 0, &elem);
+	ASSERT_EQ((int)(elem.value.s == literal), 1, "clone should share the literal");
+	qd_stack_element_t orig;
+	qd_stack_element(st, 1, &orig);
+	qd_stack_element(clone, 1, &elem);
+	ASSERT_EQ((int)(elem.value.s != orig.value.s), 1, "clone should copy owned strings");
+
+	qd_stack_destroy(clone);
+	qd_stack_destroy(st);
+}
+
+TEST(CloneContextWindowTest) {
+	qd_context* ctx = qd_create_context(256);
+	for (int64_t i = 0; i < 100; i++) {
+		qd_push_i(ctx, i);
+	}
+	qd_push_s(ctx, "top");
+
+	qd_context* clone = qd_clone_context_window(ctx, 2, 40);
+	ASSERT(clone != NULL, "window clone should succeed");
+	ASSERT_EQ((int)qd_stack_size(clone->st), 2, "clone should hold only the window");
+	ASSERT_EQ((int)qd_stack_capacity(clone->st), 40, "clone should get the requested capacity");
+
+	qd_stack_element_t elem;
+	qd_stack_element(clone->st, 0, &elem);
+	ASSERT_EQ(elem.value.i, 99, "window should start below the top");
+	qd_stack_element_t orig;
+	qd_stack_element(ctx->st, 100, &orig);
+	qd_stack_element(clone->st, 1, &elem);
+	ASSERT_STR_EQ(elem.value.s, "top", "window should end at the top");
+	ASSERT_EQ((int)(elem.value.s != orig.value.s), 1, "window should copy owned strings");
+	qd_free_context(clone);
+
+	clone = qd_clone_context_window(ctx, 1000, 0);
+	ASSERT(clone != NULL, "oversized window clone should succeed");
+	ASSERT_EQ((int)qd_stack_size(clone->st), 101, "oversized window should copy the whole stack");
+	ASSERT_EQ((int)qd_stack_capacity(clone->st), 101, "capacity should be raised to the window");
+	qd_free_context(clone);
+
+	clone = qd_clone_context_window(ctx, 0, 0);
+	ASSERT(clone != NULL, "empty window clone should succeed");
+	ASSERT_EQ((int)qd_stack_capacity(clone->st), QD_STACK_CLONE_MIN_CAPACITY, "capacity should be raised to the minimum");
+	qd_free_context(clone);
+
+	ASSERT_EQ((int)qd_stack_size(ctx->st), 101, "parent stack should be untouched");
+	qd_free_context(ctx);
+}
+
+// ========== in-place stack move tests ==========
+
+TEST(StackRollKeepsStringStorageTest) {
+	qd_stack* st = NULL;
+	qd_stack_init(&st, 8);
+
+	qd_stack_push_str(st, "a");
+	qd_stack_push_int(st, 2);
+	qd_stack_push_float(st, 3.5);
+
+	qd_stack_element_t before;
+	qd_stack_element(st, 0, &before);
+
+	qd_stack_error err = qd_stack_roll(st, 2);
+	ASSERT_EQ(err, QD_STACK_OK, "roll should succeed");
+	ASSERT_EQ((int)qd_stack_size(st), 3, "roll should keep the size");
+
+	qd_stack_element_t elem;
+	qd_stack_element(st, 0, &elem);
+	ASSERT_EQ(elem.type, QD_STACK_TYPE_INT, "bottom should be the int");
+	ASSERT_EQ(elem.value.i, 2, "bottom should be 2");
+	qd_stack_element(st, 1, &elem);
+	ASSERT_EQ(elem.type, QD_STACK_TYPE_FLOAT, "middle should be the float");
+	ASSERT_EQ(float_eq(elem.value.f, 3.5), 1, "middle should be 3.5");
+	qd_stack_element(st, 2, &elem);
+	ASSERT_EQ(elem.type, QD_STACK_TYPE_STR, "top should be the string");
+	ASSERT_EQ((int)(elem.value.s == before.value.s), 1, "roll should not copy the string");
+
+	err = qd_stack_roll(st, 3);
+	ASSERT_EQ(err, QD_STACK_ERR_UNDERFLOW, "roll past the bottom should fail");
+
+	qd_stack_destroy(st);
+}
+
+TEST(StackRemoveReleasesElementTest) {
+	qd_stack* st = NULL;
+	qd_stack_init(&st, 8);
+
+	static const char literal[] = "lit";
+	qd_stack_push_int(st, 1);
+	qd_stack_push_str(st, "owned");
+	qd_stack_push_str_borrowed(st, literal);
+
+	qd_stack_error err = qd_stack_remove(st, 1);
+	ASSERT_EQ(err, QD_STACK_OK, "remove should succeed");
+	ASSERT_EQ((int)qd_stack_size(st), 2, "remove should shrink the stack");
+
+	qd_stack_element_t elem;
+	qd_stack_element(st, 1, &elem);
+	ASSERT_EQ((int)elem.is_borrowed, 1, "moved literal should stay borrowed");
+	ASSERT_EQ((int)(elem.value.s == literal), 1, "moved literal should keep its storage");
+
+	err = qd_stack_remove(st, 2);
+	ASSERT_EQ(err, QD_STACK_ERR_UNDERFLOW, "remove past the bottom should fail");
+
+	qd_stack_destroy(st);
+}
+
+TEST(TaintSurvivesOnlyInPlaceTest) {
+	qd_stack* st = NULL;
+	qd_stack_init(&st, 8);
+
+	qd_stack_push_int(st, 1);
+	qd_stack_push_int(st, 2);
+	qd_stack_mark_top_tainted(st);
+	ASSERT_EQ((int)qd_stack_is_top_tainted(st), 1, "top should be tainted");
+
+	qd_stack_roll(st, 1);
+	qd_stack_roll(st, 1);
+	ASSERT_EQ((int)qd_stack_is_top_tainted(st), 0, "moved values should not be tainted");
+
+	int64_t top = 0;
+	ASSERT_EQ(qd_stack_top_int(st, &top), QD_STACK_OK, "top should be an int");
+	ASSERT_EQ(top, 2, "top should be 2 again");
+
+	qd_stack_destroy(st);
+}
+
+// ========== growable stack tests ==========
+
+TEST(GrowableStackTest) {
+	qd_stack* st = NULL;
+	ASSERT_EQ(qd_stack_init_growable(&st, 1 << 22), QD_STACK_OK, "reserving a large stack should succeed");
+	ASSERT_EQ((int)qd_stack_is_growable(st), 1, "stack should be growable");
+
+	for (int64_t i = 0; i < (1 << 20); i++) {
+		ASSERT_EQ(qd_stack_push_int(st, i), QD_STACK_OK, "push should succeed");
+	}
+	qd_stack_push_str(st, "top");
+	ASSERT_EQ((int)qd_stack_size(st), (1 << 20) + 1, "stack should hold every value");
+
+	qd_stack* clone = NULL;
+	ASSERT_EQ(qd_stack_clone(&clone, st), QD_STACK_OK, "clone should succeed");
+	ASSERT_EQ((int)qd_stack_is_growable(clone), 0, "clone should not reserve a growable mapping");
+	ASSERT_EQ((int)qd_stack_capacity(clone), 1 << 22, "clone should keep the capacity");
+
+	qd_stack_element_t elem;
+	qd_stack_element(clone, (1 << 20) - 1, &elem);
+	ASSERT_EQ(elem.value.i, (1 << 20) - 1, "clone should copy deep values");
+	qd_stack_destroy(clone);
+	qd_stack_destroy(st);
+
+	ASSERT_EQ(qd_stack_init_growable(&st, 2), QD_STACK_OK, "reserving a small stack should succeed");
+	qd_stack_push_int(st, 1);
+	qd_stack_push_int(st, 2);
+	ASSERT_EQ(qd_stack_push_int(st, 3), QD_STACK_ERR_OVERFLOW, "push past the capacity should fail");
+	qd_stack_destroy(st);
+}
+
+// Resident set size in pages, from /proc/self/statm
+static long resident_pages(void) {
+	long size = 0;
+	long resident = 0;
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (f) {
+		if (fscanf(f, "%ld %ld", &size, &resident) != 2) {
+			resident = 0;
+		}
+		fclose(f);
+	}
+	return resident;
+}
+
+TEST(GrowableStackReleaseUnusedTest) {
+	qd_stack* st = NULL;
+	ASSERT_EQ(qd_stack_init_growable(&st, 1 << 22), QD_STACK_OK, "reserving a large stack should succeed");
+	for (int64_t i = 0; i < (1 << 20); i++) {
+		qd_stack_push_int(st, i);
+	}
+	qd_stack_element_t elem;
+	while (qd_stack_size(st) > 10) {
+		qd_stack_pop(st, &elem);
+	}
+
+	long before = resident_pages();
+	qd_stack_release_unused(st);
+	long after = resident_pages();
+	long page_size = sysconf(_SC_PAGESIZE);
+	long grown_pages = (long)((1 << 20) * sizeof(int64_t)) / page_size;
+	ASSERT(before - after >= grown_pages / 2, "the pages the stack grew into should be released");
+
+	ASSERT_EQ((int)qd_stack_size(st), 10, "the remaining values should stay");
+	qd_stack_element(st, 9, &elem);
+	ASSERT_EQ(elem.value.i, 9, "the remaining values should keep their contents");
+	for (int64_t i = 10; i < 100000; i++) {
+		ASSERT_EQ(qd_stack_push_int(st, i), QD_STACK_OK, "the stack should grow again");
+	}
+	qd_stack_element(st, 99999, &elem);
+	ASSERT_EQ(elem.value.i, 99999, "released pages should be usable again");
+	qd_stack_destroy(st);
+
+	ASSERT_EQ(qd_stack_init(&st, 16), QD_STACK_OK, "init should succeed");
+	qd_stack_push_int(st, 7);
+	qd_stack_release_unused(st);
+	qd_stack_peek(st, &elem);
+	ASSERT_EQ(elem.value.i, 7, "a stack that isn't growable should be left alone");
+	qd_stack_destroy(st);
+}
+
+// ========== spawn/wait tests ==========
+
+static _Atomic int spawned_leaves;
+
+static qd_exec_result spawn_leaf(qd_context* ctx) {
+	(void)ctx;
+	spawned_leaves++;
+	return (qd_exec_result){0};
+}
+
+static qd_exec_result spawn_branch(qd_context* ctx) {
+	for (int i = 0; i < 10; i++) {
+		qd_stack_push_ptr(ctx->st, (void*)spawn_leaf);
+		qd_spawn(ctx);
+	}
+	for (int i = 0; i < 10; i++) {
+		qd_wait(ctx);
+	}
+	return (qd_exec_result){0};
+}
+
+TEST(SpawnWaitNestedTasksTest) {
+	qd_context* ctx = create_test_context();
+	spawned_leaves = 0;
+
+	for (int i = 0; i < 50; i++) {
+		qd_stack_push_ptr(ctx->st, (void*)spawn_branch);
+		ASSERT_EQ(qd_spawn(ctx).code, 0, "spawn should succeed");
+	}
+	for (int i = 0; i < 50; i++) {
+		ASSERT_EQ(qd_wait(ctx).code, 0, "wait should succeed");
+	}
+
+	ASSERT_EQ(spawned_leaves, 500, "every nested task should have run");
+	ASSERT_EQ((int)qd_stack_size(ctx->st), 0, "wait should consume every handle");
+
+	destroy_test_context(ctx);
+}
+
+static _Atomic int parked_finished;
+static int parked_pipe[2];
+static char parked_byte;
+
+static qd_exec_result yield_and_sleep(qd_context* ctx) {
+	for (int i = 0; i < 10; i++) {
+		qd_yield(ctx);
+	}
+	qd_sleep(1000000);
+	parked_finished++;
+	return (qd_exec_result){0};
+}
+
+static qd_exec_result read_pipe(qd_context* ctx) {
+	(void)ctx;
+	while (read(parked_pipe[0], &parked_byte, 1) != 1) {
+		qd_wait_fd(parked_pipe[0], QD_WAIT_READ);
+	}
+	parked_finished++;
+	return (qd_exec_result){0};
+}
+
+TEST(YieldAndSleepInTasksTest) {
+	qd_context* ctx = create_test_context();
+	parked_finished = 0;
+
+	for (int i = 0; i < 100; i++) {
+		qd_stack_push_ptr(ctx->st, (void*)yield_and_sleep);
+		qd_spawn(ctx);
+	}
+	for (int i = 0; i < 100; i++) {
+		qd_wait(ctx);
+	}
+
+	ASSERT_EQ(parked_finished, 100, "every parked task should have resumed");
+	ASSERT_EQ(qd_yield(ctx).code, 0, "yield outside a task should succeed");
+
+	destroy_test_context(ctx);
+}
+
+TEST(WaitFdResumesTaskTest) {
+	qd_context* ctx = create_test_context();
+	parked_finished = 0;
+	ASSERT_EQ(pipe(parked_pipe), 0, "pipe should be created");
+	fcntl(parked_pipe[0], F_SETFL, O_NONBLOCK);
+
+	qd_stack_push_ptr(ctx->st, (void*)read_pipe);
+	qd_spawn(ctx);
+	qd_sleep(10000000);
+	ASSERT_EQ(write(parked_pipe[1], "q", 1), 1, "write should succeed");
+	qd_wait(ctx);
+
+	ASSERT_EQ(parked_finished, 1, "reader should have resumed");
+	ASSERT_EQ(parked_byte, 'q', "reader should have read the byte");
+
+	close(parked_pipe[0]);
+	close(parked_pipe[1]);
+	destroy_test_context(ctx);
+}
+
+static _Atomic size_t spawned_stack_size;
+static _Atomic bool spawned_stack_growable;
+
+static qd_exec_result record_stack(qd_context* ctx) {
+	spawned_stack_size = qd_stack_capacity(ctx->st);
+	spawned_stack_growable = qd_stack_is_growable(ctx->st);
+	return (qd_exec_result){0};
+}
+
+TEST(SpawnInheritsStackSizeTest) {
+	qd_context* ctx = qd_create_context_growable(100000);
+	ASSERT(ctx != NULL, "growable context should be created");
+
+	qd_stack_push_ptr(ctx->st, (void*)record_stack);
+	qd_spawn(ctx);
+	qd_wait(ctx);
+	ASSERT_EQ((int)spawned_stack_size, 100000, "task should get the spawner's stack size");
+	ASSERT_EQ((int)spawned_stack_growable, 1, "task should get a growable stack");
+	qd_free_context(ctx);
+
+	ctx = create_test_context();
+	qd_stack_push_ptr(ctx->st, (void*)record_stack);
+	qd_spawn(ctx);
+	qd_wait(ctx);
+	ASSERT_EQ((int)spawned_stack_size, (int)qd_stack_capacity(ctx->st), "task should get the spawner's stack size");
+	ASSERT_EQ((int)spawned_stack_growable, 0, "task should get a fixed stack");
+	destroy_test_context(ctx);
+}
+
+TEST(SpawnSizedTest) {
+	qd_context* ctx = qd_create_context_growable(100000);
+	ASSERT(ctx != NULL, "growable context should be created");
+
+	qd_stack_push_ptr(ctx->st, (void*)record_stack);
+	ASSERT_EQ(qd_spawn_sized(ctx, 0, 5000).code, 0, "sized spawn should succeed");
+	qd_wait(ctx);
+	ASSERT_EQ((int)spawned_stack_size, 5000, "task should get the requested stack size");
+	ASSERT_EQ((int)spawned_stack_growable, 1, "task should still grow like the spawner's");
+
+	qd_stack_push_ptr(ctx->st, (void*)record_stack);
+	qd_spawn_sized(ctx, 0, 0);
+	qd_wait(ctx);
+	ASSERT_EQ((int)spawned_stack_size, 100000, "size 0 should inherit the spawner's stack size");
+	qd_free_context(ctx);
+}
+
+// ========== channel tests ==========
+
+static _Atomic long long channel_sum;
+static _Atomic int channel_received;
+
+// ( channel base -- ): sends base .. base + 249 as strings
+static qd_exec_result channel_producer(qd_context* ctx) {
+	qd_stack_element_t base;
+	qd_stack_element_t channel;
+	qd_stack_pop(ctx->st, &base);
+	qd_stack_pop(ctx->st, &channel);
+
+	for (int i = 0; i < 250; i++) {
+		char text[32];
+		snprintf(text, sizeof(text), "%lld", (long long)(base.value.i + i));
+		qd_stack_push_ptr(ctx->st, channel.value.p);
+		qd_stack_push_str(ctx->st, text);
+		qd_send(ctx);
+	}
+	return (qd_exec_result){0};
+}
+
+// ( channel -- ): receives until the channel is closed
+static qd_exec_result channel_consumer(qd_context* ctx) {
+	qd_stack_element_t channel;
+	qd_stack_pop(ctx->st, &channel);
+
+	for (;;) {
+		qd_stack_element_t ok;
+		qd_stack_element_t value;
+		qd_stack_push_ptr(ctx->st, channel.value.p);
+		qd_recv(ctx);
+		qd_stack_pop(ctx->st, &ok);
+		qd_stack_pop(ctx->st, &value);
+		if (ok.value.i == 0) {
+			break;
+		}
+		channel_sum += atoll(value.value.s);
+		channel_received++;
+		qd_stack_element_release(&value);
+	}
+	return (qd_exec_result){0};
+}
+
+TEST(ChannelPassesValuesBetweenTasksTest) {
+	qd_context* ctx = create_test_context();
+	channel_sum = 0;
+	channel_received = 0;
+
+	qd_stack_push_int(ctx->st, 4);
+	ASSERT_EQ(qd_chan(ctx).code, 0, "chan should succeed");
+	qd_stack_element_t channel;
+	qd_stack_pop(ctx->st, &channel);
+
+	for (int i = 0; i < 3; i++) {
+		qd_stack_push_ptr(ctx->st, channel.value.p);
+		qd_stack_push_ptr(ctx->st, (void*)channel_consumer);
+		qd_stack_push_int(ctx->st, 1);
+		ASSERT_EQ(qd_spawn_args(ctx).code, 0, "spawn with arguments should succeed");
+	}
+	for (int i = 0; i < 4; i++) {
+		qd_stack_push_ptr(ctx->st, channel.value.p);
+		qd_stack_push_int(ctx->st, i * 1000);
+		qd_stack_push_ptr(ctx->st, (void*)channel_producer);
+		qd_stack_push_int(ctx->st, 2);
+		qd_spawn_args(ctx);
+	}
+	ASSERT_EQ((int)qd_stack_size(ctx->st), 7, "spawn should consume the arguments");
+
+	// Producers were spawned last, so their handles are on top
+	for (int i = 0; i < 4; i++) {
+		qd_wait(ctx);
+	}
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_close(ctx);
+	for (int i = 0; i < 3; i++) {
+		qd_wait(ctx);
+	}
+
+	// Each producer sends 250 * base + 0 + 1 + ... + 249
+	ASSERT_EQ(channel_received, 1000, "every value should be received once");
+	ASSERT_EQ(channel_sum, 250LL * 6000 + 4LL * 31125, "values should arrive intact");
+
+	free(channel.value.p);
+	destroy_test_context(ctx);
+}
+
+TEST(ChannelTryRecvAndCloseTest) {
+	qd_context* ctx = create_test_context();
+	qd_stack_element_t value;
+	qd_stack_element_t ok;
+
+	qd_stack_push_int(ctx->st, 2);
+	qd_chan(ctx);
+	qd_stack_element_t channel;
+	qd_stack_pop(ctx->st, &channel);
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	ASSERT_EQ(qd_try_recv(ctx).code, 0, "try_recv should succeed");
+	qd_stack_pop(ctx->st, &ok);
+	qd_stack_pop(ctx->st, &value);
+	ASSERT_EQ(ok.value.i, 0, "try_recv on an empty channel should not receive");
+	ASSERT_EQ(value.type, QD_STACK_TYPE_INT, "try_recv should push 0 when nothing was received");
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_stack_push_int(ctx->st, 42);
+	qd_send(ctx);
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_stack_push_str(ctx->st, "moved");
+	qd_send(ctx);
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	ASSERT_EQ(qd_close(ctx).code, 0, "close should succeed");
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_try_recv(ctx);
+	qd_stack_pop(ctx->st, &ok);
+	qd_stack_pop(ctx->st, &value);
+	ASSERT_EQ(ok.value.i, 1, "values sent before close should still arrive");
+	ASSERT_EQ(value.value.i, 42, "values should arrive in order");
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_recv(ctx);
+	qd_stack_pop(ctx->st, &ok);
+	qd_stack_pop(ctx->st, &value);
+	ASSERT_EQ(ok.value.i, 1, "recv should drain a closed channel");
+	ASSERT_STR_EQ(value.value.s, "moved", "strings should arrive intact");
+	qd_stack_element_release(&value);
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_recv(ctx);
+	qd_stack_pop(ctx->st, &ok);
+	qd_stack_pop(ctx->st, &value);
+	ASSERT_EQ(ok.value.i, 0, "recv on a closed, empty channel should not wait");
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	ASSERT_EQ(qd_close(ctx).code, 0, "closing twice should succeed");
+
+	free(channel.value.p);
+	destroy_test_context(ctx);
+}
+
+static _Atomic int single_slot_sent;
+
+static void sleep_ms(long ms) {
+	struct timespec duration = {ms / 1000, (ms % 1000) * 1000000};
+	nanosleep(&duration, NULL);
+}
+
+// ( channel -- ): sends 1 and 2, counting each send that went through
+static qd_exec_result single_slot_producer(qd_context* ctx) {
+	qd_stack_element_t channel;
+	qd_stack_pop(ctx->st, &channel);
+
+	for (int64_t i = 1; i <= 2; i++) {
+		qd_stack_push_ptr(ctx->st, channel.value.p);
+		qd_stack_push_int(ctx->st, i);
+		qd_send(ctx);
+		single_slot_sent++;
+	}
+	return (qd_exec_result){0};
+}
+
+TEST(ChannelCapacityOneTest) {
+	qd_context* ctx = create_test_context();
+	qd_stack_element_t value;
+	qd_stack_element_t ok;
+	single_slot_sent = 0;
+
+	qd_stack_push_int(ctx->st, 1);
+	qd_chan(ctx);
+	qd_stack_element_t channel;
+	qd_stack_pop(ctx->st, &channel);
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_stack_push_ptr(ctx->st, (void*)single_slot_producer);
+	qd_stack_push_int(ctx->st, 1);
+	qd_spawn_args(ctx);
+
+	// Give the producer time to (wrongly) get its second value in
+	for (int i = 0; i < 100 && single_slot_sent < 1; i++) {
+		sleep_ms(1);
+	}
+	sleep_ms(20);
+	ASSERT_EQ(single_slot_sent, 1, "second send should wait while the one slot is full");
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_try_recv(ctx);
+	qd_stack_pop(ctx->st, &ok);
+	qd_stack_pop(ctx->st, &value);
+	ASSERT_EQ(ok.value.i, 1, "try_recv should take the first value");
+	ASSERT_EQ(value.value.i, 1, "first value should arrive first");
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_recv(ctx);
+	qd_stack_pop(ctx->st, &ok);
+	qd_stack_pop(ctx->st, &value);
+	ASSERT_EQ(ok.value.i, 1, "recv should take the second value");
+	ASSERT_EQ(value.value.i, 2, "second value should not overwrite the first");
+
+	qd_wait(ctx);
+	ASSERT_EQ(single_slot_sent, 2, "both sends should complete");
+
+	qd_stack_push_ptr(ctx->st, channel.value.p);
+	qd_try_recv(ctx);
+	qd_stack_pop(ctx->st, &ok);
+	qd_stack_pop(ctx->st, &value);
+	ASSERT_EQ(ok.value.i, 0, "channel should be empty afterwards");
+
+	free(channel.value.p);
+	destroy_test_context(ctx);
+}
+
+TEST(CheckStackNumericTest) {
+	qd_context* ctx = create_test_context();
+	const qd_stack_type types[] = {QD_STACK_TYPE_FLOAT, QD_STACK_TYPE_INT};
+
+	// Returns only if the check passes
+	qd_stack_push_int(ctx->st, 3);
+	qd_stack_push_float(ctx->st, 2.5);
+	qd_check_stack_numeric(ctx, 2, types, "test");
+	ASSERT_EQ((int)qd_stack_size(ctx->st), 2, "int and float should be accepted for each other");
+
+	qd_stack_push_float(ctx->st, 1.5);
+	qd_stack_push_int(ctx->st, 4);
+	qd_check_stack_numeric(ctx, 2, types, "test");
+	qd_check_stack(ctx, 2, types, "test");
+	ASSERT_EQ((int)qd_stack_size(ctx->st), 4, "exact types should pass both checks");
+
+	destroy_test_context(ctx);
+}
@@ -1,6 +1,11 @@
+#define _GNU_SOURCE
+
 #include <stdnetqd/net.h>
+#include <qdrt/coroutine.h>
 #include <qdrt/runtime.h>
 #include <qdrt/stack.h>
+#include <errno.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,6 +14,20 @@
 #include <sys/socket.h>
 #include <netdb.h>
 
+// Sockets are non-blocking: a call that would block waits with qd_wait_fd(), which parks a spawned
+// task instead of its thread. errno is only read through these out-of-line helpers, since a parked
+// task may resume on another thread and must not reuse the previous thread's errno address.
+
+// The call failed only because it would block (or was interrupted) and should be retried
+static __attribute__((noinline)) bool net_would_block(void) {
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+// connect() failed only because the connection completes asynchronously
+static __attribute__((noinline)) bool net_connect_pending(void) {
+	return errno == EINPROGRESS || errno == EINTR;
+}
+
 // Stack signature: ( port:i -- socket:i )
 // Creates a server socket, binds to the port, and listens
 qd_exec_result usr_net_listen(qd_context* ctx) {
@@ -27,7 +46,7 @@ qd_exec_result usr_net_listen(qd_context* ctx) {
 	int port = (int)port_elem.value.i;
 
 	// Create socket
-	int server_fd = socket(AF_INET, SOCK_STREAM, 0);
+	int server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
 	if (server_fd < 0) {
 		fprintf(stderr, "Fatal error in usr_net_listen: failed to create socket\n");
 		abort();
@@ -53,8 +72,8 @@ qd_exec_result usr_net_listen(qd_context* ctx) {
 		abort();
 	}
 
-	// Listen with backlog of 128
-	if (listen(server_fd, 128) < 0) {
+	// Listen with the system's largest backlog, so bursts of connections aren't dropped while tasks accept them
+	if (listen(server_fd, SOMAXCONN) < 0) {
 		close(server_fd);
 		fprintf(stderr, "Fatal error in usr_net_listen: failed to listen on socket\n");
 		abort();
@@ -66,7 +85,7 @@ qd_exec_result usr_net_listen(qd_context* ctx) {
 }
 
 // Stack signature: ( server_socket:i -- client_socket:i )
-// Accepts a client connection (blocking)
+// Accepts a client connection (blocking; parks a spawned task)
 qd_exec_result usr_net_accept(qd_context* ctx) {
 	qd_stack_element_t socket_elem;
 	qd_stack_error err = qd_stack_pop(ctx->st, &socket_elem);
@@ -83,7 +102,10 @@ qd_exec_result usr_net_accept(qd_context* ctx) {
 	int server_fd = (int)socket_elem.value.i;
 
 	// Accept connection
-	int client_fd = accept(server_fd, NULL, NULL);
+	int client_fd;
+	while ((client_fd = accept4(server_fd, NULL, NULL, SOCK_NONBLOCK)) < 0 && net_would_block()) {
+		qd_wait_fd(server_fd, QD_WAIT_READ);
+	}
 	if (client_fd < 0) {
 		fprintf(stderr, "Fatal error in usr_net_accept: failed to accept connection\n");
 		abort();
@@ -126,7 +148,7 @@ qd_exec_result usr_net_connect(qd_context* ctx) {
 	char* host = host_elem.value.s;
 
 	// Create socket
-	int sock_fd = socket(AF_INET, SOCK_STREAM, 0);
+	int sock_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
 	if (sock_fd < 0) {
 		free(host);
 		fprintf(stderr, "Fatal error in usr_net_connect: failed to create socket\n");
@@ -149,7 +171,14 @@ qd_exec_result usr_net_connect(qd_context* ctx) {
 	addr.sin_port = htons((uint16_t)port);
 
 	// Connect
-	if (connect(sock_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+	int result = connect(sock_fd, (struct sockaddr*)&addr, sizeof(addr));
+	if (result < 0 && net_connect_pending()) {
+		qd_wait_fd(sock_fd, QD_WAIT_WRITE);
+		int error = 0;
+		socklen_t error_len = sizeof(error);
+		result = getsockopt(sock_fd, SOL_SOCKET, SO_ERROR, &error, &error_len) < 0 || error != 0 ? -1 : 0;
+	}
+	if (result < 0) {
 		close(sock_fd);
 		free(host);
 		fprintf(stderr, "Fatal error in usr_net_connect: failed to connect\n");
@@ -196,8 +225,19 @@ qd_exec_result usr_net_send(qd_context* ctx) {
 	char* data = data_elem.value.s;
 	size_t len = strlen(data);
 
-	// Send data
-	ssize_t bytes_sent = write(sock_fd, data, len);
+	// Send data, all of it like a blocking socket would
+	ssize_t bytes_sent = 0;
+	while ((size_t)bytes_sent < len) {
+		ssize_t written = write(sock_fd, data + bytes_sent, len - (size_t)bytes_sent);
+		if (written >= 0) {
+			bytes_sent += written;
+		} else if (net_would_block()) {
+			qd_wait_fd(sock_fd, QD_WAIT_WRITE);
+		} else {
+			bytes_sent = -1;
+			break;
+		}
+	}
 	free(data);
 
 	if (bytes_sent < 0) {
@@ -253,7 +293,10 @@ qd_exec_result usr_net_receive(qd_context* ctx) {
 	}
 
 	// Read data
-	ssize_t bytes_read = read(sock_fd, buffer, (size_t)max_bytes);
+	ssize_t bytes_read;
+	while ((bytes_read = read(sock_fd, buffer, (size_t)max_bytes)) < 0 && net_would_block()) {
+		qd_wait_fd(sock_fd, QD_WAIT_READ);
+	}
 	if (bytes_read < 0) {
 		free(buffer);
 		fprintf(stderr, "Fatal error in usr_net_receive: failed to read from socket\n");
@@ -11,7 +11,7 @@
 // len - get string length ( str:s -- len:i )
 qd_exec_result usr_str_len(qd_context* ctx) {
 	qd_stack_element_t val;
-	qd_stack_error err = qd_stack_pop(ctx->st, &val);
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &val);
 
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::len: Stack underflow\n");
@@ -24,7 +24,7 @@ qd_exec_result usr_str_len(qd_context* ctx) {
 	}
 
 	size_t len = strlen(val.value.s);
-	free(val.value.s);
+	qd_stack_element_release(&val);
 
 	qd_push_i(ctx, (int64_t)len);
 	return (qd_exec_result){0};
@@ -35,24 +35,24 @@ qd_exec_result usr_str_concat(qd_context* ctx) {
 	qd_stack_element_t str2, str1;
 
 	// Pop str2 (top)
-	qd_stack_error err = qd_stack_pop(ctx->st, &str2);
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &str2);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::concat: Stack underflow\n");
 		abort();
 	}
 
 	// Pop str1
-	err = qd_stack_pop(ctx->st, &str1);
+	err = qd_stack_pop_ref(ctx->st, &str1);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::concat: Stack underflow\n");
-		if (str2.type == QD_STACK_TYPE_STR) free(str2.value.s);
+		qd_stack_element_release(&str2);
 		abort();
 	}
 
 	if (str1.type != QD_STACK_TYPE_STR || str2.type != QD_STACK_TYPE_STR) {
 		fprintf(stderr, "Fatal error in str::concat: Expected two strings\n");
-		if (str1.type == QD_STACK_TYPE_STR) free(str1.value.s);
-		if (str2.type == QD_STACK_TYPE_STR) free(str2.value.s);
+		qd_stack_element_release(&str1);
+		qd_stack_element_release(&str2);
 		abort();
 	}
 
@@ -62,19 +62,21 @@ qd_exec_result usr_str_concat(qd_context* ctx) {
 
 	if (!result) {
 		fprintf(stderr, "Fatal error in str::concat: Memory allocation failed\n");
-		free(str1.value.s);
-		free(str2.value.s);
+		qd_stack_element_release(&str1);
+		qd_stack_element_release(&str2);
 		abort();
 	}
 
 	strcpy(result, str1.value.s);
 	strcat(result, str2.value.s);
 
-	free(str1.value.s);
-	free(str2.value.s);
+	qd_stack_element_release(&str1);
+	qd_stack_element_release(&str2);
 
-	qd_push_s(ctx, result);
-	free(result);
+	// Hand the buffer to the stack instead of copying it again
+	if (qd_stack_push_str_owned(ctx->st, result) != QD_STACK_OK) {
+		free(result);
+	}
 
 	return (qd_exec_result){0};
 }
@@ -84,31 +86,31 @@ qd_exec_result usr_str_contains(qd_context* ctx) {
 	qd_stack_element_t needle, haystack;
 
 	// Pop needle (top)
-	qd_stack_error err = qd_stack_pop(ctx->st, &needle);
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &needle);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::contains: Stack underflow\n");
 		abort();
 	}
 
 	// Pop haystack
-	err = qd_stack_pop(ctx->st, &haystack);
+	err = qd_stack_pop_ref(ctx->st, &haystack);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::contains: Stack underflow\n");
-		if (needle.type == QD_STACK_TYPE_STR) free(needle.value.s);
+		qd_stack_element_release(&needle);
 		abort();
 	}
 
 	if (haystack.type != QD_STACK_TYPE_STR || needle.type != QD_STACK_TYPE_STR) {
 		fprintf(stderr, "Fatal error in str::contains: Expected two strings\n");
-		if (haystack.type == QD_STACK_TYPE_STR) free(haystack.value.s);
-		if (needle.type == QD_STACK_TYPE_STR) free(needle.value.s);
+		qd_stack_element_release(&haystack);
+		qd_stack_element_release(&needle);
 		abort();
 	}
 
 	int result = (strstr(haystack.value.s, needle.value.s) != NULL) ? 1 : 0;
 
-	free(haystack.value.s);
-	free(needle.value.s);
+	qd_stack_element_release(&haystack);
+	qd_stack_element_release(&needle);
 
 	qd_push_i(ctx, result);
 	return (qd_exec_result){0};
@@ -119,24 +121,24 @@ qd_exec_result usr_str_starts_with(qd_context* ctx) {
 	qd_stack_element_t prefix, str;
 
 	// Pop prefix (top)
-	qd_stack_error err = qd_stack_pop(ctx->st, &prefix);
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &prefix);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::starts_with: Stack underflow\n");
 		abort();
 	}
 
 	// Pop str
-	err = qd_stack_pop(ctx->st, &str);
+	err = qd_stack_pop_ref(ctx->st, &str);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::starts_with: Stack underflow\n");
-		if (prefix.type == QD_STACK_TYPE_STR) free(prefix.value.s);
+		qd_stack_element_release(&prefix);
 		abort();
 	}
 
 	if (str.type != QD_STACK_TYPE_STR || prefix.type != QD_STACK_TYPE_STR) {
 		fprintf(stderr, "Fatal error in str::starts_with: Expected two strings\n");
-		if (str.type == QD_STACK_TYPE_STR) free(str.value.s);
-		if (prefix.type == QD_STACK_TYPE_STR) free(prefix.value.s);
+		qd_stack_element_release(&str);
+		qd_stack_element_release(&prefix);
 		abort();
 	}
 
@@ -148,8 +150,8 @@ qd_exec_result usr_str_starts_with(qd_context* ctx) {
 		result = (strncmp(str.value.s, prefix.value.s, prefix_len) == 0) ? 1 : 0;
 	}
 
-	free(str.value.s);
-	free(prefix.value.s);
+	qd_stack_element_release(&str);
+	qd_stack_element_release(&prefix);
 
 	qd_push_i(ctx, result);
 	return (qd_exec_result){0};
@@ -160,24 +162,24 @@ qd_exec_result usr_str_ends_with(qd_context* ctx) {
 	qd_stack_element_t suffix, str;
 
 	// Pop suffix (top)
-	qd_stack_error err = qd_stack_pop(ctx->st, &suffix);
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &suffix);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::ends_with: Stack underflow\n");
 		abort();
 	}
 
 	// Pop str
-	err = qd_stack_pop(ctx->st, &str);
+	err = qd_stack_pop_ref(ctx->st, &str);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::ends_with: Stack underflow\n");
-		if (suffix.type == QD_STACK_TYPE_STR) free(suffix.value.s);
+		qd_stack_element_release(&suffix);
 		abort();
 	}
 
 	if (str.type != QD_STACK_TYPE_STR || suffix.type != QD_STACK_TYPE_STR) {
 		fprintf(stderr, "Fatal error in str::ends_with: Expected two strings\n");
-		if (str.type == QD_STACK_TYPE_STR) free(str.value.s);
-		if (suffix.type == QD_STACK_TYPE_STR) free(suffix.value.s);
+		qd_stack_element_release(&str);
+		qd_stack_element_release(&suffix);
 		abort();
 	}
 
@@ -190,8 +192,8 @@ qd_exec_result usr_str_ends_with(qd_context* ctx) {
 		result = (strcmp(str_end, suffix.value.s) == 0) ? 1 : 0;
 	}
 
-	free(str.value.s);
-	free(suffix.value.s);
+	qd_stack_element_release(&str);
+	qd_stack_element_release(&suffix);
 
 	qd_push_i(ctx, result);
 	return (qd_exec_result){0};
@@ -612,32 +614,32 @@ qd_exec_result usr_str_compare(qd_context* ctx) {
 	qd_stack_element_t str2_elem, str1_elem;
 
 	// Pop str2
-	qd_stack_error err = qd_stack_pop(ctx->st, &str2_elem);
+	qd_stack_error err = qd_stack_pop_ref(ctx->st, &str2_elem);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::compare: Stack underflow\n");
 		abort();
 	}
 
 	// Pop str1
-	err = qd_stack_pop(ctx->st, &str1_elem);
+	err = qd_stack_pop_ref(ctx->st, &str1_elem);
 	if (err != QD_STACK_OK) {
 		fprintf(stderr, "Fatal error in str::compare: Stack underflow\n");
-		if (str2_elem.type == QD_STACK_TYPE_STR) free(str2_elem.value.s);
+		qd_stack_element_release(&str2_elem);
 		abort();
 	}
 
 	if (str1_elem.type != QD_STACK_TYPE_STR || str2_elem.type != QD_STACK_TYPE_STR) {
 		fprintf(stderr, "Fatal error in str::compare: Expected two strings\n");
-		if (str1_elem.type == QD_STACK_TYPE_STR) free(str1_elem.value.s);
-		if (str2_elem.type == QD_STACK_TYPE_STR) free(str2_elem.value.s);
+		qd_stack_element_release(&str1_elem);
+		qd_stack_element_release(&str2_elem);
 		abort();
 	}
 
 	int cmp = strcmp(str1_elem.value.s, str2_elem.value.s);
 	int result = (cmp < 0) ? -1 : (cmp > 0) ? 1 : 0;
 
-	free(str1_elem.value.s);
-	free(str2_elem.value.s);
+	qd_stack_element_release(&str1_elem);
+	qd_stack_element_release(&str2_elem);
 
 	qd_push_i(ctx, result);
 	return (qd_exec_result){0};
@@ -3,6 +3,7 @@
 #include <stdtimeqd/time.h>
 #include <qdrt/stack.h>
 #include <qdrt/runtime.h>
+#include <qdrt/coroutine.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -37,7 +38,7 @@ qd_exec_result usr_time_now(qd_context* ctx) {
 	return (qd_exec_result){0};
 }
 
-// sleep - sleep for N nanoseconds ( nanoseconds:i -- )
+// sleep - sleep for N nanoseconds; parks a spawned task instead of its thread ( nanoseconds:i -- )
 qd_exec_result usr_time_sleep(qd_context* ctx) {
 	qd_stack_element_t val;
 	qd_stack_error err = qd_stack_pop(ctx->st, &val);
@@ -57,11 +58,7 @@ qd_exec_result usr_time_sleep(qd_context* ctx) {
 		abort();
 	}
 
-	struct timespec ts;
-	ts.tv_sec = val.value.i / 1000000000;
-	ts.tv_nsec = val.value.i % 1000000000;
-
-	nanosleep(&ts, NULL);
+	qd_sleep(val.value.i);
 
 	return (qd_exec_result){0};
 }
@@ -0,0 +1,53 @@
+#!/bin/bash
+
+# Test that quadc -flto loads the runtime and standard library bitcode
+# quadc only warns about bitcode it can't read (e.g. from a newer LLVM) and links without it,
+# so the programs would still pass; the compiler output is checked instead
+
+set -u
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+source "$SCRIPT_DIR/test_utils.sh"
+
+QUADC="${QUADC:-build/debug/cmd/quadc/quadc}"
+QUADRATE_LIBDIR="${QUADRATE_LIBDIR:-dist/lib}"
+TEMP_DIR="/tmp/qd_bitcode_tests_$$"
+
+export QUADRATE_LIBDIR
+
+mkdir -p "$TEMP_DIR"
+trap "rm -rf $TEMP_DIR" EXIT
+
+print_header "Runtime Bitcode Tests"
+
+increment_test_counter
+if [ -f "$QUADRATE_LIBDIR/qdrt/qdrt.bc" ]; then
+	log_pass "qdrt.bc built"
+else
+	log_fail "qdrt.bc built" "missing in $QUADRATE_LIBDIR/qdrt"
+fi
+
+# Programs using the runtime only and a standard library with bitcode of its own
+for test_file in tests/qd/math/math_utils.qd tests/qd/strings/str_module.qd; do
+	increment_test_counter
+	test_name="$(basename "$test_file" .qd) (-flto)"
+	binary="$TEMP_DIR/$(basename "$test_file" .qd)"
+	compile_log="$binary.compile"
+
+	if ! "$QUADC" -O2 -flto "$test_file" -o "$binary" >"$compile_log" 2>&1; then
+		log_fail "$test_name" "compilation failed"
+		continue
+	fi
+	if grep -qE "ignoring .*\.bc|failed to link .*\.bc" "$compile_log"; then
+		log_fail "$test_name" "bitcode not loaded: $(head -1 "$compile_log")"
+		continue
+	fi
+	if ! "$binary" 2>&1 | diff -q "${test_file%.qd}.out" - >/dev/null; then
+		log_fail "$test_name" "output mismatch"
+		continue
+	fi
+	log_pass "$test_name"
+done
+
+print_summary
+print_result_and_exit